@@ -0,0 +1,436 @@
+// Сквозной бенчмарк: синтетический корпус -> Pipeline -> JSON.
+//
+//   grustnify_corpus_bench [--full] [--corpus DIR] [--json FILE]
+//                          [--baseline FILE] [--tolerance PCT]
+//                          [--intermediate=float|int16|half]
+//
+// Прогресс и сравнение с базой идут в stderr, JSON — в --json или stdout.
+// Корпус генерируется утилитой ffmpeg (должна быть в PATH) один раз и
+// переиспользуется. Каждая задача выполняется в отдельном процессе, чтобы
+// peak RSS (getrusage) относился к одной задаче.
+
+#include "app/pipeline.hpp"
+#include "log/log.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct CorpusEntry {
+  int channels;
+  int sample_rate;
+  int seconds;
+  const char *container; // wav | flac | mp3
+};
+
+// mp3 не бывает многоканальным, поэтому 5.1 только в wav/flac.
+constexpr CorpusEntry kQuickCorpus[] = {
+    {1, 44100, 10, "wav"},  {2, 44100, 30, "mp3"},  {2, 48000, 60, "flac"},
+    {6, 48000, 30, "wav"},  {2, 96000, 60, "flac"}, {1, 96000, 10, "mp3"},
+};
+
+constexpr CorpusEntry kFullCorpus[] = {
+    {2, 44100, 600, "mp3"},
+    {6, 96000, 1800, "flac"},
+    {2, 48000, 7200, "flac"},
+};
+
+// То, что дочерний процесс передаёт родителю
+struct JobReport {
+  bool ok;
+  double wall_ms;
+  app::PipelineStats stats;
+};
+
+struct JobResult {
+  std::string name;
+  CorpusEntry entry{};
+  bool ok = false;
+  double wall_ms = 0.0;
+  app::PipelineStats stats;
+  long peak_rss_kb = 0;
+
+  double x_realtime() const {
+    return wall_ms > 0.0 ? stats.input_seconds() * 1000.0 / wall_ms : 0.0;
+  }
+};
+
+std::string entry_name(const CorpusEntry &e) {
+  const char *layout = e.channels == 1   ? "mono"
+                       : e.channels == 2 ? "stereo"
+                                         : "5.1";
+  return std::string(layout) + "_" + std::to_string(e.sample_rate) + "_" +
+         std::to_string(e.seconds) + "s." + e.container;
+}
+
+int run_command(const std::vector<std::string> &args) {
+  std::vector<char *> argv;
+  for (const std::string &a : args)
+    argv.push_back(const_cast<char *>(a.c_str()));
+  argv.push_back(nullptr);
+
+  pid_t pid;
+  if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+    return -1;
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0)
+    return -1;
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Тон с медленной амплитудной модуляцией и немного шума: кодекам и
+// гейтингу громкости есть с чем работать, в отличие от чистого синуса.
+bool generate(const CorpusEntry &e, const fs::path &path) {
+  if (fs::exists(path))
+    return true;
+
+  const char *layout = e.channels == 1   ? "mono"
+                       : e.channels == 2 ? "stereo"
+                                         : "5.1";
+  const std::string source =
+      std::string("aevalsrc=exprs='0.3*sin(2*PI*(220+55*ch)*t)*"
+                  "(0.6+0.4*sin(2*PI*0.25*t))+0.03*(random(ch)-0.5)'") +
+      ":c=" + layout + ":s=" + std::to_string(e.sample_rate) +
+      ":d=" + std::to_string(e.seconds);
+
+  std::vector<std::string> args = {"ffmpeg", "-hide_banner", "-loglevel",
+                                   "error",  "-y",           "-f",
+                                   "lavfi",  "-i",           source};
+  const std::string_view container = e.container;
+  if (container == "mp3") {
+    args.insert(args.end(), {"-c:a", "libmp3lame", "-b:a", "192k"});
+  } else if (container == "flac") {
+    args.insert(args.end(), {"-c:a", "flac"});
+  } else {
+    args.insert(args.end(), {"-c:a", "pcm_s16le"});
+  }
+
+  const fs::path partial = path.string() + ".part." + e.container;
+  args.push_back(partial.string());
+
+  std::fprintf(stderr, "generating %s\n", path.filename().c_str());
+  if (run_command(args) != 0) {
+    std::fprintf(stderr, "ffmpeg failed for %s\n", path.c_str());
+    return false;
+  }
+  fs::rename(partial, path);
+  return true;
+}
+
+// Задача в дочернем процессе; статистика возвращается через pipe, RSS —
+// через wait4().
+JobResult run_job(const app::PipelineOptions &options, const CorpusEntry &e,
+                  const fs::path &input, const fs::path &output) {
+  JobResult r;
+  r.name = entry_name(e);
+  r.entry = e;
+
+  int fds[2];
+  if (pipe(fds) != 0)
+    return r;
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return r;
+  }
+
+  if (pid == 0) {
+    close(fds[0]);
+    JobReport report{};
+
+    app::Pipeline pipeline(options);
+    const auto started = std::chrono::steady_clock::now();
+    report.ok = pipeline.process(input, output, &report.stats);
+    report.wall_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - started)
+                         .count();
+
+    const bool written =
+        write(fds[1], &report, sizeof(report)) == sizeof(report);
+    _exit(written ? 0 : 1);
+  }
+
+  close(fds[1]);
+  JobReport report{};
+  const bool got = read(fds[0], &report, sizeof(report)) == sizeof(report);
+  close(fds[0]);
+
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+
+  r.ok = got && report.ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  r.wall_ms = report.wall_ms;
+  r.stats = report.stats;
+  r.peak_rss_kb = usage.ru_maxrss; // Linux: килобайты
+  fs::remove(output);
+  return r;
+}
+
+const char *intermediate_name(app::IntermediateFormat f) {
+  switch (f) {
+  case app::IntermediateFormat::Int16:
+    return "int16";
+  case app::IntermediateFormat::Half:
+    return "half";
+  default:
+    return "float";
+  }
+}
+
+void write_json(std::ostream &out, const app::PipelineOptions &options,
+                const std::vector<JobResult> &results) {
+  out << "{\n  \"version\": 1,\n"
+      << "  \"speed_factor\": " << options.speed_factor << ",\n"
+      << "  \"intermediate\": \"" << intermediate_name(options.intermediate)
+      << "\",\n  \"jobs\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const JobResult &r = results[i];
+    const app::PipelineStats &s = r.stats;
+    out << "    {\"name\": \"" << r.name << "\", \"channels\": "
+        << r.entry.channels << ", \"sample_rate\": " << r.entry.sample_rate
+        << ", \"seconds\": " << r.entry.seconds << ", \"format\": \""
+        << r.entry.container << "\", \"ok\": " << (r.ok ? "true" : "false")
+        << ", \"wall_ms\": " << r.wall_ms << ", \"decode_ms\": " << s.decode_ms
+        << ", \"speed_ms\": " << s.speed_ms << ", \"reverb_ms\": "
+        << s.reverb_ms << ", \"loudness_ms\": " << s.loudness_ms
+        << ", \"encode_ms\": " << s.encode_ms << ", \"x_realtime\": "
+        << r.x_realtime() << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}"
+        << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+// Разбор только того JSON, который пишет write_json: плоские объекты в
+// массиве "jobs". name -> (поле -> число).
+using Baseline = std::map<std::string, std::map<std::string, double>>;
+
+bool load_baseline(const fs::path &path, Baseline &baseline) {
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::stringstream ss;
+  ss << in.rdbuf();
+  const std::string text = ss.str();
+
+  size_t pos = text.find("\"jobs\"");
+  if (pos == std::string::npos)
+    return false;
+
+  auto skip_ws = [&] {
+    while (pos < text.size() &&
+           std::isspace(static_cast<unsigned char>(text[pos])))
+      ++pos;
+  };
+  auto read_string = [&](std::string &out) {
+    if (text[pos] != '"')
+      return false;
+    const size_t end = text.find('"', pos + 1);
+    if (end == std::string::npos)
+      return false;
+    out = text.substr(pos + 1, end - pos - 1);
+    pos = end + 1;
+    return true;
+  };
+
+  while ((pos = text.find('{', pos)) != std::string::npos) {
+    ++pos;
+    std::string name;
+    std::map<std::string, double> fields;
+    while (true) {
+      skip_ws();
+      if (pos >= text.size())
+        return false;
+      if (text[pos] == '}') {
+        ++pos;
+        break;
+      }
+      if (text[pos] == ',') {
+        ++pos;
+        continue;
+      }
+      std::string key;
+      if (!read_string(key))
+        return false;
+      skip_ws();
+      if (text[pos++] != ':')
+        return false;
+      skip_ws();
+      if (text[pos] == '"') {
+        std::string value;
+        if (!read_string(value))
+          return false;
+        if (key == "name")
+          name = value;
+      } else {
+        const size_t end = text.find_first_of(",}", pos);
+        const std::string value = text.substr(pos, end - pos);
+        pos = end;
+        if (value.starts_with("true") || value.starts_with("false"))
+          fields[key] = value.starts_with("true") ? 1.0 : 0.0;
+        else
+          fields[key] = std::strtod(value.c_str(), nullptr);
+      }
+    }
+    if (!name.empty())
+      baseline[name] = std::move(fields);
+  }
+  return true;
+}
+
+// Возвращает число регрессий: wall_ms и peak_rss_kb хуже базы больше чем
+// на tolerance процентов.
+int compare(const std::vector<JobResult> &results, const Baseline &baseline,
+            double tolerance) {
+  int regressions = 0;
+  std::fprintf(stderr, "\n%-28s %12s %12s %8s %12s %12s %8s\n", "job", "base ms",
+              "ms", "delta", "base RSS", "RSS", "delta");
+  for (const JobResult &r : results) {
+    const auto it = baseline.find(r.name);
+    if (it == baseline.end() || !r.ok) {
+      std::fprintf(stderr, "%-28s %s\n", r.name.c_str(),
+                  r.ok ? "(no baseline)" : "(failed)");
+      continue;
+    }
+    auto field = [&](const char *key) {
+      const auto f = it->second.find(key);
+      return f == it->second.end() ? 0.0 : f->second;
+    };
+    const double base_ms = field("wall_ms");
+    const double base_rss = field("peak_rss_kb");
+    const double d_ms = base_ms > 0 ? (r.wall_ms / base_ms - 1.0) * 100 : 0;
+    const double d_rss =
+        base_rss > 0 ? (r.peak_rss_kb / base_rss - 1.0) * 100 : 0;
+    const bool bad = d_ms > tolerance || d_rss > tolerance;
+    regressions += bad;
+    std::fprintf(stderr, "%-28s %12.1f %12.1f %+7.1f%% %12.0f %12ld %+7.1f%%%s\n",
+                r.name.c_str(), base_ms, r.wall_ms, d_ms, base_rss,
+                r.peak_rss_kb, d_rss, bad ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+void usage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--full] [--corpus DIR] [--json FILE] "
+               "[--baseline FILE] [--tolerance PCT] "
+               "[--intermediate=float|int16|half]\n",
+               argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  bool full = false;
+  fs::path corpus_dir = "bench_corpus";
+  fs::path json_path;
+  fs::path baseline_path;
+  double tolerance = 10.0;
+  app::PipelineOptions options;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--full") {
+      full = true;
+    } else if (arg == "--corpus" && has_value) {
+      corpus_dir = argv[++i];
+    } else if (arg == "--json" && has_value) {
+      json_path = argv[++i];
+    } else if (arg == "--baseline" && has_value) {
+      baseline_path = argv[++i];
+    } else if (arg == "--tolerance" && has_value) {
+      tolerance = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--intermediate=float") {
+      options.intermediate = app::IntermediateFormat::Float32;
+    } else if (arg == "--intermediate=int16") {
+      options.intermediate = app::IntermediateFormat::Int16;
+    } else if (arg == "--intermediate=half") {
+      options.intermediate = app::IntermediateFormat::Half;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  grustnify::Log::Init();
+  grustnify::Log::GetClientLogger()->set_level(spdlog::level::warn);
+
+  std::vector<CorpusEntry> corpus(std::begin(kQuickCorpus),
+                                  std::end(kQuickCorpus));
+  if (full)
+    corpus.insert(corpus.end(), std::begin(kFullCorpus), std::end(kFullCorpus));
+
+  std::error_code ec;
+  fs::create_directories(corpus_dir / "out", ec);
+  if (ec) {
+    std::fprintf(stderr, "cannot create %s: %s\n", corpus_dir.c_str(),
+                 ec.message().c_str());
+    return 1;
+  }
+
+  std::vector<JobResult> results;
+  for (const CorpusEntry &e : corpus) {
+    const fs::path input = corpus_dir / entry_name(e);
+    if (!generate(e, input))
+      return 1;
+
+    const fs::path output =
+        corpus_dir / "out" / app::grustnified_path(input).filename();
+    JobResult r = run_job(options, e, input, output);
+    std::fprintf(stderr, "%-28s %s wall %9.1f ms  decode %8.1f  speed %7.1f  reverb "
+                "%7.1f  loudness %7.1f  encode %8.1f  %6.1fx  RSS %ld KiB\n",
+                r.name.c_str(), r.ok ? "ok  " : "FAIL", r.wall_ms,
+                r.stats.decode_ms, r.stats.speed_ms, r.stats.reverb_ms,
+                r.stats.loudness_ms, r.stats.encode_ms, r.x_realtime(),
+                r.peak_rss_kb);
+    results.push_back(std::move(r));
+  }
+
+  if (!json_path.empty()) {
+    std::ofstream out(json_path);
+    write_json(out, options, results);
+  } else {
+    write_json(std::cout, options, results);
+  }
+
+  int failed = 0;
+  for (const JobResult &r : results)
+    failed += !r.ok;
+
+  if (!baseline_path.empty()) {
+    Baseline baseline;
+    if (!load_baseline(baseline_path, baseline)) {
+      std::fprintf(stderr, "cannot read baseline %s\n", baseline_path.c_str());
+      return 1;
+    }
+    if (compare(results, baseline, tolerance) > 0)
+      return 3;
+  }
+
+  return failed > 0 ? 1 : 0;
+}
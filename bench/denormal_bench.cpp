@@ -0,0 +1,113 @@
+// Ревербератор на длинной тишине: хвост затухает до субнормальных чисел,
+// и без FTZ/DAZ отдельные секунды обрабатываются в разы медленнее.
+//
+//   grustnify_denormal_bench [--seconds N] [--room-size X]
+//
+// Для каждого алгоритма: 0.5 с шума, затем N секунд тишины (по умолчанию
+// 120) — с core::ScopedFlushDenormals и без. Печатает нс/сэмпл медианной
+// секунды тишины и 90-го перцентиля (худшая секунда шумит от вытеснения
+// процесса). Код выхода 3, если под guard'ом p90 больше медианы вдвое.
+
+#include "core/denormals.hpp"
+#include "core/reverb_kernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr int kChannels = 2;
+
+struct Result {
+  double median_ns = 0.0; // на сэмпл
+  double p90_ns = 0.0;
+};
+
+Result run(core::ReverbAlgorithm algorithm, float room_size, int seconds) {
+  core::ReverbParams p;
+  p.algorithm = algorithm;
+  p.room_size = room_size;
+  p.damp = 0.2f;
+  auto proc = core::make_reverb_processor(kSampleRate, kChannels, p);
+
+  std::vector<float> block(static_cast<size_t>(kSampleRate) * kChannels);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+  for (size_t i = 0; i < block.size() / 2; ++i)
+    block[i] = noise(rng);
+  proc->process(block.data(), block.data(), kSampleRate);
+
+  std::vector<double> per_second;
+  for (int s = 0; s < seconds; ++s) {
+    std::fill(block.begin(), block.end(), 0.0f);
+    const auto start = std::chrono::steady_clock::now();
+    proc->process(block.data(), block.data(), kSampleRate);
+    const auto ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    per_second.push_back(ns / static_cast<double>(block.size()));
+  }
+
+  std::sort(per_second.begin(), per_second.end());
+  Result r;
+  r.median_ns = per_second[per_second.size() / 2];
+  r.p90_ns = per_second[per_second.size() * 9 / 10];
+  return r;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int seconds = 120;
+  float room_size = 0.8f;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--room-size" && i + 1 < argc) {
+      room_size = static_cast<float>(std::atof(argv[++i]));
+    } else {
+      std::fprintf(stderr, "usage: %s [--seconds N] [--room-size X]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  struct Algorithm {
+    const char *name;
+    core::ReverbAlgorithm value;
+  };
+  constexpr Algorithm kAlgorithms[] = {
+      {"schroeder", core::ReverbAlgorithm::Schroeder},
+      {"fdn8", core::ReverbAlgorithm::Fdn8},
+      {"fdn16", core::ReverbAlgorithm::Fdn16},
+  };
+
+  bool regressed = false;
+  std::printf("%-10s %-8s %12s %12s %8s\n", "algorithm", "ftz/daz",
+              "median ns", "p90 ns", "ratio");
+  for (const Algorithm &a : kAlgorithms) {
+    for (bool flush : {false, true}) {
+      Result r;
+      if (flush) {
+        const core::ScopedFlushDenormals guard;
+        r = run(a.value, room_size, seconds);
+      } else {
+        r = run(a.value, room_size, seconds);
+      }
+      const double ratio = r.p90_ns / r.median_ns;
+      std::printf("%-10s %-8s %12.2f %12.2f %8.2f\n", a.name,
+                  flush ? "on" : "off", r.median_ns, r.p90_ns, ratio);
+      if (flush && ratio > 2.0)
+        regressed = true;
+    }
+  }
+  return regressed ? 3 : 0;
+}
@@ -0,0 +1,174 @@
+// Задержка открытия: AudioDecoder::open() с быстрым путём (подсказка
+// демуксера, без find_stream_info) и с обычным зондированием FFmpeg.
+//
+//   grustnify_open_bench [--corpus DIR] [--runs N] [--seconds N]
+//
+// Клипы WAV/MP3/FLAC/M4A генерируются утилитой ffmpeg (должна быть в PATH)
+// в DIR (bench_corpus/open). Каждый файл открывается N раз (по умолчанию
+// 200) попеременно обоими способами; печатаются медиана и 90-й перцентиль
+// в микросекундах. Кэш страниц после первого открытия тёплый — это
+// задержка разбора заголовков, а не диска. Код выхода 3, если быстрый
+// путь где-то медленнее обычного по медиане.
+
+#include "core/audio_decoder.hpp"
+#include "log/log.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Clip {
+  const char *ext;
+  std::vector<std::string> codec_args;
+};
+
+const Clip kClips[] = {
+    {"wav", {"-c:a", "pcm_s16le"}},
+    {"mp3", {"-c:a", "libmp3lame", "-b:a", "192k"}},
+    {"flac", {"-c:a", "flac"}},
+    {"m4a", {"-c:a", "aac", "-b:a", "160k"}},
+};
+
+int run_command(const std::vector<std::string> &args) {
+  std::vector<char *> argv;
+  for (const std::string &a : args)
+    argv.push_back(const_cast<char *>(a.c_str()));
+  argv.push_back(nullptr);
+
+  pid_t pid;
+  if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+    return -1;
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0)
+    return -1;
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+bool generate(const Clip &clip, int seconds, const fs::path &path) {
+  if (fs::exists(path))
+    return true;
+  std::vector<std::string> args = {
+      "ffmpeg", "-hide_banner", "-loglevel", "error", "-y", "-f", "lavfi",
+      "-i",
+      "sine=frequency=440:sample_rate=44100:duration=" +
+          std::to_string(seconds),
+      "-ac", "2"};
+  args.insert(args.end(), clip.codec_args.begin(), clip.codec_args.end());
+  const fs::path partial = path.string() + ".part." + clip.ext;
+  args.push_back(partial.string());
+
+  std::fprintf(stderr, "generating %s\n", path.filename().c_str());
+  if (run_command(args) != 0) {
+    std::fprintf(stderr, "ffmpeg failed for %s\n", path.c_str());
+    return false;
+  }
+  fs::rename(partial, path);
+  return true;
+}
+
+double open_us(const fs::path &path, bool fast) {
+  core::DecodeOptions options;
+  options.fast_open = fast;
+  const auto started = std::chrono::steady_clock::now();
+  core::AudioDecoder decoder(path, options);
+  const bool ok = decoder.open();
+  const double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - started)
+                        .count();
+  return ok ? us : -1.0;
+}
+
+struct Percentiles {
+  double median = 0.0;
+  double p90 = 0.0;
+};
+
+Percentiles percentiles(std::vector<double> v) {
+  std::sort(v.begin(), v.end());
+  return {v[v.size() / 2], v[v.size() * 9 / 10]};
+}
+
+void usage(const char *argv0) {
+  std::fprintf(stderr, "usage: %s [--corpus DIR] [--runs N] [--seconds N]\n",
+               argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  fs::path corpus_dir = "bench_corpus/open";
+  int runs = 200;
+  int seconds = 5;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--corpus" && has_value) {
+      corpus_dir = argv[++i];
+    } else if (arg == "--runs" && has_value) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--seconds" && has_value) {
+      seconds = std::max(1, std::atoi(argv[++i]));
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  grustnify::Log::Init();
+  grustnify::Log::GetClientLogger()->set_level(spdlog::level::warn);
+
+  std::error_code ec;
+  fs::create_directories(corpus_dir, ec);
+  if (ec) {
+    std::fprintf(stderr, "cannot create %s: %s\n", corpus_dir.c_str(),
+                 ec.message().c_str());
+    return 1;
+  }
+
+  std::printf("%-8s %12s %12s %12s %12s %8s\n", "format", "probe p50",
+              "probe p90", "fast p50", "fast p90", "speedup");
+  int slower = 0;
+  for (const Clip &clip : kClips) {
+    const fs::path path = corpus_dir / ("clip_" + std::to_string(seconds) +
+                                        "s." + clip.ext);
+    if (!generate(clip, seconds, path))
+      return 1;
+
+    std::vector<double> probe, fast;
+    for (int r = 0; r < runs; ++r) {
+      // Попеременно: дрейф частоты и фоновая нагрузка делятся поровну
+      const double a = open_us(path, false);
+      const double b = open_us(path, true);
+      if (a < 0.0 || b < 0.0) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+      }
+      probe.push_back(a);
+      fast.push_back(b);
+    }
+
+    const Percentiles p = percentiles(probe);
+    const Percentiles f = percentiles(fast);
+    slower += f.median > p.median;
+    std::printf("%-8s %12.1f %12.1f %12.1f %12.1f %7.2fx\n", clip.ext,
+                p.median, p.p90, f.median, f.p90,
+                f.median > 0.0 ? p.median / f.median : 0.0);
+  }
+  return slower ? 3 : 0;
+}
@@ -0,0 +1,188 @@
+// Ядро change_speed по качествам: пропускная способность и подавление
+// зеркал/алиасинга.
+//
+//   grustnify_resample_bench [--seconds N] [--channels N] [--runs N]
+//
+// Скорость: N секунд (по умолчанию 60) шума 48 кГц рендерятся каждым
+// качеством при speed 1.15 и 0.8; печатается лучший из --runs прогонов
+// (по умолчанию 5) в миллионах выходных кадров в секунду.
+//
+// Подавление: тоны на 0.05–0.9 частоты Найквиста проходят через ядро,
+// спектр выхода (окно Кайзера, 64K точек) сравнивается с тем, что должно
+// остаться: тон на f / speed, если он ниже Найквиста. Печатается худший
+// паразитный пик в dB относительно тона на входе. Код выхода 3, если
+// полифазное качество подавляет хуже линейной интерполяции.
+
+#include "core/fir_design.hpp"
+#include "core/speed_kernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr int kSampleRate = 48000;
+constexpr size_t kFftSize = 65536;
+// Главный лепесток окна Кайзера с beta 20 — около 7 бинов в каждую сторону
+constexpr double kWindowBeta = 20.0;
+constexpr long kMainLobeBins = 12;
+
+struct Quality {
+  const char *name;
+  core::SpeedQuality value;
+};
+
+constexpr Quality kQualities[] = {
+    {"linear", core::SpeedQuality::Linear},
+    {"fast", core::SpeedQuality::Fast},
+    {"balanced", core::SpeedQuality::Balanced},
+    {"best", core::SpeedQuality::Best},
+};
+
+constexpr float kSpeeds[] = {1.15f, 0.8f};
+
+double mframes_per_second(const core::speed::Kernel &kernel,
+                          const std::vector<float> &in, int channels,
+                          float speed, int runs) {
+  const size_t in_frames = in.size() / channels;
+  const size_t out_frames = core::speed::output_frames(in_frames, speed);
+  std::vector<float> out(out_frames * channels);
+  double best = 0.0;
+  for (int r = 0; r < runs; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    kernel.render(in.data(), 0, in_frames, channels, 0, out_frames,
+                  out.data());
+    const double s = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    best = std::max(best, out_frames / s / 1e6);
+  }
+  return best;
+}
+
+void fft(std::vector<std::complex<double>> &a) {
+  const size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1) {
+    const double angle = -2.0 * std::numbers::pi / len;
+    const std::complex<double> w(std::cos(angle), std::sin(angle));
+    for (size_t i = 0; i < n; i += len) {
+      std::complex<double> wk(1.0);
+      for (size_t k = 0; k < len / 2; ++k) {
+        const std::complex<double> u = a[i + k];
+        const std::complex<double> v = a[i + k + len / 2] * wk;
+        a[i + k] = u + v;
+        a[i + k + len / 2] = u - v;
+        wk *= w;
+      }
+    }
+  }
+}
+
+// Худший паразитный пик выхода для тона tone (доля Найквиста входа), dB
+double worst_spur_db(core::SpeedQuality quality, float speed, double tone) {
+  const core::speed::Kernel kernel(speed, quality);
+  const double amplitude = 0.5;
+  const size_t in_frames =
+      static_cast<size_t>(kFftSize / std::min(1.0f, speed) + 4096);
+  std::vector<float> in(in_frames);
+  for (size_t i = 0; i < in_frames; ++i)
+    in[i] = static_cast<float>(amplitude *
+                               std::sin(std::numbers::pi * tone * i));
+  const size_t out_frames = core::speed::output_frames(in_frames, speed);
+  std::vector<float> out(out_frames);
+  kernel.render(in.data(), 0, in_frames, 1, 0, out_frames, out.data());
+
+  // Середина выхода: края фильтра с нулями за сигналом не мешают
+  const size_t offset = (out_frames - kFftSize) / 2;
+  std::vector<std::complex<double>> spectrum(kFftSize);
+  double gain = 0.0;
+  for (size_t i = 0; i < kFftSize; ++i) {
+    const double w =
+        core::fir::kaiser(kWindowBeta, static_cast<int>(i), kFftSize);
+    spectrum[i] = out[offset + i] * w;
+    gain += w;
+  }
+  fft(spectrum);
+
+  const double expected = tone / speed; // доля Найквиста выхода
+  const long expected_bin =
+      expected < 1.0 ? std::lround(expected * kFftSize / 2) : -1;
+  double worst = 0.0;
+  for (long k = 0; k <= static_cast<long>(kFftSize / 2); ++k) {
+    if (expected_bin >= 0 && std::labs(k - expected_bin) <= kMainLobeBins)
+      continue;
+    worst = std::max(worst, std::abs(spectrum[k]));
+  }
+  const double reference = amplitude * gain / 2.0;
+  return 20.0 * std::log10(std::max(worst / reference, 1e-12));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int seconds = 60;
+  int channels = 2;
+  int runs = 5;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--seconds" && has_value) {
+      seconds = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--channels" && has_value) {
+      channels = std::clamp(std::atoi(argv[++i]), 1, 8);
+    } else if (arg == "--runs" && has_value) {
+      runs = std::max(1, std::atoi(argv[++i]));
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--seconds N] [--channels N] [--runs N]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<float> noise(static_cast<size_t>(seconds) * kSampleRate *
+                           channels);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  for (float &x : noise)
+    x = dist(rng);
+
+  constexpr double kTones[] = {0.05, 0.2, 0.4, 0.6, 0.75, 0.85, 0.9};
+  std::printf("%-9s %5s %6s %14s %14s %10s\n", "quality", "speed", "taps",
+              "Mframes/s", "x realtime", "worst dB");
+  bool regressed = false;
+  for (const float speed : kSpeeds) {
+    double linear_db = 0.0;
+    for (const Quality &q : kQualities) {
+      const core::speed::Kernel kernel(speed, q.value);
+      const double mfps =
+          mframes_per_second(kernel, noise, channels, speed, runs);
+      double worst = -1e9;
+      for (const double tone : kTones)
+        worst = std::max(worst, worst_spur_db(q.value, speed, tone));
+      if (q.value == core::SpeedQuality::Linear)
+        linear_db = worst;
+      else if (worst >= linear_db)
+        regressed = true;
+      std::printf("%-9s %5.2f %6d %14.1f %14.0f %10.1f\n", q.name, speed,
+                  kernel.taps(), mfps, mfps * 1e6 / kSampleRate, worst);
+    }
+  }
+  return regressed ? 3 : 0;
+}
@@ -1,92 +1,94 @@
 #include "app.hpp"
-#include <QDir>
-#include <QFileInfo>
 
-#include "core/audio_buffer.hpp"
-#include "core/audio_buffer.hpp" // apply_reverb, ReverbParams
-#include "core/audio_decoder.hpp"
-#include "core/audio_encoder.hpp"
+#include "app/pipeline.hpp"
 #include "log/log.hpp"
+#include <QMetaObject>
+#include <QThreadPool>
+#include <filesystem>
+#include <utility>
 
 namespace app {
 
-App::App(int &argc, char **argv) : QApplication(argc, argv) {}
-App::~App() = default;
+namespace {
 
-void App::load_audio_file(const QString &path) {
-  TE_INFO("loading file: {}", path.toStdString());
-  file_path_ = path;
+PipelineOptions gui_options() {
+  PipelineOptions options;
+  options.waveform_cache = true;
+  return options;
 }
 
-void App::process_audio_file() {
-  if (file_path_.isEmpty()) {
-    TE_ERROR("No file loaded");
-    return;
-  }
-
-  TE_INFO("processing file: {}", file_path_.toStdString());
+} // namespace
 
-  QFileInfo info(file_path_);
-  const QString dir = info.absolutePath();
-  const QString baseName = info.completeBaseName();
+App::App(int &argc, char **argv)
+    : QApplication(argc, argv), pipeline_(gui_options()) {}
 
-  const QString outName = baseName + "_grustnified.mp3";
-  const QString outPath = QDir(dir).filePath(outName);
-
-  TE_INFO("output file: {}", outPath.toStdString());
-
-  core::AudioDecoder decoder(file_path_);
-  if (!decoder.open()) {
-    TE_ERROR("Failed to open decoder for {}", file_path_.toStdString());
-    return;
-  }
-
-  core::AudioBuffer buffer;
-  if (!decoder.decode_to_buffer(buffer)) {
-    TE_ERROR("Failed to decode audio file {}", file_path_.toStdString());
-    return;
-  }
+App::~App() {
+  // Воркеры пишут в this через очередь событий — дождаться всех, включая
+  // те, чей результат уже устарел
+  QThreadPool::globalInstance()->waitForDone();
+}
 
-  if (buffer.sample_rate <= 0 || buffer.channels <= 0 ||
-      buffer.samples.empty()) {
-    TE_ERROR("Decoded buffer is empty or invalid");
-    return;
+void App::reset_peaks(bool output) {
+  if (output) {
+    ++output_generation_;
+    output_peaks_ = {};
+    emit output_peaks_changed();
+  } else {
+    ++input_generation_;
+    input_peaks_ = {};
+    emit input_peaks_changed();
   }
+}
 
-  TE_INFO("decoded: sample_rate={} channels={} frames={}", buffer.sample_rate,
-          buffer.channels, buffer.samples.size() / buffer.channels);
-
-  const float speed_factor = 1.15f;
-  core::AudioBuffer buffer_slowed = core::change_speed(buffer, speed_factor);
-
-  core::ReverbParams rp;
-  rp.mix = 0.10f;
-  rp.room_size = 0.5f;
-  rp.damp = 0.3f;
-
-  core::AudioBuffer processed = core::reverb(buffer_slowed, rp);
-
-  if (processed.samples.empty()) {
-    TE_ERROR("Processed buffer is empty after reverb+slowdown");
-    return;
-  }
+void App::load_peaks(const std::filesystem::path &file, bool output) {
+  reset_peaks(output);
+  const uint64_t request = output ? output_generation_ : input_generation_;
+
+  auto job = [this, file, output, request] {
+    core::PeakPyramid peaks;
+    if (!waveform_peaks(file, {}, peaks))
+      peaks = {};
+    QMetaObject::invokeMethod(
+        this,
+        [this, output, request, peaks = std::move(peaks)]() mutable {
+          if (request != (output ? output_generation_ : input_generation_))
+            return;
+          if (output) {
+            output_peaks_ = std::move(peaks);
+            emit output_peaks_changed();
+          } else {
+            input_peaks_ = std::move(peaks);
+            emit input_peaks_changed();
+          }
+        },
+        Qt::QueuedConnection);
+  };
+  QThreadPool::globalInstance()->start(std::move(job));
+}
 
-  TE_INFO("processed: sample_rate={} channels={} frames={}",
-          processed.sample_rate, processed.channels,
-          processed.samples.size() / processed.channels);
+void App::load_audio_file(const QString &path) {
+  TE_INFO("loading file: {}", path.toStdString());
+  file_path_ = path;
+  // Старые пики выхода к новому файлу не относятся
+  reset_peaks(true);
+  // Повторное открытие того же файла читает пики из кэша
+  load_peaks(std::filesystem::path(path.toStdU16String()), false);
+}
 
-  core::AudioEncoder encoder;
-  if (!encoder.open(outPath, processed.sample_rate, processed.channels)) {
-    TE_ERROR("Failed to open encoder for {}", outPath.toStdString());
+void App::process_audio_file() {
+  if (file_path_.isEmpty()) {
+    TE_ERROR("No file loaded");
     return;
   }
 
-  if (!encoder.encode_from_buffer(processed)) {
-    TE_ERROR("Failed to encode processed audio to {}", outPath.toStdString());
+  const std::filesystem::path input(file_path_.toStdU16String());
+  const std::filesystem::path output = grustnified_path(input);
+  if (!pipeline_.process(input, output)) {
+    reset_peaks(true);
     return;
   }
-
-  TE_INFO("Successfully grustnified {}", outPath.toStdString());
+  // Пики выхода pipeline уже положил в кэш
+  load_peaks(output, true);
 }
 
 } // namespace app
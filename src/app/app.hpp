@@ -1,3 +1,4 @@
+#include "app/pipeline.hpp"
 #include <QApplication>
 
 namespace app {
@@ -10,7 +11,26 @@ public:
   void load_audio_file(const QString &path);
   void process_audio_file();
 
+  // Волна до/после (пусто, пока файл не загружен/не обработан или пока
+  // пики считаются в фоне — готовность сообщают сигналы ниже)
+  const core::PeakPyramid &input_peaks() const { return input_peaks_; }
+  const core::PeakPyramid &output_peaks() const { return output_peaks_; }
+
+signals:
+  void input_peaks_changed();
+  void output_peaks_changed();
+
 private:
+  // Пики считаются в глобальном QThreadPool, результат возвращается в
+  // GUI-поток. Результат устаревшего запроса (файл сменили) отбрасывается.
+  void load_peaks(const std::filesystem::path &file, bool output);
+  void reset_peaks(bool output);
+
   QString file_path_;
+  Pipeline pipeline_;
+  core::PeakPyramid input_peaks_;
+  core::PeakPyramid output_peaks_;
+  uint64_t input_generation_ = 0;
+  uint64_t output_generation_ = 0;
 };
 } // namespace app
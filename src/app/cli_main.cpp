@@ -0,0 +1,447 @@
+#include "app/pipeline.hpp"
+#include "log/log.hpp"
+#include "metrics/metrics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include "app/job_server.hpp"
+#include "app/watch_daemon.hpp"
+#include <atomic>
+#include <csignal>
+#include <ctime>
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+#include <thread>
+#endif
+
+namespace {
+
+void usage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--intermediate=float|int16|half] "
+               "[--reverb=schroeder|fdn8|fdn16] [--reverb-tail] "
+               "[--speed-quality=linear|fast|balanced|best] [--normalize[=LUFS]] "
+               "[--silence-dbfs[=DB]] "
+               "[--keep-video[=stretch|keep]] [--preview[=START[:SECONDS]]] "
+               "[--excerpt=START[:SECONDS]] [--wav-format=f32|s16] [--direct-io] [--io-uring] "
+               "[--checkpoint=DIR] [--metrics=FILE|-] <input> [output]\n",
+               argv0);
+#ifdef __linux__
+  std::fprintf(stderr,
+               "       %s [--intermediate=...] --watch <dir> "
+               "[--output-dir <dir>] [--workers N] [--queue N]\n",
+               argv0);
+  std::fprintf(stderr, "       %s --serve <socket> [--workers N] [--queue N]\n",
+               argv0);
+#endif
+}
+
+bool parse_intermediate(std::string_view value, app::IntermediateFormat &out) {
+  if (value == "float")
+    out = app::IntermediateFormat::Float32;
+  else if (value == "int16")
+    out = app::IntermediateFormat::Int16;
+  else if (value == "half")
+    out = app::IntermediateFormat::Half;
+  else
+    return false;
+  return true;
+}
+
+bool parse_video_timestamps(std::string_view value,
+                            core::VideoTimestampPolicy &out) {
+  if (value == "stretch")
+    out = core::VideoTimestampPolicy::Stretch;
+  else if (value == "keep")
+    out = core::VideoTimestampPolicy::Keep;
+  else
+    return false;
+  return true;
+}
+
+bool parse_reverb(std::string_view value, core::ReverbAlgorithm &out) {
+  if (value == "schroeder")
+    out = core::ReverbAlgorithm::Schroeder;
+  else if (value == "fdn8")
+    out = core::ReverbAlgorithm::Fdn8;
+  else if (value == "fdn16")
+    out = core::ReverbAlgorithm::Fdn16;
+  else
+    return false;
+  return true;
+}
+
+bool parse_speed_quality(std::string_view value, core::SpeedQuality &out) {
+  if (value == "linear")
+    out = core::SpeedQuality::Linear;
+  else if (value == "fast")
+    out = core::SpeedQuality::Fast;
+  else if (value == "balanced")
+    out = core::SpeedQuality::Balanced;
+  else if (value == "best")
+    out = core::SpeedQuality::Best;
+  else
+    return false;
+  return true;
+}
+
+// "START" или "START:SECONDS", в секундах
+bool parse_window(std::string_view value, double &start, double &seconds) {
+  const std::string text(value);
+  char *end = nullptr;
+  start = std::strtod(text.c_str(), &end);
+  if (end == text.c_str() || start < 0.0)
+    return false;
+  if (*end == ':') {
+    const char *from = end + 1;
+    seconds = std::strtod(from, &end);
+    if (end == from || seconds <= 0.0)
+      return false;
+  }
+  return *end == '\0';
+}
+
+// Целевая громкость, LUFS: конечное отрицательное число
+bool parse_lufs(std::string_view value, double &lufs) {
+  const std::string text(value);
+  char *end = nullptr;
+  lufs = std::strtod(text.c_str(), &end);
+  return end != text.c_str() && *end == '\0' && lufs < 0.0 && lufs > -70.0;
+}
+
+// Порог тишины, dBFS RMS по блоку: конечное отрицательное число
+bool parse_dbfs(std::string_view value, float &dbfs) {
+  const std::string text(value);
+  char *end = nullptr;
+  const double parsed = std::strtod(text.c_str(), &end);
+  dbfs = static_cast<float>(parsed);
+  return end != text.c_str() && *end == '\0' && parsed < 0.0 &&
+         parsed > -200.0;
+}
+
+// OpenMetrics-снимок всего процесса; "-" — stdout
+void dump_metrics(const std::filesystem::path &path) {
+  if (!metrics::registry().write_openmetrics(path))
+    TE_WARN("Could not write metrics to {}", path.string());
+}
+
+#ifdef __linux__
+// SIGUSR1 — снимок метрик работающего сервиса. Сигнал ждёт отдельный поток
+// в sigwait(), поэтому файл пишется обычным кодом, а не из обработчика.
+// Создаётся до потоков сервиса: они наследуют маску с заблокированным
+// SIGUSR1.
+class MetricsSignalDumper {
+public:
+  explicit MetricsSignalDumper(std::filesystem::path path)
+      : path_(std::move(path)) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    thread_ = std::thread([this, set] {
+      int sig = 0;
+      while (sigwait(&set, &sig) == 0 && !stopping_)
+        dump_metrics(path_);
+    });
+  }
+
+  ~MetricsSignalDumper() {
+    stopping_ = true;
+    pthread_kill(thread_.native_handle(), SIGUSR1);
+    thread_.join();
+  }
+
+private:
+  std::filesystem::path path_;
+  std::atomic<bool> stopping_{false};
+  std::thread thread_;
+};
+
+void (*g_request_stop)(void *) = nullptr;
+void *g_stop_target = nullptr;
+
+void on_stop_signal(int) {
+  if (g_request_stop)
+    g_request_stop(g_stop_target);
+}
+
+// Запускает долгоживущий сервис (WatchDaemon/JobServer) до SIGINT/SIGTERM.
+template <typename Service> int run_service(Service &service) {
+  g_stop_target = &service;
+  g_request_stop = [](void *s) { static_cast<Service *>(s)->request_stop(); };
+
+  struct sigaction sa {};
+  sa.sa_handler = on_stop_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  const bool ok = service.run();
+  g_request_stop = nullptr;
+  return ok ? 0 : 1;
+}
+#endif
+
+#ifdef __linux__
+// Миллисекунды с exec(): загрузка библиотек и статическая инициализация идут
+// до main(), часы внутри main() их не видят. starttime в /proc/self/stat —
+// в тиках с загрузки системы (обычно 10 мс).
+std::optional<double> ms_since_exec() {
+  std::ifstream stat("/proc/self/stat");
+  std::string line;
+  if (!std::getline(stat, line))
+    return std::nullopt;
+  // Имя процесса в скобках может содержать пробелы: поля — после ')'
+  const auto comm_end = line.rfind(')');
+  if (comm_end == std::string::npos)
+    return std::nullopt;
+  std::istringstream fields(line.substr(comm_end + 1));
+  std::string skip;
+  for (int field = 3; field < 22; ++field)
+    fields >> skip;
+  unsigned long long start_ticks = 0;
+  timespec now{};
+  const long ticks_per_second = sysconf(_SC_CLK_TCK);
+  if (!(fields >> start_ticks) || ticks_per_second <= 0 ||
+      clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+    return std::nullopt;
+  const double now_ms = now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+  return now_ms - start_ticks * 1e3 / ticks_per_second;
+}
+#else
+std::optional<double> ms_since_exec() { return std::nullopt; }
+#endif
+
+} // namespace
+
+// Headless entry point: no Qt is linked or loaded, so process startup only
+// pays for FFmpeg and spdlog.
+int main(int argc, char *argv[]) {
+  const auto started = std::chrono::steady_clock::now();
+  const std::optional<double> startup_ms = ms_since_exec();
+  const auto log_startup = [&] {
+    if (startup_ms)
+      TE_INFO("startup: {:.1f} ms from exec to main", *startup_ms);
+  };
+
+  app::PipelineOptions options;
+  std::vector<std::filesystem::path> paths;
+  bool preview = false;
+  double preview_start = 0.0;
+  double preview_seconds = app::kPreviewSeconds;
+  bool excerpt = false;
+  double excerpt_start = 0.0;
+  double excerpt_seconds = 0.0; // до конца
+  std::optional<core::SpeedQuality> speed_quality;
+  std::filesystem::path metrics_path;
+#ifdef __linux__
+  app::WatchOptions watch;
+  app::JobServerOptions serve;
+#endif
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    [[maybe_unused]] const bool has_value = i + 1 < argc;
+    constexpr std::string_view kIntermediate = "--intermediate=";
+    constexpr std::string_view kKeepVideo = "--keep-video=";
+    constexpr std::string_view kPreview = "--preview=";
+    constexpr std::string_view kExcerpt = "--excerpt=";
+    constexpr std::string_view kReverb = "--reverb=";
+    constexpr std::string_view kSpeedQuality = "--speed-quality=";
+    constexpr std::string_view kCheckpoint = "--checkpoint=";
+    constexpr std::string_view kMetrics = "--metrics=";
+    constexpr std::string_view kNormalize = "--normalize=";
+    constexpr std::string_view kSilenceDbfs = "--silence-dbfs=";
+    if (arg.starts_with(kIntermediate)) {
+      if (!parse_intermediate(arg.substr(kIntermediate.size()),
+                              options.intermediate)) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg.starts_with(kReverb)) {
+      if (!parse_reverb(arg.substr(kReverb.size()),
+                        options.reverb.algorithm)) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg.starts_with(kSpeedQuality)) {
+      core::SpeedQuality quality;
+      if (!parse_speed_quality(arg.substr(kSpeedQuality.size()), quality)) {
+        usage(argv[0]);
+        return 2;
+      }
+      speed_quality = options.speed_quality = quality;
+    } else if (arg == "--normalize") {
+      options.normalize_loudness = true;
+    } else if (arg.starts_with(kNormalize)) {
+      double lufs = 0.0;
+      if (!parse_lufs(arg.substr(kNormalize.size()), lufs)) {
+        usage(argv[0]);
+        return 2;
+      }
+      options.normalize_loudness = true;
+      options.loudness.target_lufs = static_cast<float>(lufs);
+    } else if (arg == "--silence-dbfs") {
+      options.silence_dbfs = core::ActivityMap::kNoiseFloorDbfs;
+    } else if (arg.starts_with(kSilenceDbfs)) {
+      if (!parse_dbfs(arg.substr(kSilenceDbfs.size()), options.silence_dbfs)) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg == "--reverb-tail") {
+      options.reverb.render_tail = true;
+    } else if (arg == "--keep-video") {
+      options.keep_video = true;
+    } else if (arg.starts_with(kKeepVideo)) {
+      options.keep_video = true;
+      if (!parse_video_timestamps(arg.substr(kKeepVideo.size()),
+                                  options.video_timestamps)) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg == "--wav-format=f32") {
+      options.wav.format = core::WavSampleFormat::F32;
+    } else if (arg == "--wav-format=s16") {
+      options.wav.format = core::WavSampleFormat::S16;
+    } else if (arg == "--direct-io") {
+      // Большие .wav не должны вытеснять page cache соседей по узлу
+      options.wav.direct_io = true;
+      options.wav.drop_cache = true;
+    } else if (arg == "--io-uring") {
+      // Сетевые тома: упреждающее чтение и запись без ожидания на каждом
+      // пакете; без io_uring — тихо обычный I/O
+      options.decode.async_io = true;
+      options.async_io = true;
+    } else if (arg.starts_with(kCheckpoint)) {
+      // Повторный запуск с тем же каталогом продолжит прерванный рендер
+      options.checkpoint_dir = std::string(arg.substr(kCheckpoint.size()));
+    } else if (arg.starts_with(kMetrics)) {
+      // Сервисы пишут снимок по SIGUSR1 и при выходе, разовый запуск — в
+      // конце
+      metrics_path = std::string(arg.substr(kMetrics.size()));
+      if (metrics_path.empty()) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg == "--preview") {
+      preview = true;
+    } else if (arg.starts_with(kPreview)) {
+      preview = true;
+      if (!parse_window(arg.substr(kPreview.size()), preview_start,
+                        preview_seconds)) {
+        usage(argv[0]);
+        return 2;
+      }
+    } else if (arg.starts_with(kExcerpt)) {
+      excerpt = true;
+      if (!parse_window(arg.substr(kExcerpt.size()), excerpt_start,
+                        excerpt_seconds)) {
+        usage(argv[0]);
+        return 2;
+      }
+#ifdef __linux__
+    } else if (arg == "--watch" && has_value) {
+      watch.watch_dir = argv[++i];
+    } else if (arg == "--serve" && has_value) {
+      serve.socket_path = argv[++i];
+    } else if (arg == "--output-dir" && has_value) {
+      watch.output_dir = argv[++i];
+    } else if (arg == "--workers" && has_value) {
+      watch.workers = serve.workers = std::atoi(argv[++i]);
+    } else if (arg == "--queue" && has_value) {
+      watch.queue_capacity = serve.max_queued_per_client =
+          std::strtoul(argv[++i], nullptr, 10);
+#endif
+    } else if (arg.starts_with("--")) {
+      usage(argv[0]);
+      return 2;
+    } else {
+      paths.emplace_back(arg);
+    }
+  }
+
+#ifdef __linux__
+  const bool watching = !watch.watch_dir.empty();
+  const bool serving = !serve.socket_path.empty();
+  if (watching || serving) {
+    if (!paths.empty() || (watching && serving)) {
+      usage(argv[0]);
+      return 2;
+    }
+    grustnify::Log::Init();
+    log_startup();
+    std::optional<MetricsSignalDumper> dumper;
+    if (!metrics_path.empty())
+      dumper.emplace(metrics_path);
+
+    int status = 0;
+    if (serving) {
+      serve.loudness = options.loudness;
+      app::JobServer server(std::move(serve));
+      status = run_service(server);
+    } else {
+      watch.pipeline = options;
+      app::WatchDaemon daemon(std::move(watch));
+      status = run_service(daemon);
+    }
+    if (dumper) {
+      dumper.reset();
+      dump_metrics(metrics_path);
+    }
+    return status;
+  }
+#endif
+
+  if (paths.empty() || paths.size() > 2 || (preview && excerpt)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  grustnify::Log::Init();
+  log_startup();
+
+  const std::filesystem::path &input = paths[0];
+  std::filesystem::path output =
+      paths.size() == 2 ? paths[1]
+                        : app::grustnified_path(input, options.keep_video);
+  if (preview) {
+    options = app::preview_options(options, preview_start, preview_seconds);
+    // Явно заданное качество важнее быстрого по умолчанию для предпросмотра
+    if (speed_quality)
+      options.speed_quality = *speed_quality;
+    // Полный рендер рядом не перезаписываем
+    if (paths.size() == 1) {
+      output = input.parent_path() / input.stem();
+      output += "_preview.mp3";
+    }
+  } else if (excerpt) {
+    if (options.keep_video)
+      TE_WARN("--excerpt renders audio only, video is not copied");
+    options = app::excerpt_options(options, excerpt_start, excerpt_seconds);
+    if (paths.size() == 1) {
+      output = input.parent_path() / input.stem();
+      output += "_excerpt.mp3";
+    }
+  }
+
+  app::Pipeline pipeline(options);
+  const bool ok = pipeline.process(input, output);
+
+  // От exec(), если известно: в задержку входит и запуск процесса
+  const auto elapsed = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - started);
+  TE_INFO("first job latency: {:.1f} ms",
+          startup_ms.value_or(0.0) + elapsed.count());
+  if (!metrics_path.empty())
+    dump_metrics(metrics_path);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#pragma once
+// Протокол локального job-сервера (grustnify_cli --serve <socket>).
+//
+// Сокет AF_UNIX / SOCK_SEQPACKET: одно сообщение — одна структура, к которой
+// через SCM_RIGHTS приложен ровно один fd. Сэмплы по сокету не идут:
+//  - запрос: fd с interleaved float32 PCM (memfd, shm, файл) с offset 0,
+//    не меньше frames * channels * 4 байт. memfd, запечатанный от
+//    уменьшения (F_SEAL_SHRINK), сервер мапит без копирования; любой
+//    другой fd копирует, чтобы усечение посреди задачи не уронило его;
+//  - ответ: новый memfd сервера с результатом — float32 PCM или mp3, длина
+//    данных в JobResponse::bytes (сам файл может быть длиннее).
+// Ответы приходят в порядке завершения задач; сопоставляются по job_id.
+// Заголовок самодостаточен: клиенты могут подключать только его.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace app::proto {
+
+constexpr uint32_t kMagic = 0x59524e47; // "GNRY"
+constexpr uint16_t kVersion = 1;
+
+enum class OutputKind : uint8_t {
+  PcmF32 = 0, // interleaved float32, та же раскладка, что и на входе
+  Mp3 = 1,
+};
+
+enum class Status : uint8_t {
+  Ok = 0,
+  BadRequest = 1, // неверный magic/версия/параметры
+  BadFd = 2,      // нет fd, или он короче frames * channels * 4
+  Busy = 3,       // очередь клиента заполнена, запрос отброшен
+  Failed = 4,     // ошибка DSP/кодирования
+};
+
+struct JobRequest {
+  uint32_t magic = kMagic;
+  uint16_t version = kVersion;
+  OutputKind output = OutputKind::PcmF32;
+  uint8_t normalize_loudness = 0; // 1 — к target_lufs
+  uint64_t job_id = 0; // возвращается в ответе как есть
+  int32_t sample_rate = 0;
+  int32_t channels = 0;
+  uint64_t frames = 0;
+  float speed_factor = 1.15f;
+  float reverb_mix = 0.10f;
+  float reverb_room_size = 0.5f;
+  float reverb_damp = 0.3f;
+  float target_lufs = -14.0f;
+  int32_t bitrate = 128000; // только для Mp3
+};
+
+struct JobResponse {
+  uint32_t magic = kMagic;
+  uint16_t version = kVersion;
+  Status status = Status::Ok;
+  OutputKind output = OutputKind::PcmF32;
+  uint64_t job_id = 0;
+  int32_t sample_rate = 0;
+  int32_t channels = 0;
+  uint64_t frames = 0; // для PcmF32
+  uint64_t bytes = 0;  // полезная длина данных в приложенном fd
+};
+
+// Отправляет msg и (если fd >= 0) дескриптор одним сообщением.
+inline bool send_message(int sock, const void *msg, size_t size, int fd) {
+  iovec iov{const_cast<void *>(msg), size};
+  msghdr hdr{};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  if (fd >= 0) {
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  }
+
+  ssize_t n;
+  do {
+    n = sendmsg(sock, &hdr, MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  return n == static_cast<ssize_t>(size);
+}
+
+// Принимает одно сообщение. Возвращает его длину (0 — соединение закрыто,
+// < 0 — ошибка); *fd — приложенный дескриптор или -1. Из всех пришедших
+// дескрипторов остаётся первый, остальные закрываются: иначе клиент мог бы
+// исчерпать таблицу fd получателя.
+inline ssize_t recv_message(int sock, void *msg, size_t size, int *fd) {
+  *fd = -1;
+  iovec iov{msg, size};
+  msghdr hdr{};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  // С запасом: лишние fd должны дойти до нас, чтобы их закрыть
+  constexpr size_t kMaxFds = 8;
+  alignas(cmsghdr) char control[CMSG_SPACE(kMaxFds * sizeof(int))] = {};
+  hdr.msg_control = control;
+  hdr.msg_controllen = sizeof(control);
+
+  ssize_t n;
+  do {
+    n = recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0)
+    return n;
+
+  for (cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+       cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const unsigned char *data = CMSG_DATA(cmsg);
+    for (size_t i = 0; i < count; ++i) {
+      int received;
+      std::memcpy(&received, data + i * sizeof(int), sizeof(int));
+      if (*fd < 0)
+        *fd = received;
+      else
+        ::close(received);
+    }
+  }
+  // Усечённое сообщение или управляющие данные — чужой протокол; fd всё
+  // равно отдаём на закрытие.
+  if (n > 0 && (hdr.msg_flags & (MSG_TRUNC | MSG_CTRUNC)))
+    return -1;
+  return n;
+}
+
+} // namespace app::proto
@@ -0,0 +1,453 @@
+#include "app/job_server.hpp"
+
+#include "core/activity.hpp"
+#include "core/audio_buffer.hpp"
+#include "core/audio_encoder.hpp"
+#include "core/denormals.hpp"
+#include "log/log.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace app {
+
+namespace {
+
+// Задачи в очередях всех клиентов
+const metrics::Gauge &queued_jobs() {
+  static const metrics::Gauge gauge = metrics::registry().gauge(
+      "grustnify_queue_depth", "Jobs waiting for a worker.",
+      {{"queue", "serve"}});
+  return gauge;
+}
+
+// Запросы, отклонённые без выполнения, по статусу ответа
+void count_rejected(proto::Status status) {
+  auto counter = [](const char *label) {
+    return metrics::registry().counter(
+        "grustnify_serve_rejected_jobs",
+        "Requests answered without running a job.", {{"status", label}});
+  };
+  static const metrics::Counter bad_request = counter("bad_request");
+  static const metrics::Counter bad_fd = counter("bad_fd");
+  static const metrics::Counter busy = counter("busy");
+  if (status == proto::Status::Busy)
+    busy.inc();
+  else if (status == proto::Status::BadFd)
+    bad_fd.inc();
+  else
+    bad_request.inc();
+}
+
+} // namespace
+
+struct JobServer::Client {
+  explicit Client(int fd) : fd(fd) {}
+  ~Client() {
+    queued_jobs().add(-static_cast<int64_t>(queue.size()));
+    for (Job &job : queue)
+      ::close(job.fd);
+    ::close(fd);
+  }
+
+  int fd;
+  std::deque<Job> queue;
+  size_t inflight = 0;
+  bool scheduled = false; // лежит в ready_
+  bool closed = false;
+};
+
+namespace {
+
+bool valid_request(const proto::JobRequest &r) {
+  return r.magic == proto::kMagic && r.version == proto::kVersion &&
+         r.sample_rate > 0 && r.sample_rate <= 768000 && r.channels > 0 &&
+         r.channels <= 64 && r.frames > 0 &&
+         // frames * channels * 4 не переполняет size_t
+         r.frames <= SIZE_MAX / sizeof(float) / r.channels &&
+         r.speed_factor > 0.0f && r.speed_factor <= 16.0f &&
+         (r.output == proto::OutputKind::PcmF32 ||
+          r.output == proto::OutputKind::Mp3);
+}
+
+// Вход задачи в in.samples; fd закрывается или переходит к storage.
+bool load_input(int fd, size_t samples, core::AudioBuffer &in) {
+  const int seals = fcntl(fd, F_GET_SEALS);
+  if (seals >= 0 && (seals & F_SEAL_SHRINK)) {
+    if (in.samples.adopt_fd(fd, samples))
+      return true;
+    ::close(fd);
+    return false;
+  }
+
+  try {
+    in.samples.resize_uninitialized(samples);
+  } catch (const std::bad_alloc &) {
+    ::close(fd);
+    return false;
+  }
+  auto *dst = reinterpret_cast<char *>(in.samples.data());
+  const size_t bytes = samples * sizeof(float);
+  size_t done = 0;
+  while (done < bytes) {
+    const ssize_t n = pread(fd, dst + done, bytes - done,
+                            static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    done += static_cast<size_t>(n);
+  }
+  ::close(fd);
+  return done == bytes;
+}
+
+proto::JobResponse response_for(const proto::JobRequest &r,
+                                 proto::Status status) {
+  proto::JobResponse resp;
+  resp.status = status;
+  resp.output = r.output;
+  resp.job_id = r.job_id;
+  resp.sample_rate = r.sample_rate;
+  resp.channels = r.channels;
+  return resp;
+}
+
+} // namespace
+
+JobServer::JobServer(JobServerOptions options) : options_(std::move(options)) {
+  if (options_.workers <= 0)
+    options_.workers =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  options_.max_queued_per_client =
+      std::max<size_t>(1, options_.max_queued_per_client);
+  options_.max_inflight_per_client =
+      std::max<size_t>(1, options_.max_inflight_per_client);
+  stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+JobServer::~JobServer() {
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    unlink(options_.socket_path.c_str());
+  }
+  if (stop_fd_ >= 0)
+    ::close(stop_fd_);
+}
+
+void JobServer::request_stop() {
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = write(stop_fd_, &one, sizeof(one));
+}
+
+bool JobServer::open_socket() {
+  const std::string path = options_.socket_path.string();
+  sockaddr_un addr{};
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    TE_ERROR("serve: bad socket path '{}'", path);
+    return false;
+  }
+
+  // Сокет от упавшего прошлого запуска мешает bind().
+  struct stat st{};
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path.c_str());
+
+  listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    TE_ERROR("serve: socket failed: {}", std::strerror(errno));
+    return false;
+  }
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      listen(listen_fd_, SOMAXCONN) < 0) {
+    TE_ERROR("serve: cannot listen on {}: {}", path, std::strerror(errno));
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+bool JobServer::run() {
+  if (stop_fd_ < 0 || !open_socket())
+    return false;
+
+  TE_INFO("serving on {} ({} workers)", options_.socket_path.string(),
+          options_.workers);
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < options_.workers; ++i)
+    workers.emplace_back([this] { worker_loop(); });
+
+  std::vector<pollfd> fds;
+  while (true) {
+    fds.clear();
+    fds.push_back({stop_fd_, POLLIN, 0});
+    fds.push_back({listen_fd_, POLLIN, 0});
+    {
+      std::lock_guard lock(mutex_);
+      for (const auto &[fd, client] : clients_)
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      TE_ERROR("serve: poll failed: {}", std::strerror(errno));
+      break;
+    }
+    if (fds[0].revents & POLLIN)
+      break;
+    if (fds[1].revents & POLLIN)
+      accept_client();
+
+    for (size_t i = 2; i < fds.size(); ++i) {
+      if (!fds[i].revents)
+        continue;
+      std::shared_ptr<Client> client;
+      {
+        std::lock_guard lock(mutex_);
+        const auto it = clients_.find(fds[i].fd);
+        if (it != clients_.end())
+          client = it->second;
+      }
+      if (client)
+        read_client(client);
+    }
+  }
+
+  // Выполняющиеся задачи доделываются, очереди отбрасываются.
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+    ready_.clear();
+    clients_.clear();
+  }
+  work_cv_.notify_all();
+  for (std::thread &t : workers)
+    t.join();
+
+  TE_INFO("serve: stopped");
+  return true;
+}
+
+void JobServer::accept_client() {
+  const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd < 0)
+    return;
+  std::lock_guard lock(mutex_);
+  clients_.emplace(fd, std::make_shared<Client>(fd));
+}
+
+void JobServer::drop_client(int fd) {
+  std::lock_guard lock(mutex_);
+  const auto it = clients_.find(fd);
+  if (it == clients_.end())
+    return;
+  // Сокет закроется, когда воркеры отпустят свои ссылки.
+  Client &client = *it->second;
+  client.closed = true;
+  queued_jobs().add(-static_cast<int64_t>(client.queue.size()));
+  for (Job &job : client.queue)
+    ::close(job.fd);
+  client.queue.clear();
+  std::erase(ready_, it->second);
+  clients_.erase(it);
+}
+
+void JobServer::read_client(const std::shared_ptr<Client> &client) {
+  Job job;
+  const ssize_t n =
+      proto::recv_message(client->fd, &job.request, sizeof(job.request),
+                          &job.fd);
+  if (n <= 0) {
+    if (job.fd >= 0)
+      ::close(job.fd);
+    drop_client(client->fd);
+    return;
+  }
+
+  proto::Status reject = proto::Status::Ok;
+  if (static_cast<size_t>(n) != sizeof(job.request) ||
+      !valid_request(job.request)) {
+    reject = proto::Status::BadRequest;
+  } else if (job.fd < 0) {
+    reject = proto::Status::BadFd;
+  } else {
+    std::lock_guard lock(mutex_);
+    if (client->queue.size() >= options_.max_queued_per_client) {
+      reject = proto::Status::Busy;
+    } else {
+      client->queue.push_back(job);
+      queued_jobs().add(1);
+      schedule(client);
+      return;
+    }
+  }
+
+  count_rejected(reject);
+  if (job.fd >= 0)
+    ::close(job.fd);
+  const proto::JobResponse resp = response_for(job.request, reject);
+  proto::send_message(client->fd, &resp, sizeof(resp), -1);
+}
+
+void JobServer::schedule(const std::shared_ptr<Client> &client) {
+  if (client->scheduled || client->closed || client->queue.empty() ||
+      client->inflight >= options_.max_inflight_per_client) {
+    return;
+  }
+  client->scheduled = true;
+  ready_.push_back(client);
+  work_cv_.notify_one();
+}
+
+void JobServer::worker_loop() {
+  const core::ScopedFlushDenormals flush_denormals;
+  while (true) {
+    std::shared_ptr<Client> client;
+    Job job;
+    {
+      std::unique_lock lock(mutex_);
+      work_cv_.wait(lock, [&] { return stopping_ || !ready_.empty(); });
+      if (stopping_)
+        return;
+
+      // Одна задача от клиента, и он уходит в конец круга.
+      client = std::move(ready_.front());
+      ready_.pop_front();
+      client->scheduled = false;
+      job = client->queue.front();
+      client->queue.pop_front();
+      queued_jobs().add(-1);
+      ++client->inflight;
+      schedule(client);
+    }
+
+    execute(*client, job);
+
+    std::lock_guard lock(mutex_);
+    --client->inflight;
+    schedule(client);
+  }
+}
+
+void JobServer::execute(Client &client, Job &job) {
+  const proto::JobRequest &req = job.request;
+  proto::JobResponse resp = response_for(req, proto::Status::Ok);
+  const auto started = std::chrono::steady_clock::now();
+
+  auto reply = [&](proto::Status status, int fd) {
+    metrics::record_job(
+        status == proto::Status::Ok,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      started)
+            .count(),
+        static_cast<double>(req.frames) / req.sample_rate);
+    resp.status = status;
+    if (!proto::send_message(client.fd, &resp, sizeof(resp), fd))
+      TE_WARN("serve: job {}: client went away", req.job_id);
+  };
+
+  // Вход: страницы клиента без копирования, если клиент не может их
+  // отнять (F_SEAL_SHRINK) — иначе усечение посреди задачи дало бы SIGBUS
+  // всему серверу. Остальное копируется. frames проверен valid_request().
+  core::AudioBuffer in{req.sample_rate, req.channels, {}};
+  const size_t samples = static_cast<size_t>(req.frames) * req.channels;
+  const size_t bytes = samples * sizeof(float);
+  struct stat st{};
+  if (fstat(job.fd, &st) != 0 || st.st_size < 0 ||
+      static_cast<uint64_t>(st.st_size) < bytes ||
+      !load_input(job.fd, samples, in)) {
+    reply(proto::Status::BadFd, -1);
+    return;
+  }
+
+  // Выход сразу в memfd, который уйдёт клиенту.
+  const int out_fd = memfd_create("grustnify-pcm", MFD_CLOEXEC);
+  core::AudioBuffer out{req.sample_rate, req.channels, {}};
+  if (out_fd < 0 || !out.samples.adopt_fd(out_fd, 0)) {
+    if (out_fd >= 0)
+      ::close(out_fd);
+    reply(proto::Status::Failed, -1);
+    return;
+  }
+
+  try {
+    // Цифровая тишина в записи не обрабатывается, выход тот же бит в бит
+    // (см. core/activity.hpp)
+    const core::ActivityMap activity = core::build_activity(
+        in.samples.data(), in.samples.size() / req.channels, req.channels);
+    core::ActivityMap out_activity;
+    core::change_speed(in, req.speed_factor, out, &activity, &out_activity);
+    in.samples.release();
+
+    const core::ReverbParams reverb{req.reverb_mix, req.reverb_room_size,
+                                    req.reverb_damp};
+    core::reverb(out, reverb, out, &out_activity);
+
+    if (req.normalize_loudness) {
+      core::LoudnessParams loudness = options_.loudness;
+      loudness.target_lufs = req.target_lufs;
+      core::normalize_loudness(out, loudness);
+    }
+  } catch (const std::bad_alloc &) {
+    TE_ERROR("serve: job {}: out of memory", req.job_id);
+    reply(proto::Status::Failed, -1);
+    return;
+  }
+
+  resp.frames = out.samples.size() / req.channels;
+
+  if (req.output == proto::OutputKind::PcmF32) {
+    resp.bytes = out.samples.size() * sizeof(float);
+    reply(proto::Status::Ok, out.samples.fd());
+    return;
+  }
+
+  // mp3 тоже пишется в memfd; FFmpeg открывает его через /proc/self/fd.
+  const int mp3_fd = memfd_create("grustnify-mp3", MFD_CLOEXEC);
+  if (mp3_fd < 0) {
+    reply(proto::Status::Failed, -1);
+    return;
+  }
+  const std::string mp3_path = "/proc/self/fd/" + std::to_string(mp3_fd);
+
+  core::AudioEncoder encoder;
+  const bool encoded =
+      encoder.open(mp3_path, req.sample_rate, req.channels, req.bitrate,
+                   "mp3") &&
+      encoder.encode_from_buffer(out);
+  encoder.close();
+
+  if (!encoded || fstat(mp3_fd, &st) != 0) {
+    TE_ERROR("serve: job {}: encoding failed", req.job_id);
+    ::close(mp3_fd);
+    reply(proto::Status::Failed, -1);
+    return;
+  }
+  resp.bytes = static_cast<uint64_t>(st.st_size);
+  reply(proto::Status::Ok, mp3_fd);
+  ::close(mp3_fd);
+}
+
+} // namespace app
@@ -0,0 +1,67 @@
+#pragma once
+#include "app/job_protocol.hpp"
+#include <condition_variable>
+#include <core/loudness.hpp>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace app {
+
+struct JobServerOptions {
+  std::filesystem::path socket_path;
+  int workers = 0; // 0 -> число ядер
+  // Очередь на клиента: сверх неё запрос сразу получает Status::Busy.
+  size_t max_queued_per_client = 16;
+  // Сколько задач одного клиента выполняется одновременно; остальные
+  // воркеры достаются другим клиентам (round-robin).
+  size_t max_inflight_per_client = 2;
+  // Потолок true peak и т.п.; target_lufs берётся из запроса.
+  core::LoudnessParams loudness;
+};
+
+// Локальный job-сервер (см. job_protocol.hpp): PCM приходит и уходит в
+// memfd, DSP работает прямо по замапленным страницам клиента. Только Linux.
+class JobServer {
+public:
+  explicit JobServer(JobServerOptions options);
+  ~JobServer();
+
+  JobServer(const JobServer &) = delete;
+  JobServer &operator=(const JobServer &) = delete;
+
+  // Блокирует до request_stop(); false, если сокет не удалось открыть.
+  bool run();
+  // Async-signal-safe.
+  void request_stop();
+
+private:
+  struct Job {
+    proto::JobRequest request;
+    int fd = -1;
+  };
+  struct Client;
+
+  bool open_socket();
+  void accept_client();
+  void read_client(const std::shared_ptr<Client> &client);
+  void drop_client(int fd);
+  void schedule(const std::shared_ptr<Client> &client); // под mutex_
+  void worker_loop();
+  void execute(Client &client, Job &job);
+
+  JobServerOptions options_;
+  int listen_fd_ = -1;
+  int stop_fd_ = -1;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::map<int, std::shared_ptr<Client>> clients_; // по fd сокета
+  std::deque<std::shared_ptr<Client>> ready_; // есть задачи и свободный слот
+  bool stopping_ = false;
+};
+
+} // namespace app
@@ -0,0 +1,649 @@
+#include "app/pipeline.hpp"
+
+#include "core/activity.hpp"
+#include "core/audio_decoder.hpp"
+#include "core/audio_encoder.hpp"
+#include "core/checkpoint.hpp"
+#include "core/compact_buffer.hpp"
+#include "core/denormals.hpp"
+#include "core/peaks.hpp"
+#include "core/reverb_kernel.hpp"
+#include "core/speed_kernel.hpp"
+#include "log/log.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace app {
+
+std::filesystem::path grustnified_path(const std::filesystem::path &input,
+                                       bool keep_extension) {
+  // Через path, не string(): на Windows имена не в ANSI-кодировке
+  // теряются или бросают исключение
+  std::filesystem::path name = input.stem();
+  name += "_grustnified";
+  name += keep_extension && input.has_extension()
+              ? input.extension()
+              : std::filesystem::path(".mp3");
+  std::filesystem::path out = input;
+  out.replace_filename(name);
+  return out;
+}
+
+PipelineOptions excerpt_options(PipelineOptions full, double start_seconds,
+                                double duration_seconds) {
+  full.decode.start_seconds = start_seconds;
+  full.decode.duration_seconds = duration_seconds;
+  // Окно звука с полным видео не склеить
+  full.keep_video = false;
+  return full;
+}
+
+PipelineOptions preview_options(PipelineOptions full, double start_seconds,
+                                double duration_seconds) {
+  full.decode.sample_rate = kPreviewSampleRate;
+  full.decode.channels = kPreviewChannels;
+  full.speed_quality = core::SpeedQuality::Fast;
+  return excerpt_options(std::move(full), start_seconds, duration_seconds);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point &since) {
+  const auto now = Clock::now();
+  const double ms =
+      std::chrono::duration<double, std::milli>(now - since).count();
+  since = now;
+  return ms;
+}
+
+template <typename Buffer>
+bool encode_output(const Buffer &processed, const std::filesystem::path &output,
+                   const PipelineOptions &options,
+                   core::AudioEncoder &encoder) {
+  encoder.set_wav_options(options.wav);
+  encoder.set_async_io(options.async_io);
+  if (!encoder.open(output, processed.sample_rate, processed.channels,
+                    options.bitrate)) {
+    TE_ERROR("Failed to open encoder for {}", output.string());
+    return false;
+  }
+
+  if (!encoder.encode_from_buffer(processed)) {
+    TE_ERROR("Failed to encode processed audio to {}", output.string());
+    encoder.close();
+    return false;
+  }
+  encoder.close();
+  return true;
+}
+
+template <typename Buffer>
+bool write_output(const Buffer &processed, const std::filesystem::path &input,
+                  int stream_index, const std::filesystem::path &output,
+                  const PipelineOptions &options, core::AudioEncoder &encoder) {
+  if (!options.keep_video)
+    return encode_output(processed, output, options, encoder);
+
+  const core::RemuxOptions remux{options.speed_factor,
+                                 options.video_timestamps, options.bitrate};
+  if (!core::remux_with_audio(input, stream_index, output, processed, remux)) {
+    TE_ERROR("Failed to remux {} into {}", input.string(), output.string());
+    return false;
+  }
+  return true;
+}
+
+std::filesystem::path cache_dir_of(const PipelineOptions &options) {
+  return options.waveform_cache_dir.empty() ? core::default_peak_cache_dir()
+                                            : options.waveform_cache_dir;
+}
+
+// Кэш необязателен: ошибки только в лог.
+void store_peaks(const PipelineOptions &options,
+                 const std::filesystem::path &file,
+                 const core::PeakPyramid &peaks) {
+  const uint64_t hash = core::content_hash(file);
+  if (hash == 0 || peaks.empty())
+    return;
+  if (!peaks.save(core::peak_cache_path(cache_dir_of(options), hash)))
+    TE_WARN("Could not cache waveform of {}", file.string());
+}
+
+template <typename Buffer>
+void trim(Buffer &buffer, bool keep) {
+  // Ёмкость в mmap-файле не держим: это дисковое место, а не heap.
+  if (keep && buffer.samples.backend() == core::StorageBackend::Heap)
+    buffer.samples.clear();
+  else
+    buffer.samples.release();
+}
+
+// Попадания в кэш: {result="hit"} / {result="miss"} одного счётчика
+struct HitCounter {
+  HitCounter(std::string_view name, std::string_view help)
+      : hit(metrics::registry().counter(name, help, {{"result", "hit"}})),
+        miss(metrics::registry().counter(name, help, {{"result", "miss"}})) {}
+  void count(bool is_hit) const { (is_hit ? hit : miss).inc(); }
+
+  metrics::Counter hit;
+  metrics::Counter miss;
+};
+
+// Карта тишины в trace-лог: участки от секунды, не больше kMaxTraced.
+void trace_silence(const core::ActivityMap &activity, int sample_rate) {
+  constexpr size_t kMaxTraced = 32;
+  const auto ranges =
+      activity.silent_ranges(static_cast<size_t>(sample_rate));
+  TE_TRACE("activity: {} blocks of {} frames, {} silent frames in {} ranges",
+           activity.active.size(), core::ActivityMap::kBlockFrames,
+           activity.silent_frames(), ranges.size());
+  const double rate = static_cast<double>(sample_rate);
+  for (size_t i = 0; i < ranges.size() && i < kMaxTraced; ++i) {
+    TE_TRACE("  silent {:.2f}s - {:.2f}s", ranges[i].first / rate,
+             ranges[i].second / rate);
+  }
+  if (ranges.size() > kMaxTraced)
+    TE_TRACE("  ... {} more", ranges.size() - kMaxTraced);
+}
+
+// Этапы run_resumable(); Checkpoint::stage — сколько из них завершено.
+// a и b — файлы сэмплов checkpoint'а, этап читает один и пишет в другой.
+enum ResumeStage : uint32_t {
+  kStageNone,
+  kStageDecoded,    // вход -> a
+  kStageSlowed,     // change_speed: a -> b
+  kStageReverbed,   // reverb: b -> a, с хвостом
+  kStageNormalized, // копия a без разгона -> b, нормализация b
+};
+
+constexpr size_t kResumeBlockFrames = 65536;
+constexpr size_t kResumeTailFrames = 4096;
+
+// Ключ checkpoint'а: содержимое входа и всё, что меняет сэмплы. Кодек и
+// контейнер выхода не входят: кодирование всегда повторяется целиком.
+uint64_t job_key(const std::filesystem::path &input,
+                 const PipelineOptions &o) {
+  uint64_t hash = core::content_hash(input);
+  auto mix = [&hash](const auto &value) {
+    unsigned char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    for (const unsigned char b : bytes) {
+      hash ^= b;
+      hash *= 0x100000001b3ull;
+    }
+  };
+  mix(o.decode.sample_rate);
+  mix(o.decode.channels);
+  mix(o.decode.start_seconds);
+  mix(o.decode.duration_seconds);
+  mix(o.reverb_preroll_seconds);
+  mix(o.speed_factor);
+  mix(o.speed_quality);
+  mix(o.reverb.mix);
+  mix(o.reverb.room_size);
+  mix(o.reverb.damp);
+  mix(o.reverb.algorithm);
+  mix(o.reverb.render_tail);
+  mix(o.reverb.tail_threshold);
+  mix(o.reverb.tail_max_seconds);
+  mix(o.normalize_loudness);
+  mix(o.loudness.target_lufs);
+  mix(o.loudness.true_peak_ceiling_db);
+  mix(o.loudness.max_gain_db);
+  mix(o.loudness.lookahead_ms);
+  mix(o.loudness.release_ms);
+  return hash;
+}
+
+// Окно декодера вместе с разгоном reverb'а перед ним
+core::DecodeOptions preroll_window(const PipelineOptions &o) {
+  core::DecodeOptions decode = o.decode;
+  const double lead = std::clamp(o.reverb_preroll_seconds, 0.0,
+                                 std::max(0.0, decode.start_seconds));
+  decode.start_seconds -= lead;
+  if (decode.duration_seconds > 0.0)
+    decode.duration_seconds += lead;
+  return decode;
+}
+
+// Выходные кадры разгона. Начала окон округляются декодером так же, поэтому
+// отрезается ровно до кадра, с которого начинается запрошенное окно.
+size_t preroll_output_frames(const PipelineOptions &o,
+                             const core::DecodeOptions &decode,
+                             int sample_rate, float speed_factor) {
+  const auto at = [sample_rate](double seconds) {
+    return std::llround(std::max(0.0, seconds) * sample_rate);
+  };
+  const long long lead = at(o.decode.start_seconds) - at(decode.start_seconds);
+  return lead > 0 ? core::speed::output_frames(static_cast<size_t>(lead),
+                                               speed_factor)
+                  : 0;
+}
+
+std::filesystem::path checkpoint_path(const PipelineOptions &options,
+                                      uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(key));
+  return options.checkpoint_dir / name;
+}
+
+} // namespace
+
+bool waveform_peaks(const std::filesystem::path &file,
+                    const std::filesystem::path &cache_dir,
+                    core::PeakPyramid &out) {
+  const std::filesystem::path dir =
+      cache_dir.empty() ? core::default_peak_cache_dir() : cache_dir;
+  const uint64_t hash = core::content_hash(file);
+  const bool hit = hash != 0 && out.load(core::peak_cache_path(dir, hash));
+  static const HitCounter peak_cache("grustnify_peak_cache_lookups",
+                                     "Waveform peak cache lookups.");
+  peak_cache.count(hit);
+  if (hit)
+    return true;
+
+  core::AudioDecoder decoder(file);
+  core::PeakBuilder builder;
+  if (!decoder.open() || !decoder.decode_to_peaks(builder)) {
+    TE_ERROR("Failed to build waveform of {}", file.string());
+    return false;
+  }
+  out = builder.finish();
+  if (hash != 0 && !out.save(core::peak_cache_path(dir, hash)))
+    TE_WARN("Could not cache waveform of {}", file.string());
+  return !out.empty();
+}
+
+Pipeline::Pipeline(PipelineOptions options)
+    : options_(std::move(options)),
+      encoder_(std::make_unique<core::AudioEncoder>()) {
+  // Долгоживущий воркер держит и буферы кодера: следующий файл с теми же
+  // параметрами кодируется без аллокаций. Сам кодек остаётся открытым только
+  // при AV_CODEC_CAP_ENCODER_FLUSH; libmp3lame (mp3 по умолчанию) его нет,
+  // и он открывается заново для каждого файла
+  encoder_->set_keep_codec(options_.keep_workspace);
+}
+
+Pipeline::~Pipeline() = default;
+
+template <typename Buffer>
+bool Pipeline::run_stages(Workspace<Buffer> &ws,
+                          const std::filesystem::path &input,
+                          const std::filesystem::path &output,
+                          PipelineStats &stats) {
+  const PipelineOptions &options = options_;
+  auto stage = Clock::now();
+
+  const core::DecodeOptions window = preroll_window(options);
+  core::AudioDecoder decoder(input, window);
+  if (!decoder.open()) {
+    TE_ERROR("Failed to open decoder for {}", input.string());
+    return false;
+  }
+
+  // Пики входа собираются попутно с декодированием; для окна предпросмотра
+  // они бы не соответствовали файлу.
+  core::PeakBuilder input_peaks;
+  const bool cache_input_peaks = options.waveform_cache &&
+                                 options.decode.start_seconds <= 0.0 &&
+                                 options.decode.duration_seconds <= 0.0;
+  if (cache_input_peaks)
+    decoder.set_peak_builder(&input_peaks);
+  core::ActivityBuilder activity_builder(options.silence_dbfs);
+  if (options.skip_silence)
+    decoder.set_activity_builder(&activity_builder);
+
+  Buffer &buffer = ws.decoded;
+  if (options.keep_workspace) {
+    static const HitCounter reuse(
+        "grustnify_workspace_reuses",
+        "Jobs that found stage buffers kept from the previous job.");
+    reuse.count(buffer.samples.capacity() > 0);
+  }
+  buffer.samples.clear();
+  if (!decoder.decode_to_buffer(buffer)) {
+    TE_ERROR("Failed to decode audio file {}", input.string());
+    return false;
+  }
+  if (cache_input_peaks)
+    store_peaks(options, input, input_peaks.finish());
+
+  if (buffer.sample_rate <= 0 || buffer.channels <= 0 ||
+      buffer.samples.empty()) {
+    TE_ERROR("Decoded buffer is empty or invalid");
+    return false;
+  }
+
+  stats.decode_ms = elapsed_ms(stage);
+  stats.sample_rate = buffer.sample_rate;
+  stats.channels = buffer.channels;
+  stats.input_frames = buffer.samples.size() / buffer.channels;
+  TE_INFO("decoded: sample_rate={} channels={} frames={}", buffer.sample_rate,
+          buffer.channels, stats.input_frames);
+
+  core::ActivityMap input_activity;
+  if (options.skip_silence) {
+    input_activity = activity_builder.finish();
+    stats.silent_input_frames = input_activity.silent_frames();
+    trace_silence(input_activity, buffer.sample_rate);
+  }
+  const core::ActivityMap *activity =
+      options.skip_silence ? &input_activity : nullptr;
+
+  core::ActivityMap speed_activity;
+  Buffer *slowed = &ws.processed;
+  if constexpr (std::is_same_v<Buffer, core::AudioBuffer>) {
+    // float — на месте: пик памяти — один сигнал (длиной выхода)
+    buffer = core::change_speed(std::move(buffer), options.speed_factor,
+                                activity, activity ? &speed_activity : nullptr,
+                                options.speed_quality);
+    stats.skipped_speed_frames = speed_activity.silent_frames();
+    slowed = &buffer;
+  } else {
+    stats.skipped_speed_frames =
+        core::change_speed(buffer, options.speed_factor, ws.processed,
+                           activity, activity ? &speed_activity : nullptr,
+                           options.speed_quality);
+    trim(buffer, options.keep_workspace);
+  }
+  Buffer &processed = *slowed;
+  stats.speed_ms = elapsed_ms(stage);
+
+  stats.skipped_reverb_frames =
+      core::reverb(processed, options.reverb, processed,
+                   activity ? &speed_activity : nullptr);
+  stats.reverb_ms = elapsed_ms(stage);
+  if (activity) {
+    TE_TRACE("silence skipped: speed {} frames, reverb {} frames",
+             stats.skipped_speed_frames, stats.skipped_reverb_frames);
+  }
+
+  const size_t lead = preroll_output_frames(
+      options, window, processed.sample_rate, options.speed_factor);
+  if (lead > 0) {
+    TE_TRACE("reverb preroll: dropping {} frames", lead);
+    processed.samples.erase_front(lead * processed.channels);
+  }
+
+  if (processed.samples.empty()) {
+    TE_ERROR("Processed buffer is empty after reverb+slowdown");
+    return false;
+  }
+
+  if (options.normalize_loudness) {
+    const core::LoudnessStats loudness =
+        core::normalize_loudness(processed, options.loudness);
+    TE_INFO("loudness: {:.1f} LUFS, true peak {:.1f} dBTP -> target {:.1f} "
+            "LUFS",
+            loudness.integrated_lufs, 20.0 * std::log10(loudness.true_peak),
+            options.loudness.target_lufs);
+  }
+  stats.loudness_ms = elapsed_ms(stage);
+  stats.output_frames = processed.samples.size() / processed.channels;
+
+  TE_INFO("processed: sample_rate={} channels={} frames={}",
+          processed.sample_rate, processed.channels,
+          processed.samples.size() / processed.channels);
+
+  if (!write_output(processed, input, decoder.stream_index(), output, options,
+                    *encoder_))
+    return false;
+  stats.encode_ms = elapsed_ms(stage);
+
+  if (options.waveform_cache)
+    store_peaks(options, output, core::build_peaks(processed));
+  return true;
+}
+
+bool Pipeline::run_resumable(const std::filesystem::path &input,
+                             const std::filesystem::path &output,
+                             PipelineStats &stats) {
+  const PipelineOptions &options = options_;
+  if (options.speed_factor <= 0.0f) {
+    TE_ERROR("Invalid speed factor {}", options.speed_factor);
+    return false;
+  }
+
+  // Каталог на задачу: общий checkpoint_dir годится для нескольких воркеров
+  const uint64_t key = job_key(input, options);
+  const std::filesystem::path dir = checkpoint_path(options, key);
+  const std::filesystem::path state_path = dir / "state";
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+
+  core::Checkpoint ck;
+  if (ck.load(state_path) && ck.job_key == key && ck.stage > kStageNone) {
+    TE_INFO("resuming from checkpoint {}: stage {}, {} frames in", dir.string(),
+            ck.stage, ck.progress);
+  } else {
+    ck = core::Checkpoint{};
+    ck.job_key = key;
+  }
+
+  core::AudioBuffer a{ck.sample_rate, ck.channels, {}};
+  core::AudioBuffer b{ck.sample_rate, ck.channels, {}};
+  if (!core::open_checkpoint_storage(dir / "a.f32", a.samples,
+                                     ck.frames[0] * ck.channels) ||
+      !core::open_checkpoint_storage(dir / "b.f32", b.samples,
+                                     ck.frames[1] * ck.channels)) {
+    TE_ERROR("Failed to open checkpoint files in {}", dir.string());
+    return false;
+  }
+
+  auto stage = Clock::now();
+  auto saved = stage;
+  // Сначала сэмплы, потом состояние: checkpoint не ссылается на то, чего
+  // в файлах ещё нет. Неудача не останавливает задачу.
+  auto save = [&](const core::AudioBuffer &written) {
+    saved = Clock::now();
+    if (!written.samples.sync() || !ck.save(state_path))
+      TE_WARN("Could not write checkpoint to {}", dir.string());
+  };
+  auto due = [&] {
+    return std::chrono::duration<double>(Clock::now() - saved).count() >=
+           options.checkpoint_interval_seconds;
+  };
+  auto finish_stage = [&](uint32_t done, const core::AudioBuffer &written) {
+    ck.stage = done;
+    ck.progress = 0;
+    ck.state.clear();
+    save(written);
+  };
+
+  // Декодер после seek в сжатом потоке не повторяет сэмплы бит в бит, так
+  // что декодирование сохраняется только целиком.
+  const core::DecodeOptions window = preroll_window(options);
+  if (ck.stage < kStageDecoded) {
+    core::AudioDecoder decoder(input, window);
+    if (!decoder.open()) {
+      TE_ERROR("Failed to open decoder for {}", input.string());
+      return false;
+    }
+    a.samples.clear();
+    if (!decoder.decode_to_buffer(a)) {
+      TE_ERROR("Failed to decode audio file {}", input.string());
+      return false;
+    }
+    if (a.sample_rate <= 0 || a.channels <= 0 || a.samples.empty()) {
+      TE_ERROR("Decoded buffer is empty or invalid");
+      return false;
+    }
+    ck.sample_rate = a.sample_rate;
+    ck.channels = a.channels;
+    ck.frames[0] = a.samples.size() / a.channels;
+    finish_stage(kStageDecoded, a);
+    stats.decode_ms = elapsed_ms(stage);
+  }
+
+  const int channels = ck.channels;
+  a.sample_rate = b.sample_rate = ck.sample_rate;
+  a.channels = b.channels = channels;
+  stats.sample_rate = ck.sample_rate;
+  stats.channels = channels;
+
+  // Интерполяции нужен только номер выходного кадра: он и есть фаза
+  if (ck.stage < kStageSlowed) {
+    const size_t in_frames = ck.frames[0];
+    const size_t out_frames =
+        core::speed::output_frames(in_frames, options.speed_factor);
+    const core::speed::Kernel kernel(options.speed_factor,
+                                     options.speed_quality);
+    stats.input_frames = in_frames;
+    b.samples.resize_uninitialized(out_frames * channels);
+    for (size_t first = ck.progress; first < out_frames;
+         first += kResumeBlockFrames) {
+      const size_t count = std::min(kResumeBlockFrames, out_frames - first);
+      kernel.render(a.samples.data(), 0, in_frames, channels, first, count,
+                    b.samples.data() + first * channels);
+      if (due()) {
+        ck.progress = first + count;
+        save(b);
+      }
+    }
+    ck.frames[1] = out_frames;
+    finish_stage(kStageSlowed, b);
+    stats.speed_ms = elapsed_ms(stage);
+  }
+
+  // Линии задержки и их индексы уходят в checkpoint вместе с progress
+  if (ck.stage < kStageReverbed) {
+    const size_t frames = ck.frames[1];
+    auto proc = core::make_reverb_processor(ck.sample_rate, channels,
+                                            options.reverb);
+    if (ck.progress > 0 &&
+        !proc->load_state(ck.state.data(), ck.state.size())) {
+      TE_WARN("Checkpoint reverb state does not match, restarting reverb");
+      ck.progress = 0;
+    }
+    a.samples.resize_uninitialized(frames * channels);
+    for (size_t first = ck.progress; first < frames;
+         first += kResumeBlockFrames) {
+      const size_t count = std::min(kResumeBlockFrames, frames - first);
+      proc->process(b.samples.data() + first * channels,
+                    a.samples.data() + first * channels, count);
+      if (due()) {
+        ck.progress = first + count;
+        ck.state = proc->save_state();
+        save(a);
+      }
+    }
+    if (options.reverb.render_tail) {
+      core::render_tail(*proc, ck.sample_rate, channels, options.reverb,
+                        kResumeTailFrames, [&](const float *block, size_t n) {
+                          const size_t at = a.samples.size();
+                          a.samples.resize_uninitialized(at + n * channels);
+                          std::copy_n(block, n * channels,
+                                      a.samples.data() + at);
+                        });
+    }
+    ck.frames[0] = a.samples.size() / channels;
+    finish_stage(kStageReverbed, a);
+    stats.reverb_ms = elapsed_ms(stage);
+  }
+
+  // Нормализация идёт на месте, поэтому по копии: выход reverb'а остаётся
+  // целым, если задача упадёт посреди неё. Разгон reverb'а отрезается той же
+  // копией.
+  const size_t lead =
+      std::min(preroll_output_frames(options, window, ck.sample_rate,
+                                     options.speed_factor),
+               static_cast<size_t>(ck.frames[0]));
+  const core::AudioBuffer *result = &a;
+  if (options.normalize_loudness || lead > 0) {
+    if (ck.stage < kStageNormalized) {
+      b.samples.resize_uninitialized(a.samples.size() - lead * channels);
+      std::copy(a.samples.begin() + lead * channels, a.samples.end(),
+                b.samples.begin());
+      if (options.normalize_loudness) {
+        const core::LoudnessStats loudness =
+            core::normalize_loudness(b, options.loudness);
+        TE_INFO("loudness: {:.1f} LUFS, true peak {:.1f} dBTP -> target "
+                "{:.1f} LUFS",
+                loudness.integrated_lufs,
+                20.0 * std::log10(loudness.true_peak),
+                options.loudness.target_lufs);
+      }
+      ck.frames[1] = b.samples.size() / channels;
+      finish_stage(kStageNormalized, b);
+      stats.loudness_ms = elapsed_ms(stage);
+    }
+    result = &b;
+  }
+  stats.output_frames = result->samples.size() / channels;
+
+  // Состояние FFmpeg-кодека не сериализуется (резервуар битов MP3, модель
+  // психоакустики), так что кодирование повторяется целиком
+  int stream_index = -1;
+  if (options.keep_video) {
+    core::AudioDecoder probe(input, options.decode);
+    if (!probe.open()) {
+      TE_ERROR("Failed to open decoder for {}", input.string());
+      return false;
+    }
+    stream_index = probe.stream_index();
+  }
+  if (!write_output(*result, input, stream_index, output, options,
+                    *encoder_))
+    return false;
+  stats.encode_ms = elapsed_ms(stage);
+
+  if (options.waveform_cache)
+    store_peaks(options, output, core::build_peaks(*result));
+
+  a.samples.release();
+  b.samples.release();
+  std::filesystem::remove_all(dir, ec);
+  return true;
+}
+
+bool Pipeline::process(const std::filesystem::path &input,
+                       const std::filesystem::path &output,
+                       PipelineStats *stats) {
+  TE_INFO("processing file: {}", input.string());
+  TE_INFO("output file: {}", output.string());
+
+  PipelineStats local;
+  PipelineStats &st = stats ? *stats : local;
+  st = {};
+  const auto started = Clock::now();
+  // Вызывающий поток (GUI-воркер, CLI) — тоже под FTZ/DAZ
+  const core::ScopedFlushDenormals flush_denormals;
+
+  bool ok = false;
+  if (!options_.checkpoint_dir.empty()) {
+    ok = run_resumable(input, output, st);
+  } else if (options_.intermediate == IntermediateFormat::Float32) {
+    ok = run_stages(float_ws_, input, output, st);
+    trim(float_ws_.decoded, options_.keep_workspace);
+    trim(float_ws_.processed, options_.keep_workspace);
+  } else {
+    compact_ws_.decoded.format =
+        options_.intermediate == IntermediateFormat::Int16
+            ? core::CompactFormat::Int16
+            : core::CompactFormat::Half;
+    ok = run_stages(compact_ws_, input, output, st);
+    trim(compact_ws_.decoded, options_.keep_workspace);
+    trim(compact_ws_.processed, options_.keep_workspace);
+  }
+  metrics::record_job(
+      ok, std::chrono::duration<double>(Clock::now() - started).count(),
+      st.input_seconds());
+  if (!ok)
+    return false;
+
+  TE_INFO("Successfully grustnified {}", output.string());
+  return true;
+}
+
+} // namespace app
@@ -0,0 +1,160 @@
+#pragma once
+#include <core/activity.hpp>
+#include <core/audio_buffer.hpp>
+#include <core/audio_decoder.hpp>
+#include <core/compact_buffer.hpp>
+#include <core/loudness.hpp>
+#include <core/peaks.hpp>
+#include <core/video_remux.hpp>
+#include <core/wav_writer.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+namespace core {
+class AudioEncoder;
+}
+
+namespace app {
+
+// Хранение сигнала между этапами: Int16/Half вдвое экономнее по памяти
+// (см. core::CompactFormat о запасе и точности).
+enum class IntermediateFormat { Float32, Int16, Half };
+
+struct PipelineOptions {
+  // Формат и окно декодирования; полный рендер — значения по умолчанию
+  core::DecodeOptions decode;
+  // Окно не с начала файла: декодирование начинается раньше на столько,
+  // reverb разгоняется на этом куске, и он отрезается до нормализации —
+  // хвост звучавшего до окна слышен с первого сэмпла, как в полном рендере
+  double reverb_preroll_seconds = 2.0;
+  float speed_factor = 1.15f;
+  core::SpeedQuality speed_quality = core::SpeedQuality::Linear;
+  core::ReverbParams reverb{0.10f, 0.5f, 0.3f};
+  int bitrate = 128000;
+  // Для выхода .wav: формат сэмплов и O_DIRECT/сброс page cache
+  core::WavOptions wav;
+  // Запись выхода FFmpeg-muxer'ом через io_uring (вход — decode.async_io);
+  // нативный WAV пишет WavWriter и этого не касается
+  bool async_io = false;
+  // EBU R128 нормализация + true-peak лимитер перед кодированием; меняет
+  // громкость выхода (до +max_gain_db), поэтому только по запросу
+  bool normalize_loudness = false;
+  core::LoudnessParams loudness;
+  IntermediateFormat intermediate = IntermediateFormat::Float32;
+  // Держать буферы этапов и открытый кодек между вызовами process()
+  // (долгоживущие воркеры); иначе всё отдаётся сразу после задачи.
+  bool keep_workspace = false;
+  // Видео/субтитры входа копируются в выход пакетами, меняется только звук;
+  // контейнер выхода — по его расширению (см. core::remux_with_audio).
+  bool keep_video = false;
+  core::VideoTimestampPolicy video_timestamps =
+      core::VideoTimestampPolicy::Stretch;
+  // Пирамиды пиков входа и выхода кладутся в кэш по content hash (волна в
+  // GUI); пустой каталог — core::default_peak_cache_dir()
+  bool waveform_cache = false;
+  std::filesystem::path waveform_cache_dir;
+  // Карта тихих блоков строится при декодировании; speed и reverb пропускают
+  // блоки тише silence_dbfs (RMS по блоку), выход в них — нули. По умолчанию
+  // -inf — только цифровая тишина, выход тот же бит в бит. Конечный порог
+  // (--silence-dbfs) — с потерями; рендер с checkpoint'ами тишину не
+  // пропускает вовсе (см. core/activity.hpp)
+  bool skip_silence = true;
+  float silence_dbfs = core::ActivityMap::kSilenceDbfs;
+  // Каталог checkpoint'а: этапы пишут сэмплы в файлы там и периодически
+  // сохраняют состояние, повторный запуск продолжает с последней точки с
+  // тем же результатом. Пусто — без checkpoint'ов. Промежуточные буферы
+  // тогда всегда float.
+  std::filesystem::path checkpoint_dir;
+  double checkpoint_interval_seconds = 60.0; // по часам, не по сигналу
+};
+
+// Фрагмент [start, start + duration) входа в полном качестве (duration 0 —
+// до конца): декодер переходит к окну seek'ом, так что время зависит от
+// длины фрагмента, а не файла. Видео не копируется.
+PipelineOptions excerpt_options(PipelineOptions full, double start_seconds,
+                                double duration_seconds);
+
+// Предпросмотр: тот же фрагмент, но 22.05 кГц стерео и короткий фильтр
+// смены скорости.
+constexpr int kPreviewSampleRate = 22050;
+constexpr int kPreviewChannels = 2;
+constexpr double kPreviewSeconds = 20.0;
+
+PipelineOptions preview_options(PipelineOptions full, double start_seconds,
+                                double duration_seconds = kPreviewSeconds);
+
+// Время этапов последнего process(), мс
+struct PipelineStats {
+  double decode_ms = 0.0;
+  double speed_ms = 0.0;
+  double reverb_ms = 0.0;
+  double loudness_ms = 0.0;
+  double encode_ms = 0.0;
+  int sample_rate = 0;
+  int channels = 0;
+  size_t input_frames = 0;
+  size_t output_frames = 0;
+  // Кадры входа в тихих блоках и кадры, которые speed/reverb заполнили
+  // нулями без обработки
+  size_t silent_input_frames = 0;
+  size_t skipped_speed_frames = 0;
+  size_t skipped_reverb_frames = 0;
+
+  double total_ms() const {
+    return decode_ms + speed_ms + reverb_ms + loudness_ms + encode_ms;
+  }
+  double input_seconds() const {
+    return sample_rate > 0 ? static_cast<double>(input_frames) / sample_rate
+                           : 0.0;
+  }
+};
+
+// song.wav -> song_grustnified.mp3 (рядом с исходным файлом);
+// с keep_extension clip.mkv -> clip_grustnified.mkv (для keep_video)
+std::filesystem::path grustnified_path(const std::filesystem::path &input,
+                                       bool keep_extension = false);
+
+// Пики файла из кэша; промах — декодирование одних пиков (без буфера
+// сэмплов) и запись в кэш. cache_dir пустой — каталог по умолчанию.
+bool waveform_peaks(const std::filesystem::path &file,
+                    const std::filesystem::path &cache_dir,
+                    core::PeakPyramid &out);
+
+// decode -> change_speed -> reverb -> encode, без зависимостей от Qt
+class Pipeline {
+public:
+  explicit Pipeline(PipelineOptions options = {});
+  ~Pipeline();
+
+  bool process(const std::filesystem::path &input,
+               const std::filesystem::path &output,
+               PipelineStats *stats = nullptr);
+
+  const PipelineOptions &options() const { return options_; }
+
+private:
+  // decoded -> change_speed -> processed; reverb и нормализация на месте.
+  // float-путь меняет скорость тоже на месте и обходится одним decoded.
+  template <typename Buffer> struct Workspace {
+    Buffer decoded;
+    Buffer processed;
+  };
+
+  template <typename Buffer>
+  bool run_stages(Workspace<Buffer> &ws, const std::filesystem::path &input,
+                  const std::filesystem::path &output, PipelineStats &stats);
+
+  // То же с checkpoint'ами в options_.checkpoint_dir; этапы пишут из
+  // файла в файл, чтобы прерванный этап можно было повторить
+  bool run_resumable(const std::filesystem::path &input,
+                     const std::filesystem::path &output,
+                     PipelineStats &stats);
+
+  PipelineOptions options_;
+  Workspace<core::AudioBuffer> float_ws_;
+  Workspace<core::CompactAudioBuffer> compact_ws_;
+  std::unique_ptr<core::AudioEncoder> encoder_;
+};
+
+} // namespace app
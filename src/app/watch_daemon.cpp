@@ -0,0 +1,281 @@
+#include "app/watch_daemon.hpp"
+
+#include "core/denormals.hpp"
+#include "log/log.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace app {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::array kAudioExtensions = {".wav", ".flac", ".mp3", ".ogg",
+                                         ".opus", ".m4a", ".aac", ".aif",
+                                         ".aiff", ".wma", ".mka"};
+
+// Скрытые и временные файлы (в т.ч. наши собственные) не трогаем.
+bool is_candidate(const fs::path &path) {
+  const std::string name = path.filename().string();
+  if (name.empty() || name.front() == '.')
+    return false;
+
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return std::find(kAudioExtensions.begin(), kAudioExtensions.end(), ext) !=
+         kAudioExtensions.end();
+}
+
+const metrics::Gauge &queued_files() {
+  static const metrics::Gauge gauge = metrics::registry().gauge(
+      "grustnify_queue_depth", "Jobs waiting for a worker.",
+      {{"queue", "watch"}});
+  return gauge;
+}
+
+} // namespace
+
+std::filesystem::path watch_output_name(const std::filesystem::path &input,
+                                        bool keep_video) {
+  fs::path name = input.filename();
+  name += "_grustnified";
+  name += keep_video && input.has_extension() ? input.extension()
+                                              : fs::path(".mp3");
+  return name;
+}
+
+WatchDaemon::WatchDaemon(WatchOptions options)
+    : options_(std::move(options)), queue_(options_.queue_capacity) {
+  if (options_.output_dir.empty())
+    options_.output_dir = options_.watch_dir / "grustnified";
+  if (options_.workers <= 0)
+    options_.workers =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  options_.pipeline.keep_workspace = true;
+
+  stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+WatchDaemon::~WatchDaemon() {
+  if (inotify_fd_ >= 0)
+    close(inotify_fd_);
+  if (stop_fd_ >= 0)
+    close(stop_fd_);
+}
+
+void WatchDaemon::request_stop() {
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t n = write(stop_fd_, &one, sizeof(one));
+}
+
+bool WatchDaemon::run() {
+  if (stop_fd_ < 0) {
+    TE_ERROR("watch: eventfd failed: {}", std::strerror(errno));
+    return false;
+  }
+
+  std::error_code ec;
+  fs::create_directories(options_.output_dir, ec);
+  if (ec) {
+    TE_ERROR("watch: cannot create {}: {}", options_.output_dir.string(),
+             ec.message());
+    return false;
+  }
+  // Опубликованный результат — IN_MOVED_TO в том же каталоге: каждый
+  // *_grustnified.mp3 обрабатывался бы снова, без конца
+  if (fs::equivalent(options_.watch_dir, options_.output_dir, ec)) {
+    TE_ERROR("watch: output dir {} must differ from the watched dir",
+             options_.output_dir.string());
+    return false;
+  }
+
+  inotify_fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if (inotify_fd_ < 0) {
+    TE_ERROR("watch: inotify_init1 failed: {}", std::strerror(errno));
+    return false;
+  }
+  if (inotify_add_watch(inotify_fd_, options_.watch_dir.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+    TE_ERROR("watch: cannot watch {}: {}", options_.watch_dir.string(),
+             std::strerror(errno));
+    return false;
+  }
+
+  TE_INFO("watching {} -> {} ({} workers, queue {})",
+          options_.watch_dir.string(), options_.output_dir.string(),
+          options_.workers, queue_.capacity());
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < options_.workers; ++i)
+    workers.emplace_back([this, i] { worker_loop(i); });
+  std::thread watcher([this] { watch_loop(); });
+
+  // Ждём сигнала остановки; eventfd не вычитываем, чтобы watch_loop тоже
+  // его увидел.
+  pollfd stop{stop_fd_, POLLIN, 0};
+  while (poll(&stop, 1, -1) < 0 && errno == EINTR) {
+  }
+
+  // Задачи в очереди бросаем: их выходных файлов нет, и при следующем
+  // запуске scan_existing() поставит их снова. Текущие доделываются.
+  stopping_ = true;
+  queue_.close();
+  watcher.join();
+  for (std::thread &t : workers)
+    t.join();
+
+  TE_INFO("watch: stopped, {} done, {} failed", jobs_done_.load(),
+          jobs_failed_.load());
+  return true;
+}
+
+void WatchDaemon::watch_loop() {
+  // Сначала watch, потом скан: файл, закрытый между ними, придёт дважды,
+  // но не потеряется (дубликаты отсекает pending_).
+  scan_existing();
+
+  alignas(inotify_event) char events[16 * 1024];
+  pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+
+  while (!stopping_) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      TE_ERROR("watch: poll failed: {}", std::strerror(errno));
+      return;
+    }
+    if (fds[1].revents & POLLIN)
+      return;
+
+    const ssize_t len = read(inotify_fd_, events, sizeof(events));
+    if (len <= 0)
+      continue;
+
+    for (ssize_t off = 0; off < len;) {
+      const auto *ev = reinterpret_cast<const inotify_event *>(events + off);
+      off += sizeof(inotify_event) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {
+        TE_WARN("watch: inotify queue overflow, rescanning");
+        scan_existing();
+      } else if (ev->len > 0 && !(ev->mask & IN_ISDIR)) {
+        enqueue(options_.watch_dir / ev->name);
+      }
+      if (stopping_)
+        return;
+    }
+  }
+}
+
+void WatchDaemon::scan_existing() {
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(options_.watch_dir, ec)) {
+    if (stopping_)
+      return;
+    if (!entry.is_regular_file(ec) || !is_candidate(entry.path()))
+      continue;
+
+    // Уже обработанные (выход новее входа) пропускаем.
+    const fs::path out =
+        options_.output_dir /
+        watch_output_name(entry.path(), options_.pipeline.keep_video);
+    std::error_code out_ec;
+    const auto out_time = fs::last_write_time(out, out_ec);
+    if (!out_ec && out_time >= entry.last_write_time(ec))
+      continue;
+
+    enqueue(entry.path());
+  }
+}
+
+void WatchDaemon::enqueue(const fs::path &input) {
+  if (!is_candidate(input))
+    return;
+  {
+    std::lock_guard lock(pending_mutex_);
+    if (!pending_.insert(input).second)
+      return;
+  }
+  // Блокирует при полной очереди — это и есть backpressure.
+  queued_files().add(1);
+  if (!queue_.push(input)) {
+    queued_files().add(-1);
+    std::lock_guard lock(pending_mutex_);
+    pending_.erase(input);
+  }
+}
+
+void WatchDaemon::worker_loop(int id) {
+  const core::ScopedFlushDenormals flush_denormals;
+  Pipeline pipeline(options_.pipeline);
+  while (auto input = queue_.pop()) {
+    queued_files().add(-1);
+    {
+      // Файл, перезаписанный во время обработки, встанет в очередь снова.
+      std::lock_guard lock(pending_mutex_);
+      pending_.erase(*input);
+    }
+    if (stopping_)
+      continue;
+
+    if (process_one(pipeline, id, *input))
+      ++jobs_done_;
+    else
+      ++jobs_failed_;
+  }
+}
+
+bool WatchDaemon::process_one(Pipeline &pipeline, int id,
+                              const fs::path &input) {
+  std::error_code ec;
+  if (!fs::is_regular_file(input, ec)) {
+    TE_WARN("watch: {} disappeared before processing", input.string());
+    return false;
+  }
+
+  const fs::path final_path =
+      options_.output_dir /
+      watch_output_name(input, options_.pipeline.keep_video);
+  // Скрытое имя в том же каталоге: rename() атомарен, расширение .mp3
+  // оставлено, чтобы энкодер выбрал тот же muxer.
+  fs::path temp_name = ".";
+  temp_name += final_path.stem();
+  temp_name += ".tmp" + std::to_string(id);
+  temp_name += final_path.extension();
+  const fs::path temp_path = options_.output_dir / temp_name;
+
+  if (!pipeline.process(input, temp_path)) {
+    fs::remove(temp_path, ec);
+    TE_ERROR("watch: failed {}", input.string());
+    return false;
+  }
+
+  fs::rename(temp_path, final_path, ec);
+  if (ec) {
+    TE_ERROR("watch: cannot publish {}: {}", final_path.string(),
+             ec.message());
+    fs::remove(temp_path, ec);
+    return false;
+  }
+
+  TE_INFO("watch: [{}] {} -> {}", id, input.filename().string(),
+          final_path.string());
+  return true;
+}
+
+} // namespace app
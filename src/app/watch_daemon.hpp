@@ -0,0 +1,74 @@
+#pragma once
+#include "app/bounded_queue.hpp"
+#include "app/pipeline.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+
+namespace app {
+
+struct WatchOptions {
+  std::filesystem::path watch_dir;
+  // Пусто -> watch_dir / "grustnified" (вне наблюдения: inotify не
+  // рекурсивен). Сам watch_dir не допускается: run() вернёт false
+  std::filesystem::path output_dir;
+  int workers = 0; // 0 -> число ядер
+  // Сколько файлов ждут воркера; дальше поток inotify ждёт сам, а события
+  // копятся в очереди ядра (при переполнении каталог пересканируется).
+  size_t queue_capacity = 64;
+  PipelineOptions pipeline;
+};
+
+// Имя результата в output_dir: song.flac -> song.flac_grustnified.mp3 (с
+// keep_video clip.mkv -> clip.mkv_grustnified.mkv). Расширение входа остаётся
+// в имени: song.wav и song.flac из одного каталога иначе публиковались бы в
+// один файл, и второй молча затирал бы первый.
+std::filesystem::path watch_output_name(const std::filesystem::path &input,
+                                        bool keep_video);
+
+// Долгоживущий режим: файлы, дописанные в watch_dir (IN_CLOSE_WRITE) или
+// перемещённые туда (IN_MOVED_TO), обрабатываются пулом воркеров. Каждый
+// воркер держит свой Pipeline с буферами этапов и открытым кодеком между
+// задачами. Результат пишется во временный скрытый файл и
+// переименовывается, так что потребители output_dir никогда не видят
+// недописанный mp3. Только Linux.
+class WatchDaemon {
+public:
+  explicit WatchDaemon(WatchOptions options);
+  ~WatchDaemon();
+
+  WatchDaemon(const WatchDaemon &) = delete;
+  WatchDaemon &operator=(const WatchDaemon &) = delete;
+
+  // Блокирует до request_stop(); false, если наблюдение не запустилось.
+  bool run();
+  // Async-signal-safe: можно вызывать из обработчика SIGINT/SIGTERM.
+  void request_stop();
+
+  uint64_t jobs_done() const { return jobs_done_; }
+  uint64_t jobs_failed() const { return jobs_failed_; }
+
+private:
+  void watch_loop();
+  void worker_loop(int id);
+  void scan_existing();
+  void enqueue(const std::filesystem::path &input);
+  bool process_one(Pipeline &pipeline, int id,
+                   const std::filesystem::path &input);
+
+  WatchOptions options_;
+  BoundedQueue<std::filesystem::path> queue_;
+  std::mutex pending_mutex_;
+  std::set<std::filesystem::path> pending_; // в очереди, но ещё не взяты
+
+  int inotify_fd_ = -1;
+  int stop_fd_ = -1; // eventfd, взводится request_stop()
+  std::atomic<bool> stopping_{false};
+  std::atomic<uint64_t> jobs_done_{0};
+  std::atomic<uint64_t> jobs_failed_{0};
+};
+
+} // namespace app
@@ -0,0 +1,113 @@
+#include "core/activity.hpp"
+
+#include "core/simd.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace core {
+
+bool ActivityMap::any_active(size_t first, size_t last) const {
+  last = std::min(last, frames);
+  if (first >= last)
+    return false;
+  const size_t b0 = first / kBlockFrames;
+  const size_t b1 = (last + kBlockFrames - 1) / kBlockFrames;
+  return std::any_of(active.begin() + b0, active.begin() + b1,
+                     [](uint8_t a) { return a != 0; });
+}
+
+size_t ActivityMap::silent_frames() const {
+  size_t silent = 0;
+  for (size_t b = 0; b < active.size(); ++b) {
+    if (!active[b])
+      silent += std::min(kBlockFrames, frames - b * kBlockFrames);
+  }
+  return silent;
+}
+
+std::vector<std::pair<size_t, size_t>>
+ActivityMap::silent_ranges(size_t min_frames) const {
+  std::vector<std::pair<size_t, size_t>> ranges;
+  for (size_t b = 0; b < active.size();) {
+    if (active[b]) {
+      ++b;
+      continue;
+    }
+    const size_t first = b * kBlockFrames;
+    while (b < active.size() && !active[b])
+      ++b;
+    const size_t last = std::min(b * kBlockFrames, frames);
+    if (last - first >= min_frames)
+      ranges.emplace_back(first, last);
+  }
+  return ranges;
+}
+
+ActivityBuilder::ActivityBuilder(float silence_dbfs)
+    : threshold_sq_(std::pow(10.0, silence_dbfs / 10.0)) {}
+
+void ActivityBuilder::start(int channels) {
+  map_ = ActivityMap{};
+  channels_ = channels;
+  block_frames_ = 0;
+  block_energy_ = 0.0;
+  block_active_ = false;
+}
+
+void ActivityBuilder::add(const float *frames, size_t count) {
+  if (channels_ <= 0)
+    return;
+
+  // Блок заведомо громче порога, если энергия уже выше порога для полного
+  // блока; короткий последний блок добирает проверку в close_block()
+  const double full_block = threshold_sq_ *
+                            static_cast<double>(ActivityMap::kBlockFrames) *
+                            channels_;
+  while (count > 0) {
+    const size_t take =
+        std::min(count, ActivityMap::kBlockFrames - block_frames_);
+    const size_t n = take * channels_;
+    if (!block_active_) {
+      if (threshold_sq_ > 0.0) {
+        block_energy_ += simd::sum_squares(frames, n);
+        block_active_ = block_energy_ > full_block;
+      } else {
+        // Квадраты крошечных отсчётов уходят в ноль — сравниваем сами
+        // отсчёты
+        block_active_ = simd::peak_abs(frames, n) > 0.0f;
+      }
+    }
+
+    block_frames_ += take;
+    map_.frames += take;
+    frames += n;
+    count -= take;
+    if (block_frames_ == ActivityMap::kBlockFrames)
+      close_block();
+  }
+}
+
+void ActivityBuilder::close_block() {
+  const double samples = static_cast<double>(block_frames_) * channels_;
+  map_.active.push_back(block_active_ ||
+                        block_energy_ > threshold_sq_ * samples);
+  block_frames_ = 0;
+  block_energy_ = 0.0;
+  block_active_ = false;
+}
+
+ActivityMap ActivityBuilder::finish() {
+  if (block_frames_ > 0)
+    close_block();
+  return std::move(map_);
+}
+
+ActivityMap build_activity(const float *frames, size_t count, int channels,
+                           float silence_dbfs) {
+  ActivityBuilder builder(silence_dbfs);
+  builder.start(channels);
+  builder.add(frames, count);
+  return builder.finish();
+}
+
+} // namespace core
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Карта активности для длинных записей с паузами (лекции, подкасты, полевые
+// записи): по флагу на блок из kBlockFrames кадров. По умолчанию (порог
+// -inf) тихие только блоки из точных нулей, и выход совпадает с полной
+// обработкой бит в бит. С конечным порогом (например, kNoiseFloorDbfs)
+// тихим считается блок, RMS которого по всем каналам не выше порога: шум
+// АЦП, дизер и остатки декодера между фразами. DSP обрабатывает такой блок
+// как нулевой, и результат отличается от полной обработки не больше чем на
+// этот порог.
+namespace core {
+
+struct ActivityMap {
+  static constexpr std::size_t kBlockFrames = 1024;
+  static constexpr float kSilenceDbfs =
+      -std::numeric_limits<float>::infinity();
+  static constexpr float kNoiseFloorDbfs = -90.0f; // --silence-dbfs
+
+  std::size_t frames = 0;
+  std::vector<uint8_t> active; // 1 — блок громче порога
+
+  bool empty() const { return active.empty(); }
+  // Есть ли активные блоки среди кадров [first, last)
+  bool any_active(std::size_t first, std::size_t last) const;
+  std::size_t silent_frames() const;
+  // Тихие участки [first, last) в кадрах не короче min_frames
+  std::vector<std::pair<std::size_t, std::size_t>>
+  silent_ranges(std::size_t min_frames = 0) const;
+};
+
+// Однопроходная сборка, как у PeakBuilder: кадры подаются блоками любого
+// размера, на каждый блок карты — одна SIMD-сумма квадратов (блок, уже
+// набравший энергию выше порога, дальше не проверяется).
+class ActivityBuilder {
+public:
+  explicit ActivityBuilder(float silence_dbfs = ActivityMap::kSilenceDbfs);
+
+  void start(int channels);
+  void add(const float *frames, std::size_t count);
+  ActivityMap finish();
+
+private:
+  void close_block();
+
+  ActivityMap map_;
+  double threshold_sq_; // порог RMS в квадрате; 0 — только точные нули
+  int channels_ = 0;
+  std::size_t block_frames_ = 0; // кадров в текущем блоке
+  double block_energy_ = 0.0;    // сумма квадратов отсчётов блока
+  bool block_active_ = false;
+};
+
+ActivityMap build_activity(const float *frames, std::size_t count,
+                           int channels,
+                           float silence_dbfs = ActivityMap::kSilenceDbfs);
+
+} // namespace core
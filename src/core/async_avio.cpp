@@ -0,0 +1,120 @@
+#include "core/async_avio.hpp"
+
+#include "core/uring_file.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace core {
+
+namespace {
+
+// Буфер самого AVIOContext: крупные чанки держит core::aio, здесь хватит
+// обычного размера
+constexpr int kAvioBufferBytes = 64 * 1024;
+
+struct AsyncFile {
+  std::unique_ptr<aio::PrefetchReader> reader;
+  std::unique_ptr<aio::WriteBehind> writer;
+};
+
+int read_packet(void *opaque, uint8_t *buf, int size) {
+  auto *file = static_cast<AsyncFile *>(opaque);
+  const int64_t n = file->reader->read(buf, static_cast<std::size_t>(size));
+  if (n == 0)
+    return AVERROR_EOF;
+  return n < 0 ? AVERROR(static_cast<int>(-n)) : static_cast<int>(n);
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int write_packet(void *opaque, const uint8_t *buf, int size) {
+#else
+int write_packet(void *opaque, uint8_t *buf, int size) {
+#endif
+  auto *file = static_cast<AsyncFile *>(opaque);
+  const int64_t n = file->writer->write(buf, static_cast<std::size_t>(size));
+  return n < 0 ? AVERROR(static_cast<int>(-n)) : static_cast<int>(n);
+}
+
+int64_t seek(void *opaque, int64_t offset, int whence) {
+  auto *file = static_cast<AsyncFile *>(opaque);
+  const int64_t size =
+      file->reader ? file->reader->size() : file->writer->size();
+  if (whence & AVSEEK_SIZE)
+    return size;
+
+  const int64_t current =
+      file->reader ? file->reader->tell() : file->writer->tell();
+  switch (whence & ~AVSEEK_FORCE) {
+  case SEEK_SET:
+    break;
+  case SEEK_CUR:
+    offset += current;
+    break;
+  case SEEK_END:
+    offset += size;
+    break;
+  default:
+    return AVERROR(EINVAL);
+  }
+  const int64_t pos = file->reader ? file->reader->seek(offset)
+                                   : file->writer->seek(offset);
+  return pos < 0 ? AVERROR(static_cast<int>(-pos)) : pos;
+}
+
+AVIOContext *wrap(std::unique_ptr<AsyncFile> file, bool write) {
+  auto *buffer = static_cast<uint8_t *>(av_malloc(kAvioBufferBytes));
+  if (!buffer)
+    return nullptr;
+  AVIOContext *pb =
+      avio_alloc_context(buffer, kAvioBufferBytes, write ? 1 : 0, file.get(),
+                         write ? nullptr : read_packet,
+                         write ? write_packet : nullptr, seek);
+  if (!pb) {
+    av_free(buffer);
+    return nullptr;
+  }
+  file.release(); // теперь владеет pb->opaque
+  return pb;
+}
+
+} // namespace
+
+AVIOContext *open_async_input(const std::filesystem::path &path) {
+  auto file = std::make_unique<AsyncFile>();
+  file->reader = aio::PrefetchReader::open(path);
+  if (!file->reader)
+    return nullptr;
+  return wrap(std::move(file), false);
+}
+
+AVIOContext *open_async_output(const std::filesystem::path &path) {
+  auto file = std::make_unique<AsyncFile>();
+  file->writer = aio::WriteBehind::open(path);
+  if (!file->writer)
+    return nullptr;
+  return wrap(std::move(file), true);
+}
+
+bool close_async_avio(AVIOContext **pb) {
+  if (!pb || !*pb)
+    return true;
+  std::unique_ptr<AsyncFile> file(static_cast<AsyncFile *>((*pb)->opaque));
+  bool ok = true;
+  if (file->writer) {
+    avio_flush(*pb);
+    ok = (*pb)->error == 0 && file->writer->close();
+  }
+  av_freep(&(*pb)->buffer);
+  avio_context_free(pb);
+  return ok;
+}
+
+} // namespace core
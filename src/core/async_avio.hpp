@@ -0,0 +1,20 @@
+#pragma once
+#include <filesystem>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+// AVIOContext поверх core::aio: demuxer читает из чанков, уже прочитанных
+// вперёд, muxer пишет в буферы, которые уходят в io_uring без ожидания.
+// Открытие возвращает nullptr, если io_uring недоступен, — тогда остаётся
+// обычный file-протокол FFmpeg.
+namespace core {
+
+AVIOContext *open_async_input(const std::filesystem::path &path);
+AVIOContext *open_async_output(const std::filesystem::path &path);
+// Дописывает буфер, закрывает файл и освобождает контекст; *pb = nullptr.
+// false — была ошибка записи.
+bool close_async_avio(AVIOContext **pb);
+
+} // namespace core
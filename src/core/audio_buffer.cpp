@@ -1,161 +1,227 @@
 #include "core/audio_buffer.hpp"
+#include "core/activity.hpp"
+#include "core/reverb_kernel.hpp"
+#include "core/speed_kernel.hpp"
+#include "metrics/metrics.hpp"
 #include <algorithm>
-#include <array>
-#include <cmath>
+#include <cstddef>
+#include <utility>
 #include <vector>
 namespace core {
 
-AudioBuffer change_speed(const AudioBuffer &in, float speed_factor) {
+namespace {
+constexpr size_t kTailBlockFrames = 4096;
+}
+
+size_t change_speed(const AudioBuffer &in, float speed_factor,
+                    AudioBuffer &out, const ActivityMap *activity,
+                    ActivityMap *out_activity, SpeedQuality quality) {
   // speed_factor > 1.0 => медленнее и ниже тон
   // speed_factor < 1.0 => быстрее и выше тон
 
-  AudioBuffer out;
   out.sample_rate = in.sample_rate;
   out.channels = in.channels;
+  out.samples.clear();
+  if (out_activity)
+    *out_activity = ActivityMap{};
 
   if (speed_factor <= 0.0f || in.channels <= 0 || in.samples.empty()) {
-    return out;
+    return 0;
   }
 
+  const metrics::StageTimer timer(metrics::Stage::Speed);
   const int channels = in.channels;
   const std::size_t in_frames = in.samples.size() / channels;
-  const std::size_t out_frames =
-      static_cast<std::size_t>(in_frames * speed_factor);
-
-  out.samples.resize(out_frames * channels);
-
-  for (std::size_t n = 0; n < out_frames; ++n) {
-    float in_pos = static_cast<float>(n) / speed_factor;
-
-    std::size_t i0 = static_cast<std::size_t>(in_pos);
-    float frac = in_pos - static_cast<float>(i0);
-
-    if (i0 >= in_frames - 1) {
-      i0 = in_frames - 1;
-      frac = 0.0f;
-    }
-
-    std::size_t i1 = (i0 + 1 < in_frames) ? (i0 + 1) : i0;
-
-    for (int ch = 0; ch < channels; ++ch) {
-      float s0 = in.samples[i0 * channels + ch];
-      float s1 = in.samples[i1 * channels + ch];
-      float s = s0 + (s1 - s0) * frac;
+  const std::size_t out_frames = speed::output_frames(in_frames, speed_factor);
+  const speed::Kernel kernel(speed_factor, quality);
+
+  out.samples.resize_uninitialized(out_frames * channels);
+  if (!activity || activity->frames != in_frames) {
+    kernel.render(in.samples.data(), 0, in_frames, channels, 0, out_frames,
+                  out.samples.data());
+    timer.done(out_frames);
+    return 0;
+  }
 
-      out.samples[n * channels + ch] = s;
+  // Свёртка нулей — ноль: блок, читающий только тихий (не громче порога
+  // карты) вход, заполняется нулями без render()
+  size_t skipped = 0;
+  for (size_t first = 0; first < out_frames;
+       first += ActivityMap::kBlockFrames) {
+    const size_t count =
+        std::min(ActivityMap::kBlockFrames, out_frames - first);
+    const size_t begin = kernel.input_begin(first, in_frames);
+    const size_t end = kernel.input_end(first + count - 1, in_frames);
+    float *dst = out.samples.data() + first * channels;
+    const bool active = activity->any_active(begin, end);
+    if (active) {
+      kernel.render(in.samples.data(), 0, in_frames, channels, first, count,
+                    dst);
+    } else {
+      std::fill_n(dst, count * channels, 0.0f);
+      skipped += count;
     }
+    if (out_activity)
+      out_activity->active.push_back(active);
   }
-
-  return out;
+  if (out_activity)
+    out_activity->frames = out_frames;
+  timer.done(out_frames, skipped);
+  return skipped;
 }
 
-AudioBuffer reverb(const AudioBuffer &in, const ReverbParams &p) {
-  AudioBuffer out;
+size_t reverb(const AudioBuffer &in, const ReverbParams &p, AudioBuffer &out,
+              const ActivityMap *activity) {
   out.sample_rate = in.sample_rate;
   out.channels = in.channels;
 
   if (in.sample_rate <= 0 || in.channels <= 0 || in.samples.empty()) {
-    return out;
+    out.samples.clear();
+    return 0;
   }
 
-  const int sr = in.sample_rate;
+  const metrics::StageTimer timer(metrics::Stage::Reverb);
   const int channels = in.channels;
   const size_t frames = in.samples.size() / channels;
-
-  out.samples.resize(in.samples.size());
-
-  float mix = std::clamp(p.mix, 0.0f, 1.0f);
-  float room_size = std::clamp(p.room_size, 0.0f, 1.0f);
-  float damp = std::clamp(p.damp, 0.0f, 1.0f);
-
-  const float dry = 1.0f - mix;
-  const float wet = mix;
-
-  constexpr int NUM_COMBS = 4;
-  constexpr int NUM_ALLPASSES = 2;
-
-  const float comb_delays_ms[NUM_COMBS] = {29.7f, 37.1f, 41.1f, 43.7f};
-  const float allpass_delays_ms[NUM_ALLPASSES] = {5.0f, 1.7f};
-
-  const float base_feedback = 0.75f;
-  const float feedback = base_feedback + room_size * 0.2f; // ~0.75..0.95
-
-  const float allpass_gain = 0.5f;
-
-  std::vector<float> in_ch(frames);
-  std::vector<float> out_ch(frames);
-
-  for (int ch = 0; ch < channels; ++ch) {
-
-    for (size_t n = 0; n < frames; ++n) {
-      in_ch[n] = in.samples[n * channels + ch];
+  out.samples.resize_uninitialized(in.samples.size());
+  if (activity && activity->frames != frames)
+    activity = nullptr;
+
+  // 4 параллельных comb'а + 2 последовательных allpass'а на каждый канал;
+  // для типичных (каналы, частота) ядро специализировано на этапе компиляции.
+  // С картой активности вход идёт блоками, чтобы пропускать тишину.
+  auto proc = make_reverb_processor(in.sample_rate, channels, p);
+  SilenceSkip silence(activity);
+  const size_t step = activity ? ActivityMap::kBlockFrames : frames;
+  size_t skipped = 0;
+  for (size_t first = 0; first < frames; first += step) {
+    const size_t count = std::min(step, frames - first);
+    const size_t n = count * channels;
+    float *dst = out.samples.data() + first * channels;
+    if (silence.skip(*proc, first, count)) {
+      std::fill_n(dst, n, 0.0f);
+      skipped += count;
+      continue;
     }
+    proc->process(in.samples.data() + first * channels, dst, count);
+    silence.processed(dst, n);
+  }
 
-    std::array<std::vector<float>, NUM_COMBS> comb_buffers;
-    std::array<size_t, NUM_COMBS> comb_indices{};
-
-    for (int i = 0; i < NUM_COMBS; ++i) {
-      int delay_samples = static_cast<int>(comb_delays_ms[i] * 0.001f * sr);
-      delay_samples = std::max(delay_samples, 1);
-      comb_buffers[i].assign(delay_samples, 0.0f);
-      comb_indices[i] = 0;
-    }
+  if (p.render_tail) {
+    render_tail(*proc, in.sample_rate, channels, p, kTailBlockFrames,
+                [&](const float *block, size_t n) {
+                  const size_t at = out.samples.size();
+                  out.samples.resize_uninitialized(at + n * out.channels);
+                  std::copy_n(block, n * out.channels,
+                              out.samples.data() + at);
+                });
+  }
+  timer.done(out.samples.size() / channels, skipped);
+  return skipped;
+}
 
-    std::array<std::vector<float>, NUM_ALLPASSES> allpass_buffers;
-    std::array<size_t, NUM_ALLPASSES> allpass_indices{};
+AudioBuffer change_speed(AudioBuffer &&buffer, float speed_factor,
+                         const ActivityMap *activity,
+                         ActivityMap *out_activity, SpeedQuality quality) {
+  if (out_activity)
+    *out_activity = ActivityMap{};
+  if (speed_factor <= 0.0f || buffer.channels <= 0 || buffer.samples.empty()) {
+    buffer.samples.clear();
+    return std::move(buffer);
+  }
 
-    for (int i = 0; i < NUM_ALLPASSES; ++i) {
-      int delay_samples = static_cast<int>(allpass_delays_ms[i] * 0.001f * sr);
-      delay_samples = std::max(delay_samples, 1);
-      allpass_buffers[i].assign(delay_samples, 0.0f);
-      allpass_indices[i] = 0;
+  const metrics::StageTimer timer(metrics::Stage::Speed);
+  const int channels = buffer.channels;
+  const size_t in_frames = buffer.samples.size() / channels;
+  const size_t out_frames = speed::output_frames(in_frames, speed_factor);
+  const speed::Kernel kernel(speed_factor, quality);
+  if (activity && activity->frames != in_frames)
+    activity = nullptr;
+
+  // Замедление пишет кадр n из кадров около n / speed <= n, ускорение — из
+  // n / speed >= n. Первое идёт блоками с конца, второе с начала, и блок
+  // выхода ложится только на уже прочитанный вход. Где это нарушают
+  // округление или длина фильтра (speed почти 1) — обычная копия.
+  constexpr size_t kBlock = ActivityMap::kBlockFrames;
+  const size_t blocks = (out_frames + kBlock - 1) / kBlock;
+  const bool backward = speed_factor > 1.0f;
+  for (size_t b = 0; b < blocks; ++b) {
+    const size_t first = b * kBlock;
+    const size_t count = std::min(kBlock, out_frames - first);
+    const bool fits =
+        backward
+            ? kernel.input_end(first + count - 1, in_frames) <= first + count
+            : kernel.input_begin(first, in_frames) >= first;
+    if (!fits) {
+      AudioBuffer out;
+      change_speed(buffer, speed_factor, out, activity, out_activity,
+                   quality);
+      return out;
     }
+  }
 
-    for (size_t n = 0; n < frames; ++n) {
-      float x = in_ch[n];
-
-      float comb_sum = 0.0f;
-      for (int i = 0; i < NUM_COMBS; ++i) {
-        auto &buf = comb_buffers[i];
-        auto &idx = comb_indices[i];
-
-        float y = buf[idx];
-        buf[idx] = x + y * feedback * (1.0f - damp);
-
-        idx++;
-        if (idx >= buf.size())
-          idx = 0;
-
-        comb_sum += y;
-      }
-
-      float ap = comb_sum;
-      for (int i = 0; i < NUM_ALLPASSES; ++i) {
-        auto &buf = allpass_buffers[i];
-        auto &idx = allpass_indices[i];
-
-        float buf_y = buf[idx];
-        float v = ap - buf_y;
-        buf[idx] = ap + buf_y * allpass_gain;
-
-        idx++;
-        if (idx >= buf.size())
-          idx = 0;
+  if (out_frames > in_frames)
+    buffer.samples.resize_uninitialized(out_frames * channels);
+  float *data = buffer.samples.data();
+  if (out_activity && activity)
+    out_activity->active.resize(blocks);
+
+  // Блок рендерится в scratch: его окно входа цело, пока читается
+  std::vector<float> scratch(kBlock * channels);
+  size_t skipped = 0;
+  for (size_t i = 0; i < blocks; ++i) {
+    const size_t b = backward ? blocks - 1 - i : i;
+    const size_t first = b * kBlock;
+    const size_t count = std::min(kBlock, out_frames - first);
+    float *dst = data + first * channels;
+    const bool active =
+        !activity ||
+        activity->any_active(kernel.input_begin(first, in_frames),
+                             kernel.input_end(first + count - 1, in_frames));
+    if (active) {
+      kernel.render(data, 0, in_frames, channels, first, count,
+                    scratch.data());
+      std::copy_n(scratch.data(), count * channels, dst);
+    } else {
+      std::fill_n(dst, count * channels, 0.0f);
+      skipped += count;
+    }
+    if (out_activity && activity)
+      out_activity->active[b] = active;
+  }
+  if (out_activity && activity)
+    out_activity->frames = out_frames;
 
-        ap = v;
-      }
+  buffer.samples.resize_uninitialized(out_frames * channels);
+  timer.done(out_frames, skipped);
+  return std::move(buffer);
+}
 
-      float wet_sample = ap;
-      float dry_sample = x;
+AudioBuffer reverb(AudioBuffer &&buffer, const ReverbParams &p) {
+  reverb(buffer, p, buffer);
+  return std::move(buffer);
+}
 
-      out_ch[n] = dry * dry_sample + wet * wet_sample;
-    }
+void reverb_inplace(AudioView view, const ReverbParams &p) {
+  if (!view.data || view.sample_rate <= 0 || view.channels <= 0 ||
+      view.frames == 0)
+    return;
+  const metrics::StageTimer timer(metrics::Stage::Reverb);
+  make_reverb_processor(view.sample_rate, view.channels, p)
+      ->process(view.data, view.data, view.frames);
+  timer.done(view.frames);
+}
 
-    for (size_t n = 0; n < frames; ++n) {
-      out.samples[n * channels + ch] = out_ch[n];
-    }
-  }
+AudioBuffer change_speed(const AudioBuffer &in, float speed_factor,
+                         SpeedQuality quality) {
+  AudioBuffer out;
+  change_speed(in, speed_factor, out, nullptr, nullptr, quality);
+  return out;
+}
 
+AudioBuffer reverb(const AudioBuffer &in, const ReverbParams &p) {
+  AudioBuffer out;
+  reverb(in, p, out);
   return out;
 }
 
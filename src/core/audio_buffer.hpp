@@ -1,17 +1,83 @@
 #pragma once
-#include <vector>
+#include <core/sample_storage.hpp>
+#include <cstddef>
 namespace core {
+struct ActivityMap;
+
 struct AudioBuffer {
   int sample_rate;
   int channels;
-  std::vector<float> samples;
+  // interleaved float; крупные буферы уходят в mmap (см. StorageConfig)
+  SampleStorage samples;
 };
 
+// Schroeder — 4 comb'а + 2 allpass'а (как раньше); Fdn8/Fdn16 — сеть
+// задержек с обратной связью через матрицу Адамара: хвост плотнее и без
+// «металла» на большом room_size. Fdn8 дешевле Schroeder'а на сэмпл,
+// Fdn16 — примерно в полтора раза дороже.
+enum class ReverbAlgorithm { Schroeder, Fdn8, Fdn16 };
+
 struct ReverbParams {
   float mix = 0.3f;
   float room_size = 0.8f;
   float damp = 0.3f;
+  ReverbAlgorithm algorithm = ReverbAlgorithm::Schroeder;
+  // Хвост после конца входа: выход длиннее входа, рендер останавливается,
+  // когда все линии задержки тише tail_threshold (или через
+  // tail_max_seconds). Без него хвост обрезается вместе со входом.
+  bool render_tail = false;
+  float tail_threshold = 1e-5f; // -100 dBFS
+  float tail_max_seconds = 30.0f;
 };
-AudioBuffer change_speed(const core::AudioBuffer &buffer, float speed_factor);
+
+// Интерполяция change_speed. Linear (по умолчанию) — два соседних отсчёта,
+// как раньше: дёшево, но зеркала спектра и алиасинг слышны на высоких.
+// Остальные — полифазный windowed-sinc на 16/32/64 отсчёта
+// (см. core/speed_kernel.hpp), выбираются явно.
+enum class SpeedQuality { Linear, Fast, Balanced, Best };
+
+AudioBuffer change_speed(const core::AudioBuffer &buffer, float speed_factor,
+                         SpeedQuality quality = SpeedQuality::Linear);
 AudioBuffer reverb(const core::AudioBuffer &buffer, const ReverbParams &p);
+
+// Невладеющий вид на interleaved float: обработка на месте чужой памяти
+// (mmap, буфер плеера) без AudioBuffer.
+struct AudioView {
+  float *data = nullptr;
+  std::size_t frames = 0;
+  int channels = 0;
+  int sample_rate = 0;
+};
+
+inline AudioView view_of(AudioBuffer &buffer) {
+  return {buffer.samples.data(),
+          buffer.channels > 0 ? buffer.samples.size() / buffer.channels : 0,
+          buffer.channels, buffer.sample_rate};
+}
+
+// На месте, без второй копии сигнала. rvalue-варианты обрабатывают память
+// переданного буфера и возвращают её же; change_speed растит или
+// укорачивает его (карты активности — как у вариантов ниже). Вид не растёт,
+// поэтому reverb_inplace хвост не рендерит.
+AudioBuffer change_speed(core::AudioBuffer &&buffer, float speed_factor,
+                         const ActivityMap *activity = nullptr,
+                         ActivityMap *out_activity = nullptr,
+                         SpeedQuality quality = SpeedQuality::Linear);
+AudioBuffer reverb(core::AudioBuffer &&buffer, const ReverbParams &p);
+void reverb_inplace(AudioView view, const ReverbParams &p);
+
+// Варианты с выходным буфером: ёмкость out переиспользуется между вызовами.
+// change_speed требует &out != &buffer, reverb допускает обработку на месте.
+//
+// activity — карта входа (core/activity.hpp): тихие блоки не обрабатываются,
+// выход тот же бит в бит. change_speed заполняет карту выхода для reverb.
+// Возвращают число кадров выхода, записанных нулями без обработки.
+std::size_t change_speed(const core::AudioBuffer &buffer, float speed_factor,
+                         core::AudioBuffer &out,
+                         const ActivityMap *activity = nullptr,
+                         ActivityMap *out_activity = nullptr,
+                         SpeedQuality quality = SpeedQuality::Linear);
+std::size_t reverb(const core::AudioBuffer &buffer, const ReverbParams &p,
+                   core::AudioBuffer &out,
+                   const ActivityMap *activity = nullptr);
 } // namespace core
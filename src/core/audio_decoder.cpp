@@ -1,8 +1,16 @@
 #include "core/audio_decoder.hpp"
+#include "core/async_avio.hpp"
+#include "core/av_pcm_format.hpp"
 #include "log/log.hpp"
-#include <QString>
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstdint>
-#include <vector>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -17,56 +25,167 @@ extern "C" {
 }
 
 namespace core {
-AudioDecoder::AudioDecoder(QString &input_path) : path_(input_path) {}
+
+AudioDecoder::AudioDecoder(std::filesystem::path input_path,
+                           DecodeOptions options)
+    : path_(std::move(input_path)), options_(options) {}
 AudioDecoder::~AudioDecoder() { close(); };
-bool AudioDecoder::open() {
-  close();
+namespace {
 
-  // Step 1: Open the input file and create format context
-  if (avformat_open_input(&format_ctx_, path_.toUtf8().constData(), nullptr,
-                          nullptr) != 0) {
-    TE_ERROR("Could not open input file.");
-    format_ctx_ = nullptr;
-    return false;
+// Пакеты перед окном, которые декодируются и выбрасываются после seek
+constexpr int kSeekPrerollPackets = 2;
+
+// Демуксер по сигнатуре файла: с ним avformat_open_input не зондирует
+// вход. Сырые MPEG-кадры и ID3 без контейнера различает только
+// расширение. nullptr — пусть угадывает FFmpeg.
+const char *demuxer_hint(const std::filesystem::path &path) {
+  unsigned char m[12] = {};
+  std::ifstream in(path, std::ios::binary);
+  in.read(reinterpret_cast<char *>(m), sizeof(m));
+  const size_t n = static_cast<size_t>(in.gcount());
+  auto tag = [&](size_t at, const char *t) {
+    return n >= at + 4 && std::memcmp(m + at, t, 4) == 0;
   };
-  // Step 2: Retrieve Stream information;
-  if (avformat_find_stream_info(format_ctx_, nullptr) < 0) {
 
-    TE_ERROR("Could not find stream information.");
+  if ((tag(0, "RIFF") || tag(0, "RF64") || tag(0, "BW64")) && tag(8, "WAVE"))
+    return "wav";
+  if (tag(0, "fLaC"))
+    return "flac";
+  if (tag(0, "OggS"))
+    return "ogg";
+  if (tag(0, "FORM") && (tag(8, "AIFF") || tag(8, "AIFC")))
+    return "aiff";
+  if (tag(4, "ftyp"))
+    return "mov"; // mov,mp4,m4a,3gp,...
+  if (n >= 4 && m[0] == 0x1a && m[1] == 0x45 && m[2] == 0xdf && m[3] == 0xa3)
+    return "matroska";
+
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  const bool id3 = n >= 3 && std::memcmp(m, "ID3", 3) == 0;
+  const bool sync = n >= 2 && m[0] == 0xff && (m[1] & 0xe0) == 0xe0;
+  if ((id3 || sync) && ext == ".mp3")
+    return "mp3";
+  if ((id3 || sync) && ext == ".aac")
+    return "aac";
+  return nullptr;
+}
+
+// Заголовка контейнера хватает, чтобы открыть декодер без
+// avformat_find_stream_info: кодек, частота и число каналов известны. Для
+// окна нужен ещё start_time — его иначе досчитывает find_stream_info.
+// AAC — исключение: при неявном SBR/PS (HE-AAC) заголовок даёт половинную
+// частоту и моно, настоящие видны только в первом кадре, поэтому AAC
+// всегда зондируется.
+bool header_complete(const AVStream *stream, bool windowed) {
+  const AVCodecParameters *par = stream->codecpar;
+  if (par->codec_id == AV_CODEC_ID_AAC ||
+      par->codec_id == AV_CODEC_ID_AAC_LATM)
+    return false;
+  return par->codec_id != AV_CODEC_ID_NONE && par->sample_rate > 0 &&
+         par->ch_layout.nb_channels > 0 &&
+         (!windowed || stream->start_time != AV_NOPTS_VALUE);
+}
+
+} // namespace
+
+bool AudioDecoder::open_input(bool fast) {
+  // Неудача быстрого пути — не ошибка, open() повторит обычным
+  auto fail = [&](const char *what) {
+    if (fast)
+      TE_TRACE("fast open of {} failed: {}", path_.string(), what);
+    else
+      TE_ERROR("{}", what);
     close();
     return false;
+  };
+
+  // Step 1: Open the input file and create format context
+  const std::u8string utf8_path = path_.u8string();
+  if (options_.async_io) {
+    avio_ = open_async_input(path_);
+    if (avio_ && (format_ctx_ = avformat_alloc_context())) {
+      format_ctx_->pb = avio_;
+      format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    } else {
+      TE_WARN("io_uring unavailable, reading {} with regular I/O",
+              path_.string());
+    }
+  }
+  const char *hint = fast ? demuxer_hint(path_) : nullptr;
+  const AVInputFormat *input_format =
+      hint ? av_find_input_format(hint) : nullptr;
+  // Формат известен — probesize/analyzeduration ограничивают только
+  // find_stream_info, если он всё же понадобится. Без подсказки лимиты не
+  // ставим: ими урезалось бы и само угадывание (mp3 с большой обложкой).
+  AVDictionary *format_opts = nullptr;
+  if (input_format) {
+    av_dict_set(&format_opts, "probesize", "65536", 0);
+    av_dict_set(&format_opts, "analyzeduration", "500000", 0);
+  }
+  const int opened = avformat_open_input(
+      &format_ctx_, reinterpret_cast<const char *>(utf8_path.c_str()),
+      input_format, &format_opts);
+  av_dict_free(&format_opts);
+  if (opened != 0) {
+    format_ctx_ = nullptr;
+    return fail("Could not open input file.");
   }
-  // Step 3: Find the audio stream
+
+  const bool windowed =
+      options_.start_seconds > 0.0 || options_.duration_seconds > 0.0;
   audio_stream_index_ =
       av_find_best_stream(format_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+  // Step 2: Retrieve Stream information, если заголовка не хватило;
+  if (!fast || audio_stream_index_ < 0 ||
+      !header_complete(format_ctx_->streams[audio_stream_index_], windowed)) {
+    if (avformat_find_stream_info(format_ctx_, nullptr) < 0)
+      return fail("Could not find stream information.");
+    // Step 3: Find the audio stream
+    audio_stream_index_ = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_AUDIO,
+                                              -1, -1, nullptr, 0);
+  }
   if (audio_stream_index_ < 0) {
     TE_TRACE("Could not find audio stream");
     close();
     return false;
   }
 
+  // Остальные потоки (видео, субтитры) демуксер может не разбирать
+  for (unsigned i = 0; i < format_ctx_->nb_streams; ++i) {
+    if (static_cast<int>(i) != audio_stream_index_)
+      format_ctx_->streams[i]->discard = AVDISCARD_ALL;
+  }
+
   AVStream *stream = format_ctx_->streams[audio_stream_index_];
   // Step 4: Get codec for audio stream
   const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
-  if (!codec) {
-    TE_ERROR("Could not find decoder.");
-    close();
-    return false;
-  }
+  if (!codec)
+    return fail("Could not find decoder.");
 
   codec_ctx_ = avcodec_alloc_context3(codec);
   if (!codec_ctx_ ||
       avcodec_parameters_to_context(codec_ctx_, stream->codecpar) < 0) {
-    TE_ERROR("Could not copy codec params");
-    close();
-    return false;
+    return fail("Could not copy codec params");
   }
 
-  if (avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
-    TE_ERROR("Could not open codec.");
-    close();
+  if (avcodec_open2(codec_ctx_, codec, nullptr) < 0)
+    return fail("Could not open codec.");
+  // Формат сэмплов некоторые декодеры узнают только из первого кадра —
+  // его и декодирует find_stream_info
+  if (codec_ctx_->sample_fmt == AV_SAMPLE_FMT_NONE ||
+      codec_ctx_->sample_rate <= 0 || codec_ctx_->ch_layout.nb_channels <= 0)
+    return fail("Incomplete codec parameters.");
+  return true;
+}
+
+bool AudioDecoder::open() {
+  close();
+  // Быстрый путь может не сработать (сигнатура солгала, параметров в
+  // заголовке не хватило) — тогда обычное зондирование FFmpeg.
+  if (!(options_.fast_open && open_input(true)) && !open_input(false))
     return false;
-  }
 
   if (codec_ctx_->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
     av_channel_layout_default(&codec_ctx_->ch_layout,
@@ -74,12 +193,25 @@ bool AudioDecoder::open() {
   }
   av_channel_layout_copy(&input_channel_layout_, &codec_ctx_->ch_layout);
 
-  output_sample_rate_ = codec_ctx_->sample_rate;
-  output_channels_ = codec_ctx_->ch_layout.nb_channels;
+  const int input_channels = codec_ctx_->ch_layout.nb_channels;
+  output_sample_rate_ = options_.sample_rate > 0 ? options_.sample_rate
+                                                 : codec_ctx_->sample_rate;
+  output_channels_ = options_.channels > 0
+                         ? std::min(options_.channels, input_channels)
+                         : input_channels;
   av_channel_layout_default(&output_channel_layout_, output_channels_);
 
+  // swr нужен только для смены частоты/раскладки (в т.ч. даунмикса
+  // предпросмотра) или экзотических форматов;
+  // чистую смену формата делают SIMD-ядра core::convert.
+  direct_convert_ =
+      pcm_format_of(codec_ctx_->sample_fmt, direct_format_, direct_planar_) &&
+      output_sample_rate_ == codec_ctx_->sample_rate &&
+      av_channel_layout_compare(&input_channel_layout_,
+                                &output_channel_layout_) == 0;
+
   // Init resampler
-  if (!init_resampler()) {
+  if (!direct_convert_ && !init_resampler()) {
     TE_ERROR("Could not init resampler");
     close();
     return false;
@@ -94,28 +226,112 @@ bool AudioDecoder::open() {
   }
 
   end_of_file_ = false;
+  flushing_ = false;
+  position_ = -1;
+  window_done_ = false;
+  windowed_ =
+      options_.start_seconds > 0.0 || options_.duration_seconds > 0.0;
+  if (windowed_) {
+    window_begin_ = std::llround(std::max(0.0, options_.start_seconds) *
+                                 output_sample_rate_);
+    window_end_ = options_.duration_seconds > 0.0
+                      ? window_begin_ + std::llround(options_.duration_seconds *
+                                                     output_sample_rate_)
+                      : INT64_MAX;
+    // Без seek окно всё равно вырежется, просто декодировать придётся с начала
+    if (window_begin_ > 0 && !seek_to_window())
+      TE_WARN("Seek failed, decoding {} from the start", path_.string());
+  }
 
   return true;
 };
 
-bool AudioDecoder::decode_to_buffer(core::AudioBuffer &buffer) {
-  if (!format_ctx_ || !swr_ctx_ || !codec_ctx_ || !packet_ || !frame_) {
+bool AudioDecoder::seek_to_window() {
+  const AVStream *stream = format_ctx_->streams[audio_stream_index_];
+  // Декодерам с перекрытием кадров (MP3, AAC, Opus) после seek нужен разгон:
+  // первые кадры выходят неполными. Начинаем на пару пакетов раньше, лишнее
+  // по меткам времени отрежет clip_to_window.
+  const AVCodecParameters *par = stream->codecpar;
+  const int64_t preroll =
+      par->seek_preroll > 0 ? par->seek_preroll
+                            : int64_t{kSeekPrerollPackets} * par->frame_size;
+  const int64_t begin = std::max<int64_t>(
+      0, window_begin_ - av_rescale(preroll, output_sample_rate_,
+                                    std::max(par->sample_rate, 1)));
+  int64_t ts = av_rescale_q(begin, AVRational{1, output_sample_rate_},
+                            stream->time_base);
+  if (stream->start_time != AV_NOPTS_VALUE)
+    ts += stream->start_time;
+  if (av_seek_frame(format_ctx_, audio_stream_index_, ts,
+                    AVSEEK_FLAG_BACKWARD) < 0) {
+    return false;
+  }
+  avcodec_flush_buffers(codec_ctx_);
+  return true;
+}
+
+int64_t AudioDecoder::frame_position() const {
+  const int64_t ts = frame_->best_effort_timestamp;
+  if (ts == AV_NOPTS_VALUE)
+    return 0;
+  const AVStream *stream = format_ctx_->streams[audio_stream_index_];
+  const int64_t start =
+      stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+  return std::max<int64_t>(
+      0, av_rescale_q(ts - start, stream->time_base,
+                      AVRational{1, output_sample_rate_}));
+}
+
+size_t AudioDecoder::clip_to_window(size_t count, size_t &head) {
+  head = 0;
+  if (!windowed_)
+    return count;
+
+  const int64_t begin = position_;
+  position_ += static_cast<int64_t>(count);
+  if (position_ >= window_end_)
+    window_done_ = true;
+
+  const int64_t lo = std::max(begin, window_begin_);
+  const int64_t hi = std::min(position_, window_end_);
+  if (hi <= lo) {
+    head = count;
+    return 0;
+  }
+  head = static_cast<size_t>(lo - begin);
+  return static_cast<size_t>(hi - lo);
+}
+
+bool AudioDecoder::ready() {
+  if (!format_ctx_ || (!direct_convert_ && !swr_ctx_) || !codec_ctx_ ||
+      !packet_ || !frame_) {
     TE_ERROR("Decoder is not itialized");
     close();
     return false;
   }
+  return true;
+}
 
-  buffer.sample_rate = output_sample_rate_;
-  buffer.channels = output_channels_;
+namespace {
+
+const metrics::Counter &input_bytes() {
+  static const metrics::Counter counter = metrics::registry().counter(
+      "grustnify_decoder_input_bytes",
+      "Compressed bytes of audio packets fed to decoders.");
+  return counter;
+}
 
-  std::vector<float> tmp;
+} // namespace
 
-  while (true) {
+template <typename Sink> bool AudioDecoder::decode_frames(Sink &&sink) {
+  const metrics::Counter &bytes = input_bytes();
+  while (!window_done_) {
     if (!end_of_file_) {
       if (av_read_frame(format_ctx_, packet_) < 0) {
         end_of_file_ = true;
         avcodec_send_packet(codec_ctx_, nullptr);
       } else if (packet_->stream_index == audio_stream_index_) {
+        bytes.inc(static_cast<uint64_t>(packet_->size));
         avcodec_send_packet(codec_ctx_, packet_);
         av_packet_unref(packet_);
       } else {
@@ -141,33 +357,200 @@ bool AudioDecoder::decode_to_buffer(core::AudioBuffer &buffer) {
       return false;
     }
 
-    // Resample to output buffer
-    int max_out_samples = frame_->nb_samples;
+    // После seek позиция берётся из таймстемпа первого кадра
+    if (windowed_ && position_ < 0)
+      position_ = frame_position();
 
-    tmp.resize(max_out_samples * output_channels_);
-
-    uint8_t *out_data[1] = {reinterpret_cast<uint8_t *>(tmp.data())};
-
-    int converted =
-        swr_convert(swr_ctx_, out_data, max_out_samples,
-                    (const uint8_t **)frame_->data, frame_->nb_samples);
+    int max_out_samples =
+        direct_convert_ ? frame_->nb_samples
+                        : swr_get_out_samples(swr_ctx_, frame_->nb_samples);
+    if (max_out_samples < 0) {
+      TE_ERROR("Failed to query resampler output size");
+      close();
+      return false;
+    }
 
+    const bool converted = sink(max_out_samples);
     av_frame_unref(frame_);
 
-    if (converted < 0) {
-
+    if (!converted) {
       TE_ERROR("Failed to resample");
       close();
       return false;
     }
+  }
 
-    int total_samples = converted * output_channels_;
-
-    buffer.samples.insert(buffer.samples.end(), tmp.begin(),
-                          tmp.begin() + total_samples);
+  // Хвост, задержанный ресемплером
+  if (!direct_convert_ && !window_done_) {
+    if (windowed_ && position_ < 0)
+      position_ = 0;
+    const int pending = swr_get_out_samples(swr_ctx_, 0);
+    if (pending > 0) {
+      flushing_ = true;
+      const bool converted = sink(pending);
+      flushing_ = false;
+      if (!converted) {
+        TE_ERROR("Failed to flush resampler");
+        close();
+        return false;
+      }
+    }
   }
   return true;
-};
+}
+
+template <typename Storage> void AudioDecoder::reserve_for(Storage &samples) {
+  // Резервируем по заявленной длительности: крупный файл сразу попадает в
+  // mmap-хранилище без промежуточного переезда из heap.
+  int64_t expected_frames = estimated_frames();
+  if (windowed_) {
+    const int64_t window = window_end_ - window_begin_;
+    expected_frames = expected_frames > 0
+                          ? std::min(expected_frames - window_begin_, window)
+                          : (window < INT64_MAX ? window : 0);
+  }
+  // Подсказку Sequential на всю ёмкость mmap ставит сам рост хранилища:
+  // здесь ещё ничего не записано
+  if (expected_frames > 0) {
+    samples.reserve(samples.size() +
+                    static_cast<size_t>(expected_frames) * output_channels_);
+  }
+}
+
+bool AudioDecoder::decode_to_buffer(core::AudioBuffer &buffer) {
+  if (!ready())
+    return false;
+
+  buffer.sample_rate = output_sample_rate_;
+  buffer.channels = output_channels_;
+  reserve_for(buffer.samples);
+  if (peaks_)
+    peaks_->start(output_sample_rate_, output_channels_);
+  if (activity_)
+    activity_->start(output_channels_);
+
+  // Convert straight into the output buffer
+  const metrics::StageTimer timer(metrics::Stage::Decode);
+  const bool ok = decode_frames([&](int max_out_samples) {
+    const size_t offset = buffer.samples.size();
+    buffer.samples.resize_uninitialized(
+        offset + static_cast<size_t>(max_out_samples) * output_channels_);
+
+    float *out = buffer.samples.data() + offset;
+    const int converted = convert_frame(out, max_out_samples);
+    size_t head = 0;
+    const size_t kept =
+        clip_to_window(static_cast<size_t>(std::max(converted, 0)), head);
+    if (head > 0 && kept > 0)
+      std::memmove(out, out + head * output_channels_,
+                   kept * output_channels_ * sizeof(float));
+    buffer.samples.resize_uninitialized(offset + kept * output_channels_);
+    if (peaks_)
+      peaks_->add(out, kept);
+    if (activity_)
+      activity_->add(out, kept);
+    return converted >= 0;
+  });
+  if (ok) {
+    timer.done(buffer.samples.size() / output_channels_);
+    // Дальше DSP читает записанное подряд
+    buffer.samples.advise(StorageAccess::Sequential);
+  }
+  return ok;
+}
+
+bool AudioDecoder::decode_to_buffer(core::CompactAudioBuffer &buffer) {
+  if (!ready())
+    return false;
+
+  buffer.sample_rate = output_sample_rate_;
+  buffer.channels = output_channels_;
+  reserve_for(buffer.samples);
+  if (peaks_)
+    peaks_->start(output_sample_rate_, output_channels_);
+  if (activity_)
+    activity_->start(output_channels_);
+
+  // Кадр декодируется во float-черновик и сразу упаковывается
+  const metrics::StageTimer timer(metrics::Stage::Decode);
+  const bool ok = decode_frames([&](int max_out_samples) {
+    frame_scratch_.resize(static_cast<size_t>(max_out_samples) *
+                          output_channels_);
+    const int converted = convert_frame(frame_scratch_.data(), max_out_samples);
+    if (converted < 0)
+      return false;
+
+    size_t head = 0;
+    const size_t kept = clip_to_window(static_cast<size_t>(converted), head);
+    const size_t offset = buffer.samples.size();
+    const size_t n = kept * output_channels_;
+    buffer.samples.resize_uninitialized(offset + n);
+    encode_compact(buffer.format,
+                   frame_scratch_.data() + head * output_channels_,
+                   buffer.samples.data() + offset, n);
+    const float *kept_frames = frame_scratch_.data() + head * output_channels_;
+    if (peaks_)
+      peaks_->add(kept_frames, kept);
+    if (activity_)
+      activity_->add(kept_frames, kept);
+    return true;
+  });
+  if (ok) {
+    timer.done(buffer.samples.size() / output_channels_);
+    // Дальше DSP читает записанное подряд
+    buffer.samples.advise(StorageAccess::Sequential);
+  }
+  return ok;
+}
+
+bool AudioDecoder::decode_to_peaks(PeakBuilder &peaks) {
+  if (!ready())
+    return false;
+
+  peaks.start(output_sample_rate_, output_channels_);
+  return decode_frames([&](int max_out_samples) {
+    frame_scratch_.resize(static_cast<size_t>(max_out_samples) *
+                          output_channels_);
+    const int converted = convert_frame(frame_scratch_.data(), max_out_samples);
+    if (converted < 0)
+      return false;
+    size_t head = 0;
+    const size_t kept = clip_to_window(static_cast<size_t>(converted), head);
+    peaks.add(frame_scratch_.data() + head * output_channels_, kept);
+    return true;
+  });
+}
+int64_t AudioDecoder::estimated_frames() const {
+  if (!format_ctx_ || audio_stream_index_ < 0 || output_sample_rate_ <= 0)
+    return 0;
+  const AVStream *stream = format_ctx_->streams[audio_stream_index_];
+  if (stream->duration > 0) {
+    return av_rescale_q(stream->duration, stream->time_base,
+                        AVRational{1, output_sample_rate_});
+  }
+  if (format_ctx_->duration > 0) {
+    return av_rescale(format_ctx_->duration, output_sample_rate_,
+                      AV_TIME_BASE);
+  }
+  return 0;
+}
+
+int AudioDecoder::convert_frame(float *out, int max_out_samples) {
+  if (direct_convert_) {
+    convert::to_interleaved_f32(direct_format_, direct_planar_,
+                                frame_->extended_data, out, frame_->nb_samples,
+                                output_channels_, convert_scratch_);
+    return frame_->nb_samples;
+  }
+
+  uint8_t *out_data[1] = {reinterpret_cast<uint8_t *>(out)};
+  if (flushing_)
+    return swr_convert(swr_ctx_, out_data, max_out_samples, nullptr, 0);
+  return swr_convert(swr_ctx_, out_data, max_out_samples,
+                     (const uint8_t **)frame_->extended_data,
+                     frame_->nb_samples);
+}
+
 bool AudioDecoder::init_resampler() {
   if (!codec_ctx_) {
     TE_ERROR("Could not init resampler");
@@ -215,6 +598,8 @@ void AudioDecoder::close() {
     avformat_close_input(&format_ctx_);
     format_ctx_ = nullptr;
   }
+  // С AVFMT_FLAG_CUSTOM_IO pb не закрывается avformat'ом
+  close_async_avio(&avio_);
 
   av_channel_layout_uninit(&input_channel_layout_);
   av_channel_layout_uninit(&output_channel_layout_);
@@ -224,6 +609,10 @@ void AudioDecoder::close() {
   output_sample_rate_ = 0;
   output_channels_ = 0;
   end_of_file_ = false;
+  direct_convert_ = false;
+  windowed_ = false;
+  position_ = -1;
+  window_done_ = false;
 }
 } // namespace core
   //
@@ -1,6 +1,11 @@
 #pragma once
-#include <QString>
 #include <core/audio_buffer.hpp>
+#include <core/compact_buffer.hpp>
+#include <core/activity.hpp>
+#include <core/peaks.hpp>
+#include <core/sample_convert.hpp>
+#include <filesystem>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -15,20 +20,69 @@ extern "C" {
 }
 
 namespace core {
+
+// Формат и окно декодирования. По умолчанию — весь файл как есть; для
+// предпросмотра swr сразу даунмиксит и понижает частоту, а окно читается
+// после seek, так что время не зависит от длины файла.
+struct DecodeOptions {
+  int sample_rate = 0;           // 0 — как в источнике
+  int channels = 0;              // 0 — как в источнике; больше не бывает
+  double start_seconds = 0.0;    // начало окна
+  double duration_seconds = 0.0; // 0 — до конца
+  // Чтение через io_uring с упреждением (core/async_avio.hpp); где его нет —
+  // обычный file-протокол
+  bool async_io = false;
+  // Демуксер по сигнатуре/расширению и без avformat_find_stream_info, когда
+  // параметров кодека из заголовка достаточно; при неудаче — обычное
+  // зондирование FFmpeg. false — сразу обычное.
+  bool fast_open = true;
+};
+
 class AudioDecoder {
 public:
-  AudioDecoder(QString &input_path);
+  explicit AudioDecoder(std::filesystem::path input_path,
+                        DecodeOptions options = {});
   ~AudioDecoder();
   bool open();
   bool decode_to_buffer(core::AudioBuffer &buffer);
+  // Упаковывает каждый кадр в buffer.format сразу после декодирования
+  bool decode_to_buffer(core::CompactAudioBuffer &buffer);
+  // Пирамида пиков строится попутно с decode_to_buffer (nullptr — нет)
+  void set_peak_builder(PeakBuilder *peaks) { peaks_ = peaks; }
+  // Карта тихих блоков — тоже попутно (nullptr — нет)
+  void set_activity_builder(ActivityBuilder *activity) {
+    activity_ = activity;
+  }
+  // Только пики, без буфера сэмплов (волна для GUI)
+  bool decode_to_peaks(PeakBuilder &peaks);
+
+  // Индекс выбранного аудиопотока во входном контейнере (после open())
+  int stream_index() const { return audio_stream_index_; }
 
 private:
+  // Контейнер, поток и открытый декодер; fast — см. DecodeOptions::fast_open
+  bool open_input(bool fast);
   bool init_resampler();
+  bool ready();
+  template <typename Storage> void reserve_for(Storage &samples);
+  // Декодирует до конца; sink(max_out_samples) забирает frame_
+  template <typename Sink> bool decode_frames(Sink &&sink);
+  int64_t estimated_frames() const;
+  bool seek_to_window();
+  // Позиция frame_ на выходной шкале (относительно начала потока)
+  int64_t frame_position() const;
+  // Из count только что сконвертированных кадров оставляет попавшие в окно:
+  // пропустить head, вернуть число оставшихся
+  size_t clip_to_window(size_t count, size_t &head);
+  // frame_ -> interleaved float; возвращает число кадров или < 0
+  int convert_frame(float *out, int max_out_samples);
   void close();
 
 private:
-  QString path_ = "";
+  std::filesystem::path path_;
+  DecodeOptions options_;
   AVFormatContext *format_ctx_ = nullptr;
+  AVIOContext *avio_ = nullptr; // свой pb при async_io
   AVCodecContext *codec_ctx_ = nullptr;
   SwrContext *swr_ctx_ = nullptr;
   int audio_stream_index_ = -1;
@@ -40,7 +94,24 @@ private:
   int output_sample_rate_ = 0;
   int output_channels_ = 0;
   bool end_of_file_ = false;
+  bool flushing_ = false; // convert_frame() выдаёт хвост swr
+
+  // Окно в выходных кадрах; position_ < 0 — ещё не известна
+  bool windowed_ = false;
+  int64_t window_begin_ = 0;
+  int64_t window_end_ = 0;
+  int64_t position_ = -1;
+  bool window_done_ = false;
   AVSampleFormat output_sample_fmt_ = AV_SAMPLE_FMT_FLT;
   AVPacket *packet_ = nullptr;
+
+  // Прямая конвертация без swr, когда меняется только формат сэмплов
+  bool direct_convert_ = false;
+  convert::PcmFormat direct_format_ = convert::PcmFormat::F32;
+  bool direct_planar_ = false;
+  std::vector<float> convert_scratch_;
+  std::vector<float> frame_scratch_; // для компактного вывода
+  PeakBuilder *peaks_ = nullptr;
+  ActivityBuilder *activity_ = nullptr;
 };
 } // namespace core
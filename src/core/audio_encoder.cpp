@@ -1,61 +1,122 @@
 #include "audio_encoder.hpp"
+#include "core/async_avio.hpp"
+#include "core/av_pcm_format.hpp"
 #include "log/log.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
 
 namespace core {
 
+namespace {
+
+const metrics::Counter &output_bytes() {
+  static const metrics::Counter counter = metrics::registry().counter(
+      "grustnify_encoder_output_bytes",
+      "Bytes of encoded packets and WAV data written by encoders.");
+  return counter;
+}
+
+} // namespace
+
 AudioEncoder::AudioEncoder() = default;
 
-AudioEncoder::~AudioEncoder() { close(); }
+AudioEncoder::~AudioEncoder() {
+  close();
+  cleanup(); // тёплый кодек, оставленный close()
+}
 
-void AudioEncoder::cleanup() {
-  if (fifo_)
-    av_audio_fifo_free(fifo_);
-  if (swr_ctx_)
-    swr_free(&swr_ctx_);
-  if (packet_)
-    av_packet_free(&packet_);
-  if (frame_)
-    av_frame_free(&frame_);
-  if (codec_ctx_)
-    avcodec_free_context(&codec_ctx_);
+void AudioEncoder::release_output() {
+  wav_.reset();
 
-  if (format_ctx_) {
-    if (opened_ && !(format_ctx_->oformat->flags & AVFMT_NOFILE)) {
+  if (format_ctx_ && owns_format_) {
+    if (async_pb_) {
+      if (!close_async_avio(&format_ctx_->pb))
+        TE_ERROR("AudioEncoder: write error on {}", path_.string());
+    } else if (opened_ && !(format_ctx_->oformat->flags & AVFMT_NOFILE)) {
       avio_closep(&format_ctx_->pb);
     }
     avformat_free_context(format_ctx_);
   }
 
   format_ctx_ = nullptr;
-  codec_ctx_ = nullptr;
-  swr_ctx_ = nullptr;
-  fifo_ = nullptr;
   stream_ = nullptr;
-  frame_ = nullptr;
-  packet_ = nullptr;
   opened_ = false;
+  owns_format_ = true;
+  async_pb_ = false;
   pts_ = 0;
 }
 
-bool AudioEncoder::open(const QString &path, int sample_rate, int channels,
-                        int bitrate) {
-  cleanup(); // Очистка на всякий случай
+void AudioEncoder::release_buffers() {
+  if (fifo_)
+    av_audio_fifo_free(fifo_);
+  if (convert_data_) {
+    av_freep(&convert_data_[0]);
+    av_freep(&convert_data_);
+  }
+  if (packet_)
+    av_packet_free(&packet_);
+  if (frame_)
+    av_frame_free(&frame_);
+
+  fifo_ = nullptr;
+  frame_ = nullptr;
+  packet_ = nullptr;
+}
+
+void AudioEncoder::release_codec() {
+  release_buffers();
+  if (codec_ctx_)
+    avcodec_free_context(&codec_ctx_);
+  codec_ctx_ = nullptr;
+}
+
+void AudioEncoder::cleanup() {
+  release_codec();
+  release_output();
+}
+
+bool AudioEncoder::open(const std::filesystem::path &path, int sample_rate,
+                        int channels, int bitrate, const char *format_name) {
+  // Незакрытый прошлый файл дописывается, как в деструкторе; его кодек
+  // остаётся, если подойдёт (см. set_keep_codec())
+  close();
+  release_output();
 
   path_ = path;
   sample_rate_ = sample_rate;
   channels_ = channels;
   bitrate_ = bitrate;
 
+  std::string ext = path_.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  const bool wav = format_name ? std::string_view(format_name) == "wav"
+                               : ext == ".wav";
+  if (wav && open_wav(path)) {
+    release_codec();
+    return true;
+  }
+
+  const std::u8string utf8_path = path_.u8string();
+  const char *c_path = reinterpret_cast<const char *>(utf8_path.c_str());
+
   // 1. Создаём выходной AVFormatContext (угадываем формат по расширению .mp3)
-  if (avformat_alloc_output_context2(&format_ctx_, nullptr, nullptr,
-                                     path_.toUtf8().constData()) < 0 ||
+  if (avformat_alloc_output_context2(&format_ctx_, nullptr, format_name,
+                                     c_path) < 0 ||
       !format_ctx_) {
     TE_ERROR("AudioEncoder: Could not allocate output context");
     return false;
   }
 
   // 2. Инициализация кодека и стрима
-  if (!init_stream_and_codec()) {
+  const AVCodecID codec_id =
+      !wav ? AV_CODEC_ID_MP3
+      : wav_options_.format == WavSampleFormat::S16 ? AV_CODEC_ID_PCM_S16LE
+                                                    : AV_CODEC_ID_PCM_F32LE;
+  if (!init_stream_and_codec(codec_id)) {
     TE_ERROR("AudioEncoder: init_stream_and_codec failed");
     cleanup();
     return false;
@@ -63,8 +124,16 @@ bool AudioEncoder::open(const QString &path, int sample_rate, int channels,
 
   // 3. Открытие файла (если формат требует)
   if (!(format_ctx_->oformat->flags & AVFMT_NOFILE)) {
-    if (avio_open(&format_ctx_->pb, path_.toUtf8().constData(),
-                  AVIO_FLAG_WRITE) < 0) {
+    if (async_io_) {
+      format_ctx_->pb = open_async_output(path_);
+      async_pb_ = format_ctx_->pb != nullptr;
+      if (!async_pb_)
+        TE_WARN("AudioEncoder: io_uring unavailable, writing {} with "
+                "regular I/O",
+                path_.string());
+    }
+    if (!async_pb_ &&
+        avio_open(&format_ctx_->pb, c_path, AVIO_FLAG_WRITE) < 0) {
       TE_ERROR("AudioEncoder: Could not open output file");
       cleanup();
       return false;
@@ -82,50 +151,156 @@ bool AudioEncoder::open(const QString &path, int sample_rate, int channels,
   return true;
 }
 
-bool AudioEncoder::init_stream_and_codec() {
-  // Находим MP3 кодек
-  const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MP3);
-  if (!codec) {
-    TE_ERROR("AudioEncoder: MP3 codec not found");
+bool AudioEncoder::open_wav(const std::filesystem::path &path) {
+  // PCM не нужны ни кодек, ни FIFO с нарезкой по кадрам: блоки сразу в файл
+  auto writer = std::make_unique<WavWriter>();
+  if (!writer->open(path, sample_rate_, channels_, wav_options_)) {
+    TE_WARN("AudioEncoder: native WAV writer unavailable for {}, using FFmpeg",
+            path.string());
+    return false;
+  }
+  wav_ = std::move(writer);
+  opened_ = true;
+  return true;
+}
+
+bool AudioEncoder::attach(AVFormatContext *format_ctx, int sample_rate,
+                          int channels, int bitrate, AVCodecID codec_id,
+                          int64_t start_pts) {
+  cleanup();
+
+  sample_rate_ = sample_rate;
+  channels_ = channels;
+  bitrate_ = bitrate;
+  format_ctx_ = format_ctx;
+  owns_format_ = false;
+
+  if (!init_stream_and_codec(codec_id)) {
+    TE_ERROR("AudioEncoder: init_stream_and_codec failed");
+    cleanup();
     return false;
   }
+  pts_ = start_pts;
+  opened_ = true;
+  return true;
+}
+
+namespace {
+
+// Формат сэмплов для кодека: MP3 — S16P, как и раньше (LAME), для прочих —
+// первый поддерживаемый из тех, что умеют SIMD-ядра.
+AVSampleFormat pick_sample_format(const AVCodec *codec) {
+  const AVSampleFormat *supported = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+  const void *configs = nullptr;
+  if (avcodec_get_supported_config(nullptr, codec, AV_CODEC_CONFIG_SAMPLE_FORMAT,
+                                   0, &configs, nullptr) >= 0)
+    supported = static_cast<const AVSampleFormat *>(configs);
+#else
+  supported = codec->sample_fmts;
+#endif
+  if (!supported)
+    return AV_SAMPLE_FMT_S16P;
+
+  const AVSampleFormat preferred[] = {
+      codec->id == AV_CODEC_ID_MP3 ? AV_SAMPLE_FMT_S16P : AV_SAMPLE_FMT_FLTP,
+      AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLT,  AV_SAMPLE_FMT_S16P,
+      AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_S32};
+  for (AVSampleFormat want : preferred)
+    for (const AVSampleFormat *f = supported; *f != AV_SAMPLE_FMT_NONE; ++f)
+      if (*f == want)
+        return want;
+  return AV_SAMPLE_FMT_NONE;
+}
+
+} // namespace
+
+bool AudioEncoder::codec_reusable(AVCodecID codec_id) const {
+  if (!codec_ctx_ || !fifo_ || !convert_data_ || !frame_ || !packet_)
+    return false;
+  const bool global_header =
+      format_ctx_->oformat->flags & AVFMT_GLOBALHEADER;
+  return codec_ctx_->codec_id == codec_id &&
+         codec_ctx_->sample_rate == sample_rate_ &&
+         codec_ctx_->ch_layout.nb_channels == channels_ &&
+         codec_ctx_->bit_rate == bitrate_ &&
+         static_cast<bool>(codec_ctx_->flags & AV_CODEC_FLAG_GLOBAL_HEADER) ==
+             global_header;
+}
 
+bool AudioEncoder::buffers_reusable() const {
+  return fifo_ && convert_data_ && frame_ && packet_ &&
+         frame_->format == codec_ctx_->sample_fmt &&
+         frame_->ch_layout.nb_channels == channels_ &&
+         frame_samples_ ==
+             (codec_ctx_->frame_size > 0 ? codec_ctx_->frame_size : 1024);
+}
+
+bool AudioEncoder::init_stream_and_codec(AVCodecID codec_id) {
   stream_ = avformat_new_stream(format_ctx_, nullptr);
   if (!stream_)
     return false;
 
+  // Тёплый кодек после close(): состояние уже сброшено, новому потоку
+  // нужны только его параметры
+  if (codec_reusable(codec_id)) {
+    avcodec_parameters_from_context(stream_->codecpar, codec_ctx_);
+    stream_->time_base = codec_ctx_->time_base;
+    return true;
+  }
+  // Кодек без сброса (libmp3lame) открывается заново, а FIFO, кадр, пакет и
+  // буфер конвертации от прошлого файла берутся, если формат тот же
+  if (codec_ctx_)
+    avcodec_free_context(&codec_ctx_);
+  codec_ctx_ = nullptr;
+
+  const AVCodec *codec = avcodec_find_encoder(codec_id);
+  if (!codec) {
+    TE_ERROR("AudioEncoder: {} encoder not found", avcodec_get_name(codec_id));
+    return false;
+  }
+
   codec_ctx_ = avcodec_alloc_context3(codec);
   if (!codec_ctx_)
     return false;
 
-  // Параметры MP3
   codec_ctx_->bit_rate = bitrate_;
-  codec_ctx_->sample_fmt = AV_SAMPLE_FMT_S16P; // Стандарт для LAME MP3 (Planar)
+  codec_ctx_->sample_fmt = pick_sample_format(codec);
   codec_ctx_->sample_rate = sample_rate_;
+  codec_ctx_->time_base = AVRational{1, sample_rate_};
   av_channel_layout_default(&codec_ctx_->ch_layout, channels_);
+  if (format_ctx_->oformat->flags & AVFMT_GLOBALHEADER)
+    codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 
   // Открываем кодек
-  if (avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
+  if (codec_ctx_->sample_fmt == AV_SAMPLE_FMT_NONE ||
+      avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
     TE_ERROR("AudioEncoder: Could not open codec");
     return false;
   }
 
   avcodec_parameters_from_context(stream_->codecpar, codec_ctx_);
+  stream_->time_base = codec_ctx_->time_base;
 
-  // --- Инициализация SwrContext (Resampler) ---
-  // Вход: Float Interleaved (из вашего AudioBuffer)
-  // Выход: S16 Planar (для MP3)
-  AVChannelLayout in_layout;
-  av_channel_layout_default(&in_layout, channels_);
+  if (buffers_reusable()) {
+    frame_->nb_samples = frame_samples_;
+    return true;
+  }
+  release_buffers();
 
-  int ret = swr_alloc_set_opts2(&swr_ctx_, &codec_ctx_->ch_layout,
-                                codec_ctx_->sample_fmt, codec_ctx_->sample_rate,
-                                &in_layout, AV_SAMPLE_FMT_FLT, sample_rate_, 0,
-                                nullptr);
-  av_channel_layout_uninit(&in_layout);
+  // --- Конвертация формата ---
+  // Вход: Float Interleaved (из AudioBuffer), выход: формат кодека (S16P для
+  // MP3). Частота и раскладка совпадают, поэтому swr не нужен — SIMD-ядра.
+  if (!pcm_format_of(codec_ctx_->sample_fmt, codec_format_, codec_planar_)) {
+    TE_ERROR("AudioEncoder: unsupported codec sample format");
+    return false;
+  }
 
-  if (ret < 0 || swr_init(swr_ctx_) < 0) {
-    TE_ERROR("AudioEncoder: Could not init SwrContext");
+  int linesize = 0;
+  if (av_samples_alloc_array_and_samples(&convert_data_, &linesize, channels_,
+                                         kConvertChunkFrames,
+                                         codec_ctx_->sample_fmt, 0) < 0) {
+    TE_ERROR("AudioEncoder: could not alloc temp samples");
     return false;
   }
 
@@ -137,7 +312,9 @@ bool AudioEncoder::init_stream_and_codec() {
   // Аллокация вспомогательных структур
   packet_ = av_packet_alloc();
   frame_ = av_frame_alloc();
-  frame_->nb_samples = codec_ctx_->frame_size;
+  // Кодеки с переменным кадром (frame_size == 0) кормим кусками по 1024.
+  frame_samples_ = codec_ctx_->frame_size > 0 ? codec_ctx_->frame_size : 1024;
+  frame_->nb_samples = frame_samples_;
   frame_->format = codec_ctx_->sample_fmt;
   av_channel_layout_copy(&frame_->ch_layout, &codec_ctx_->ch_layout);
 
@@ -147,97 +324,163 @@ bool AudioEncoder::init_stream_and_codec() {
   return true;
 }
 
-bool AudioEncoder::encode_from_buffer(const AudioBuffer &buffer) {
-  if (!opened_ || !swr_ctx_ || !fifo_) {
+bool AudioEncoder::accepts(int sample_rate, int channels) const {
+  if (!opened_ || (!wav_ && (!convert_data_ || !fifo_))) {
     TE_ERROR("AudioEncoder: encoder is not initialized");
     return false;
   }
 
-  if (buffer.channels != channels_ || buffer.sample_rate != sample_rate_) {
+  if (channels != channels_ || sample_rate != sample_rate_) {
     TE_ERROR("AudioEncoder: buffer format does not match encoder");
     return false;
   }
+  return true;
+}
 
-  const int nb_samples = static_cast<int>(buffer.samples.size()) / channels_;
-  if (nb_samples == 0)
+bool AudioEncoder::encode_chunk(const float *interleaved, int nb_samples) {
+  if (wav_) {
+    if (!wav_->write(interleaved, static_cast<size_t>(nb_samples))) {
+      TE_ERROR("AudioEncoder: WAV write failed");
+      return false;
+    }
     return true;
+  }
 
-  // 1. Ресемплинг во временный буфер (Float -> S16P)
-  uint8_t **converted_data = nullptr;
-  int linesize;
-  if (av_samples_alloc_array_and_samples(&converted_data, &linesize, channels_,
-                                         nb_samples, codec_ctx_->sample_fmt,
-                                         0) < 0) {
-    TE_ERROR("AudioEncoder: could not alloc temp samples");
+  // 1. Конвертация во временный буфер (Float -> S16P)
+  convert::from_interleaved_f32(interleaved, codec_format_, codec_planar_,
+                                convert_data_, nb_samples, channels_,
+                                convert_scratch_,
+                                dither_ ? &dither_state_ : nullptr);
+
+  // 2. Запись в FIFO
+  if (av_audio_fifo_write(fifo_, (void **)convert_data_, nb_samples) <
+      nb_samples) {
+    TE_ERROR("AudioEncoder: fifo write failed");
     return false;
   }
 
-  const uint8_t *input_data[1] = {
-      reinterpret_cast<const uint8_t *>(buffer.samples.data())};
+  return encode_fifo_frames();
+}
 
-  int ret =
-      swr_convert(swr_ctx_, converted_data, nb_samples, input_data, nb_samples);
-  if (ret < 0) {
-    TE_ERROR("AudioEncoder: swr_convert failed");
-    if (converted_data)
-      av_freep(&converted_data[0]);
-    free(converted_data);
+bool AudioEncoder::encode_interleaved(const float *interleaved,
+                                      size_t frames) {
+  if (!accepts(sample_rate_, channels_))
     return false;
+  for (size_t done = 0; done < frames; done += kConvertChunkFrames) {
+    const int nb_samples =
+        static_cast<int>(std::min<size_t>(kConvertChunkFrames, frames - done));
+    if (!encode_chunk(interleaved + done * channels_, nb_samples))
+      return false;
   }
+  return true;
+}
 
-  // 2. Запись в FIFO
-  if (av_audio_fifo_write(fifo_, (void **)converted_data, nb_samples) <
-      nb_samples) {
-    TE_ERROR("AudioEncoder: fifo write failed");
-    if (converted_data)
-      av_freep(&converted_data[0]);
-    free(converted_data);
+bool AudioEncoder::encode_from_buffer(const AudioBuffer &buffer) {
+  if (!accepts(buffer.sample_rate, buffer.channels))
+    return false;
+
+  const size_t total_frames = buffer.samples.size() / channels_;
+  if (total_frames == 0)
+    return true;
+
+  buffer.samples.advise(StorageAccess::Sequential);
+  const metrics::StageTimer timer(metrics::Stage::Encode);
+
+  // WAV: весь буфер одним вызовом, блоки writer'а и так по 1 МиБ
+  if (wav_) {
+    if (!wav_->write(buffer.samples.data(), total_frames)) {
+      TE_ERROR("AudioEncoder: WAV write failed");
+      return false;
+    }
+    timer.done(total_frames);
+    return true;
+  }
+
+  // Конвертируем блоками прямо из буфера: никакой полной S16P-копии сигнала.
+  for (size_t done = 0; done < total_frames; done += kConvertChunkFrames) {
+    const int nb_samples = static_cast<int>(
+        std::min<size_t>(kConvertChunkFrames, total_frames - done));
+    if (!encode_chunk(buffer.samples.data() + done * channels_, nb_samples))
+      return false;
+  }
+
+  timer.done(total_frames);
+  return true;
+}
+
+bool AudioEncoder::encode_from_buffer(const CompactAudioBuffer &buffer) {
+  if (!accepts(buffer.sample_rate, buffer.channels))
     return false;
+
+  const size_t total_frames = buffer.samples.size() / channels_;
+  if (total_frames == 0)
+    return true;
+
+  buffer.samples.advise(StorageAccess::Sequential);
+  const metrics::StageTimer timer(metrics::Stage::Encode);
+
+  // Распаковка во float тем же блоком, что и конвертация в формат кодека
+  chunk_scratch_.resize(static_cast<size_t>(kConvertChunkFrames) * channels_);
+  for (size_t done = 0; done < total_frames; done += kConvertChunkFrames) {
+    const int nb_samples = static_cast<int>(
+        std::min<size_t>(kConvertChunkFrames, total_frames - done));
+    decode_compact(buffer.format, buffer.samples.data() + done * channels_,
+                   chunk_scratch_.data(),
+                   static_cast<size_t>(nb_samples) * channels_);
+    if (!encode_chunk(chunk_scratch_.data(), nb_samples))
+      return false;
   }
 
-  if (converted_data) {
-    av_freep(&converted_data[0]);
-    free(converted_data);
+  timer.done(total_frames);
+  return true;
+}
+
+bool AudioEncoder::send_and_write(AVFrame *frame) {
+  // Отправка в кодек
+  if (avcodec_send_frame(codec_ctx_, frame) < 0) {
+    TE_ERROR("AudioEncoder: avcodec_send_frame failed");
+    return false;
+  }
+
+  // Получение пакетов
+  while (true) {
+    int ret_pkt = avcodec_receive_packet(codec_ctx_, packet_);
+    if (ret_pkt == AVERROR(EAGAIN) || ret_pkt == AVERROR_EOF)
+      break;
+    if (ret_pkt < 0)
+      return false;
+
+    packet_->stream_index = stream_->index;
+    av_packet_rescale_ts(packet_, codec_ctx_->time_base, stream_->time_base);
+    output_bytes().inc(static_cast<uint64_t>(packet_->size));
+
+    if (av_interleaved_write_frame(format_ctx_, packet_) < 0) {
+      TE_ERROR("AudioEncoder: write frame failed");
+      return false;
+    }
+    av_packet_unref(packet_);
   }
+  return true;
+}
 
+bool AudioEncoder::encode_fifo_frames() {
   // 3. Вычитывание полных кадров из FIFO и кодирование
-  while (av_audio_fifo_size(fifo_) >= codec_ctx_->frame_size) {
+  while (av_audio_fifo_size(fifo_) >= frame_samples_) {
     if (av_frame_make_writable(frame_) < 0)
       return false;
 
-    // Читаем ровно frame_size (1152) сэмплов
-    if (av_audio_fifo_read(fifo_, (void **)frame_->data,
-                           codec_ctx_->frame_size) < codec_ctx_->frame_size) {
+    // Читаем ровно frame_size (1152 для MP3) сэмплов
+    if (av_audio_fifo_read(fifo_, (void **)frame_->data, frame_samples_) <
+        frame_samples_) {
       return false;
     }
 
-    frame_->nb_samples = codec_ctx_->frame_size;
+    frame_->nb_samples = frame_samples_;
     frame_->pts = pts_;
     pts_ += frame_->nb_samples;
 
-    // Отправка в кодек
-    if (avcodec_send_frame(codec_ctx_, frame_) < 0) {
-      TE_ERROR("AudioEncoder: avcodec_send_frame failed");
+    if (!send_and_write(frame_))
       return false;
-    }
-
-    // Получение пакетов
-    while (true) {
-      int ret_pkt = avcodec_receive_packet(codec_ctx_, packet_);
-      if (ret_pkt == AVERROR(EAGAIN) || ret_pkt == AVERROR_EOF)
-        break;
-      if (ret_pkt < 0)
-        return false;
-
-      packet_->stream_index = stream_->index;
-      av_packet_rescale_ts(packet_, codec_ctx_->time_base, stream_->time_base);
-
-      if (av_interleaved_write_frame(format_ctx_, packet_) < 0) {
-        TE_ERROR("AudioEncoder: write frame failed");
-        return false;
-      }
-      av_packet_unref(packet_);
-    }
   }
 
   return true;
@@ -247,14 +490,34 @@ void AudioEncoder::close() {
   if (!opened_)
     return;
 
+  if (wav_) {
+    output_bytes().inc(wav_->data_bytes());
+    if (!wav_->close())
+      TE_ERROR("AudioEncoder: could not finalize {}", path_.string());
+    cleanup();
+    return;
+  }
+
   // Сначала сбрасываем остатки данных
-  flush_encoder();
+  const bool flushed = flush_encoder();
 
-  // Пишем трейлер файла
-  if (format_ctx_) {
+  // Пишем трейлер файла (при attach() это делает владелец muxer'а)
+  if (format_ctx_ && owns_format_) {
     av_write_trailer(format_ctx_);
   }
 
+  // После флаша до EOF кодек с ENCODER_FLUSH сбрасывается и готов к
+  // следующему файлу. Остальные (libmp3lame) закрываются, но FIFO, кадр,
+  // пакет и буфер конвертации остаются для следующего open()
+  if (keep_codec_ && flushed && owns_format_) {
+    if (codec_ctx_->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH)
+      avcodec_flush_buffers(codec_ctx_);
+    else
+      avcodec_free_context(&codec_ctx_);
+    av_audio_fifo_reset(fifo_);
+    release_output();
+    return;
+  }
   cleanup();
 }
 
@@ -262,7 +525,8 @@ bool AudioEncoder::flush_encoder() {
   if (!fifo_ || !codec_ctx_)
     return false;
 
-  // 1. Если в FIFO остались данные, добиваем тишиной до полного кадра
+  // 1. Если в FIFO остались данные, отдаём их последним кадром; кодекам с
+  // фиксированным размером кадра добиваем тишиной
   int remaining = av_audio_fifo_size(fifo_);
   if (remaining > 0) {
     if (av_frame_make_writable(frame_) < 0)
@@ -270,50 +534,24 @@ bool AudioEncoder::flush_encoder() {
 
     av_audio_fifo_read(fifo_, (void **)frame_->data, remaining);
 
-    // Паддинг нулями
-    int padding = codec_ctx_->frame_size - remaining;
-    for (int ch = 0; ch < channels_; ch++) {
-      // S16P = int16_t (2 байта)
-      int16_t *ptr = reinterpret_cast<int16_t *>(frame_->data[ch]);
-      memset(ptr + remaining, 0, padding * sizeof(int16_t));
+    int nb_samples = remaining;
+    if (!(codec_ctx_->codec->capabilities &
+          AV_CODEC_CAP_VARIABLE_FRAME_SIZE) &&
+        codec_ctx_->frame_size > 0) {
+      av_samples_set_silence(frame_->data, remaining, frame_samples_ - remaining,
+                             channels_, codec_ctx_->sample_fmt);
+      nb_samples = frame_samples_;
     }
 
-    frame_->nb_samples = codec_ctx_->frame_size;
+    frame_->nb_samples = nb_samples;
     frame_->pts = pts_;
     pts_ += frame_->nb_samples;
 
-    avcodec_send_frame(codec_ctx_, frame_);
-
-    // Забираем пакет
-    while (true) {
-      int ret = avcodec_receive_packet(codec_ctx_, packet_);
-      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-        break;
-      if (ret < 0)
-        break;
-
-      packet_->stream_index = stream_->index;
-      av_packet_rescale_ts(packet_, codec_ctx_->time_base, stream_->time_base);
-      av_interleaved_write_frame(format_ctx_, packet_);
-      av_packet_unref(packet_);
-    }
+    send_and_write(frame_);
   }
 
   // 2. Финальный флаш самого кодека (передаем nullptr)
-  if (avcodec_send_frame(codec_ctx_, nullptr) >= 0) {
-    while (true) {
-      int ret = avcodec_receive_packet(codec_ctx_, packet_);
-      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-        break;
-
-      packet_->stream_index = stream_->index;
-      av_packet_rescale_ts(packet_, codec_ctx_->time_base, stream_->time_base);
-      av_interleaved_write_frame(format_ctx_, packet_);
-      av_packet_unref(packet_);
-    }
-  }
-
-  return true;
+  return send_and_write(nullptr);
 }
 
 } // namespace core
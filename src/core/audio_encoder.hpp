@@ -1,7 +1,10 @@
 #pragma once
 
 #include "audio_buffer.hpp"
-#include <QString>
+#include "compact_buffer.hpp"
+#include "sample_convert.hpp"
+#include "wav_writer.hpp"
+#include <filesystem>
 #include <memory>
 #include <vector>
 
@@ -10,7 +13,6 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/audio_fifo.h>
 #include <libavutil/opt.h>
-#include <libswresample/swresample.h>
 }
 
 namespace core {
@@ -20,26 +22,71 @@ public:
   AudioEncoder();
   ~AudioEncoder();
 
-  // Инициализация
-  bool open(const QString &path, int sample_rate, int channels,
-            int bitrate = 128000);
+  // Инициализация. format_name задаёт контейнер явно (например, "mp3"), когда
+  // его нельзя угадать по расширению — /proc/self/fd/N у memfd.
+  // .wav/"wav" пишется напрямую WavWriter'ом (см. set_wav_options()), FFmpeg
+  // остаётся запасным путём для платформ без POSIX I/O.
+  bool open(const std::filesystem::path &path, int sample_rate, int channels,
+            int bitrate = 128000, const char *format_name = nullptr);
+
+  // Аудиопоток внутри чужого muxer'а (ремукс видео): поток добавляется в
+  // format_ctx, заголовок и трейлер пишет владелец. Кодек — codec_id,
+  // формат сэмплов выбирается из поддерживаемых им. start_pts — начало
+  // потока в сэмплах. Вызывать до avformat_write_header().
+  bool attach(AVFormatContext *format_ctx, int sample_rate, int channels,
+              int bitrate, AVCodecID codec_id, int64_t start_pts = 0);
+  const AVStream *stream() const { return stream_; }
+
+  // Формат сэмплов и режим I/O для WAV-выхода; задавать до open()
+  void set_wav_options(const WavOptions &options) { wav_options_ = options; }
+  // Запись через io_uring с отложенным сбросом (core/async_avio.hpp) вместо
+  // file-протокола FFmpeg; задавать до open()
+  void set_async_io(bool enabled) { async_io_ = enabled; }
+
+  // TPDF-дизер при округлении до 16 бит (по умолчанию выключен)
+  void set_dither(bool enabled) { dither_ = enabled; }
+
+  // Долгоживущие воркеры: close() оставляет FIFO, кадр, пакет и буфер
+  // конвертации, а кодек, если он умеет сброс (AV_CODEC_CAP_ENCODER_FLUSH), —
+  // открытым. Следующий open() с тем же кодеком, частотой, каналами и
+  // битрейтом обходится без аллокаций; кодек без сброса (libmp3lame)
+  // открывается заново через avcodec_open2
+  void set_keep_codec(bool enabled) { keep_codec_ = enabled; }
 
   // Кодирование куска данных
   bool encode_from_buffer(const AudioBuffer &buffer);
+  bool encode_from_buffer(const CompactAudioBuffer &buffer);
+  // Очередной кусок interleaved float (для пошаговой подачи при ремуксе)
+  bool encode_interleaved(const float *interleaved, size_t frames);
 
   // Завершение кодирования (ВАЖНО вызвать в конце)
   void close();
 
 private:
-  bool init_stream_and_codec();
+  bool open_wav(const std::filesystem::path &path);
+  bool init_stream_and_codec(AVCodecID codec_id);
+  bool accepts(int sample_rate, int channels) const;
+  bool encode_chunk(const float *interleaved, int nb_samples);
+  bool encode_fifo_frames(); // Кодирует все полные кадры из FIFO
+  bool send_and_write(AVFrame *frame); // nullptr — флаш кодека
   bool flush_encoder(); // Сброс остатков из FIFO и энкодера
-  void cleanup();       // Очистка ресурсов
+  bool codec_reusable(AVCodecID codec_id) const;
+  bool buffers_reusable() const; // буферы подходят к новому codec_ctx_
+  void release_output();  // muxer, файл, WAV — всё, что относится к файлу
+  void release_buffers(); // FIFO, кадр, пакет, буфер конвертации
+  void release_codec();   // кодек и его буферы
+  void cleanup();         // Очистка ресурсов
 
-  QString path_;
+  std::filesystem::path path_;
   int sample_rate_ = 0;
   int channels_ = 0;
   int bitrate_ = 0;
   bool opened_ = false;
+  bool owns_format_ = true; // false после attach()
+  bool async_io_ = false;
+  bool async_pb_ = false; // format_ctx_->pb — наш AVIOContext
+  bool keep_codec_ = false;
+  int frame_samples_ = 0;   // размер кадра кодека (или наш, если переменный)
 
   // FFmpeg structures
   AVFormatContext *format_ctx_ = nullptr;
@@ -49,9 +96,22 @@ private:
   AVPacket *packet_ = nullptr;
 
   // Новые структуры для MP3
-  SwrContext *swr_ctx_ = nullptr;
   AVAudioFifo *fifo_ = nullptr;
   int64_t pts_ = 0;
+
+  // Блок конвертации Float -> формат кодека
+  static constexpr int kConvertChunkFrames = 16384;
+  uint8_t **convert_data_ = nullptr;
+  convert::PcmFormat codec_format_ = convert::PcmFormat::S16;
+  bool codec_planar_ = true;
+  std::vector<float> convert_scratch_;
+  std::vector<float> chunk_scratch_; // распакованный компактный блок
+  bool dither_ = false;
+
+  // Нативный WAV: при нём FFmpeg-структуры не создаются
+  WavOptions wav_options_;
+  std::unique_ptr<WavWriter> wav_;
+  convert::DitherState dither_state_;
 };
 
 } // namespace core
@@ -0,0 +1,30 @@
+#pragma once
+#include <core/sample_convert.hpp>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+namespace core {
+
+// AVSampleFormat -> формат ядер core::convert. false — формат ядрами не
+// поддерживается (u8, s64, double), нужен swr.
+inline bool pcm_format_of(AVSampleFormat fmt, convert::PcmFormat &format,
+                          bool &planar) {
+  planar = av_sample_fmt_is_planar(fmt);
+  switch (av_get_packed_sample_fmt(fmt)) {
+  case AV_SAMPLE_FMT_S16:
+    format = convert::PcmFormat::S16;
+    return true;
+  case AV_SAMPLE_FMT_S32:
+    format = convert::PcmFormat::S32;
+    return true;
+  case AV_SAMPLE_FMT_FLT:
+    format = convert::PcmFormat::F32;
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace core
@@ -0,0 +1,173 @@
+#include "core/checkpoint.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRUSTNIFY_HAVE_CHECKPOINTS 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+namespace {
+
+constexpr char kMagic[4] = {'G', 'R', 'C', 'K'};
+constexpr uint32_t kVersion = 1;
+
+struct CheckpointHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t job_key;
+  uint32_t stage;
+  int32_t sample_rate;
+  int32_t channels;
+  uint32_t reserved;
+  uint64_t frames[2];
+  uint64_t progress;
+  uint64_t state_bytes;
+};
+
+#ifdef GRUSTNIFY_HAVE_CHECKPOINTS
+bool write_all(int fd, const void *data, size_t size) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  while (size > 0) {
+    const ssize_t n = ::write(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool read_all(int fd, void *data, size_t size) {
+  auto *p = static_cast<uint8_t *>(data);
+  while (size > 0) {
+    const ssize_t n = ::read(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// rename() переживает падение, только если сброшен и каталог
+void sync_dir(const std::filesystem::path &dir) {
+  const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+}
+#endif
+
+} // namespace
+
+bool Checkpoint::save(const std::filesystem::path &path) const {
+#ifdef GRUSTNIFY_HAVE_CHECKPOINTS
+  CheckpointHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.job_key = job_key;
+  header.stage = stage;
+  header.sample_rate = sample_rate;
+  header.channels = channels;
+  header.frames[0] = frames[0];
+  header.frames[1] = frames[1];
+  header.progress = progress;
+  header.state_bytes = state.size();
+
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  const int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0644);
+  if (fd < 0)
+    return false;
+  const bool ok = write_all(fd, &header, sizeof(header)) &&
+                  write_all(fd, state.data(), state.size()) &&
+                  ::fsync(fd) == 0;
+  ::close(fd);
+  std::error_code ec;
+  if (ok)
+    std::filesystem::rename(temp, path, ec);
+  if (!ok || ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  sync_dir(path.parent_path());
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+bool Checkpoint::load(const std::filesystem::path &path) {
+#ifdef GRUSTNIFY_HAVE_CHECKPOINTS
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  CheckpointHeader header{};
+  struct stat st {};
+  bool ok = read_all(fd, &header, sizeof(header)) &&
+            std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+            header.version == kVersion && ::fstat(fd, &st) == 0 &&
+            header.state_bytes ==
+                static_cast<uint64_t>(st.st_size) - sizeof(header);
+  std::vector<uint8_t> bytes;
+  if (ok) {
+    bytes.resize(header.state_bytes);
+    ok = read_all(fd, bytes.data(), bytes.size());
+  }
+  ::close(fd);
+  if (!ok)
+    return false;
+
+  job_key = header.job_key;
+  stage = header.stage;
+  sample_rate = header.sample_rate;
+  channels = header.channels;
+  frames[0] = header.frames[0];
+  frames[1] = header.frames[1];
+  progress = header.progress;
+  state = std::move(bytes);
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+bool open_checkpoint_storage(const std::filesystem::path &path,
+                             SampleStorage &samples, size_t count) {
+#ifdef GRUSTNIFY_HAVE_CHECKPOINTS
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return false;
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<uint64_t>(st.st_size) < count * sizeof(float) ||
+      !samples.adopt_fd(fd, count)) {
+    ::close(fd);
+    return false;
+  }
+  return true;
+#else
+  (void)path;
+  (void)samples;
+  (void)count;
+  return false;
+#endif
+}
+
+} // namespace core
@@ -0,0 +1,35 @@
+#pragma once
+#include <core/sample_storage.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Checkpoint многочасового рендера: после OOM-kill или вытеснения spot-узла
+// задача продолжает с последней точки, а не с нуля. Сэмплы этапов живут в
+// файлах рядом (open_checkpoint_storage), здесь — докуда они дописаны и
+// внутреннее состояние незаконченного этапа.
+namespace core {
+
+struct Checkpoint {
+  uint64_t job_key = 0; // вход и параметры: чужой checkpoint не подхватится
+  uint32_t stage = 0;   // завершённых этапов
+  int32_t sample_rate = 0;
+  int32_t channels = 0;
+  uint64_t frames[2] = {}; // кадров в файлах сэмплов
+  uint64_t progress = 0;   // кадров выхода незаконченного этапа
+  std::vector<uint8_t> state; // его состояние (линии reverb'а)
+
+  // Временный файл, fsync и rename: на диске всегда целый checkpoint,
+  // старый или новый.
+  bool save(const std::filesystem::path &path) const;
+  bool load(const std::filesystem::path &path);
+};
+
+// Файл сэмплов как хранилище буфера: первые count сэмплов — уже записанные,
+// рост буфера расширяет файл. Перед save() checkpoint'а — samples.sync().
+// false — платформа без mmap или файл не открылся.
+bool open_checkpoint_storage(const std::filesystem::path &path,
+                             SampleStorage &samples, std::size_t count);
+
+} // namespace core
@@ -0,0 +1,249 @@
+#include "core/compact_buffer.hpp"
+
+#include "core/activity.hpp"
+#include "core/reverb_kernel.hpp"
+#include "core/sample_convert.hpp"
+#include "core/speed_kernel.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace core {
+
+namespace {
+
+constexpr size_t kBlockFrames = 4096;
+
+void reset_like(const CompactAudioBuffer &in, CompactAudioBuffer &out) {
+  out.sample_rate = in.sample_rate;
+  out.channels = in.channels;
+  out.format = in.format;
+}
+
+bool is_empty(const CompactAudioBuffer &b) {
+  return b.sample_rate <= 0 || b.channels <= 0 || b.samples.empty();
+}
+
+} // namespace
+
+void encode_compact(CompactFormat format, const float *in, uint16_t *out,
+                    size_t n) {
+  const convert::Kernels &k = convert::kernels();
+  if (format == CompactFormat::Half)
+    k.f32_to_f16(in, out, n);
+  else
+    k.f32_to_s16(in, reinterpret_cast<int16_t *>(out), n, nullptr);
+}
+
+void decode_compact(CompactFormat format, const uint16_t *in, float *out,
+                    size_t n) {
+  const convert::Kernels &k = convert::kernels();
+  if (format == CompactFormat::Half)
+    k.f16_to_f32(in, out, n);
+  else
+    k.s16_to_f32(reinterpret_cast<const int16_t *>(in), out, n);
+}
+
+CompactAudioBuffer compact(const AudioBuffer &buffer, CompactFormat format) {
+  CompactAudioBuffer out;
+  out.sample_rate = buffer.sample_rate;
+  out.channels = buffer.channels;
+  out.format = format;
+  out.samples.resize_uninitialized(buffer.samples.size());
+  encode_compact(format, buffer.samples.data(), out.samples.data(),
+                 buffer.samples.size());
+  return out;
+}
+
+AudioBuffer expand(const CompactAudioBuffer &buffer) {
+  AudioBuffer out;
+  out.sample_rate = buffer.sample_rate;
+  out.channels = buffer.channels;
+  out.samples.resize_uninitialized(buffer.samples.size());
+  decode_compact(buffer.format, buffer.samples.data(), out.samples.data(),
+                 buffer.samples.size());
+  return out;
+}
+
+size_t change_speed(const CompactAudioBuffer &in, float speed_factor,
+                    CompactAudioBuffer &out, const ActivityMap *activity,
+                    ActivityMap *out_activity, SpeedQuality quality) {
+  reset_like(in, out);
+  out.samples.clear();
+  if (out_activity)
+    *out_activity = ActivityMap{};
+  if (speed_factor <= 0.0f || in.channels <= 0 || in.samples.empty())
+    return 0;
+
+  const metrics::StageTimer timer(metrics::Stage::Speed);
+  const int channels = in.channels;
+  const size_t in_frames = in.samples.size() / channels;
+  const size_t out_frames = speed::output_frames(in_frames, speed_factor);
+  const speed::Kernel kernel(speed_factor, quality);
+  out.samples.resize_uninitialized(out_frames * channels);
+  if (activity && activity->frames != in_frames)
+    activity = nullptr;
+
+  // С картой — блоки карты, чтобы тихие целиком пропускались; ноль в обоих
+  // компактных форматах — нулевые биты
+  const size_t step = activity ? ActivityMap::kBlockFrames : kBlockFrames;
+  std::vector<float> window;
+  std::vector<float> block(step * channels);
+  size_t skipped = 0;
+  for (size_t first = 0; first < out_frames; first += step) {
+    const size_t count = std::min(step, out_frames - first);
+    const size_t begin = kernel.input_begin(first, in_frames);
+    const size_t end = kernel.input_end(first + count - 1, in_frames);
+    uint16_t *dst = out.samples.data() + first * channels;
+
+    const bool active = !activity || activity->any_active(begin, end);
+    if (out_activity && activity)
+      out_activity->active.push_back(active);
+    if (!active) {
+      std::fill_n(dst, count * channels, uint16_t{0});
+      skipped += count;
+      continue;
+    }
+
+    window.resize((end - begin) * channels);
+    decode_compact(in.format, in.samples.data() + begin * channels,
+                   window.data(), window.size());
+    kernel.render(window.data(), begin, in_frames, channels, first, count,
+                  block.data());
+    encode_compact(out.format, block.data(), dst, count * channels);
+  }
+  if (out_activity && activity)
+    out_activity->frames = out_frames;
+  timer.done(out_frames, skipped);
+  return skipped;
+}
+
+size_t reverb(const CompactAudioBuffer &in, const ReverbParams &p,
+              CompactAudioBuffer &out, const ActivityMap *activity) {
+  reset_like(in, out);
+  if (is_empty(in)) {
+    out.samples.clear();
+    return 0;
+  }
+
+  const metrics::StageTimer timer(metrics::Stage::Reverb);
+  const int channels = in.channels;
+  const size_t frames = in.samples.size() / channels;
+  out.samples.resize_uninitialized(in.samples.size());
+  if (activity && activity->frames != frames)
+    activity = nullptr;
+
+  auto proc = make_reverb_processor(in.sample_rate, channels, p);
+  SilenceSkip silence(activity);
+  const size_t step = activity ? ActivityMap::kBlockFrames : kBlockFrames;
+  std::vector<float> block(step * channels);
+  size_t skipped = 0;
+  for (size_t first = 0; first < frames; first += step) {
+    const size_t count = std::min(step, frames - first);
+    const size_t n = count * channels;
+    uint16_t *dst = out.samples.data() + first * channels;
+    if (silence.skip(*proc, first, count)) {
+      std::fill_n(dst, n, uint16_t{0});
+      skipped += count;
+      continue;
+    }
+    decode_compact(in.format, in.samples.data() + first * channels,
+                   block.data(), n);
+    proc->process(block.data(), block.data(), count);
+    silence.processed(block.data(), n);
+    encode_compact(out.format, block.data(), dst, n);
+  }
+
+  if (p.render_tail) {
+    render_tail(*proc, in.sample_rate, channels, p, kBlockFrames,
+                [&](const float *tail, size_t count) {
+                  const size_t at = out.samples.size();
+                  out.samples.resize_uninitialized(at + count * channels);
+                  encode_compact(out.format, tail, out.samples.data() + at,
+                                 count * channels);
+                });
+  }
+  timer.done(out.samples.size() / channels, skipped);
+  return skipped;
+}
+
+CompactAudioBuffer change_speed(const CompactAudioBuffer &in,
+                                float speed_factor, SpeedQuality quality) {
+  CompactAudioBuffer out;
+  change_speed(in, speed_factor, out, nullptr, nullptr, quality);
+  return out;
+}
+
+CompactAudioBuffer reverb(const CompactAudioBuffer &in, const ReverbParams &p) {
+  CompactAudioBuffer out;
+  reverb(in, p, out);
+  return out;
+}
+
+LoudnessStats measure_loudness(const CompactAudioBuffer &buffer) {
+  if (is_empty(buffer))
+    return {};
+
+  const int channels = buffer.channels;
+  const size_t frames = buffer.samples.size() / channels;
+  LoudnessMeter meter(buffer.sample_rate, channels);
+  std::vector<float> block(kBlockFrames * channels);
+  for (size_t first = 0; first < frames; first += kBlockFrames) {
+    const size_t count = std::min(kBlockFrames, frames - first);
+    decode_compact(buffer.format, buffer.samples.data() + first * channels,
+                   block.data(), count * channels);
+    meter.process(block.data(), count);
+  }
+  return meter.result();
+}
+
+LoudnessStats normalize_loudness(CompactAudioBuffer &buffer,
+                                 const LoudnessParams &p) {
+  const metrics::StageTimer timer(metrics::Stage::Loudness);
+  const LoudnessStats stats = measure_loudness(buffer);
+  if (!std::isfinite(stats.integrated_lufs))
+    return stats;
+
+  const int channels = buffer.channels;
+  const size_t frames = buffer.samples.size() / channels;
+  uint16_t *data = buffer.samples.data();
+  const float gain = normalization_gain(stats, p);
+  std::vector<float> block(kBlockFrames * channels);
+
+  if (!needs_limiter(stats, gain, p)) {
+    for (size_t first = 0; first < frames; first += kBlockFrames) {
+      const size_t n = std::min(kBlockFrames, frames - first) * channels;
+      uint16_t *at = data + first * channels;
+      decode_compact(buffer.format, at, block.data(), n);
+      for (size_t i = 0; i < n; ++i)
+        block[i] *= gain;
+      encode_compact(buffer.format, block.data(), at, n);
+    }
+    timer.done(frames);
+    return stats;
+  }
+
+  // Выход лимитера отстаёт от входа, поэтому пишется поверх уже прочитанных
+  // кадров — как и во float-версии.
+  LookaheadLimiter limiter(buffer.sample_rate, channels, gain, p);
+  std::vector<float> out(std::max(kBlockFrames, limiter.latency() + 1) *
+                         channels);
+  size_t written = 0;
+  for (size_t first = 0; first < frames; first += kBlockFrames) {
+    const size_t count = std::min(kBlockFrames, frames - first);
+    decode_compact(buffer.format, data + first * channels, block.data(),
+                   count * channels);
+    const size_t emitted = limiter.process(block.data(), count, out.data());
+    encode_compact(buffer.format, out.data(), data + written * channels,
+                   emitted * channels);
+    written += emitted;
+  }
+  const size_t emitted = limiter.flush(out.data());
+  encode_compact(buffer.format, out.data(), data + written * channels,
+                 emitted * channels);
+  timer.done(frames);
+  return stats;
+}
+
+} // namespace core
@@ -0,0 +1,52 @@
+#pragma once
+#include <core/audio_buffer.hpp>
+#include <core/loudness.hpp>
+#include <core/sample_storage.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+
+// Формат промежуточного хранения между этапами пайплайна (2 байта на отсчёт
+// вместо 4).
+//  Int16 — диапазон [-1, 1), всё громче клипуется; ошибка квантования
+//          не больше 1/65536 (округление к ближайшему, без дизеринга).
+//  Half  — IEEE binary16: относительная ошибка не больше 2^-11, запас до
+//          65504, так что перегрузы до нормализации не теряются.
+enum class CompactFormat { Int16, Half };
+
+struct CompactAudioBuffer {
+  int sample_rate = 0;
+  int channels = 0;
+  CompactFormat format = CompactFormat::Half;
+  // interleaved; для Int16 — битовое представление int16_t
+  BasicSampleStorage<uint16_t> samples;
+};
+
+void encode_compact(CompactFormat format, const float *in, uint16_t *out,
+                    size_t n);
+void decode_compact(CompactFormat format, const uint16_t *in, float *out,
+                    size_t n);
+
+CompactAudioBuffer compact(const AudioBuffer &buffer, CompactFormat format);
+AudioBuffer expand(const CompactAudioBuffer &buffer);
+
+// Те же преобразования, что и для AudioBuffer; отсчёты разворачиваются во
+// float блоками, поэтому полная float-копия сигнала не создаётся.
+CompactAudioBuffer change_speed(const CompactAudioBuffer &buffer,
+                                float speed_factor,
+                                SpeedQuality quality = SpeedQuality::Linear);
+CompactAudioBuffer reverb(const CompactAudioBuffer &buffer,
+                          const ReverbParams &p);
+size_t change_speed(const CompactAudioBuffer &buffer, float speed_factor,
+                    CompactAudioBuffer &out,
+                    const ActivityMap *activity = nullptr,
+                    ActivityMap *out_activity = nullptr,
+                    SpeedQuality quality = SpeedQuality::Linear);
+size_t reverb(const CompactAudioBuffer &buffer, const ReverbParams &p,
+              CompactAudioBuffer &out, const ActivityMap *activity = nullptr);
+LoudnessStats measure_loudness(const CompactAudioBuffer &buffer);
+LoudnessStats normalize_loudness(CompactAudioBuffer &buffer,
+                                 const LoudnessParams &p);
+
+} // namespace core
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define GRUSTNIFY_DENORMALS_SSE 1
+#include <xmmintrin.h>
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define GRUSTNIFY_DENORMALS_ARM64 1
+#endif
+
+// Затухающие хвосты рекурсивных фильтров (comb'ы, FDN, ФНЧ) уходят в
+// субнормальные числа, а на x86 каждая операция с ними стоит сотни тактов.
+// На время DSP поток работает в режиме FTZ/DAZ: такие значения считаются
+// нулём. Режим — свойство потока, поэтому guard ставится на каждом
+// рабочем потоке, а деструктор возвращает прежнее состояние.
+namespace core {
+
+class ScopedFlushDenormals {
+public:
+  ScopedFlushDenormals() {
+#if defined(GRUSTNIFY_DENORMALS_SSE)
+    saved_ = _mm_getcsr();
+    _mm_setcsr(static_cast<unsigned>(saved_) | kFtz | kDaz);
+#elif defined(GRUSTNIFY_DENORMALS_ARM64)
+    asm volatile("mrs %0, fpcr" : "=r"(saved_));
+    asm volatile("msr fpcr, %0" : : "r"(saved_ | kFz));
+#endif
+  }
+  ~ScopedFlushDenormals() {
+#if defined(GRUSTNIFY_DENORMALS_SSE)
+    _mm_setcsr(static_cast<unsigned>(saved_));
+#elif defined(GRUSTNIFY_DENORMALS_ARM64)
+    asm volatile("msr fpcr, %0" : : "r"(saved_));
+#endif
+  }
+  ScopedFlushDenormals(const ScopedFlushDenormals &) = delete;
+  ScopedFlushDenormals &operator=(const ScopedFlushDenormals &) = delete;
+
+private:
+  static constexpr unsigned kFtz = 0x8000; // MXCSR: результат -> 0
+  static constexpr unsigned kDaz = 0x0040; // MXCSR: операнды -> 0
+  static constexpr uint64_t kFz = uint64_t{1} << 24; // FPCR.FZ
+  uint64_t saved_ = 0;
+};
+
+} // namespace core
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace core::fir {
+
+// Модифицированная функция Бесселя I0 (ряд), нужна для окна Кайзера.
+inline double bessel_i0(double x) {
+  double sum = 1.0, term = 1.0;
+  const double half = x * 0.5;
+  for (int k = 1; k < 64; ++k) {
+    term *= (half / k) * (half / k);
+    sum += term;
+    if (term < sum * 1e-17)
+      break;
+  }
+  return sum;
+}
+
+// Окно Кайзера в точке r ∈ [-1, 1] (0 — центр): для фильтров, чьи отсчёты
+// стоят не на сетке окна (фазы полифазного ресемплера).
+inline double kaiser_at(double beta, double r) {
+  return bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) /
+         bessel_i0(beta);
+}
+
+inline double kaiser(double beta, int n, int length) {
+  if (length <= 1)
+    return 1.0;
+  return kaiser_at(beta, 2.0 * n / (length - 1) - 1.0);
+}
+
+inline double sinc(double x) {
+  if (std::fabs(x) < 1e-12)
+    return 1.0;
+  const double px = std::numbers::pi * x;
+  return std::sin(px) / px;
+}
+
+// Прототип ФНЧ для интерполятора с коэффициентом `factor`: length отсчётов,
+// срез на cutoff (доля от исходной частоты Найквиста), окно Кайзера.
+// Сумма коэффициентов каждой фазы ≈ 1.
+inline std::vector<double> interpolation_lowpass(int factor, int length,
+                                                 double cutoff, double beta) {
+  std::vector<double> h(length);
+  const double center = (length - 1) * 0.5;
+  for (int m = 0; m < length; ++m) {
+    const double t = (m - center) / factor;
+    h[m] = cutoff * sinc(cutoff * t) * kaiser(beta, m, length);
+  }
+  return h;
+}
+
+} // namespace core::fir
@@ -0,0 +1,494 @@
+#include "core/loudness.hpp"
+
+#include "core/fir_design.hpp"
+#include "core/simd.hpp"
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+namespace {
+
+using simd::f32x4;
+
+constexpr double kBlockSeconds = 0.4;
+constexpr int kSubBlocksPerBlock = 4; // 75% перекрытие блоков по 400 мс
+constexpr double kAbsoluteGateLufs = -70.0;
+constexpr double kRelativeGateLu = -10.0;
+
+// Два каскадных биквада K-weighting (BS.1770-4), пересчитанные под любую
+// частоту дискретизации по аналоговым прототипам.
+struct BiquadCoeffs {
+  float b0, b1, b2, a1, a2;
+};
+
+std::array<BiquadCoeffs, 2> k_weighting_coeffs(double fs) {
+  std::array<BiquadCoeffs, 2> c{};
+
+  {
+    const double f0 = 1681.974450955533;
+    const double gain_db = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    const double k = std::tan(std::numbers::pi * f0 / fs);
+    const double vh = std::pow(10.0, gain_db / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+    c[0] = {static_cast<float>((vh + vb * k / q + k * k) / a0),
+            static_cast<float>(2.0 * (k * k - vh) / a0),
+            static_cast<float>((vh - vb * k / q + k * k) / a0),
+            static_cast<float>(2.0 * (k * k - 1.0) / a0),
+            static_cast<float>((1.0 - k / q + k * k) / a0)};
+  }
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+    const double k = std::tan(std::numbers::pi * f0 / fs);
+    const double a0 = 1.0 + k / q + k * k;
+    c[1] = {1.0f, -2.0f, 1.0f, static_cast<float>(2.0 * (k * k - 1.0) / a0),
+            static_cast<float>((1.0 - k / q + k * k) / a0)};
+  }
+  return c;
+}
+
+// K-weighting для четырёх каналов сразу: по каналу в каждой полосе f32x4
+// (рекурсивный фильтр не векторизуется по времени, но хорошо — по каналам).
+struct KWeightingLanes {
+  struct Stage {
+    f32x4 b0, b1, b2, a1, a2;
+    f32x4 s1 = f32x4::zero(), s2 = f32x4::zero();
+  };
+  std::array<Stage, 2> stages;
+
+  explicit KWeightingLanes(const std::array<BiquadCoeffs, 2> &c) {
+    for (int i = 0; i < 2; ++i) {
+      stages[i].b0 = f32x4::splat(c[i].b0);
+      stages[i].b1 = f32x4::splat(c[i].b1);
+      stages[i].b2 = f32x4::splat(c[i].b2);
+      stages[i].a1 = f32x4::splat(c[i].a1);
+      stages[i].a2 = f32x4::splat(c[i].a2);
+    }
+  }
+
+  f32x4 process(f32x4 x) {
+    for (Stage &s : stages) {
+      // transposed direct form II
+      const f32x4 y = fmadd(s.b0, x, s.s1);
+      s.s1 = s.b1 * x - s.a1 * y + s.s2;
+      s.s2 = s.b2 * x - s.a2 * y;
+      x = y;
+    }
+    return x;
+  }
+};
+
+// BS.1770: объёмные каналы 5.1/7.1 с весом 1.41, LFE не учитывается.
+float channel_weight(int ch, int channels) {
+  if (channels >= 6) {
+    if (ch == 3)
+      return 0.0f;
+    if (ch >= 4)
+      return 1.41f;
+  }
+  return 1.0f;
+}
+
+// 4x интерполятор для оценки true peak: 48 отсчётов, 4 фазы по 12.
+// Коэффициенты транспонированы — все фазы считаются одной f32x4 на такт.
+constexpr int kTruePeakFactor = 4;
+constexpr int kTruePeakTaps = 12;
+
+const std::array<f32x4, kTruePeakTaps> &true_peak_coeffs() {
+  static const std::array<f32x4, kTruePeakTaps> coeffs = [] {
+    const auto h = fir::interpolation_lowpass(
+        kTruePeakFactor, kTruePeakFactor * kTruePeakTaps, 0.9, 7.0);
+    std::array<f32x4, kTruePeakTaps> out{};
+    for (int k = 0; k < kTruePeakTaps; ++k) {
+      float lanes[kTruePeakFactor];
+      for (int p = 0; p < kTruePeakFactor; ++p)
+        lanes[p] = static_cast<float>(h[k * kTruePeakFactor + p]);
+      out[k] = f32x4::load(lanes);
+    }
+    return out;
+  }();
+  return coeffs;
+}
+
+class TruePeakDetector {
+public:
+  explicit TruePeakDetector(int channels)
+      : channels_(channels),
+        history_(static_cast<size_t>(channels) * 2 * kTruePeakTaps, 0.0f),
+        coeffs_(true_peak_coeffs()) {}
+
+  // Принимает один interleaved кадр, возвращает max |x| по всем каналам и
+  // интерполированным точкам между предыдущим и текущим отсчётом.
+  float push_frame(const float *frame) {
+    pos_ = (pos_ == 0 ? kTruePeakTaps : pos_) - 1;
+    f32x4 peak = f32x4::zero();
+    for (int ch = 0; ch < channels_; ++ch) {
+      float *hist = history_.data() + ch * 2 * kTruePeakTaps;
+      hist[pos_] = hist[pos_ + kTruePeakTaps] = frame[ch];
+
+      // hist[pos_ + k] == x[n - k]
+      const float *window = hist + pos_;
+      f32x4 acc = f32x4::zero();
+      for (int k = 0; k < kTruePeakTaps; ++k)
+        acc = fmadd(f32x4::splat(window[k]), coeffs_[k], acc);
+      peak = max(peak, abs(acc));
+    }
+    return peak.hmax();
+  }
+
+private:
+  int channels_;
+  std::vector<float> history_;
+  const std::array<f32x4, kTruePeakTaps> &coeffs_;
+  int pos_ = 0;
+};
+
+double energy_to_lufs(double z) {
+  return z > 0.0 ? -0.691 + 10.0 * std::log10(z)
+                 : -std::numeric_limits<double>::infinity();
+}
+
+double gated_loudness(const std::vector<double> &sub_energy,
+                      const std::vector<size_t> &sub_frames) {
+  // Средний квадрат по каждому блоку 400 мс.
+  std::vector<double> blocks;
+  if (sub_energy.size() < kSubBlocksPerBlock) {
+    double e = 0.0;
+    size_t n = 0;
+    for (size_t i = 0; i < sub_energy.size(); ++i) {
+      e += sub_energy[i];
+      n += sub_frames[i];
+    }
+    if (n > 0)
+      blocks.push_back(e / n);
+  } else {
+    for (size_t j = 0; j + kSubBlocksPerBlock <= sub_energy.size(); ++j) {
+      double e = 0.0;
+      size_t n = 0;
+      for (size_t i = j; i < j + kSubBlocksPerBlock; ++i) {
+        e += sub_energy[i];
+        n += sub_frames[i];
+      }
+      blocks.push_back(e / n);
+    }
+  }
+
+  auto gated_mean = [&](double threshold_lufs) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (double z : blocks) {
+      if (energy_to_lufs(z) > threshold_lufs) {
+        sum += z;
+        ++count;
+      }
+    }
+    return count > 0 ? sum / count : 0.0;
+  };
+
+  const double abs_gated = gated_mean(kAbsoluteGateLufs);
+  if (abs_gated <= 0.0)
+    return -std::numeric_limits<double>::infinity();
+
+  const double relative_gate = energy_to_lufs(abs_gated) + kRelativeGateLu;
+  return energy_to_lufs(
+      gated_mean(std::max(kAbsoluteGateLufs, relative_gate)));
+}
+
+float db_to_gain(float db) { return std::pow(10.0f, db / 20.0f); }
+
+} // namespace
+
+// ------------------------------------------------------------ LoudnessMeter
+
+struct LoudnessMeter::Impl {
+  Impl(int sample_rate, int channels)
+      : channels(channels),
+        hop(std::max<size_t>(1, static_cast<size_t>(std::lround(
+                                    sample_rate * kBlockSeconds /
+                                    kSubBlocksPerBlock)))),
+        groups((channels + 3) / 4),
+        filters(groups, KWeightingLanes(k_weighting_coeffs(sample_rate))),
+        weights(groups), acc(groups, f32x4::zero()), true_peak(channels) {
+    for (int g = 0; g < groups; ++g) {
+      float w[4] = {};
+      for (int lane = 0; lane < 4 && g * 4 + lane < channels; ++lane)
+        w[lane] = channel_weight(g * 4 + lane, channels);
+      weights[g] = f32x4::load(w);
+    }
+  }
+
+  void close_sub_block() {
+    double e = 0.0;
+    for (f32x4 &a : acc) {
+      e += a.hsum();
+      a = f32x4::zero();
+    }
+    sub_energy.push_back(e);
+    sub_frames.push_back(in_hop);
+    in_hop = 0;
+  }
+
+  int channels;
+  size_t hop;
+  int groups;
+  std::vector<KWeightingLanes> filters;
+  std::vector<f32x4> weights;
+  std::vector<f32x4> acc;
+  size_t in_hop = 0;
+  TruePeakDetector true_peak;
+
+  std::vector<double> sub_energy;
+  std::vector<size_t> sub_frames;
+  double sum_sq = 0.0;
+  size_t total_samples = 0;
+  float sample_peak = 0.0f;
+  float tp = 0.0f;
+};
+
+LoudnessMeter::LoudnessMeter(int sample_rate, int channels)
+    : impl_(std::make_unique<Impl>(sample_rate, channels)) {}
+LoudnessMeter::~LoudnessMeter() = default;
+
+void LoudnessMeter::process(const float *frames, size_t count) {
+  Impl &m = *impl_;
+  const int channels = m.channels;
+
+  for (size_t i = 0; i < count; ++i) {
+    const float *frame = frames + i * channels;
+    for (int g = 0; g < m.groups; ++g) {
+      float lanes[4] = {};
+      for (int lane = 0; lane < 4 && g * 4 + lane < channels; ++lane)
+        lanes[lane] = frame[g * 4 + lane];
+      const f32x4 y = m.filters[g].process(f32x4::load(lanes));
+      m.acc[g] = fmadd(y * y, m.weights[g], m.acc[g]);
+    }
+    m.tp = std::max(m.tp, m.true_peak.push_frame(frame));
+    if (++m.in_hop == m.hop)
+      m.close_sub_block();
+  }
+
+  // Пик и RMS — отдельными SIMD-редукциями по всему блоку.
+  for (size_t done = 0; done < count; done += m.hop) {
+    const size_t n = std::min(m.hop, count - done) * channels;
+    const float *block = frames + done * channels;
+    m.sum_sq += simd::sum_squares(block, n);
+    m.sample_peak = std::max(m.sample_peak, simd::peak_abs(block, n));
+  }
+  m.total_samples += count * channels;
+}
+
+LoudnessStats LoudnessMeter::result() const {
+  const Impl &m = *impl_;
+  LoudnessStats stats;
+  if (m.total_samples == 0)
+    return stats;
+
+  std::vector<double> sub_energy = m.sub_energy;
+  std::vector<size_t> sub_frames = m.sub_frames;
+  if (m.in_hop > 0) {
+    double e = 0.0;
+    for (const f32x4 &a : m.acc)
+      e += a.hsum();
+    sub_energy.push_back(e);
+    sub_frames.push_back(m.in_hop);
+  }
+
+  stats.integrated_lufs = gated_loudness(sub_energy, sub_frames);
+  stats.sample_peak = m.sample_peak;
+  stats.true_peak = std::max(m.tp, m.sample_peak);
+  const double mean_sq = m.sum_sq / static_cast<double>(m.total_samples);
+  stats.rms_dbfs = mean_sq > 0.0 ? 10.0 * std::log10(mean_sq)
+                                 : -std::numeric_limits<double>::infinity();
+  return stats;
+}
+
+// --------------------------------------------------------- LookaheadLimiter
+
+// Пик кадра q — max(|x[q]|, true peak интерполятора); интерполятор видит
+// отсчёт ещё kTruePeakTaps - 1 кадров, поэтому окно минимума усиления
+// расширено на эту величину. Огибающая: скользящий минимум -> экспоненциальный
+// release -> скользящее среднее длины lookahead, так что итоговое усиление
+// кадра не превышает допустимого ни в одной точке окна.
+struct LookaheadLimiter::Impl {
+  Impl(int sample_rate, int channels, float gain, const LoudnessParams &p)
+      : channels(channels), gain(gain),
+        ceiling(db_to_gain(p.true_peak_ceiling_db)),
+        lookahead(std::max<size_t>(
+            1, static_cast<size_t>(p.lookahead_ms * 0.001f * sample_rate))),
+        window(lookahead + kTruePeakTaps - 1),
+        release(1.0f - std::exp(-1.0f / std::max(1.0f, p.release_ms * 0.001f *
+                                                            sample_rate))),
+        true_peak(channels), delay(window * channels, 0.0f),
+        smooth(lookahead, 0.0f) {}
+
+  void push_peak(float peak) {
+    while (!peaks.empty() && peaks.back().second <= peak)
+      peaks.pop_back();
+    peaks.emplace_back(read, peak);
+    ++read;
+  }
+
+  void emit(float *out) {
+    const size_t n = written++;
+    while (peaks.front().first < n)
+      peaks.pop_front();
+
+    const float peak = peaks.front().second * gain;
+    const float allowed = peak > ceiling ? ceiling / peak : 1.0f;
+
+    released = std::min(allowed, released + (1.0f - released) * release);
+    if (n == 0) {
+      std::fill(smooth.begin(), smooth.end(), released);
+      smooth_sum = static_cast<double>(released) * lookahead;
+    }
+    smooth_sum += released - smooth[smooth_pos];
+    smooth[smooth_pos] = released;
+    smooth_pos = smooth_pos + 1 == lookahead ? 0 : smooth_pos + 1;
+
+    const float g = gain * static_cast<float>(smooth_sum / lookahead);
+    const float *x = delay.data() + (n % window) * channels;
+    for (int ch = 0; ch < channels; ++ch)
+      out[ch] = x[ch] * g;
+  }
+
+  int channels;
+  float gain;
+  float ceiling;
+  size_t lookahead;
+  size_t window;
+  float release;
+  TruePeakDetector true_peak;
+
+  std::vector<float> delay; // window исходных кадров
+  std::deque<std::pair<size_t, float>> peaks; // убывающий по значению
+  std::vector<float> smooth;
+  double smooth_sum = 0.0;
+  size_t smooth_pos = 0;
+  float released = 1.0f;
+  size_t read = 0;    // кадров принято (включая виртуальные нули flush)
+  size_t received = 0; // настоящих кадров принято
+  size_t written = 0;
+};
+
+LookaheadLimiter::LookaheadLimiter(int sample_rate, int channels, float gain,
+                                   const LoudnessParams &p)
+    : impl_(std::make_unique<Impl>(sample_rate, channels, gain, p)) {}
+LookaheadLimiter::~LookaheadLimiter() = default;
+
+size_t LookaheadLimiter::latency() const { return impl_->window - 1; }
+
+size_t LookaheadLimiter::process(const float *in, size_t count, float *out) {
+  Impl &l = *impl_;
+  const int channels = l.channels;
+  size_t emitted = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    const float *frame = in + i * channels;
+    std::copy(frame, frame + channels,
+              l.delay.data() + (l.received % l.window) * channels);
+    ++l.received;
+
+    float peak = l.true_peak.push_frame(frame);
+    for (int ch = 0; ch < channels; ++ch)
+      peak = std::max(peak, std::fabs(frame[ch]));
+    l.push_peak(peak);
+
+    // Кадру n нужны пики [n, n + window - 1].
+    if (l.read >= l.window)
+      l.emit(out + (emitted++) * channels);
+  }
+  return emitted;
+}
+
+size_t LookaheadLimiter::flush(float *out) {
+  Impl &l = *impl_;
+  size_t emitted = 0;
+  while (l.written < l.received) {
+    if (l.read < l.written + l.window)
+      l.push_peak(0.0f);
+    else
+      l.emit(out + (emitted++) * l.channels);
+  }
+  return emitted;
+}
+
+float normalization_gain(const LoudnessStats &stats, const LoudnessParams &p) {
+  if (!std::isfinite(stats.integrated_lufs))
+    return 1.0f;
+  const float gain_db = std::min(
+      p.target_lufs - static_cast<float>(stats.integrated_lufs), p.max_gain_db);
+  return db_to_gain(gain_db);
+}
+
+bool needs_limiter(const LoudnessStats &stats, float gain,
+                   const LoudnessParams &p) {
+  return stats.true_peak * gain > db_to_gain(p.true_peak_ceiling_db);
+}
+
+LoudnessStats measure_loudness(const AudioBuffer &buffer) {
+  if (buffer.sample_rate <= 0 || buffer.channels <= 0 ||
+      buffer.samples.empty()) {
+    return {};
+  }
+  LoudnessMeter meter(buffer.sample_rate, buffer.channels);
+  meter.process(buffer.samples.data(),
+                buffer.samples.size() / buffer.channels);
+  return meter.result();
+}
+
+LoudnessStats normalize_loudness(AudioBuffer &buffer, const LoudnessParams &p) {
+  const metrics::StageTimer timer(metrics::Stage::Loudness);
+  const LoudnessStats stats = measure_loudness(buffer);
+  if (!std::isfinite(stats.integrated_lufs))
+    return stats;
+
+  const int channels = buffer.channels;
+  const size_t frames = buffer.samples.size() / channels;
+  float *data = buffer.samples.data();
+  const float gain = normalization_gain(stats, p);
+
+  // Лимитер не нужен — одно умножение по всему сигналу.
+  if (!needs_limiter(stats, gain, p)) {
+    const f32x4 g = f32x4::splat(gain);
+    const size_t total = buffer.samples.size();
+    size_t i = 0;
+    for (; i + 4 <= total; i += 4)
+      (f32x4::load(data + i) * g).store(data + i);
+    for (; i < total; ++i)
+      data[i] *= gain;
+    timer.done(frames);
+    return stats;
+  }
+
+  // На месте: лимитер копирует вход к себе до того, как выход (задержанный
+  // на latency) пишется поверх уже прочитанных кадров.
+  constexpr size_t kChunk = 4096;
+  LookaheadLimiter limiter(buffer.sample_rate, channels, gain, p);
+  std::vector<float> out(std::max(kChunk, limiter.latency() + 1) * channels);
+  size_t written = 0;
+  for (size_t read = 0; read < frames; read += kChunk) {
+    const size_t n = std::min(kChunk, frames - read);
+    const size_t emitted =
+        limiter.process(data + read * channels, n, out.data());
+    std::copy(out.begin(), out.begin() + emitted * channels,
+              data + written * channels);
+    written += emitted;
+  }
+  const size_t emitted = limiter.flush(out.data());
+  std::copy(out.begin(), out.begin() + emitted * channels,
+            data + written * channels);
+
+  timer.done(frames);
+  return stats;
+}
+
+} // namespace core
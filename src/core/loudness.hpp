@@ -0,0 +1,71 @@
+#pragma once
+#include <core/audio_buffer.hpp>
+#include <cstddef>
+#include <limits>
+#include <memory>
+
+namespace core {
+
+// Результат измерения по EBU R128 / ITU-R BS.1770-4.
+struct LoudnessStats {
+  // Интегральная громкость (LUFS); -inf для тишины.
+  double integrated_lufs = -std::numeric_limits<double>::infinity();
+  float sample_peak = 0.0f; // линейный, 1.0 == 0 dBFS
+  float true_peak = 0.0f;   // линейный, по 4x передискретизации
+  double rms_dbfs = -std::numeric_limits<double>::infinity();
+};
+
+struct LoudnessParams {
+  float target_lufs = -14.0f;
+  float true_peak_ceiling_db = -1.0f; // dBTP
+  float max_gain_db = 20.0f; // тихие записи не поднимаем бесконечно
+  float lookahead_ms = 5.0f;
+  float release_ms = 80.0f;
+};
+
+// Потоковый измеритель: кадры подаются блоками любого размера.
+class LoudnessMeter {
+public:
+  LoudnessMeter(int sample_rate, int channels);
+  ~LoudnessMeter();
+
+  void process(const float *frames, size_t count);
+  LoudnessStats result() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// Потоковый look-ahead лимитер с нормализующим усилением. Выход задержан на
+// latency() кадров; остаток выдаёт flush().
+class LookaheadLimiter {
+public:
+  LookaheadLimiter(int sample_rate, int channels, float gain,
+                   const LoudnessParams &p);
+  ~LookaheadLimiter();
+
+  size_t latency() const;
+  // Возвращает число кадров, записанных в out (не больше count).
+  size_t process(const float *in, size_t count, float *out);
+  // Выдаёт оставшиеся кадры (не больше latency()).
+  size_t flush(float *out);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// Усиление нормализации по измерению (1.0 для тишины).
+float normalization_gain(const LoudnessStats &stats, const LoudnessParams &p);
+// Нужен ли лимитер после усиления, или хватит простого умножения.
+bool needs_limiter(const LoudnessStats &stats, float gain,
+                   const LoudnessParams &p);
+
+LoudnessStats measure_loudness(const AudioBuffer &buffer);
+
+// Нормализует громкость к target_lufs и ограничивает true peak
+// look-ahead лимитером. Работает на месте, возвращает измерение до обработки.
+LoudnessStats normalize_loudness(AudioBuffer &buffer, const LoudnessParams &p);
+
+} // namespace core
@@ -0,0 +1,327 @@
+#include "core/peaks.hpp"
+
+#include "core/sample_convert.hpp"
+#include "core/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+namespace core {
+
+namespace {
+
+constexpr char kMagic[4] = {'G', 'R', 'P', 'K'};
+constexpr uint32_t kVersion = 1;
+
+struct PeakFileHeader {
+  char magic[4];
+  uint32_t version;
+  int32_t sample_rate;
+  int32_t channels;
+  uint64_t frames;
+  uint64_t cells;
+  uint32_t base_frames;
+  uint32_t reserved;
+};
+
+PeakCell merge(const PeakCell &a, const PeakCell &b) {
+  return {std::min(a.min, b.min), std::max(a.max, b.max),
+          std::sqrt(0.5f * (a.rms * a.rms + b.rms * b.rms))};
+}
+
+} // namespace
+
+void PeakPyramid::build_levels() {
+  levels_.resize(1);
+  while (levels_.back().size() > 1) {
+    const std::vector<PeakCell> &prev = levels_.back();
+    std::vector<PeakCell> next((prev.size() + 1) / 2);
+    for (size_t i = 0; i < next.size(); ++i) {
+      const size_t j = 2 * i;
+      next[i] = j + 1 < prev.size() ? merge(prev[j], prev[j + 1]) : prev[j];
+    }
+    levels_.push_back(std::move(next));
+  }
+}
+
+void PeakPyramid::render(uint64_t first, uint64_t count, size_t width,
+                         PeakCell *out) const {
+  std::fill(out, out + width, PeakCell{});
+  if (empty() || width == 0 || count == 0)
+    return;
+
+  // Самый грубый уровень, ячейка которого ещё не шире колонки: на колонку
+  // приходится не больше трёх ячеек.
+  const double per_column = static_cast<double>(count) / width;
+  size_t lvl = 0;
+  while (lvl + 1 < levels_.size() &&
+         static_cast<double>(kBaseFrames << (lvl + 1)) <= per_column) {
+    ++lvl;
+  }
+  const std::vector<PeakCell> &cells = levels_[lvl];
+  const double cell_frames = static_cast<double>(kBaseFrames << lvl);
+
+  for (size_t x = 0; x < width; ++x) {
+    const double a = first + x * per_column;
+    const double b = a + per_column;
+    const size_t c0 = static_cast<size_t>(a / cell_frames);
+    const size_t c1 = std::min(
+        std::max(c0 + 1, static_cast<size_t>(std::ceil(b / cell_frames))),
+        cells.size());
+    if (c0 >= c1)
+      continue;
+
+    PeakCell m = cells[c0];
+    float sum_sq = m.rms * m.rms;
+    for (size_t c = c0 + 1; c < c1; ++c) {
+      m.min = std::min(m.min, cells[c].min);
+      m.max = std::max(m.max, cells[c].max);
+      sum_sq += cells[c].rms * cells[c].rms;
+    }
+    m.rms = std::sqrt(sum_sq / static_cast<float>(c1 - c0));
+    out[x] = m;
+  }
+}
+
+bool PeakPyramid::save(const std::filesystem::path &path) const {
+  if (empty())
+    return false;
+
+  const std::vector<PeakCell> &base = levels_[0];
+  std::vector<float> flat(base.size() * 3);
+  for (size_t i = 0; i < base.size(); ++i) {
+    flat[3 * i] = base[i].min;
+    flat[3 * i + 1] = base[i].max;
+    flat[3 * i + 2] = base[i].rms;
+  }
+  std::vector<uint16_t> half(flat.size());
+  convert::kernels().f32_to_f16(flat.data(), half.data(), flat.size());
+
+  PeakFileHeader header{};
+  std::copy(kMagic, kMagic + 4, header.magic);
+  header.version = kVersion;
+  header.sample_rate = sample_rate_;
+  header.channels = channels_;
+  header.frames = frames_;
+  header.cells = base.size();
+  header.base_frames = kBaseFrames;
+
+  // Пишем рядом и переименовываем: читатель не увидит полфайла.
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(half.data()),
+              static_cast<std::streamsize>(half.size() * sizeof(uint16_t)));
+    if (!out)
+      return false;
+  }
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+bool PeakPyramid::load(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  PeakFileHeader header{};
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      !std::equal(kMagic, kMagic + 4, header.magic) ||
+      header.version != kVersion || header.base_frames != kBaseFrames ||
+      header.sample_rate <= 0 || header.channels <= 0 ||
+      header.cells != (header.frames + kBaseFrames - 1) / kBaseFrames ||
+      header.cells == 0) {
+    return false;
+  }
+  // Число ячеек из заголовка сверяется с длиной файла до выделения памяти:
+  // битый или чужой sidecar не должен просить гигабайты
+  std::error_code ec;
+  const uint64_t size = std::filesystem::file_size(path, ec);
+  if (ec || size < sizeof(header) ||
+      (size - sizeof(header)) / (3 * sizeof(uint16_t)) != header.cells ||
+      (size - sizeof(header)) % (3 * sizeof(uint16_t)) != 0)
+    return false;
+
+  std::vector<uint16_t> half(header.cells * 3);
+  if (!in.read(reinterpret_cast<char *>(half.data()),
+               static_cast<std::streamsize>(half.size() * sizeof(uint16_t))))
+    return false;
+  std::vector<float> flat(half.size());
+  convert::kernels().f16_to_f32(half.data(), flat.data(), half.size());
+
+  sample_rate_ = header.sample_rate;
+  channels_ = header.channels;
+  frames_ = header.frames;
+  levels_.assign(1, std::vector<PeakCell>(header.cells));
+  for (size_t i = 0; i < header.cells; ++i)
+    levels_[0][i] = {flat[3 * i], flat[3 * i + 1], flat[3 * i + 2]};
+  build_levels();
+  return true;
+}
+
+void PeakBuilder::start(int sample_rate, int channels) {
+  pyramid_ = PeakPyramid{};
+  pyramid_.sample_rate_ = sample_rate;
+  pyramid_.channels_ = channels;
+  pyramid_.levels_.resize(1);
+  cell_ = PeakCell{};
+  cell_sum_sq_ = 0.0;
+  cell_frames_ = 0;
+}
+
+void PeakBuilder::add(const float *frames, size_t count) {
+  const int channels = pyramid_.channels_;
+  if (channels <= 0)
+    return;
+
+  while (count > 0) {
+    const size_t take =
+        std::min(count, PeakPyramid::kBaseFrames - cell_frames_);
+    const size_t n = take * channels;
+
+    float lo = 0.0f, hi = 0.0f;
+    simd::min_max(frames, n, lo, hi);
+    if (cell_frames_ == 0) {
+      cell_.min = lo;
+      cell_.max = hi;
+    } else {
+      cell_.min = std::min(cell_.min, lo);
+      cell_.max = std::max(cell_.max, hi);
+    }
+    cell_sum_sq_ += simd::sum_squares(frames, n);
+
+    cell_frames_ += take;
+    pyramid_.frames_ += take;
+    frames += n;
+    count -= take;
+    if (cell_frames_ == PeakPyramid::kBaseFrames)
+      close_cell();
+  }
+}
+
+void PeakBuilder::close_cell() {
+  cell_.rms = static_cast<float>(std::sqrt(
+      cell_sum_sq_ / static_cast<double>(cell_frames_ * pyramid_.channels_)));
+  pyramid_.levels_[0].push_back(cell_);
+  cell_ = PeakCell{};
+  cell_sum_sq_ = 0.0;
+  cell_frames_ = 0;
+}
+
+PeakPyramid PeakBuilder::finish() {
+  if (pyramid_.levels_.empty())
+    return {};
+  if (cell_frames_ > 0)
+    close_cell();
+  pyramid_.build_levels();
+  PeakPyramid done = std::move(pyramid_);
+  pyramid_ = PeakPyramid{};
+  return done;
+}
+
+PeakPyramid build_peaks(const AudioBuffer &buffer) {
+  if (buffer.sample_rate <= 0 || buffer.channels <= 0)
+    return {};
+  PeakBuilder builder;
+  builder.start(buffer.sample_rate, buffer.channels);
+  builder.add(buffer.samples.data(), buffer.samples.size() / buffer.channels);
+  return builder.finish();
+}
+
+PeakPyramid build_peaks(const CompactAudioBuffer &buffer) {
+  if (buffer.sample_rate <= 0 || buffer.channels <= 0)
+    return {};
+  constexpr size_t kBlockFrames = 4096;
+  const size_t frames = buffer.samples.size() / buffer.channels;
+  std::vector<float> block(kBlockFrames * buffer.channels);
+
+  PeakBuilder builder;
+  builder.start(buffer.sample_rate, buffer.channels);
+  for (size_t done = 0; done < frames; done += kBlockFrames) {
+    const size_t count = std::min(kBlockFrames, frames - done);
+    decode_compact(buffer.format,
+                   buffer.samples.data() + done * buffer.channels,
+                   block.data(), count * buffer.channels);
+    builder.add(block.data(), count);
+  }
+  return builder.finish();
+}
+
+uint64_t content_hash(const std::filesystem::path &file) {
+  std::error_code ec;
+  const uint64_t size = std::filesystem::file_size(file, ec);
+  std::ifstream in(file, std::ios::binary);
+  if (ec || !in)
+    return 0;
+
+  uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](const void *data, size_t n) {
+    const auto *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < n; ++i) {
+      h ^= p[i];
+      h *= 1099511628211ull;
+    }
+  };
+  mix(&size, sizeof(size));
+  // Правка вне трёх участков с тем же размером видна по mtime (и по inode,
+  // если файл заменили переименованием)
+  const auto mtime =
+      std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+  if (ec)
+    return 0;
+  mix(&mtime, sizeof(mtime));
+#if defined(__unix__) || defined(__APPLE__)
+  struct stat st {};
+  if (::stat(file.c_str(), &st) == 0) {
+    const uint64_t id[2] = {static_cast<uint64_t>(st.st_dev),
+                            static_cast<uint64_t>(st.st_ino)};
+    mix(id, sizeof(id));
+  }
+#endif
+
+  constexpr uint64_t kChunk = 64 * 1024;
+  std::vector<char> chunk(kChunk);
+  const uint64_t middle = size > kChunk ? size / 2 - kChunk / 2 : 0;
+  const uint64_t tail = size > kChunk ? size - kChunk : 0;
+  for (uint64_t offset : {uint64_t{0}, middle, tail}) {
+    const uint64_t n = std::min(kChunk, size - offset);
+    in.seekg(static_cast<std::streamoff>(offset));
+    if (!in.read(chunk.data(), static_cast<std::streamsize>(n)))
+      return 0;
+    mix(chunk.data(), n);
+  }
+  return h ? h : 1;
+}
+
+std::filesystem::path default_peak_cache_dir() {
+  if (const char *env = std::getenv("GRUSTNIFY_PEAK_CACHE"); env && *env)
+    return env;
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+    return std::filesystem::path(xdg) / "grustnify" / "peaks";
+  if (const char *home = std::getenv("HOME"); home && *home)
+    return std::filesystem::path(home) / ".cache" / "grustnify" / "peaks";
+  std::error_code ec;
+  return std::filesystem::temp_directory_path(ec) / "grustnify-peaks";
+}
+
+std::filesystem::path peak_cache_path(const std::filesystem::path &cache_dir,
+                                      uint64_t hash) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.peaks",
+                static_cast<unsigned long long>(hash));
+  return cache_dir / name;
+}
+
+} // namespace core
@@ -0,0 +1,87 @@
+#pragma once
+#include <core/audio_buffer.hpp>
+#include <core/compact_buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Пирамида пиков для отрисовки волны: min/max/RMS по ячейкам, каждый уровень
+// вдвое грубее предыдущего. Колонка на экране собирается из нескольких ячеек
+// подходящего уровня, так что отрисовка стоит O(пикселей) при любом зуме.
+namespace core {
+
+// Сводка по всем каналам кадров ячейки.
+struct PeakCell {
+  float min = 0.0f;
+  float max = 0.0f;
+  float rms = 0.0f;
+};
+
+class PeakPyramid {
+public:
+  static constexpr std::size_t kBaseFrames = 256; // кадров в ячейке уровня 0
+
+  int sample_rate() const { return sample_rate_; }
+  int channels() const { return channels_; }
+  uint64_t frames() const { return frames_; }
+  bool empty() const { return levels_.empty() || levels_[0].empty(); }
+
+  std::size_t levels() const { return levels_.size(); }
+  const std::vector<PeakCell> &level(std::size_t i) const {
+    return levels_[i];
+  }
+
+  // width колонок на кадры [first, first + count). Ближе kBaseFrames кадров
+  // на колонку пирамида не детализирует: соседние колонки берут одну ячейку.
+  void render(uint64_t first, uint64_t count, std::size_t width,
+              PeakCell *out) const;
+
+  // Компактный sidecar: заголовок + уровень 0 в half float (6 байт на
+  // ячейку); остальные уровни строятся при загрузке.
+  bool save(const std::filesystem::path &path) const;
+  bool load(const std::filesystem::path &path);
+
+private:
+  friend class PeakBuilder;
+  void build_levels();
+
+  int sample_rate_ = 0;
+  int channels_ = 0;
+  uint64_t frames_ = 0;
+  std::vector<std::vector<PeakCell>> levels_;
+};
+
+// Однопроходная сборка: кадры подаются блоками любого размера (декодер,
+// выход DSP), на каждую ячейку — одна SIMD-редукция.
+class PeakBuilder {
+public:
+  void start(int sample_rate, int channels);
+  void add(const float *frames, std::size_t count);
+  PeakPyramid finish();
+
+private:
+  void close_cell();
+
+  PeakPyramid pyramid_;
+  PeakCell cell_;
+  double cell_sum_sq_ = 0.0;
+  std::size_t cell_frames_ = 0;
+};
+
+PeakPyramid build_peaks(const AudioBuffer &buffer);
+PeakPyramid build_peaks(const CompactAudioBuffer &buffer);
+
+// Ключ кэша: FNV-1a по размеру, mtime, устройству и inode файла и трём
+// участкам по 64 КиБ (начало, середина, конец). Читает не больше 192 КиБ
+// независимо от длины файла; правку вне участков ловят метаданные.
+// 0 — файл не читается.
+uint64_t content_hash(const std::filesystem::path &file);
+
+// $GRUSTNIFY_PEAK_CACHE, иначе $XDG_CACHE_HOME/grustnify/peaks,
+// иначе ~/.cache/grustnify/peaks (или системный temp).
+std::filesystem::path default_peak_cache_dir();
+std::filesystem::path peak_cache_path(const std::filesystem::path &cache_dir,
+                                      uint64_t hash);
+
+} // namespace core
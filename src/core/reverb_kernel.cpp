@@ -0,0 +1,287 @@
+#include "core/reverb_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace core {
+
+namespace reverb_detail {
+
+SchroederGains::SchroederGains(const ReverbParams &p) {
+  const float mix = std::clamp(p.mix, 0.0f, 1.0f);
+  const float room_size = std::clamp(p.room_size, 0.0f, 1.0f);
+  const float damp = std::clamp(p.damp, 0.0f, 1.0f);
+
+  feedback = kBaseFeedback + room_size * 0.2f; // ~0.75..0.95
+  comb = feedback * (1.0f - damp);
+  dry = 1.0f - mix;
+  wet = mix;
+}
+
+std::vector<uint8_t>
+pack_state(uint32_t pos,
+           std::initializer_list<const std::vector<float> *> parts) {
+  size_t bytes = sizeof(pos);
+  for (const std::vector<float> *v : parts)
+    bytes += v->size() * sizeof(float);
+  std::vector<uint8_t> state(bytes);
+  uint8_t *at = state.data();
+  std::memcpy(at, &pos, sizeof(pos));
+  at += sizeof(pos);
+  for (const std::vector<float> *v : parts) {
+    std::memcpy(at, v->data(), v->size() * sizeof(float));
+    at += v->size() * sizeof(float);
+  }
+  return state;
+}
+
+bool unpack_state(const uint8_t *data, size_t size, uint32_t &pos,
+                  std::initializer_list<std::vector<float> *> parts) {
+  size_t bytes = sizeof(pos);
+  for (const std::vector<float> *v : parts)
+    bytes += v->size() * sizeof(float);
+  if (size != bytes)
+    return false;
+  std::memcpy(&pos, data, sizeof(pos));
+  data += sizeof(pos);
+  for (std::vector<float> *v : parts) {
+    std::memcpy(v->data(), data, v->size() * sizeof(float));
+    data += v->size() * sizeof(float);
+  }
+  return true;
+}
+
+namespace {
+
+constexpr int kLines = kNumCombs + kNumAllpasses;
+
+// Любое число каналов и частота: задержки считаются при создании.
+class SchroederReverbGeneric final : public ReverbProcessor {
+public:
+  SchroederReverbGeneric(int sample_rate, int channels, const ReverbParams &p)
+      : channels_(channels), gains_(p),
+        layout_(RingLayout<kLines>::make(schroeder_delays(sample_rate))),
+        ring_(static_cast<size_t>(layout_.stride) * channels) {}
+
+  void process(const float *in, float *out, size_t frames) override {
+    for (size_t n = 0; n < frames; ++n, ++pos_) {
+      for (int ch = 0; ch < channels_; ++ch) {
+        const size_t i = n * channels_ + ch;
+        out[i] = schroeder_tick(ring_.data() + ch * layout_.stride, layout_,
+                                pos_, in[i], gains_);
+      }
+    }
+  }
+
+  const char *name() const override { return "schroeder-generic"; }
+  float state_peak() const override {
+    return simd::peak_abs(ring_.data(), ring_.size());
+  }
+  std::vector<uint8_t> save_state() const override {
+    return pack_state(pos_, {&ring_});
+  }
+  bool load_state(const uint8_t *data, size_t size) override {
+    return unpack_state(data, size, pos_, {&ring_});
+  }
+
+private:
+  int channels_;
+  SchroederGains gains_;
+  RingLayout<kLines> layout_;
+  std::vector<float> ring_;
+  uint32_t pos_ = 0;
+};
+
+template <int Channels>
+std::unique_ptr<ReverbProcessor> make_specialized(int sample_rate,
+                                                  const ReverbParams &p) {
+  switch (sample_rate) {
+  case 44100:
+    return std::make_unique<SchroederReverb<Channels, 44100>>(p);
+  case 48000:
+    return std::make_unique<SchroederReverb<Channels, 48000>>(p);
+  case 96000:
+    return std::make_unique<SchroederReverb<Channels, 96000>>(p);
+  default:
+    return nullptr;
+  }
+}
+
+// Блок короче самой короткой задержки читает только то, что записано до
+// него, поэтому выходы всех линий за блок известны заранее. Ядро идёт по
+// строкам [линия][такт]: регистр — четыре такта одной линии, матрица
+// Адамара — бабочки между строками, без перестановок внутри регистра и без
+// транспонирования блока.
+template <int Lines> class FdnReverb final : public ReverbProcessor {
+  static constexpr size_t kBlock = 128;
+  static constexpr size_t kRow = kBlock + 4; // x[-1], x[0..kBlock), запас
+  using f32x4 = simd::f32x4;
+
+public:
+  FdnReverb(int sample_rate, int channels, const ReverbParams &p)
+      : channels_(channels), lines_(Lines * kRow), feed_(Lines * kBlock),
+        dry_block_(kBlock), wet_block_(kBlock) {
+    constexpr int kStep = 16 / Lines;
+    std::array<int, Lines> delays{};
+    for (int i = 0; i < Lines; ++i)
+      delays[i] = delay_samples(kFdnDelaysMs[i * kStep + kStep - 1],
+                                sample_rate);
+    layout_ = RingLayout<Lines>::make(delays, 1); // ФНЧ читает x[t - 1]
+    block_ = std::min<size_t>(
+        kBlock, static_cast<size_t>(*std::min_element(delays.begin(),
+                                                      delays.end())));
+    ring_.assign(static_cast<size_t>(layout_.stride) * channels, 0.0f);
+
+    // Усиление линии подбирается под её длину: спад на секунду одинаков,
+    // и ни одна мода не звенит дольше остальных. Демпфирование —
+    // однонулевой ФНЧ (1 - b) + b z^-1 с тем же усилением на нуле и на
+    // Найквисте, что у однополюсного с коэффициентом d: b = d / (1 + d).
+    // Он зависит только от прошлого выхода линии, который лежит в кольце,
+    // так что такты блока независимы. Всё это вместе с нормировкой матрицы
+    // сводится к двум коэффициентам на линию.
+    const SchroederGains base(p);
+    const float reference = static_cast<float>(
+        delay_samples(kFdnReferenceMs, sample_rate));
+    const float damping = std::clamp(p.damp, 0.0f, 1.0f) * kFdnMaxDamping;
+    const float b = damping / (1.0f + damping);
+    for (int i = 0; i < Lines; ++i) {
+      const float gain = std::pow(base.feedback,
+                                  static_cast<float>(delays[i]) / reference) *
+                         hadamard_scale(Lines);
+      tap_now_[i] = f32x4::splat(gain * (1.0f - b));
+      tap_prev_[i] = f32x4::splat(gain * b);
+    }
+    dry_ = base.dry;
+    wet_ = base.wet;
+  }
+
+  void process(const float *in, float *out, size_t frames) override {
+    for (size_t done = 0; done < frames;) {
+      const size_t n = std::min(block_, frames - done);
+      for (int ch = 0; ch < channels_; ++ch)
+        process_block(ch, in + done * channels_ + ch,
+                      out + done * channels_ + ch, n);
+      done += n;
+      pos_ += static_cast<uint32_t>(n);
+    }
+  }
+
+  const char *name() const override { return Lines == 8 ? "fdn8" : "fdn16"; }
+  float state_peak() const override {
+    return simd::peak_abs(ring_.data(), ring_.size());
+  }
+  std::vector<uint8_t> save_state() const override {
+    return pack_state(pos_, {&ring_});
+  }
+  bool load_state(const uint8_t *data, size_t size) override {
+    return unpack_state(data, size, pos_, {&ring_});
+  }
+
+private:
+  void process_block(int ch, const float *in, float *out, size_t n) {
+    float *ring = ring_.data() + ch * layout_.stride;
+    float *dry = dry_block_.data();
+    float *wet = wet_block_.data();
+
+    // Строка линии — её выходы с такта -1
+    float *lines = lines_.data();
+    float *feed = feed_.data();
+    for (int i = 0; i < Lines; ++i)
+      copy_from_ring(ring + layout_.offset[i], layout_.mask[i],
+                     pos_ - layout_.delay[i] - 1, lines + i * kRow, n + 1);
+    for (size_t t = 0; t < n; ++t)
+      dry[t] = in[t * channels_];
+
+    // По четыре такта; хвост блока до кратного четырём — мусор, который
+    // никуда не пишется
+    for (size_t t = 0; t < n; t += 4) {
+      f32x4 v[Lines];
+      f32x4 acc = f32x4::zero();
+      unroll<Lines>([&](auto i) {
+        const float *row = lines + i * kRow + t;
+        const f32x4 now = f32x4::load(row + 1);
+        // Выход — сумма линий с чередующимся знаком
+        acc = (i & 1) ? acc - now : acc + now;
+        v[i] = fmadd(now, tap_now_[i], f32x4::load(row) * tap_prev_[i]);
+      });
+      hadamard_mix<Lines>(v);
+      const f32x4 x = f32x4::load(dry + t);
+      unroll<Lines>([&](auto i) { (v[i] + x).store(feed + i * kBlock + t); });
+      acc.store(wet + t);
+    }
+
+    for (size_t t = 0; t < n; ++t)
+      out[t * channels_] = dry_ * dry[t] + wet_ * wet[t];
+    for (int i = 0; i < Lines; ++i)
+      copy_to_ring(feed + i * kBlock, ring + layout_.offset[i],
+                   layout_.mask[i], pos_, n);
+  }
+
+  static void copy_from_ring(const float *line, uint32_t mask, uint32_t from,
+                             float *dst, size_t n) {
+    const size_t at = from & mask;
+    const size_t first = std::min<size_t>(n, mask + 1 - at);
+    std::copy_n(line + at, first, dst);
+    std::copy_n(line, n - first, dst + first);
+  }
+
+  static void copy_to_ring(const float *src, float *line, uint32_t mask,
+                           uint32_t to, size_t n) {
+    const size_t at = to & mask;
+    const size_t first = std::min<size_t>(n, mask + 1 - at);
+    std::copy_n(src, first, line + at);
+    std::copy_n(src + first, n - first, line);
+  }
+
+  int channels_;
+  RingLayout<Lines> layout_;
+  size_t block_ = kBlock;
+  std::array<f32x4, Lines> tap_now_{};  // усиление при x[t]
+  std::array<f32x4, Lines> tap_prev_{}; // усиление при x[t - 1]
+  float dry_ = 1.0f;
+  float wet_ = 0.0f;
+  std::vector<float> ring_;
+  std::vector<float> lines_;     // выходы линий за блок
+  std::vector<float> feed_;      // вход линий за блок
+  std::vector<float> dry_block_; // канал входа подряд
+  std::vector<float> wet_block_; // выход сети за блок
+  uint32_t pos_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<ReverbProcessor> make_fdn(int sample_rate, int channels,
+                                          const ReverbParams &p) {
+  if (p.algorithm == ReverbAlgorithm::Fdn16)
+    return std::make_unique<FdnReverb<16>>(sample_rate, channels, p);
+  return std::make_unique<FdnReverb<8>>(sample_rate, channels, p);
+}
+
+std::unique_ptr<ReverbProcessor> make_generic(int sample_rate, int channels,
+                                              const ReverbParams &p) {
+  return std::make_unique<SchroederReverbGeneric>(sample_rate, channels, p);
+}
+
+} // namespace reverb_detail
+
+std::unique_ptr<ReverbProcessor> make_reverb_processor(int sample_rate,
+                                                       int channels,
+                                                       const ReverbParams &p) {
+  using namespace reverb_detail;
+
+  if (p.algorithm != ReverbAlgorithm::Schroeder)
+    return make_fdn(sample_rate, channels, p);
+
+  std::unique_ptr<ReverbProcessor> proc;
+  if (channels == 1)
+    proc = make_specialized<1>(sample_rate, p);
+  else if (channels == 2)
+    proc = make_specialized<2>(sample_rate, p);
+
+  if (!proc)
+    proc = make_generic(sample_rate, channels, p);
+  return proc;
+}
+
+} // namespace core
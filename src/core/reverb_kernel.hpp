@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <core/activity.hpp>
+#include <core/audio_buffer.hpp>
+#include <core/simd.hpp>
+
+namespace core {
+
+// Потоковый ревербератор: interleaved float, in == out допускается.
+class ReverbProcessor {
+public:
+  virtual ~ReverbProcessor() = default;
+  virtual void process(const float *in, float *out, size_t frames) = 0;
+  virtual const char *name() const = 0;
+  // Наибольший |x| во внутреннем состоянии (линии, фильтры): ниже порога
+  // выход уже не слышен, и хвост можно не рендерить.
+  virtual float state_peak() const = 0;
+  // Линии задержки и индексы как байты — для checkpoint'а долгого рендера.
+  // load_state принимает только состояние процессора той же конфигурации.
+  virtual std::vector<uint8_t> save_state() const = 0;
+  virtual bool load_state(const uint8_t *data, size_t size) = 0;
+};
+
+// Schroeder: специализированное ядро для (каналы, частота) из таблицы ниже,
+// иначе — generic-вариант с задержками, посчитанными во время выполнения.
+// Fdn8/Fdn16 — см. make_fdn().
+std::unique_ptr<ReverbProcessor> make_reverb_processor(int sample_rate,
+                                                       int channels,
+                                                       const ReverbParams &p);
+
+// Хвост после конца входа: тишина блоками по block_frames, каждый блок —
+// в sink(const float *interleaved, size_t frames). Останавливается, когда
+// состояние затихло ниже p.tail_threshold или прошло p.tail_max_seconds.
+template <typename Sink>
+void render_tail(ReverbProcessor &proc, int sample_rate, int channels,
+                 const ReverbParams &p, size_t block_frames, Sink &&sink) {
+  const size_t limit = static_cast<size_t>(
+      std::max(0.0f, p.tail_max_seconds) * static_cast<float>(sample_rate));
+  std::vector<float> block(block_frames * channels);
+  for (size_t done = 0; done < limit;) {
+    if (proc.state_peak() < p.tail_threshold)
+      break;
+    const size_t n = std::min(block_frames, limit - done);
+    std::fill_n(block.data(), n * channels, 0.0f);
+    proc.process(block.data(), block.data(), n);
+    sink(static_cast<const float *>(block.data()), n);
+    done += n;
+  }
+}
+
+// Пропуск тишины по карте активности входа: тихий блок считается нулевым,
+// а блок из нулей при нулевом состоянии даёт нули и оставляет состояние
+// нулевым, так что process() можно не вызывать. Для точных нулей на входе
+// (так их оставляет change_speed) результат тот же бит в бит. state_peak()
+// проходит по всем линиям, поэтому его проверяют, только когда прошлый
+// тихий блок уже вышел нулевым.
+class SilenceSkip {
+public:
+  explicit SilenceSkip(const ActivityMap *activity) : activity_(activity) {}
+
+  // true — кадры [first, first + count) не обрабатываются, выход — нули
+  bool skip(const ReverbProcessor &proc, size_t first, size_t count) {
+    silent_ = activity_ && !activity_->any_active(first, first + count);
+    if (!silent_) {
+      idle_ = false;
+      return false;
+    }
+    if (!idle_ && quiet_)
+      idle_ = proc.state_peak() == 0.0f;
+    return idle_;
+  }
+  // После process(): выход блока
+  void processed(const float *out, size_t n) {
+    quiet_ = silent_ && simd::peak_abs(out, n) == 0.0f;
+  }
+
+private:
+  const ActivityMap *activity_;
+  bool silent_ = false;
+  bool quiet_ = false;
+  bool idle_ = false;
+};
+
+namespace reverb_detail {
+
+inline constexpr int kNumCombs = 4;
+inline constexpr int kNumAllpasses = 2;
+inline constexpr std::array<float, kNumCombs> kCombDelaysMs = {29.7f, 37.1f,
+                                                              41.1f, 43.7f};
+inline constexpr std::array<float, kNumAllpasses> kAllpassDelaysMs = {5.0f,
+                                                                     1.7f};
+inline constexpr float kBaseFeedback = 0.75f;
+inline constexpr float kAllpassGain = 0.5f;
+
+constexpr int delay_samples(float ms, int sample_rate) {
+  const int d = static_cast<int>(ms * 0.001f * sample_rate);
+  return d < 1 ? 1 : d;
+}
+
+// Коэффициенты, общие для всех вариантов ядра.
+struct SchroederGains {
+  explicit SchroederGains(const ReverbParams &p);
+  float feedback; // kBaseFeedback .. +0.2 по room_size
+  float comb;     // feedback * (1 - damp)
+  float dry;
+  float wet;
+};
+
+// Для save_state(): pos, затем массивы подряд. Их размеры задаёт
+// конфигурация процессора, поэтому в байтах их нет — только проверка
+// общей длины.
+std::vector<uint8_t>
+pack_state(uint32_t pos,
+           std::initializer_list<const std::vector<float> *> parts);
+bool unpack_state(const uint8_t *data, size_t size, uint32_t &pos,
+                  std::initializer_list<std::vector<float> *> parts);
+
+// Задержки одного канала: comb'ы, затем allpass'ы. Каждая линия — степень
+// двойки внутри общего непрерывного кольца, индекс (pos - delay) & mask.
+template <int NumLines> struct RingLayout {
+  std::array<uint32_t, NumLines> delay{};
+  std::array<uint32_t, NumLines> mask{};
+  std::array<uint32_t, NumLines> offset{};
+  uint32_t stride = 0; // размер кольца одного канала
+
+  // history — сколько сэмплов старше задержки линия ещё помнит
+  static constexpr RingLayout make(const std::array<int, NumLines> &delays,
+                                   uint32_t history = 0) {
+    RingLayout l;
+    for (int i = 0; i < NumLines; ++i) {
+      const uint32_t size =
+          std::bit_ceil(static_cast<uint32_t>(delays[i]) + history);
+      l.delay[i] = static_cast<uint32_t>(delays[i]);
+      l.mask[i] = size - 1;
+      l.offset[i] = l.stride;
+      l.stride += size;
+    }
+    return l;
+  }
+};
+
+constexpr std::array<int, kNumCombs + kNumAllpasses>
+schroeder_delays(int sample_rate) {
+  std::array<int, kNumCombs + kNumAllpasses> d{};
+  for (int i = 0; i < kNumCombs; ++i)
+    d[i] = delay_samples(kCombDelaysMs[i], sample_rate);
+  for (int i = 0; i < kNumAllpasses; ++i)
+    d[kNumCombs + i] = delay_samples(kAllpassDelaysMs[i], sample_rate);
+  return d;
+}
+
+// Один такт одного канала сети 4 comb + 2 allpass. Layout — либо constexpr
+// (специализация), либо вычисленный во время выполнения (generic).
+template <typename Layout>
+inline float schroeder_tick(float *ring, const Layout &l, uint32_t pos,
+                            float x, const SchroederGains &g) {
+  float comb_sum = 0.0f;
+  for (int i = 0; i < kNumCombs; ++i) {
+    float *line = ring + l.offset[i];
+    const float y = line[(pos - l.delay[i]) & l.mask[i]];
+    line[pos & l.mask[i]] = x + y * g.comb;
+    comb_sum += y;
+  }
+
+  float ap = comb_sum;
+  for (int i = kNumCombs; i < kNumCombs + kNumAllpasses; ++i) {
+    float *line = ring + l.offset[i];
+    const float buf_y = line[(pos - l.delay[i]) & l.mask[i]];
+    const float v = ap - buf_y;
+    line[pos & l.mask[i]] = ap + buf_y * kAllpassGain;
+    ap = v;
+  }
+
+  return g.dry * x + g.wet * ap;
+}
+
+// Число и длины линий заданы таблицами выше; специализируются каналы и
+// частота, от которой зависят задержки в сэмплах.
+template <int Channels, int SampleRate>
+class SchroederReverb final : public ReverbProcessor {
+  static constexpr int kLines = kNumCombs + kNumAllpasses;
+  static constexpr RingLayout<kLines> kLayout =
+      RingLayout<kLines>::make(schroeder_delays(SampleRate));
+
+public:
+  explicit SchroederReverb(const ReverbParams &p)
+      : gains_(p), ring_(static_cast<size_t>(kLayout.stride) * Channels) {}
+
+  void process(const float *in, float *out, size_t frames) override {
+    for (size_t n = 0; n < frames; ++n, ++pos_) {
+      for (int ch = 0; ch < Channels; ++ch) {
+        out[n * Channels + ch] = schroeder_tick(
+            ring_.data() + ch * kLayout.stride, kLayout, pos_,
+            in[n * Channels + ch], gains_);
+      }
+    }
+  }
+
+  const char *name() const override { return "schroeder-specialized"; }
+  float state_peak() const override {
+    return simd::peak_abs(ring_.data(), ring_.size());
+  }
+  std::vector<uint8_t> save_state() const override {
+    return pack_state(pos_, {&ring_});
+  }
+  bool load_state(const uint8_t *data, size_t size) override {
+    return unpack_state(data, size, pos_, {&ring_});
+  }
+
+private:
+  SchroederGains gains_;
+  std::vector<float> ring_;
+  uint32_t pos_ = 0;
+};
+
+// Generic-вариант напрямую — для тестов и бенчмарков.
+std::unique_ptr<ReverbProcessor> make_generic(int sample_rate, int channels,
+                                              const ReverbParams &p);
+
+// --- FDN ---
+
+// Взаимно простые (в сэмплах на 44.1/48 кГц) задержки, разнесённые по
+// 23..84 мс; 8-линейная сеть берёт каждую вторую.
+inline constexpr std::array<float, 16> kFdnDelaysMs = {
+    23.1f, 26.3f, 29.7f, 32.9f, 36.7f, 40.1f, 43.7f, 47.9f,
+    51.1f, 55.3f, 59.9f, 63.7f, 68.3f, 73.1f, 77.9f, 83.3f};
+// Задержка, для которой усиление петли равно feedback Schroeder'а: при
+// том же room_size время спада совпадает.
+inline constexpr float kFdnReferenceMs = 40.0f;
+// Демпфирование при damp = 1: ФНЧ в петле глушит Найквист, как
+// однополюсный с этим коэффициентом
+inline constexpr float kFdnMaxDamping = 0.7f;
+
+// f(integral_constant<int, I>) для I = 0..N-1 подряд. Циклы по линиям
+// -O2 не разворачивает, и строки FDN уходят из регистров в память.
+template <int N, typename F> inline void unroll(F &&f) {
+  [&]<int... I>(std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+  }(std::make_integer_sequence<int, N>{});
+}
+
+// Матрица Адамара над Lines строками (в ядре строка — регистр с четырьмя
+// тактами одной линии): бабочки между строками. Без нормировки: множитель
+// hadamard_scale() ядро вносит в усиления линий, и матрица ортогональна.
+template <int Lines, typename V> inline void hadamard_mix(V *v) {
+  static_assert(Lines == 4 || Lines == 8 || Lines == 16);
+  unroll<std::bit_width(unsigned{Lines}) - 1>([&](auto stage) {
+    constexpr int stride = 1 << stage;
+    unroll<Lines / 2>([&](auto j) {
+      constexpr int k = j / stride * 2 * stride + j % stride;
+      const V a = v[k], b = v[k + stride];
+      v[k] = a + b;
+      v[k + stride] = a - b;
+    });
+  });
+}
+
+constexpr float hadamard_scale(int lines) {
+  return lines == 4 ? 0.5f : lines == 8 ? 0.35355339f : 0.25f;
+}
+
+// FDN на 8 или 16 линий (по p.algorithm), любые частота и число каналов.
+std::unique_ptr<ReverbProcessor> make_fdn(int sample_rate, int channels,
+                                          const ReverbParams &p);
+
+} // namespace reverb_detail
+
+} // namespace core
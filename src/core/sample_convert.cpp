@@ -0,0 +1,790 @@
+#include "core/sample_convert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRUSTNIFY_CONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define GRUSTNIFY_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace core::convert {
+
+namespace {
+
+constexpr float kS16Scale = 32768.0f;
+constexpr float kS16Inv = 1.0f / 32768.0f;
+constexpr float kS32Inv = 1.0f / 2147483648.0f;
+constexpr float kUniformScale = 1.0f / 4294967296.0f; // int32 -> [-0.5, 0.5)
+
+inline uint32_t xorshift32(uint32_t &s) {
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+// ---------------------------------------------------------------- scalar ---
+
+void s16_to_f32_scalar(const int16_t *in, float *out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = in[i] * kS16Inv;
+}
+
+void s32_to_f32_scalar(const int32_t *in, float *out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = static_cast<float>(in[i]) * kS32Inv;
+}
+
+inline int16_t f32_to_s16_one(float x, DitherState *dither) {
+  float v = x * kS16Scale;
+  if (dither) {
+    const float a = static_cast<int32_t>(xorshift32(dither->lanes[0])) *
+                    kUniformScale;
+    const float b = static_cast<int32_t>(xorshift32(dither->lanes[0])) *
+                    kUniformScale;
+    v += a + b;
+  }
+  v = std::min(std::max(v, -32768.0f), 32767.0f);
+  return static_cast<int16_t>(std::lrintf(v));
+}
+
+void f32_to_s16_scalar(const float *in, int16_t *out, size_t n,
+                       DitherState *dither) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f32_to_s16_one(in[i], dither);
+}
+
+void f16_to_f32_scalar(const uint16_t *in, float *out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f16_to_f32(in[i]);
+}
+
+void f32_to_f16_scalar(const float *in, uint16_t *out, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f32_to_f16(in[i]);
+}
+
+void deinterleave_f32_scalar(const float *in, float *const *out, size_t frames,
+                             int channels) {
+  for (size_t n = 0; n < frames; ++n)
+    for (int ch = 0; ch < channels; ++ch)
+      out[ch][n] = in[n * channels + ch];
+}
+
+void interleave_f32_scalar(const float *const *in, float *out, size_t frames,
+                           int channels) {
+  for (size_t n = 0; n < frames; ++n)
+    for (int ch = 0; ch < channels; ++ch)
+      out[n * channels + ch] = in[ch][n];
+}
+
+constexpr Kernels kScalar = {Isa::Scalar,           s16_to_f32_scalar,
+                             s32_to_f32_scalar,     f32_to_s16_scalar,
+                             deinterleave_f32_scalar, interleave_f32_scalar,
+                             f16_to_f32_scalar,     f32_to_f16_scalar};
+
+#if defined(GRUSTNIFY_CONVERT_X86)
+
+// ------------------------------------------------------------------ SSE2 ---
+
+__attribute__((target("sse2"))) void
+s16_to_f32_sse2(const int16_t *in, float *out, size_t n) {
+  const __m128 scale = _mm_set1_ps(kS16Inv);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+  s16_to_f32_scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("sse2"))) void
+s32_to_f32_sse2(const int32_t *in, float *out, size_t n) {
+  const __m128 scale = _mm_set1_ps(kS32Inv);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+  }
+  s32_to_f32_scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("sse2"))) inline __m128i
+xorshift_sse2(__m128i &s) {
+  s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+  s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+  s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+  return s;
+}
+
+// x * 32768 (+ TPDF) -> int32 с ограничением до диапазона s16
+__attribute__((target("sse2"))) inline __m128i
+scale_to_s32_sse2(const float *p, __m128 scale, __m128 lo_clip, __m128 hi_clip,
+                  __m128 uni, DitherState *dither, __m128i &rng) {
+  __m128 v = _mm_mul_ps(_mm_loadu_ps(p), scale);
+  if (dither) {
+    const __m128 a = _mm_cvtepi32_ps(xorshift_sse2(rng));
+    const __m128 b = _mm_cvtepi32_ps(xorshift_sse2(rng));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_add_ps(a, b), uni));
+  }
+  return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, lo_clip), hi_clip));
+}
+
+__attribute__((target("sse2"))) void
+f32_to_s16_sse2(const float *in, int16_t *out, size_t n, DitherState *dither) {
+  const __m128 scale = _mm_set1_ps(kS16Scale);
+  const __m128 lo_clip = _mm_set1_ps(-32768.0f);
+  const __m128 hi_clip = _mm_set1_ps(32767.0f);
+  const __m128 uni = _mm_set1_ps(kUniformScale);
+  __m128i rng = dither ? _mm_load_si128(
+                             reinterpret_cast<const __m128i *>(dither->lanes))
+                       : _mm_setzero_si128();
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i a =
+        scale_to_s32_sse2(in + i, scale, lo_clip, hi_clip, uni, dither, rng);
+    const __m128i b = scale_to_s32_sse2(in + i + 4, scale, lo_clip, hi_clip,
+                                        uni, dither, rng);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packs_epi32(a, b));
+  }
+  if (dither)
+    _mm_store_si128(reinterpret_cast<__m128i *>(dither->lanes), rng);
+  f32_to_s16_scalar(in + i, out + i, n - i, dither);
+}
+
+__attribute__((target("sse2"))) void
+deinterleave_f32_sse2(const float *in, float *const *out, size_t frames,
+                      int channels) {
+  if (channels != 2) {
+    deinterleave_f32_scalar(in, out, frames, channels);
+    return;
+  }
+  float *l = out[0];
+  float *r = out[1];
+  size_t n = 0;
+  for (; n + 4 <= frames; n += 4) {
+    const __m128 a = _mm_loadu_ps(in + 2 * n);     // L0 R0 L1 R1
+    const __m128 b = _mm_loadu_ps(in + 2 * n + 4); // L2 R2 L3 R3
+    _mm_storeu_ps(l + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(r + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  for (; n < frames; ++n) {
+    l[n] = in[2 * n];
+    r[n] = in[2 * n + 1];
+  }
+}
+
+__attribute__((target("sse2"))) void
+interleave_f32_sse2(const float *const *in, float *out, size_t frames,
+                    int channels) {
+  if (channels != 2) {
+    interleave_f32_scalar(in, out, frames, channels);
+    return;
+  }
+  const float *l = in[0];
+  const float *r = in[1];
+  size_t n = 0;
+  for (; n + 4 <= frames; n += 4) {
+    const __m128 a = _mm_loadu_ps(l + n);
+    const __m128 b = _mm_loadu_ps(r + n);
+    _mm_storeu_ps(out + 2 * n, _mm_unpacklo_ps(a, b));
+    _mm_storeu_ps(out + 2 * n + 4, _mm_unpackhi_ps(a, b));
+  }
+  for (; n < frames; ++n) {
+    out[2 * n] = l[n];
+    out[2 * n + 1] = r[n];
+  }
+}
+
+constexpr Kernels kSse2 = {Isa::Sse2,           s16_to_f32_sse2,
+                           s32_to_f32_sse2,     f32_to_s16_sse2,
+                           deinterleave_f32_sse2, interleave_f32_sse2,
+                           f16_to_f32_scalar,   f32_to_f16_scalar};
+
+// ------------------------------------------------------------------ AVX2 ---
+
+__attribute__((target("avx2"))) void
+s16_to_f32_avx2(const int16_t *in, float *out, size_t n) {
+  const __m256 scale = _mm256_set1_ps(kS16Inv);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i a = _mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+    const __m256i b = _mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(a), scale));
+    _mm256_storeu_ps(out + i + 8,
+                     _mm256_mul_ps(_mm256_cvtepi32_ps(b), scale));
+  }
+  s16_to_f32_sse2(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void
+s32_to_f32_avx2(const int32_t *in, float *out, size_t n) {
+  const __m256 scale = _mm256_set1_ps(kS32Inv);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+  }
+  s32_to_f32_sse2(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i xorshift_avx2(__m256i &s) {
+  s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+  s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+  s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+  return s;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+scale_to_s32_avx2(const float *p, __m256 scale, __m256 lo_clip, __m256 hi_clip,
+                  __m256 uni, DitherState *dither, __m256i &rng) {
+  __m256 v = _mm256_mul_ps(_mm256_loadu_ps(p), scale);
+  if (dither) {
+    const __m256 a = _mm256_cvtepi32_ps(xorshift_avx2(rng));
+    const __m256 b = _mm256_cvtepi32_ps(xorshift_avx2(rng));
+    v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_add_ps(a, b), uni));
+  }
+  return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo_clip), hi_clip));
+}
+
+__attribute__((target("avx2"))) void
+f32_to_s16_avx2(const float *in, int16_t *out, size_t n, DitherState *dither) {
+  const __m256 scale = _mm256_set1_ps(kS16Scale);
+  const __m256 lo_clip = _mm256_set1_ps(-32768.0f);
+  const __m256 hi_clip = _mm256_set1_ps(32767.0f);
+  const __m256 uni = _mm256_set1_ps(kUniformScale);
+  __m256i rng = dither ? _mm256_load_si256(
+                             reinterpret_cast<const __m256i *>(dither->lanes))
+                       : _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i a =
+        scale_to_s32_avx2(in + i, scale, lo_clip, hi_clip, uni, dither, rng);
+    const __m256i b = scale_to_s32_avx2(in + i + 8, scale, lo_clip, hi_clip,
+                                        uni, dither, rng);
+    // packs работает внутри 128-битных половин — возвращаем порядок
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+  }
+  if (dither)
+    _mm256_store_si256(reinterpret_cast<__m256i *>(dither->lanes), rng);
+  f32_to_s16_sse2(in + i, out + i, n - i, dither);
+}
+
+__attribute__((target("avx2,f16c"))) void
+f16_to_f32_avx2(const uint16_t *in, float *out, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+  }
+  f16_to_f32_scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) void
+f32_to_f16_avx2(const float *in, uint16_t *out, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h =
+        _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), h);
+  }
+  f32_to_f16_scalar(in + i, out + i, n - i);
+}
+
+constexpr Kernels kAvx2 = {Isa::Avx2,           s16_to_f32_avx2,
+                           s32_to_f32_avx2,     f32_to_s16_avx2,
+                           deinterleave_f32_sse2, interleave_f32_sse2,
+                           f16_to_f32_avx2,     f32_to_f16_avx2};
+
+// --------------------------------------------------------------- AVX-512 ---
+
+__attribute__((target("avx512f"))) void
+s16_to_f32_avx512(const int16_t *in, float *out, size_t n) {
+  const __m512 scale = _mm512_set1_ps(kS16Inv);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i x = _mm512_cvtepi16_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i)));
+    _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), scale));
+  }
+  s16_to_f32_avx2(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void
+s32_to_f32_avx512(const int32_t *in, float *out, size_t n) {
+  const __m512 scale = _mm512_set1_ps(kS32Inv);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i x = _mm512_loadu_si512(in + i);
+    _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(x), scale));
+  }
+  s32_to_f32_avx2(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) inline __m512i
+xorshift_avx512(__m512i &s) {
+  s = _mm512_xor_si512(s, _mm512_slli_epi32(s, 13));
+  s = _mm512_xor_si512(s, _mm512_srli_epi32(s, 17));
+  s = _mm512_xor_si512(s, _mm512_slli_epi32(s, 5));
+  return s;
+}
+
+__attribute__((target("avx512f"))) void
+f32_to_s16_avx512(const float *in, int16_t *out, size_t n,
+                  DitherState *dither) {
+  const __m512 scale = _mm512_set1_ps(kS16Scale);
+  const __m512 lo_clip = _mm512_set1_ps(-32768.0f);
+  const __m512 hi_clip = _mm512_set1_ps(32767.0f);
+  const __m512 uni = _mm512_set1_ps(kUniformScale);
+  __m512i rng = dither ? _mm512_load_si512(dither->lanes)
+                       : _mm512_setzero_si512();
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 v = _mm512_mul_ps(_mm512_loadu_ps(in + i), scale);
+    if (dither) {
+      const __m512 a = _mm512_cvtepi32_ps(xorshift_avx512(rng));
+      const __m512 b = _mm512_cvtepi32_ps(xorshift_avx512(rng));
+      v = _mm512_add_ps(v, _mm512_mul_ps(_mm512_add_ps(a, b), uni));
+    }
+    const __m512i x =
+        _mm512_cvtps_epi32(_mm512_min_ps(_mm512_max_ps(v, lo_clip), hi_clip));
+    // сужение с насыщением сохраняет порядок элементов
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm512_cvtsepi32_epi16(x));
+  }
+  if (dither)
+    _mm512_store_si512(dither->lanes, rng);
+  f32_to_s16_avx2(in + i, out + i, n - i, dither);
+}
+
+__attribute__((target("avx512f"))) void
+f16_to_f32_avx512(const uint16_t *in, float *out, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i h =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm512_storeu_ps(out + i, _mm512_cvtph_ps(h));
+  }
+  f16_to_f32_avx2(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void
+f32_to_f16_avx512(const float *in, uint16_t *out, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i h =
+        _mm512_cvtps_ph(_mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), h);
+  }
+  f32_to_f16_avx2(in + i, out + i, n - i);
+}
+
+constexpr Kernels kAvx512 = {Isa::Avx512,         s16_to_f32_avx512,
+                             s32_to_f32_avx512,   f32_to_s16_avx512,
+                             deinterleave_f32_sse2, interleave_f32_sse2,
+                             f16_to_f32_avx512,   f32_to_f16_avx512};
+
+#endif // GRUSTNIFY_CONVERT_X86
+
+#if defined(GRUSTNIFY_CONVERT_NEON)
+
+// ------------------------------------------------------------------ NEON ---
+
+void s16_to_f32_neon(const int16_t *in, float *out, size_t n) {
+  const float32x4_t scale = vdupq_n_f32(kS16Inv);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const int16x8_t x = vld1q_s16(in + i);
+    vst1q_f32(out + i,
+              vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+    vst1q_f32(out + i + 4,
+              vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+  }
+  s16_to_f32_scalar(in + i, out + i, n - i);
+}
+
+void s32_to_f32_neon(const int32_t *in, float *out, size_t n) {
+  const float32x4_t scale = vdupq_n_f32(kS32Inv);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(in + i)), scale));
+  s32_to_f32_scalar(in + i, out + i, n - i);
+}
+
+inline uint32x4_t xorshift_neon(uint32x4_t &s) {
+  s = veorq_u32(s, vshlq_n_u32(s, 13));
+  s = veorq_u32(s, vshrq_n_u32(s, 17));
+  s = veorq_u32(s, vshlq_n_u32(s, 5));
+  return s;
+}
+
+void f32_to_s16_neon(const float *in, int16_t *out, size_t n,
+                     DitherState *dither) {
+  const float32x4_t scale = vdupq_n_f32(kS16Scale);
+  const float32x4_t lo_clip = vdupq_n_f32(-32768.0f);
+  const float32x4_t hi_clip = vdupq_n_f32(32767.0f);
+  const float32x4_t uni = vdupq_n_f32(kUniformScale);
+  uint32x4_t rng = dither ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+
+  auto scaled = [&](const float *p) {
+    float32x4_t v = vmulq_f32(vld1q_f32(p), scale);
+    if (dither) {
+      const float32x4_t a =
+          vcvtq_f32_s32(vreinterpretq_s32_u32(xorshift_neon(rng)));
+      const float32x4_t b =
+          vcvtq_f32_s32(vreinterpretq_s32_u32(xorshift_neon(rng)));
+      v = vmlaq_f32(v, vaddq_f32(a, b), uni);
+    }
+    return vcvtnq_s32_f32(vminq_f32(vmaxq_f32(v, lo_clip), hi_clip));
+  };
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const int32x4_t a = scaled(in + i);
+    const int32x4_t b = scaled(in + i + 4);
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+  if (dither)
+    vst1q_u32(dither->lanes, rng);
+  f32_to_s16_scalar(in + i, out + i, n - i, dither);
+}
+
+void deinterleave_f32_neon(const float *in, float *const *out, size_t frames,
+                           int channels) {
+  if (channels != 2) {
+    deinterleave_f32_scalar(in, out, frames, channels);
+    return;
+  }
+  size_t n = 0;
+  for (; n + 4 <= frames; n += 4) {
+    const float32x4x2_t lr = vld2q_f32(in + 2 * n);
+    vst1q_f32(out[0] + n, lr.val[0]);
+    vst1q_f32(out[1] + n, lr.val[1]);
+  }
+  for (; n < frames; ++n) {
+    out[0][n] = in[2 * n];
+    out[1][n] = in[2 * n + 1];
+  }
+}
+
+void interleave_f32_neon(const float *const *in, float *out, size_t frames,
+                         int channels) {
+  if (channels != 2) {
+    interleave_f32_scalar(in, out, frames, channels);
+    return;
+  }
+  size_t n = 0;
+  for (; n + 4 <= frames; n += 4) {
+    float32x4x2_t lr;
+    lr.val[0] = vld1q_f32(in[0] + n);
+    lr.val[1] = vld1q_f32(in[1] + n);
+    vst2q_f32(out + 2 * n, lr);
+  }
+  for (; n < frames; ++n) {
+    out[2 * n] = in[0][n];
+    out[2 * n + 1] = in[1][n];
+  }
+}
+
+void f16_to_f32_neon(const uint16_t *in, float *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(out + i,
+              vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+  f16_to_f32_scalar(in + i, out + i, n - i);
+}
+
+void f32_to_f16_neon(const float *in, uint16_t *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1_u16(out + i,
+             vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+  f32_to_f16_scalar(in + i, out + i, n - i);
+}
+
+constexpr Kernels kNeon = {Isa::Neon,           s16_to_f32_neon,
+                           s32_to_f32_neon,     f32_to_s16_neon,
+                           deinterleave_f32_neon, interleave_f32_neon,
+                           f16_to_f32_neon,     f32_to_f16_neon};
+
+#endif // GRUSTNIFY_CONVERT_NEON
+
+bool isa_supported(Isa isa) {
+  switch (isa) {
+  case Isa::Scalar:
+    return true;
+#if defined(GRUSTNIFY_CONVERT_X86)
+  case Isa::Sse2:
+    return __builtin_cpu_supports("sse2");
+  case Isa::Avx2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+  case Isa::Avx512:
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+#endif
+#if defined(GRUSTNIFY_CONVERT_NEON)
+  case Isa::Neon:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+const char *isa_name(Isa isa) {
+  switch (isa) {
+  case Isa::Scalar:
+    return "scalar";
+  case Isa::Sse2:
+    return "sse2";
+  case Isa::Avx2:
+    return "avx2";
+  case Isa::Avx512:
+    return "avx512";
+  case Isa::Neon:
+    return "neon";
+  }
+  return "unknown";
+}
+
+// Преобразования binary16 по F. Giesen (RNE, subnormal'ы, inf/NaN).
+uint16_t f32_to_f16(float x) {
+  uint32_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  const uint32_t sign = u & 0x80000000u;
+  u ^= sign;
+
+  uint16_t h;
+  if (u >= (127u + 16u) << 23) {
+    h = u > (255u << 23) ? 0x7e00 : 0x7c00; // NaN / переполнение в inf
+  } else if (u < (113u << 23)) {
+    // subnormal или ноль: выравнивание мантиссы сложением с магией
+    const uint32_t magic_u = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    float f, magic;
+    std::memcpy(&f, &u, sizeof(f));
+    std::memcpy(&magic, &magic_u, sizeof(magic));
+    f += magic;
+    std::memcpy(&u, &f, sizeof(u));
+    h = static_cast<uint16_t>(u - magic_u);
+  } else {
+    const uint32_t mant_odd = (u >> 13) & 1u;
+    u += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + mant_odd;
+    h = static_cast<uint16_t>(u >> 13);
+  }
+  return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+float f16_to_f32(uint16_t h) {
+  constexpr uint32_t shifted_exp = 0x7c00u << 13;
+  uint32_t u = (h & 0x7fffu) << 13;
+  const uint32_t exp = shifted_exp & u;
+  u += (127u - 15u) << 23;
+  float f;
+  if (exp == shifted_exp) {
+    u += (128u - 16u) << 23; // inf/NaN
+    std::memcpy(&f, &u, sizeof(f));
+  } else if (exp == 0) {
+    u += 1u << 23; // subnormal: перенормализация
+    constexpr uint32_t magic_u = 113u << 23;
+    float magic;
+    std::memcpy(&f, &u, sizeof(f));
+    std::memcpy(&magic, &magic_u, sizeof(magic));
+    f -= magic;
+  } else {
+    std::memcpy(&f, &u, sizeof(f));
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  bits |= static_cast<uint32_t>(h & 0x8000u) << 16;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+DitherState::DitherState(uint32_t seed) {
+  uint32_t s = seed ? seed : 1u;
+  for (uint32_t &lane : lanes) {
+    xorshift32(s);
+    lane = s;
+  }
+}
+
+std::vector<Isa> supported_isas() {
+  std::vector<Isa> out;
+  for (Isa isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512, Isa::Neon})
+    if (isa_supported(isa))
+      out.push_back(isa);
+  return out;
+}
+
+const Kernels &kernels_for(Isa isa) {
+  if (!isa_supported(isa))
+    return kScalar;
+  switch (isa) {
+#if defined(GRUSTNIFY_CONVERT_X86)
+  case Isa::Sse2:
+    return kSse2;
+  case Isa::Avx2:
+    return kAvx2;
+  case Isa::Avx512:
+    return kAvx512;
+#endif
+#if defined(GRUSTNIFY_CONVERT_NEON)
+  case Isa::Neon:
+    return kNeon;
+#endif
+  default:
+    return kScalar;
+  }
+}
+
+const Kernels &kernels() {
+  static const Kernels &best = kernels_for(supported_isas().back());
+  return best;
+}
+
+namespace {
+
+// Указатели на плоскости кадра: до kInlinePlanes каналов — на стеке, без
+// аллокации на каждый декодированный кадр
+constexpr int kInlinePlanes = 64;
+
+template <typename T> class PlanePointers {
+public:
+  explicit PlanePointers(int channels) {
+    if (channels > kInlinePlanes)
+      heap_.resize(channels);
+  }
+  T *data() { return heap_.empty() ? inline_.data() : heap_.data(); }
+  T &operator[](int ch) { return data()[ch]; }
+
+private:
+  std::array<T, kInlinePlanes> inline_;
+  std::vector<T> heap_;
+};
+
+} // namespace
+
+void to_interleaved_f32(PcmFormat format, bool planar,
+                        const uint8_t *const *planes, float *out,
+                        size_t frames, int channels,
+                        std::vector<float> &scratch) {
+  const Kernels &k = kernels();
+  const size_t total = frames * channels;
+
+  if (!planar) {
+    switch (format) {
+    case PcmFormat::S16:
+      k.s16_to_f32(reinterpret_cast<const int16_t *>(planes[0]), out, total);
+      return;
+    case PcmFormat::S32:
+      k.s32_to_f32(reinterpret_cast<const int32_t *>(planes[0]), out, total);
+      return;
+    case PcmFormat::F32:
+      std::memcpy(out, planes[0], total * sizeof(float));
+      return;
+    }
+  }
+
+  if (channels == 1) {
+    to_interleaved_f32(format, false, planes, out, frames, 1, scratch);
+    return;
+  }
+
+  PlanePointers<const float *> float_planes(channels);
+  if (format == PcmFormat::F32) {
+    for (int ch = 0; ch < channels; ++ch)
+      float_planes[ch] = reinterpret_cast<const float *>(planes[ch]);
+  } else {
+    scratch.resize(total);
+    for (int ch = 0; ch < channels; ++ch) {
+      float *dst = scratch.data() + ch * frames;
+      if (format == PcmFormat::S16)
+        k.s16_to_f32(reinterpret_cast<const int16_t *>(planes[ch]), dst,
+                     frames);
+      else
+        k.s32_to_f32(reinterpret_cast<const int32_t *>(planes[ch]), dst,
+                     frames);
+      float_planes[ch] = dst;
+    }
+  }
+  k.interleave_f32(float_planes.data(), out, frames, channels);
+}
+
+namespace {
+
+void f32_to_s32(const float *in, int32_t *out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const double v =
+        std::clamp(static_cast<double>(in[i]) * 2147483648.0, -2147483648.0,
+                   2147483647.0);
+    out[i] = static_cast<int32_t>(std::llrint(v));
+  }
+}
+
+void from_f32(const Kernels &k, const float *in, PcmFormat format,
+              uint8_t *out, size_t n, DitherState *dither) {
+  switch (format) {
+  case PcmFormat::S16:
+    k.f32_to_s16(in, reinterpret_cast<int16_t *>(out), n, dither);
+    return;
+  case PcmFormat::S32:
+    f32_to_s32(in, reinterpret_cast<int32_t *>(out), n);
+    return;
+  case PcmFormat::F32:
+    std::memcpy(out, in, n * sizeof(float));
+    return;
+  }
+}
+
+} // namespace
+
+void from_interleaved_f32(const float *in, PcmFormat format, bool planar,
+                          uint8_t *const *planes, size_t frames, int channels,
+                          std::vector<float> &scratch, DitherState *dither) {
+  const Kernels &k = kernels();
+  const size_t total = frames * channels;
+
+  if (!planar || channels == 1) {
+    from_f32(k, in, format, planes[0], total, dither);
+    return;
+  }
+
+  PlanePointers<float *> float_planes(channels);
+  if (format == PcmFormat::F32) {
+    for (int ch = 0; ch < channels; ++ch)
+      float_planes[ch] = reinterpret_cast<float *>(planes[ch]);
+    k.deinterleave_f32(in, float_planes.data(), frames, channels);
+    return;
+  }
+
+  scratch.resize(total);
+  for (int ch = 0; ch < channels; ++ch)
+    float_planes[ch] = scratch.data() + ch * frames;
+  k.deinterleave_f32(in, float_planes.data(), frames, channels);
+  for (int ch = 0; ch < channels; ++ch)
+    from_f32(k, float_planes[ch], format, planes[ch], frames, dither);
+}
+
+} // namespace core::convert
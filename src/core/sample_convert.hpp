@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Конвертация форматов сэмплов без swr: s16/s32/float, interleaved <-> planar,
+// опциональный TPDF-дизер. Ядра под SSE2/AVX2/AVX-512/NEON выбираются один
+// раз во время выполнения по возможностям процессора.
+namespace core::convert {
+
+enum class Isa { Scalar, Sse2, Avx2, Avx512, Neon };
+const char *isa_name(Isa isa);
+
+enum class PcmFormat { S16, S32, F32 };
+
+// Состояние генератора для TPDF-дизера: по xorshift32 на SIMD-полосу.
+struct DitherState {
+  explicit DitherState(uint32_t seed = 0x9e3779b9u);
+  alignas(64) uint32_t lanes[16];
+};
+
+struct Kernels {
+  Isa isa;
+  void (*s16_to_f32)(const int16_t *in, float *out, size_t n);
+  void (*s32_to_f32)(const int32_t *in, float *out, size_t n);
+  // dither == nullptr — без дизера (чистое округление)
+  void (*f32_to_s16)(const float *in, int16_t *out, size_t n,
+                     DitherState *dither);
+  void (*deinterleave_f32)(const float *in, float *const *out, size_t frames,
+                           int channels);
+  void (*interleave_f32)(const float *const *in, float *out, size_t frames,
+                         int channels);
+  // IEEE 754 binary16, округление к ближайшему чётному
+  void (*f16_to_f32)(const uint16_t *in, float *out, size_t n);
+  void (*f32_to_f16)(const float *in, uint16_t *out, size_t n);
+};
+
+uint16_t f32_to_f16(float x);
+float f16_to_f32(uint16_t h);
+
+// Лучший набор ядер для текущего процессора.
+const Kernels &kernels();
+// Все наборы, которые можно запускать на этой машине (для тестов/бенчмарков).
+std::vector<Isa> supported_isas();
+const Kernels &kernels_for(Isa isa);
+
+// Любой поддерживаемый формат -> interleaved float. scratch переиспользуется
+// между вызовами для planar-входов.
+void to_interleaved_f32(PcmFormat format, bool planar,
+                        const uint8_t *const *planes, float *out,
+                        size_t frames, int channels,
+                        std::vector<float> &scratch);
+
+// interleaved float -> любой поддерживаемый формат.
+void from_interleaved_f32(const float *in, PcmFormat format, bool planar,
+                          uint8_t *const *planes, size_t frames, int channels,
+                          std::vector<float> &scratch,
+                          DitherState *dither = nullptr);
+
+} // namespace core::convert
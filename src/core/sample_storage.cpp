@@ -0,0 +1,280 @@
+#include "core/sample_storage.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRUSTNIFY_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+namespace {
+
+std::mutex g_config_mutex;
+StorageConfig g_config;
+
+std::filesystem::path resolve_spill_dir(const StorageConfig &config) {
+  if (!config.spill_dir.empty())
+    return config.spill_dir;
+  if (const char *env = std::getenv("GRUSTNIFY_SPILL_DIR"); env && *env)
+    return env;
+  std::error_code ec;
+  auto tmp = std::filesystem::temp_directory_path(ec);
+  return ec ? std::filesystem::path("/tmp") : tmp;
+}
+
+#ifdef GRUSTNIFY_HAVE_MMAP
+std::size_t page_size() {
+  static const std::size_t size =
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+std::size_t round_to_pages(std::size_t bytes) {
+  const std::size_t page = page_size();
+  return (bytes + page - 1) / page * page;
+}
+
+// Создаёт анонимный (сразу unlink'нутый) файл в каталоге для spill'а.
+int create_spill_file(const std::filesystem::path &dir) {
+  std::string pattern = (dir / "grustnify-XXXXXX").string();
+  std::vector<char> name(pattern.begin(), pattern.end());
+  name.push_back('\0');
+  const int fd = mkstemp(name.data());
+  if (fd >= 0)
+    unlink(name.data());
+  return fd;
+}
+#endif
+
+} // namespace
+
+void set_storage_config(const StorageConfig &config) {
+  std::lock_guard lock(g_config_mutex);
+  g_config = config;
+}
+
+StorageConfig storage_config() {
+  std::lock_guard lock(g_config_mutex);
+  return g_config;
+}
+
+namespace detail {
+
+StorageBlock::~StorageBlock() { release(); }
+
+StorageBlock::StorageBlock(StorageBlock &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      backend_(std::exchange(other.backend_, StorageBackend::Heap)),
+      fd_(std::exchange(other.fd_, -1)),
+      fixed_(std::exchange(other.fixed_, false)) {}
+
+StorageBlock &StorageBlock::operator=(StorageBlock &&other) noexcept {
+  if (this != &other) {
+    release();
+    data_ = std::exchange(other.data_, nullptr);
+    capacity_ = std::exchange(other.capacity_, 0);
+    backend_ = std::exchange(other.backend_, StorageBackend::Heap);
+    fd_ = std::exchange(other.fd_, -1);
+    fixed_ = std::exchange(other.fixed_, false);
+  }
+  return *this;
+}
+
+void StorageBlock::release() {
+#ifdef GRUSTNIFY_HAVE_MMAP
+  if (backend_ == StorageBackend::MappedFile) {
+    if (data_)
+      munmap(data_, capacity_);
+    if (fd_ >= 0)
+      ::close(fd_);
+  } else
+#endif
+  {
+    std::free(data_);
+  }
+  data_ = nullptr;
+  capacity_ = 0;
+  backend_ = StorageBackend::Heap;
+  fd_ = -1;
+  fixed_ = false;
+}
+
+void StorageBlock::grow(std::size_t new_capacity, std::size_t used) {
+  if (new_capacity <= capacity_)
+    return;
+
+  // Запечатанный fd клиента не расширяем (ftruncate нарушил бы печати):
+  // данные переезжают в heap или spill-файл, fd закрывается.
+  if (fixed_) {
+    StorageBlock owned;
+    owned.grow(new_capacity, 0);
+    if (used > 0)
+      std::memcpy(owned.data_, data_, used);
+    *this = std::move(owned);
+    return;
+  }
+
+  const StorageConfig config = storage_config();
+  if ((backend_ == StorageBackend::MappedFile ||
+       new_capacity >= config.spill_threshold_bytes) &&
+      grow_mapped(new_capacity, used)) {
+    return;
+  }
+  // Уже в mmap, но расширить файл не вышло — в heap не откатываемся, там
+  // такой объём всё равно не поместится.
+  if (backend_ == StorageBackend::MappedFile)
+    throw std::bad_alloc();
+  grow_heap(new_capacity);
+}
+
+void StorageBlock::grow_heap(std::size_t new_capacity) {
+  void *grown = std::realloc(data_, new_capacity);
+  if (!grown)
+    throw std::bad_alloc();
+  data_ = grown;
+  capacity_ = new_capacity;
+}
+
+bool StorageBlock::grow_mapped(std::size_t new_capacity, std::size_t used) {
+#ifdef GRUSTNIFY_HAVE_MMAP
+  const std::size_t mapped_capacity = round_to_pages(new_capacity);
+
+  if (backend_ == StorageBackend::MappedFile) {
+    if (ftruncate(fd_, static_cast<off_t>(mapped_capacity)) != 0)
+      return false;
+    if (!data_) { // пустой adopt_fd()
+      void *mapped = mmap(nullptr, mapped_capacity, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd_, 0);
+      if (mapped == MAP_FAILED)
+        return false;
+      data_ = mapped;
+      capacity_ = mapped_capacity;
+      return true;
+    }
+#ifdef MREMAP_MAYMOVE
+    void *grown = mremap(data_, capacity_, mapped_capacity, MREMAP_MAYMOVE);
+#else
+    munmap(data_, capacity_);
+    void *grown = mmap(nullptr, mapped_capacity, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd_, 0);
+#endif
+    if (grown == MAP_FAILED)
+      return false;
+    data_ = grown;
+    capacity_ = mapped_capacity;
+    advise(StorageAccess::Sequential, capacity_);
+    return true;
+  }
+
+  // Переезд из heap в файл: одна копия уже записанных данных.
+  const int fd = create_spill_file(resolve_spill_dir(storage_config()));
+  if (fd < 0)
+    return false;
+  if (ftruncate(fd, static_cast<off_t>(mapped_capacity)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void *mapped = mmap(nullptr, mapped_capacity, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+  if (used > 0)
+    std::memcpy(mapped, data_, used);
+  std::free(data_);
+
+  data_ = mapped;
+  capacity_ = mapped_capacity;
+  backend_ = StorageBackend::MappedFile;
+  fd_ = fd;
+  advise(StorageAccess::Sequential, capacity_);
+  return true;
+#else
+  (void)new_capacity;
+  (void)used;
+  return false;
+#endif
+}
+
+bool StorageBlock::adopt_fd(int fd, std::size_t bytes) {
+#ifdef GRUSTNIFY_HAVE_MMAP
+  void *mapped = nullptr;
+  bool fixed = false;
+  if (bytes > 0) {
+    mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // memfd, запечатанный от записи (F_SEAL_WRITE): копия при записи.
+    if (mapped == MAP_FAILED) {
+      mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      fixed = true;
+    }
+    if (mapped == MAP_FAILED)
+      return false;
+  }
+  release();
+  // Ёмкость — ровно bytes: страница за концом файла не пишется в файл.
+  data_ = mapped;
+  capacity_ = bytes;
+  backend_ = StorageBackend::MappedFile;
+  fd_ = fd;
+  fixed_ = fixed;
+  return true;
+#else
+  (void)fd;
+  (void)bytes;
+  return false;
+#endif
+}
+
+void StorageBlock::advise(StorageAccess access, std::size_t used) const {
+#ifdef GRUSTNIFY_HAVE_MMAP
+  if (backend_ != StorageBackend::MappedFile || !data_)
+    return;
+  int advice = MADV_NORMAL;
+  switch (access) {
+  case StorageAccess::Normal:
+    advice = MADV_NORMAL;
+    break;
+  case StorageAccess::Sequential:
+    advice = MADV_SEQUENTIAL;
+    break;
+  case StorageAccess::Random:
+    advice = MADV_RANDOM;
+    break;
+  }
+  const std::size_t len = used < capacity_ ? round_to_pages(used) : capacity_;
+  if (len > 0)
+    madvise(data_, len, advice);
+#else
+  (void)access;
+  (void)used;
+#endif
+}
+
+bool StorageBlock::sync(std::size_t used) const {
+#ifdef GRUSTNIFY_HAVE_MMAP
+  if (backend_ != StorageBackend::MappedFile || !data_)
+    return true;
+  // Отображение постранично, так что хвост страницы за capacity_ тоже в нём
+  const std::size_t len = round_to_pages(std::min(used, capacity_));
+  return len == 0 || msync(data_, len, MS_SYNC) == 0;
+#else
+  (void)used;
+  return true;
+#endif
+}
+
+} // namespace detail
+
+} // namespace core
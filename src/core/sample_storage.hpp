@@ -0,0 +1,197 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+#include <utility>
+
+namespace core {
+
+// Где физически лежат сэмплы AudioBuffer.
+enum class StorageBackend {
+  Heap,       // обычная память процесса
+  MappedFile, // mmap временного файла (spill-to-disk)
+};
+
+enum class StorageAccess {
+  Normal,
+  Sequential, // decode/encode/change_speed читают и пишут подряд
+  Random,
+};
+
+struct StorageConfig {
+  // Буферы крупнее порога автоматически переезжают в mmap'нутый временный
+  // файл. 0 — всегда mmap, SIZE_MAX — никогда.
+  std::size_t spill_threshold_bytes = std::size_t{1} << 30;
+  // Пустой путь — $GRUSTNIFY_SPILL_DIR или системный temp.
+  std::filesystem::path spill_dir;
+};
+
+void set_storage_config(const StorageConfig &config);
+StorageConfig storage_config();
+
+namespace detail {
+
+// Сырая память без типа: heap или mmap временного файла.
+class StorageBlock {
+public:
+  StorageBlock() = default;
+  ~StorageBlock();
+  StorageBlock(const StorageBlock &) = delete;
+  StorageBlock &operator=(const StorageBlock &) = delete;
+  StorageBlock(StorageBlock &&other) noexcept;
+  StorageBlock &operator=(StorageBlock &&other) noexcept;
+
+  void *data() const { return data_; }
+  std::size_t capacity() const { return capacity_; }
+  StorageBackend backend() const { return backend_; }
+
+  // Увеличивает ёмкость до new_capacity байт, сохраняя первые used байт.
+  // Бросает std::bad_alloc, если не удалось ни выделить, ни замапить.
+  void grow(std::size_t new_capacity, std::size_t used);
+  // Берёт fd (memfd, файл) во владение и мапит первые bytes байт; дальнейший
+  // grow() расширяет сам файл. Запечатанный от записи fd мапится приватно, и
+  // grow() тогда копирует данные в собственное хранилище, не трогая fd.
+  // false — платформа без mmap или mmap не удался.
+  bool adopt_fd(int fd, std::size_t bytes);
+  int fd() const { return fd_; }
+  void release();
+  void advise(StorageAccess access, std::size_t used) const;
+  // msync первых used байт файла (heap — нечего сбрасывать, true)
+  bool sync(std::size_t used) const;
+
+private:
+  void grow_heap(std::size_t new_capacity);
+  bool grow_mapped(std::size_t new_capacity, std::size_t used);
+
+  void *data_ = nullptr;
+  std::size_t capacity_ = 0;
+  StorageBackend backend_ = StorageBackend::Heap;
+  int fd_ = -1;
+  bool fixed_ = false; // приватный mmap чужого fd: размер файла не меняем
+};
+
+} // namespace detail
+
+// Непрерывный массив сэмплов с интерфейсом, похожим на std::vector, но с
+// возможностью жить в mmap'нутом файле для многочасовых записей.
+template <typename T> class BasicSampleStorage {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "sample storage holds raw PCM only");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  BasicSampleStorage() = default;
+  explicit BasicSampleStorage(size_type count) { resize(count); }
+
+  BasicSampleStorage(const BasicSampleStorage &other) { *this = other; }
+  BasicSampleStorage &operator=(const BasicSampleStorage &other) {
+    if (this != &other) {
+      resize_uninitialized(other.size_);
+      if (size_ > 0)
+        std::memcpy(data(), other.data(), size_ * sizeof(T));
+    }
+    return *this;
+  }
+  BasicSampleStorage(BasicSampleStorage &&other) noexcept
+      : block_(std::move(other.block_)),
+        size_(std::exchange(other.size_, 0)) {}
+  BasicSampleStorage &operator=(BasicSampleStorage &&other) noexcept {
+    block_ = std::move(other.block_);
+    size_ = std::exchange(other.size_, 0);
+    return *this;
+  }
+
+  T *data() { return static_cast<T *>(block_.data()); }
+  const T *data() const { return static_cast<const T *>(block_.data()); }
+  size_type size() const { return size_; }
+  size_type capacity() const { return block_.capacity() / sizeof(T); }
+  bool empty() const { return size_ == 0; }
+
+  T &operator[](size_type i) { return data()[i]; }
+  const T &operator[](size_type i) const { return data()[i]; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+  void reserve(size_type count) {
+    if (count > capacity())
+      block_.grow(count * sizeof(T), size_ * sizeof(T));
+  }
+
+  // Новые элементы заполняются нулями.
+  void resize(size_type count) {
+    const size_type old = size_;
+    resize_uninitialized(count);
+    if (count > old)
+      std::memset(data() + old, 0, (count - old) * sizeof(T));
+  }
+
+  // Для стадий, которые всё равно перезапишут каждый сэмпл: не трогаем
+  // страницы лишний раз (важно для mmap-буферов на десятки гигабайт).
+  void resize_uninitialized(size_type count) {
+    if (count > capacity())
+      block_.grow(grown_capacity(count) * sizeof(T), size_ * sizeof(T));
+    size_ = count;
+  }
+
+  void assign(size_type count, T value) {
+    resize_uninitialized(count);
+    for (size_type i = 0; i < count; ++i)
+      data()[i] = value;
+  }
+
+  void clear() { size_ = 0; }
+
+  // Убирает первые count сэмплов сдвигом остальных, без перевыделения
+  // (разгон reverb'а перед окном).
+  void erase_front(size_type count) {
+    count = std::min(count, size_);
+    if (count < size_)
+      std::memmove(data(), data() + count, (size_ - count) * sizeof(T));
+    size_ -= count;
+  }
+
+  void release() {
+    block_.release();
+    size_ = 0;
+  }
+
+  // Сэмплы в чужом fd (например, memfd от другого процесса): без копирования.
+  // Владение fd переходит к storage; count — уже записанные сэмплы.
+  bool adopt_fd(int fd, size_type count) {
+    if (!block_.adopt_fd(fd, count * sizeof(T)))
+      return false;
+    size_ = count;
+    return true;
+  }
+  // fd mmap-хранилища (-1 для heap) — например, чтобы передать его по сокету.
+  int fd() const { return block_.fd(); }
+
+  StorageBackend backend() const { return block_.backend(); }
+  void advise(StorageAccess access) const {
+    block_.advise(access, size_ * sizeof(T));
+  }
+  // Записанное в mmap-файл — на диск (checkpoint'ы долгого рендера)
+  bool sync() const { return block_.sync(size_ * sizeof(T)); }
+
+private:
+  size_type grown_capacity(size_type count) const {
+    const size_type geometric = capacity() + capacity() / 2;
+    return count > geometric ? count : geometric;
+  }
+
+  detail::StorageBlock block_;
+  size_type size_ = 0;
+};
+
+using SampleStorage = BasicSampleStorage<float>;
+
+} // namespace core
@@ -0,0 +1,222 @@
+#pragma once
+// Минимальная 4-полосная float-обёртка для DSP-ядер: SSE2 на x86-64,
+// NEON на ARM, скалярный вариант на всём остальном.
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define GRUSTNIFY_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GRUSTNIFY_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace core::simd {
+
+#if defined(GRUSTNIFY_SIMD_SSE2)
+
+struct f32x4 {
+  __m128 v;
+
+  static f32x4 zero() { return {_mm_setzero_ps()}; }
+  static f32x4 splat(float x) { return {_mm_set1_ps(x)}; }
+  static f32x4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+
+  friend f32x4 operator+(f32x4 a, f32x4 b) { return {_mm_add_ps(a.v, b.v)}; }
+  friend f32x4 operator-(f32x4 a, f32x4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+  friend f32x4 operator*(f32x4 a, f32x4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+  friend f32x4 max(f32x4 a, f32x4 b) { return {_mm_max_ps(a.v, b.v)}; }
+  friend f32x4 min(f32x4 a, f32x4 b) { return {_mm_min_ps(a.v, b.v)}; }
+  friend f32x4 abs(f32x4 a) {
+    return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+  }
+  // a * b + c
+  friend f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) { return a * b + c; }
+  // [a0, b0, a1, b1] и [a2, b2, a3, b3]
+  friend f32x4 zip_lo(f32x4 a, f32x4 b) { return {_mm_unpacklo_ps(a.v, b.v)}; }
+  friend f32x4 zip_hi(f32x4 a, f32x4 b) { return {_mm_unpackhi_ps(a.v, b.v)}; }
+  // [a0 + a2, a1 + a3, b0 + b2, b1 + b3]
+  friend f32x4 fold_pairs(f32x4 a, f32x4 b) {
+    return {_mm_add_ps(_mm_movelh_ps(a.v, b.v), _mm_movehl_ps(b.v, a.v))};
+  }
+
+  float hmax() const {
+    __m128 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+  }
+  float hmin() const {
+    __m128 m = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(m);
+  }
+  float hsum() const {
+    __m128 s = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(s);
+  }
+};
+
+#elif defined(GRUSTNIFY_SIMD_NEON)
+
+struct f32x4 {
+  float32x4_t v;
+
+  static f32x4 zero() { return {vdupq_n_f32(0.0f)}; }
+  static f32x4 splat(float x) { return {vdupq_n_f32(x)}; }
+  static f32x4 load(const float *p) { return {vld1q_f32(p)}; }
+  void store(float *p) const { vst1q_f32(p, v); }
+
+  friend f32x4 operator+(f32x4 a, f32x4 b) { return {vaddq_f32(a.v, b.v)}; }
+  friend f32x4 operator-(f32x4 a, f32x4 b) { return {vsubq_f32(a.v, b.v)}; }
+  friend f32x4 operator*(f32x4 a, f32x4 b) { return {vmulq_f32(a.v, b.v)}; }
+  friend f32x4 max(f32x4 a, f32x4 b) { return {vmaxq_f32(a.v, b.v)}; }
+  friend f32x4 min(f32x4 a, f32x4 b) { return {vminq_f32(a.v, b.v)}; }
+  friend f32x4 abs(f32x4 a) { return {vabsq_f32(a.v)}; }
+  friend f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) {
+    return {vmlaq_f32(c.v, a.v, b.v)};
+  }
+  friend f32x4 zip_lo(f32x4 a, f32x4 b) { return {vzipq_f32(a.v, b.v).val[0]}; }
+  friend f32x4 zip_hi(f32x4 a, f32x4 b) { return {vzipq_f32(a.v, b.v).val[1]}; }
+  friend f32x4 fold_pairs(f32x4 a, f32x4 b) {
+    return {vcombine_f32(vadd_f32(vget_low_f32(a.v), vget_high_f32(a.v)),
+                         vadd_f32(vget_low_f32(b.v), vget_high_f32(b.v)))};
+  }
+
+  float hmax() const {
+    float32x2_t m = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+    return std::max(vget_lane_f32(m, 0), vget_lane_f32(m, 1));
+  }
+  float hmin() const {
+    float32x2_t m = vmin_f32(vget_low_f32(v), vget_high_f32(v));
+    return std::min(vget_lane_f32(m, 0), vget_lane_f32(m, 1));
+  }
+  float hsum() const {
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(s, 0) + vget_lane_f32(s, 1);
+  }
+};
+
+#else
+
+struct f32x4 {
+  float v[4];
+
+  static f32x4 zero() { return {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+  static f32x4 splat(float x) { return {{x, x, x, x}}; }
+  static f32x4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+  void store(float *p) const { std::copy(v, v + 4, p); }
+
+  template <typename Op> static f32x4 map(f32x4 a, f32x4 b, Op op) {
+    return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]),
+             op(a.v[3], b.v[3])}};
+  }
+  friend f32x4 operator+(f32x4 a, f32x4 b) {
+    return map(a, b, [](float x, float y) { return x + y; });
+  }
+  friend f32x4 operator-(f32x4 a, f32x4 b) {
+    return map(a, b, [](float x, float y) { return x - y; });
+  }
+  friend f32x4 operator*(f32x4 a, f32x4 b) {
+    return map(a, b, [](float x, float y) { return x * y; });
+  }
+  friend f32x4 max(f32x4 a, f32x4 b) {
+    return map(a, b, [](float x, float y) { return std::max(x, y); });
+  }
+  friend f32x4 min(f32x4 a, f32x4 b) {
+    return map(a, b, [](float x, float y) { return std::min(x, y); });
+  }
+  friend f32x4 abs(f32x4 a) {
+    return {{std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]),
+             std::fabs(a.v[3])}};
+  }
+  friend f32x4 fmadd(f32x4 a, f32x4 b, f32x4 c) { return a * b + c; }
+  friend f32x4 zip_lo(f32x4 a, f32x4 b) {
+    return {{a.v[0], b.v[0], a.v[1], b.v[1]}};
+  }
+  friend f32x4 zip_hi(f32x4 a, f32x4 b) {
+    return {{a.v[2], b.v[2], a.v[3], b.v[3]}};
+  }
+  friend f32x4 fold_pairs(f32x4 a, f32x4 b) {
+    return {{a.v[0] + a.v[2], a.v[1] + a.v[3], b.v[0] + b.v[2],
+             b.v[1] + b.v[3]}};
+  }
+
+  float hmax() const { return std::max({v[0], v[1], v[2], v[3]}); }
+  float hmin() const { return std::min({v[0], v[1], v[2], v[3]}); }
+  float hsum() const { return (v[0] + v[1]) + (v[2] + v[3]); }
+};
+
+#endif
+
+// max |x[i]| по массиву.
+inline float peak_abs(const float *x, std::size_t n) {
+  f32x4 m0 = f32x4::zero(), m1 = f32x4::zero();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    m0 = max(m0, abs(f32x4::load(x + i)));
+    m1 = max(m1, abs(f32x4::load(x + i + 4)));
+  }
+  float m = max(m0, m1).hmax();
+  for (; i < n; ++i)
+    m = std::max(m, std::fabs(x[i]));
+  return m;
+}
+
+// min и max по массиву (n > 0).
+inline void min_max(const float *x, std::size_t n, float &lo, float &hi) {
+  f32x4 mn = f32x4::splat(x[0]), mx = mn;
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const f32x4 a = f32x4::load(x + i);
+    mn = min(mn, a);
+    mx = max(mx, a);
+  }
+  lo = mn.hmin();
+  hi = mx.hmax();
+  for (; i < n; ++i) {
+    lo = std::min(lo, x[i]);
+    hi = std::max(hi, x[i]);
+  }
+}
+
+// sum x[i]^2 по блоку (накопление во float-полосах, итог в double) —
+// вызывать на блоках, а не на всём сигнале.
+inline double sum_squares(const float *x, std::size_t n) {
+  f32x4 s0 = f32x4::zero(), s1 = f32x4::zero();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    f32x4 a = f32x4::load(x + i), b = f32x4::load(x + i + 4);
+    s0 = fmadd(a, a, s0);
+    s1 = fmadd(b, b, s1);
+  }
+  double s = (s0 + s1).hsum();
+  for (; i < n; ++i)
+    s += static_cast<double>(x[i]) * x[i];
+  return s;
+}
+
+// Транспонирование 4x4: строки a..d становятся столбцами.
+inline void transpose4(f32x4 &a, f32x4 &b, f32x4 &c, f32x4 &d) {
+#if defined(GRUSTNIFY_SIMD_SSE2)
+  _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+#elif defined(GRUSTNIFY_SIMD_NEON)
+  const float32x4x2_t ab = vtrnq_f32(a.v, b.v); // a0 b0 a2 b2 | a1 b1 a3 b3
+  const float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+  a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+  b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+  c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+  d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+#else
+  const f32x4 r[4] = {a, b, c, d};
+  f32x4 *out[4] = {&a, &b, &c, &d};
+  for (int i = 0; i < 4; ++i)
+    *out[i] = {{r[0].v[i], r[1].v[i], r[2].v[i], r[3].v[i]}};
+#endif
+}
+
+} // namespace core::simd
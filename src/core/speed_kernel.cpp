@@ -0,0 +1,435 @@
+#include "core/speed_kernel.hpp"
+#include "core/fir_design.hpp"
+#include "core/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace core::speed {
+
+using simd::f32x4;
+
+// Коэффициенты L фаз: фаза p — выход в позиции i0 + p / L, отсчёты
+// x[i0 - half + 1] .. x[i0 + half].
+struct PhaseTable {
+  Ratio step; // вход на выходной кадр, M / L
+  int taps = 0;
+  int half = 0;
+  std::vector<float> coeffs; // L * taps
+
+  const float *phase(uint32_t p) const {
+    return coeffs.data() + static_cast<size_t>(p) * taps;
+  }
+};
+
+namespace {
+
+// Знаменатель до 4096: 1.15, 1.25, 0.8, 1.0005 и прочие «круглые» скорости
+// представимы точно. Дробь с погрешностью до 1e-6 — кадр рассинхрона на
+// миллион, дальше её не уточняем. Остальные скорости округляются до
+// ближайшей такой дроби.
+constexpr uint32_t kMaxPhases = 4096;
+constexpr double kRatioTolerance = 1e-6;
+constexpr int kMaxTaps = 512;
+// Последние использованные таблицы: воркеры с разными скоростями не
+// копят их без предела
+constexpr size_t kCachedTables = 8;
+
+struct QualitySpec {
+  int taps;
+  double beta;   // окно Кайзера: подавление ~ 8.7 + beta / 0.1102 dB
+  double cutoff; // середина перехода, доля частоты Найквиста
+};
+
+// Полоса перехода сужается с длиной фильтра: срез ближе к Найквисту
+const QualitySpec &quality_spec(SpeedQuality quality) {
+  static constexpr QualitySpec kFast{16, 6.0, 0.80};
+  static constexpr QualitySpec kBalanced{32, 8.0, 0.88};
+  static constexpr QualitySpec kBest{64, 10.0, 0.93};
+  switch (quality) {
+  case SpeedQuality::Fast:
+    return kFast;
+  case SpeedQuality::Best:
+    return kBest;
+  default:
+    return kBalanced;
+  }
+}
+
+std::shared_ptr<const PhaseTable> build_table(Ratio step,
+                                              SpeedQuality quality) {
+  const QualitySpec &spec = quality_spec(quality);
+  // Ускорение (шаг > 1) — децимация: срез на новой частоте Найквиста, а
+  // фильтр длиннее во столько же раз, чтобы переход не расширился
+  const double speed = static_cast<double>(step.den) / step.num;
+  const double scale = std::min(1.0, speed);
+  int taps = static_cast<int>(std::ceil(spec.taps / scale));
+  taps = std::min(kMaxTaps, (taps + 7) / 8 * 8);
+
+  auto table = std::make_shared<PhaseTable>();
+  table->step = step;
+  table->taps = taps;
+  table->half = taps / 2;
+  table->coeffs.resize(static_cast<size_t>(step.den) * taps);
+  const double cutoff = spec.cutoff * scale;
+  std::vector<double> h(taps);
+  for (uint32_t p = 0; p < step.den; ++p) {
+    const double frac = static_cast<double>(p) / step.den;
+    double sum = 0.0;
+    for (int k = 0; k < taps; ++k) {
+      const double t = (k - (table->half - 1)) - frac;
+      h[k] = cutoff * fir::sinc(cutoff * t) *
+             fir::kaiser_at(spec.beta, t / table->half);
+      sum += h[k];
+    }
+    // Каждая фаза с единичным усилением на DC: иначе пульсация по фазам
+    // даёт тон с частотой повторения последовательности фаз
+    float *out = table->coeffs.data() + static_cast<size_t>(p) * taps;
+    for (int k = 0; k < taps; ++k)
+      out[k] = static_cast<float>(h[k] / sum);
+  }
+  return table;
+}
+
+std::shared_ptr<const PhaseTable> phase_table(Ratio step,
+                                              SpeedQuality quality) {
+  struct Entry {
+    Ratio step;
+    SpeedQuality quality;
+    std::shared_ptr<const PhaseTable> table;
+  };
+  static std::mutex mutex;
+  static std::vector<Entry> cache; // в начале — последняя использованная
+
+  std::lock_guard lock(mutex);
+  const auto it =
+      std::find_if(cache.begin(), cache.end(), [&](const Entry &e) {
+        return e.step.num == step.num && e.step.den == step.den &&
+               e.quality == quality;
+      });
+  if (it != cache.end()) {
+    std::rotate(cache.begin(), it, it + 1);
+    return cache.front().table;
+  }
+  if (cache.size() == kCachedTables)
+    cache.pop_back();
+  cache.insert(cache.begin(), {step, quality, build_table(step, quality)});
+  return cache.front().table;
+}
+
+// Частичные суммы свёртки окна x (interleaved) с фазой c. Taps — длина
+// фильтра на этапе компиляции (0 — taps), кратна 8.
+template <int Taps>
+f32x4 dot_mono(const float *x, const float *c, int taps) {
+  const int n = Taps ? Taps : taps;
+  f32x4 a0 = f32x4::zero(), a1 = f32x4::zero();
+  for (int k = 0; k < n; k += 8) {
+    a0 = fmadd(f32x4::load(x + k), f32x4::load(c + k), a0);
+    a1 = fmadd(f32x4::load(x + k + 4), f32x4::load(c + k + 4), a1);
+  }
+  return a0 + a1;
+}
+
+// Четыре коэффициента растягиваются на [c0 c0 c1 c1] и [c2 c2 c3 c3] под
+// кадры L R L R; результат — [L R L R], половины складывает fold_pairs
+template <int Taps>
+f32x4 dot_stereo(const float *x, const float *c, int taps) {
+  const int n = Taps ? Taps : taps;
+  f32x4 a0 = f32x4::zero(), a1 = f32x4::zero();
+  for (int k = 0; k < n; k += 4) {
+    const f32x4 c4 = f32x4::load(c + k);
+    a0 = fmadd(f32x4::load(x + 2 * k), zip_lo(c4, c4), a0);
+    a1 = fmadd(f32x4::load(x + 2 * k + 4), zip_hi(c4, c4), a1);
+  }
+  return a0 + a1;
+}
+
+// Многоканальный: вектор — четыре соседних канала одного кадра
+void dot_multi(const float *x, const float *c, int taps, int channels,
+               float *out) {
+  int ch = 0;
+  for (; ch + 4 <= channels; ch += 4) {
+    f32x4 acc = f32x4::zero();
+    for (int k = 0; k < taps; ++k)
+      acc = fmadd(f32x4::splat(c[k]), f32x4::load(x + k * channels + ch),
+                  acc);
+    acc.store(out + ch);
+  }
+  for (; ch < channels; ++ch) {
+    float acc = 0.0f;
+    for (int k = 0; k < taps; ++k)
+      acc += c[k] * x[k * channels + ch];
+    out[ch] = acc;
+  }
+}
+
+// Позиция выходного кадра на входе: i0 + phase / L, шаг M / L
+struct Cursor {
+  Cursor(const PhaseTable &t, size_t first)
+      : den(t.step.den), advance(t.step.num / den),
+        phase_step(t.step.num % den) {
+    const uint64_t start = first * uint64_t{t.step.num};
+    i0 = start / den;
+    phase = static_cast<uint32_t>(start % den);
+  }
+  void next() {
+    i0 += advance;
+    phase += phase_step;
+    if (phase >= den) {
+      phase -= den;
+      ++i0;
+    }
+  }
+
+  uint32_t den;
+  uint64_t advance;
+  uint32_t phase_step;
+  uint64_t i0 = 0;
+  uint32_t phase = 0;
+};
+
+// Кадры [lo, hi) из [first, first + count), чьё окно целиком внутри
+// сигнала: base = i0 - half + 1 >= 0 и base + taps <= in_frames
+struct Interior {
+  size_t lo, hi;
+};
+
+Interior interior(const PhaseTable &t, size_t first, size_t count,
+                  size_t in_frames) {
+  const uint64_t num = t.step.num, den = t.step.den;
+  const size_t end = first + count;
+  const uint64_t back = static_cast<uint64_t>(t.half - 1);
+  const size_t lo = std::clamp<size_t>((back * den + num - 1) / num, first,
+                                       end);
+  if (in_frames < static_cast<size_t>(t.half) + 1)
+    return {lo, lo};
+  // i0 <= in_frames - half - 1
+  const uint64_t last_i0 = in_frames - t.half - 1;
+  const size_t hi = std::clamp<size_t>((last_i0 * den + den - 1) / num + 1,
+                                       lo, end);
+  return {lo, hi};
+}
+
+// Channels 0 — любое число каналов. Внутри сигнала стерео считается парами
+// кадров, моно — четвёрками: суммы полос сворачиваются вместе, одна запись
+// на группу. У краёв окно собирается в буфер с нулями снаружи.
+template <int Channels, int Taps>
+void render_phases(const PhaseTable &t, const float *src, size_t src_first,
+                   size_t in_frames, int channels, size_t first, size_t count,
+                   float *out) {
+  const size_t frame = Channels ? Channels : static_cast<size_t>(channels);
+  const Interior inner = interior(t, first, count, in_frames);
+  Cursor pos(t, first);
+
+  const auto window = [&] {
+    return src + (pos.i0 - (t.half - 1) - src_first) * frame;
+  };
+  const auto single = [&](const float *x) {
+    const float *c = t.phase(pos.phase);
+    if constexpr (Channels == 1) {
+      // Тот же порядок сложения, что у четвёрок: чанки совпадают бит в бит
+      f32x4 a = dot_mono<Taps>(x, c, t.taps), b = f32x4::zero(),
+            d = f32x4::zero(), e = f32x4::zero();
+      transpose4(a, b, d, e);
+      float lanes[4];
+      ((a + b) + (d + e)).store(lanes);
+      *out = lanes[0];
+    } else if constexpr (Channels == 2) {
+      float lanes[4];
+      fold_pairs(dot_stereo<Taps>(x, c, t.taps), f32x4::zero()).store(lanes);
+      out[0] = lanes[0];
+      out[1] = lanes[1];
+    } else {
+      dot_multi(x, c, t.taps, channels, out);
+    }
+    out += frame;
+    pos.next();
+  };
+
+  std::vector<float> edge;
+  const auto edges = [&](size_t frames) {
+    edge.resize(static_cast<size_t>(t.taps) * frame);
+    for (size_t n = 0; n < frames; ++n) {
+      const int64_t base = static_cast<int64_t>(pos.i0) - (t.half - 1);
+      std::fill(edge.begin(), edge.end(), 0.0f);
+      for (int k = 0; k < t.taps; ++k) {
+        const int64_t j = base + k;
+        if (j >= 0 && static_cast<uint64_t>(j) < in_frames)
+          std::copy_n(src + (static_cast<size_t>(j) - src_first) * frame,
+                      frame, edge.data() + k * frame);
+      }
+      single(edge.data());
+    }
+  };
+
+  edges(inner.lo - first);
+  size_t n = inner.hi - inner.lo;
+  if constexpr (Channels == 1) {
+    for (; n >= 4; n -= 4, out += 4) {
+      f32x4 acc[4];
+      for (f32x4 &a : acc) {
+        a = dot_mono<Taps>(window(), t.phase(pos.phase), t.taps);
+        pos.next();
+      }
+      transpose4(acc[0], acc[1], acc[2], acc[3]);
+      ((acc[0] + acc[1]) + (acc[2] + acc[3])).store(out);
+    }
+  } else if constexpr (Channels == 2) {
+    for (; n >= 2; n -= 2, out += 4) {
+      const f32x4 a = dot_stereo<Taps>(window(), t.phase(pos.phase), t.taps);
+      pos.next();
+      const f32x4 b = dot_stereo<Taps>(window(), t.phase(pos.phase), t.taps);
+      pos.next();
+      fold_pairs(a, b).store(out);
+    }
+  }
+  for (; n > 0; --n)
+    single(window());
+  edges(first + count - inner.hi);
+}
+
+// Длины фильтров замедления — константы, цикл свёртки разворачивается
+template <int Channels>
+void render_taps(const PhaseTable &t, const float *src, size_t src_first,
+                 size_t in_frames, int channels, size_t first, size_t count,
+                 float *out) {
+  switch (t.taps) {
+  case 16:
+    return render_phases<Channels, 16>(t, src, src_first, in_frames, channels,
+                                       first, count, out);
+  case 32:
+    return render_phases<Channels, 32>(t, src, src_first, in_frames, channels,
+                                       first, count, out);
+  case 64:
+    return render_phases<Channels, 64>(t, src, src_first, in_frames, channels,
+                                       first, count, out);
+  default:
+    return render_phases<Channels, 0>(t, src, src_first, in_frames, channels,
+                                      first, count, out);
+  }
+}
+
+void render_linear(const float *src, size_t src_first, size_t in_frames,
+                   int channels, float speed_factor, size_t first,
+                   size_t count, float *out) {
+  for (size_t n = first; n < first + count; ++n) {
+    float in_pos = static_cast<float>(n) / speed_factor;
+
+    size_t i0 = static_cast<size_t>(in_pos);
+    float frac = in_pos - static_cast<float>(i0);
+
+    if (i0 >= in_frames - 1) {
+      i0 = in_frames - 1;
+      frac = 0.0f;
+    }
+
+    size_t i1 = (i0 + 1 < in_frames) ? (i0 + 1) : i0;
+
+    const float *f0 = src + (i0 - src_first) * channels;
+    const float *f1 = src + (i1 - src_first) * channels;
+    for (int ch = 0; ch < channels; ++ch) {
+      float s0 = f0[ch];
+      float s1 = f1[ch];
+      *out++ = s0 + (s1 - s0) * frac;
+    }
+  }
+}
+
+} // namespace
+
+Ratio rational_approximation(double x, uint32_t max_den) {
+  // Подходящие дроби h / k; каждая следующая точнее
+  uint64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+  Ratio best{1, 1};
+  double r = x;
+  for (int i = 0; i < 64; ++i) {
+    const double a = std::floor(r);
+    if (a >= static_cast<double>(UINT32_MAX))
+      break;
+    const auto ai = static_cast<uint64_t>(a);
+    const uint64_t h2 = ai * h1 + h0;
+    const uint64_t k2 = ai * k1 + k0;
+    if (k2 > max_den || h2 > UINT32_MAX) {
+      // Промежуточная дробь между двумя подходящими бывает ближе последней
+      const uint64_t m = k1 > 0 ? (max_den - k0) / k1 : 0;
+      const uint64_t hm = h0 + m * h1, km = k0 + m * k1;
+      if (m > 0 && hm <= UINT32_MAX &&
+          std::fabs(static_cast<double>(hm) / km - x) <
+              std::fabs(static_cast<double>(best.num) / best.den - x))
+        best = {static_cast<uint32_t>(hm), static_cast<uint32_t>(km)};
+      break;
+    }
+    if (h2 > 0)
+      best = {static_cast<uint32_t>(h2), static_cast<uint32_t>(k2)};
+    if (h2 > 0 &&
+        std::fabs(static_cast<double>(h2) / k2 - x) <= kRatioTolerance * x)
+      break;
+    h0 = h1;
+    h1 = h2;
+    k0 = k1;
+    k1 = k2;
+    const double f = r - a;
+    if (f < 1e-12)
+      break;
+    r = 1.0 / f;
+  }
+  return best;
+}
+
+Kernel::Kernel(float speed_factor, SpeedQuality quality)
+    : speed_factor_(speed_factor) {
+  if (quality == SpeedQuality::Linear || speed_factor <= 0.0f)
+    return;
+  const Ratio step = rational_approximation(1.0 / speed_factor, kMaxPhases);
+  // 1 / 1 — копия: линейная интерполяция её и даёт, без среза фильтра
+  if (step.num != step.den)
+    table_ = phase_table(step, quality);
+}
+
+int Kernel::taps() const { return table_ ? table_->taps : 2; }
+
+size_t Kernel::input_begin(size_t n, size_t in_frames) const {
+  if (!table_) {
+    const auto i0 =
+        static_cast<size_t>(static_cast<float>(n) / speed_factor_);
+    return std::min(i0, in_frames - 1);
+  }
+  const uint64_t i0 = n * uint64_t{table_->step.num} / table_->step.den;
+  const uint64_t back = static_cast<uint64_t>(table_->half - 1);
+  return std::min<size_t>(i0 > back ? i0 - back : 0, in_frames - 1);
+}
+
+size_t Kernel::input_end(size_t n, size_t in_frames) const {
+  if (!table_) {
+    const auto i0 =
+        static_cast<size_t>(static_cast<float>(n) / speed_factor_);
+    return std::min(std::min(i0, in_frames - 1) + 2, in_frames);
+  }
+  const uint64_t i0 = n * uint64_t{table_->step.num} / table_->step.den;
+  return std::min<size_t>(i0 + table_->half + 1, in_frames);
+}
+
+void Kernel::render(const float *src, size_t src_first, size_t in_frames,
+                    int channels, size_t first, size_t count,
+                    float *out) const {
+  if (!table_) {
+    render_linear(src, src_first, in_frames, channels, speed_factor_, first,
+                  count, out);
+    return;
+  }
+
+  switch (channels) {
+  case 1:
+    return render_taps<1>(*table_, src, src_first, in_frames, channels, first,
+                          count, out);
+  case 2:
+    return render_taps<2>(*table_, src, src_first, in_frames, channels, first,
+                          count, out);
+  default:
+    return render_taps<0>(*table_, src, src_first, in_frames, channels, first,
+                          count, out);
+  }
+}
+
+} // namespace core::speed
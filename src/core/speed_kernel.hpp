@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <core/audio_buffer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Ядро change_speed, разбитое на куски выхода: компактные буферы и
+// потоковые пути декодируют только нужное окно входа.
+//
+// Выходной кадр n читает вход около позиции n / speed. Для полифазного
+// фильтра шаг 1 / speed приближается дробью M / L (1.15 -> 20 / 23):
+// позиция — целая часть n * M / L и фаза (n * M) mod L, коэффициенты L фаз
+// считаются один раз и кэшируются по дроби.
+namespace core::speed {
+
+inline std::size_t output_frames(std::size_t in_frames, float speed_factor) {
+  return static_cast<std::size_t>(in_frames * speed_factor);
+}
+
+// Дробь M / L, ближайшая к x при L <= max_den (цепная дробь)
+struct Ratio {
+  uint32_t num = 1; // M
+  uint32_t den = 1; // L
+};
+Ratio rational_approximation(double x, uint32_t max_den);
+
+struct PhaseTable;
+
+class Kernel {
+public:
+  Kernel(float speed_factor, SpeedQuality quality);
+
+  // Первый входной кадр, который читает выходной кадр n.
+  std::size_t input_begin(std::size_t n, std::size_t in_frames) const;
+  // За последним входным кадром, который читает выходной кадр n.
+  std::size_t input_end(std::size_t n, std::size_t in_frames) const;
+
+  // Выходные кадры [first, first + count). src — входные кадры начиная с
+  // src_first; окно должно покрывать [input_begin(first),
+  // input_end(first + count - 1)). Вход за краями сигнала — нули.
+  void render(const float *src, std::size_t src_first, std::size_t in_frames,
+              int channels, std::size_t first, std::size_t count,
+              float *out) const;
+
+  // Отсчётов фильтра на выходной кадр (2 у Linear)
+  int taps() const;
+
+private:
+  float speed_factor_;
+  // nullptr — линейная интерполяция
+  std::shared_ptr<const PhaseTable> table_;
+};
+
+} // namespace core::speed
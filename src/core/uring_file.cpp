@@ -0,0 +1,533 @@
+#include "core/uring_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define GRUSTNIFY_HAVE_IO_URING 1
+#include <atomic>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace core::aio {
+
+namespace {
+
+struct AlignedFree {
+  void operator()(uint8_t *p) const { std::free(p); }
+};
+using Buffer = std::unique_ptr<uint8_t[], AlignedFree>;
+
+Buffer alloc_buffer(std::size_t bytes) {
+  // Кратно странице: буферы годятся и для O_DIRECT, если он понадобится
+  const std::size_t rounded = (bytes + 4095) / 4096 * 4096;
+  return Buffer(static_cast<uint8_t *>(std::aligned_alloc(4096, rounded)));
+}
+
+} // namespace
+
+#ifdef GRUSTNIFY_HAVE_IO_URING
+
+// Минимальная обёртка над кольцами io_uring: очередь READ/WRITE и разбор
+// завершений; один владелец, без потоков.
+struct Ring {
+  ~Ring() {
+    if (sqes)
+      munmap(sqes, sqes_size);
+    if (cq_ptr && cq_ptr != sq_ptr)
+      munmap(cq_ptr, cq_size);
+    if (sq_ptr)
+      munmap(sq_ptr, sq_size);
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  bool init(unsigned entries) {
+    io_uring_params p{};
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+    if (fd < 0)
+      return false;
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+      sq_size = cq_size = std::max(sq_size, cq_size);
+
+    sq_ptr = map(sq_size, IORING_OFF_SQ_RING);
+    cq_ptr = single ? sq_ptr : map(cq_size, IORING_OFF_CQ_RING);
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(map(sqes_size, IORING_OFF_SQES));
+    if (!sq_ptr || !cq_ptr || !sqes)
+      return false;
+
+    auto *sq = static_cast<uint8_t *>(sq_ptr);
+    sq_head = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sq_entries = p.sq_entries;
+    sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+
+    auto *cq = static_cast<uint8_t *>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    return true;
+  }
+
+  void *map(std::size_t size, off_t offset) {
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  // Ставит операцию и сразу отправляет её ядру (без ожидания).
+  bool queue(uint8_t opcode, int file, void *buf, unsigned len,
+             int64_t offset, uint64_t user_data) {
+    const unsigned tail = *sq_tail;
+    const unsigned head =
+        std::atomic_ref<unsigned>(*sq_head).load(std::memory_order_acquire);
+    if (tail - head >= sq_entries)
+      return false;
+
+    const unsigned idx = tail & sq_mask;
+    io_uring_sqe &sqe = sqes[idx];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = file;
+    sqe.addr = reinterpret_cast<uint64_t>(buf);
+    sqe.len = len;
+    sqe.off = static_cast<uint64_t>(offset);
+    sqe.user_data = user_data;
+    sq_array[idx] = idx;
+    std::atomic_ref<unsigned>(*sq_tail).store(tail + 1,
+                                              std::memory_order_release);
+    ++to_submit;
+    const int n = enter(0);
+    if (n >= 0 || n == -EAGAIN || n == -EBUSY)
+      return true; // не отправленное уйдёт со следующим enter
+    // Ядро не взяло ничего — снимаем sqe, вызывающий сделает pread/pwrite
+    std::atomic_ref<unsigned>(*sq_tail).store(tail, std::memory_order_release);
+    --to_submit;
+    return false;
+  }
+
+  int enter(unsigned wait_nr) {
+    while (true) {
+      const long n =
+          syscall(__NR_io_uring_enter, fd, to_submit, wait_nr,
+                  wait_nr ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+      if (n >= 0) {
+        to_submit -= static_cast<unsigned>(n);
+        return static_cast<int>(n);
+      }
+      if (errno != EINTR)
+        return -errno;
+    }
+  }
+
+  // Блокирует до ближайшего завершения. false — кольцо сломалось
+  // (enter вернул не EINTR/EAGAIN/EBUSY), ждать в нём больше нечего.
+  bool wait(io_uring_cqe &out) {
+    while (true) {
+      const unsigned head = *cq_head;
+      const unsigned tail =
+          std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire);
+      if (head != tail) {
+        out = cqes[head & cq_mask];
+        std::atomic_ref<unsigned>(*cq_head).store(head + 1,
+                                                  std::memory_order_release);
+        return true;
+      }
+      const int n = enter(1);
+      if (n < 0 && n != -EAGAIN && n != -EBUSY)
+        return false;
+    }
+  }
+
+  // READ/WRITE появились в 5.6 вместе с PROBE; ядро старше или
+  // урезанное seccomp'ом кольцо без них считаем недоступным.
+  bool supports_read_write() const {
+    constexpr unsigned kOps = 256;
+    const std::size_t bytes =
+        sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op);
+    std::unique_ptr<uint8_t[]> storage(new uint8_t[bytes]());
+    auto *probe = reinterpret_cast<io_uring_probe *>(storage.get());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                kOps) < 0)
+      return false;
+    auto has = [probe](unsigned op) {
+      return op <= probe->last_op &&
+             (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+    return has(IORING_OP_READ) && has(IORING_OP_WRITE);
+  }
+
+  int fd = -1;
+  void *sq_ptr = nullptr;
+  void *cq_ptr = nullptr;
+  io_uring_sqe *sqes = nullptr;
+  std::size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+  unsigned *sq_head = nullptr, *sq_tail = nullptr, *sq_array = nullptr;
+  unsigned sq_mask = 0, sq_entries = 0;
+  unsigned *cq_head = nullptr, *cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_cqe *cqes = nullptr;
+  unsigned to_submit = 0;
+};
+
+namespace {
+
+std::unique_ptr<Ring> make_ring(int depth) {
+  auto ring = std::make_unique<Ring>();
+  if (!ring->init(static_cast<unsigned>(depth)))
+    return nullptr;
+  return ring;
+}
+
+} // namespace
+
+bool available() {
+  static const bool ok = [] {
+    const std::unique_ptr<Ring> ring = make_ring(2);
+    return ring && ring->supports_read_write();
+  }();
+  return ok;
+}
+
+// --- чтение с упреждением ---
+
+struct PrefetchReader::Slot {
+  Buffer buf;
+  int64_t offset = -1;
+  int64_t result = 0; // байт прочитано или -errno
+  bool inflight = false;
+  bool valid = false; // данные [offset, offset + result) готовы
+};
+
+std::unique_ptr<PrefetchReader>
+PrefetchReader::open(const std::filesystem::path &path,
+                     const AioOptions &options) {
+  if (!available() || options.depth <= 0 || options.chunk_bytes == 0)
+    return nullptr;
+
+  std::unique_ptr<PrefetchReader> r(new PrefetchReader);
+  r->ring_ = make_ring(options.depth);
+  r->fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st{};
+  if (!r->ring_ || r->fd_ < 0 || fstat(r->fd_, &st) != 0 ||
+      !S_ISREG(st.st_mode)) {
+    return nullptr;
+  }
+  r->size_ = st.st_size;
+  r->depth_ = options.depth;
+  r->chunk_ = options.chunk_bytes;
+  r->slots_ = std::make_unique<Slot[]>(options.depth);
+  for (int i = 0; i < r->depth_; ++i) {
+    r->slots_[i].buf = alloc_buffer(r->chunk_);
+    if (!r->slots_[i].buf)
+      return nullptr;
+  }
+  // Ядро сам тоже читает вперёд: подскажем, что подряд
+  posix_fadvise(r->fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  r->restart(0);
+  return r;
+}
+
+PrefetchReader::~PrefetchReader() {
+  // Буферы нельзя отпускать, пока ядро в них пишет
+  while (inflight_ > 0)
+    wait_one();
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+void PrefetchReader::submit(Slot &slot) {
+  slot.offset = next_offset_;
+  slot.valid = false;
+  next_offset_ += static_cast<int64_t>(chunk_);
+  const uint64_t index = static_cast<uint64_t>(&slot - slots_.get());
+  if (ring_->queue(IORING_OP_READ, fd_, slot.buf.get(),
+                   static_cast<unsigned>(chunk_), slot.offset, index)) {
+    slot.inflight = true;
+    ++inflight_;
+    return;
+  }
+  // Очередь не приняла — слот просто пустует, read() дочитает синхронно
+  slot.offset = -1;
+}
+
+void PrefetchReader::wait_one() {
+  io_uring_cqe cqe{};
+  if (!ring_->wait(cqe)) {
+    // Завершений не дождаться: слоты в полёте помечаются ошибкой, и
+    // read() дочитает их обычным pread
+    for (int i = 0; i < depth_; ++i) {
+      if (slots_[i].inflight) {
+        slots_[i].result = -EIO;
+        slots_[i].inflight = false;
+        slots_[i].valid = true;
+      }
+    }
+    inflight_ = 0;
+    return;
+  }
+  Slot &slot = slots_[cqe.user_data];
+  slot.result = cqe.res;
+  slot.inflight = false;
+  slot.valid = true;
+  --inflight_;
+}
+
+void PrefetchReader::restart(int64_t offset) {
+  while (inflight_ > 0)
+    wait_one();
+  next_offset_ = offset;
+  for (int i = 0; i < depth_; ++i) {
+    slots_[i].valid = false;
+    slots_[i].offset = -1;
+    if (next_offset_ < size_)
+      submit(slots_[i]);
+  }
+}
+
+PrefetchReader::Slot *PrefetchReader::slot_for(int64_t pos) {
+  for (int i = 0; i < depth_; ++i) {
+    Slot &s = slots_[i];
+    if ((s.inflight || s.valid) && s.offset >= 0 && pos >= s.offset &&
+        pos < s.offset + static_cast<int64_t>(chunk_)) {
+      return &s;
+    }
+  }
+  return nullptr;
+}
+
+int64_t PrefetchReader::read(void *dst, std::size_t size) {
+  if (pos_ >= size_ || size == 0)
+    return 0;
+
+  Slot *slot = slot_for(pos_);
+  if (!slot) {
+    restart(pos_);
+    slot = slot_for(pos_);
+  }
+  while (slot && slot->inflight)
+    wait_one();
+
+  const int64_t in_slot = slot ? pos_ - slot->offset : 0;
+  if (!slot || slot->result < 0 || in_slot >= slot->result) {
+    // Ошибка или короткое чтение в слоте: этот кусок — обычным pread
+    const ssize_t n = ::pread(fd_, dst, size, pos_);
+    if (n < 0)
+      return -errno;
+    pos_ += n;
+    return n;
+  }
+
+  const int64_t n =
+      std::min<int64_t>(static_cast<int64_t>(size), slot->result - in_slot);
+  std::memcpy(dst, slot->buf.get() + in_slot, static_cast<std::size_t>(n));
+  pos_ += n;
+
+  // Слот дочитан — он уходит за следующим чанком
+  if (pos_ >= slot->offset + slot->result) {
+    slot->valid = false;
+    if (next_offset_ < size_)
+      submit(*slot);
+  }
+  return n;
+}
+
+int64_t PrefetchReader::seek(int64_t offset) {
+  if (offset < 0)
+    return -EINVAL;
+  pos_ = offset;
+  return pos_;
+}
+
+// --- запись с отложенным сбросом ---
+
+struct WriteBehind::Slot {
+  Buffer buf;
+  std::size_t len = 0;
+  int64_t offset = 0;
+  bool inflight = false;
+};
+
+std::unique_ptr<WriteBehind>
+WriteBehind::open(const std::filesystem::path &path,
+                  const AioOptions &options) {
+  if (!available() || options.depth <= 0 || options.chunk_bytes == 0)
+    return nullptr;
+
+  std::unique_ptr<WriteBehind> w(new WriteBehind);
+  w->ring_ = make_ring(options.depth);
+  if (!w->ring_)
+    return nullptr;
+  w->depth_ = options.depth;
+  w->chunk_ = options.chunk_bytes;
+  w->slots_ = std::make_unique<Slot[]>(options.depth);
+  for (int i = 0; i < w->depth_; ++i) {
+    w->slots_[i].buf = alloc_buffer(w->chunk_);
+    if (!w->slots_[i].buf)
+      return nullptr;
+  }
+  w->fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+  if (w->fd_ < 0)
+    return nullptr;
+  return w;
+}
+
+WriteBehind::~WriteBehind() {
+  if (fd_ >= 0)
+    close();
+}
+
+bool WriteBehind::submit_current() {
+  Slot &slot = slots_[current_];
+  slot.len = fill_;
+  slot.offset = pos_;
+  if (ring_->queue(IORING_OP_WRITE, fd_, slot.buf.get(),
+                   static_cast<unsigned>(fill_), pos_,
+                   static_cast<uint64_t>(current_))) {
+    slot.inflight = true;
+    ++inflight_;
+  } else if (::pwrite(fd_, slot.buf.get(), fill_, pos_) !=
+             static_cast<ssize_t>(fill_)) {
+    error_ = errno ? errno : EIO;
+  }
+
+  pos_ += static_cast<int64_t>(fill_);
+  end_ = std::max(end_, pos_);
+  fill_ = 0;
+  current_ = (current_ + 1) % depth_;
+  return error_ == 0;
+}
+
+void WriteBehind::write_sync(const Slot &slot, std::size_t done) {
+  const std::size_t rest = slot.len - done;
+  if (::pwrite(fd_, slot.buf.get() + done, rest,
+               slot.offset + static_cast<int64_t>(done)) !=
+      static_cast<ssize_t>(rest))
+    error_ = errno ? errno : EIO;
+}
+
+void WriteBehind::wait_one() {
+  io_uring_cqe cqe{};
+  if (!ring_->wait(cqe)) {
+    // Кольцо сломалось: всё, что было в полёте, пишем синхронно (повтор
+    // уже записанного безвреден — те же байты по тому же смещению)
+    for (int i = 0; i < depth_; ++i) {
+      if (slots_[i].inflight) {
+        slots_[i].inflight = false;
+        write_sync(slots_[i], 0);
+      }
+    }
+    inflight_ = 0;
+    return;
+  }
+  Slot &slot = slots_[cqe.user_data];
+  slot.inflight = false;
+  --inflight_;
+
+  if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+    // Файл (FUSE, спецфайл) не умеет асинхронную запись — синхронно
+    write_sync(slot, 0);
+  } else if (cqe.res < 0) {
+    error_ = -cqe.res;
+  } else if (static_cast<std::size_t>(cqe.res) < slot.len) {
+    // Короткая запись: остаток синхронно
+    write_sync(slot, static_cast<std::size_t>(cqe.res));
+  }
+}
+
+void WriteBehind::drain() {
+  while (inflight_ > 0)
+    wait_one();
+}
+
+int64_t WriteBehind::write(const void *src, std::size_t size) {
+  const auto *in = static_cast<const uint8_t *>(src);
+  for (std::size_t done = 0; done < size;) {
+    Slot &slot = slots_[current_];
+    while (slot.inflight)
+      wait_one();
+    if (error_)
+      return -error_;
+
+    const std::size_t take = std::min(chunk_ - fill_, size - done);
+    std::memcpy(slot.buf.get() + fill_, in + done, take);
+    fill_ += take;
+    done += take;
+    if (fill_ == chunk_ && !submit_current())
+      return -error_;
+  }
+  return error_ ? -error_ : static_cast<int64_t>(size);
+}
+
+int64_t WriteBehind::seek(int64_t offset) {
+  if (offset < 0)
+    return -EINVAL;
+  if (fill_ > 0)
+    submit_current();
+  drain();
+  if (error_)
+    return -error_;
+  pos_ = offset;
+  return pos_;
+}
+
+int64_t WriteBehind::size() {
+  return std::max(end_, pos_ + static_cast<int64_t>(fill_));
+}
+
+bool WriteBehind::close() {
+  if (fd_ < 0)
+    return false;
+  if (fill_ > 0)
+    submit_current();
+  drain();
+  if (::close(fd_) != 0 && !error_)
+    error_ = errno;
+  fd_ = -1;
+  return error_ == 0;
+}
+
+#else
+
+struct Ring {};
+
+bool available() { return false; }
+
+struct PrefetchReader::Slot {};
+std::unique_ptr<PrefetchReader>
+PrefetchReader::open(const std::filesystem::path &, const AioOptions &) {
+  return nullptr;
+}
+PrefetchReader::~PrefetchReader() = default;
+int64_t PrefetchReader::read(void *, std::size_t) { return -ENOSYS; }
+int64_t PrefetchReader::seek(int64_t) { return -ENOSYS; }
+
+struct WriteBehind::Slot {};
+std::unique_ptr<WriteBehind> WriteBehind::open(const std::filesystem::path &,
+                                               const AioOptions &) {
+  return nullptr;
+}
+WriteBehind::~WriteBehind() = default;
+int64_t WriteBehind::write(const void *, std::size_t) { return -ENOSYS; }
+int64_t WriteBehind::seek(int64_t) { return -ENOSYS; }
+int64_t WriteBehind::size() { return 0; }
+bool WriteBehind::close() { return false; }
+
+#endif
+
+} // namespace core::aio
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+// Файловый I/O поверх io_uring (сырые системные вызовы, без liburing):
+// чтение с упреждением на несколько больших чанков и запись с отложенным
+// сбросом через ограниченное число буферов в полёте. Поток DSP не ждёт
+// сетевой том на каждом read()/write(). Где io_uring нет (не Linux, старое
+// ядро, seccomp в контейнере), open() возвращает nullptr и вызывающий
+// остаётся на обычном I/O.
+namespace core::aio {
+
+struct Ring;
+
+struct AioOptions {
+  std::size_t chunk_bytes = std::size_t{1} << 20;
+  int depth = 4; // чанков в полёте
+};
+
+// Доступен ли io_uring в этом процессе (проверяется один раз).
+bool available();
+
+class PrefetchReader {
+public:
+  static std::unique_ptr<PrefetchReader>
+  open(const std::filesystem::path &path, const AioOptions &options = {});
+  ~PrefetchReader();
+
+  // Как read(2): 0 — конец файла, < 0 — -errno.
+  int64_t read(void *dst, std::size_t size);
+  // Абсолютная позиция; упреждение перезапускается лениво при чтении.
+  int64_t seek(int64_t offset);
+  int64_t tell() const { return pos_; }
+  int64_t size() const { return size_; }
+
+private:
+  struct Slot;
+  PrefetchReader() = default;
+  void restart(int64_t offset);
+  void submit(Slot &slot);
+  void wait_one();
+  Slot *slot_for(int64_t pos);
+
+  std::unique_ptr<Ring> ring_;
+  std::unique_ptr<Slot[]> slots_;
+  int depth_ = 0;
+  std::size_t chunk_ = 0;
+  int fd_ = -1;
+  int64_t size_ = 0;
+  int64_t pos_ = 0;
+  int64_t next_offset_ = 0; // куда пойдёт следующее упреждение
+  int inflight_ = 0;
+};
+
+class WriteBehind {
+public:
+  static std::unique_ptr<WriteBehind>
+  open(const std::filesystem::path &path, const AioOptions &options = {});
+  ~WriteBehind();
+
+  // Копирует в текущий буфер; полный буфер уходит в ring, а при исчерпании
+  // свободных ждём самый старый. < 0 — -errno прошлой ошибки записи.
+  int64_t write(const void *src, std::size_t size);
+  // Muxer'ы возвращаются патчить заголовок: всё в полёте дописывается,
+  // дальше пишем с offset.
+  int64_t seek(int64_t offset);
+  int64_t tell() const { return pos_ + static_cast<int64_t>(fill_); }
+  int64_t size();
+  // Дописывает хвост и закрывает файл; false — была ошибка записи.
+  bool close();
+
+private:
+  struct Slot;
+  WriteBehind() = default;
+  bool submit_current();
+  void wait_one();
+  // Дописывает слот с байта done обычным pwrite.
+  void write_sync(const Slot &slot, std::size_t done);
+  void drain();
+
+  std::unique_ptr<Ring> ring_;
+  std::unique_ptr<Slot[]> slots_;
+  int depth_ = 0;
+  std::size_t chunk_ = 0;
+  int fd_ = -1;
+  int current_ = 0;        // заполняемый слот
+  std::size_t fill_ = 0;   // байт в нём
+  int64_t pos_ = 0;        // смещение начала текущего слота в файле
+  int64_t end_ = 0;        // дальний записанный байт
+  int inflight_ = 0;
+  int error_ = 0;
+};
+
+} // namespace core::aio
@@ -0,0 +1,268 @@
+#include "video_remux.hpp"
+#include "core/audio_encoder.hpp"
+#include "log/log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace core {
+
+namespace {
+
+// Звук кодируется с опережением копируемых пакетов: muxer'у не приходится
+// копить в памяти видео, дожидаясь аудио для interleave.
+constexpr double kAudioLeadSeconds = 0.5;
+
+constexpr AVCodecID kAudioCodecs[] = {AV_CODEC_ID_AAC, AV_CODEC_ID_MP3,
+                                      AV_CODEC_ID_OPUS, AV_CODEC_ID_VORBIS,
+                                      AV_CODEC_ID_FLAC};
+
+bool is_copied_type(AVMediaType type) {
+  return type == AVMEDIA_TYPE_VIDEO || type == AVMEDIA_TYPE_SUBTITLE ||
+         type == AVMEDIA_TYPE_ATTACHMENT;
+}
+
+// 1 — поддерживается, 0 — нет, < 0 — muxer не знает; неизвестное пробуем.
+bool container_accepts(const AVOutputFormat *format, AVCodecID id) {
+  return avformat_query_codec(format, id, FF_COMPLIANCE_NORMAL) != 0;
+}
+
+AVCodecID pick_audio_codec(const AVOutputFormat *format) {
+  for (AVCodecID id : kAudioCodecs) {
+    if (avformat_query_codec(format, id, FF_COMPLIANCE_NORMAL) == 1 &&
+        avcodec_find_encoder(id))
+      return id;
+  }
+  for (AVCodecID id : kAudioCodecs) {
+    if (container_accepts(format, id) && avcodec_find_encoder(id))
+      return id;
+  }
+  return AV_CODEC_ID_NONE;
+}
+
+// Кусок [first, first + count) в виде interleaved float
+const float *frames_at(const AudioBuffer &audio, size_t first, size_t,
+                       std::vector<float> &) {
+  return audio.samples.data() + first * audio.channels;
+}
+
+const float *frames_at(const CompactAudioBuffer &audio, size_t first,
+                       size_t count, std::vector<float> &scratch) {
+  scratch.resize(count * audio.channels);
+  decode_compact(audio.format, audio.samples.data() + first * audio.channels,
+                 scratch.data(), count * audio.channels);
+  return scratch.data();
+}
+
+struct RemuxContexts {
+  AVFormatContext *in = nullptr;
+  AVFormatContext *out = nullptr;
+  AVPacket *packet = nullptr;
+
+  ~RemuxContexts() {
+    av_packet_free(&packet);
+    if (out) {
+      if (!(out->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&out->pb);
+      avformat_free_context(out);
+    }
+    avformat_close_input(&in);
+  }
+};
+
+template <typename Buffer>
+bool remux_impl(const std::filesystem::path &input, int audio_stream_index,
+                const std::filesystem::path &output, const Buffer &audio,
+                const RemuxOptions &options) {
+  if (audio.sample_rate <= 0 || audio.channels <= 0) {
+    TE_ERROR("remux: invalid audio buffer");
+    return false;
+  }
+
+  const std::u8string in_utf8 = input.u8string();
+  const std::u8string out_utf8 = output.u8string();
+  const char *in_path = reinterpret_cast<const char *>(in_utf8.c_str());
+  const char *out_path = reinterpret_cast<const char *>(out_utf8.c_str());
+
+  RemuxContexts ctx;
+  if (avformat_open_input(&ctx.in, in_path, nullptr, nullptr) != 0) {
+    TE_ERROR("remux: could not open {}", input.string());
+    return false;
+  }
+  if (avformat_find_stream_info(ctx.in, nullptr) < 0 ||
+      audio_stream_index < 0 ||
+      audio_stream_index >= static_cast<int>(ctx.in->nb_streams)) {
+    TE_ERROR("remux: no audio stream {} in {}", audio_stream_index,
+             input.string());
+    return false;
+  }
+
+  if (avformat_alloc_output_context2(&ctx.out, nullptr, nullptr, out_path) <
+          0 ||
+      !ctx.out) {
+    TE_ERROR("remux: unknown output container for {}", output.string());
+    return false;
+  }
+  const AVOutputFormat *oformat = ctx.out->oformat;
+
+  const bool stretch = options.timestamps == VideoTimestampPolicy::Stretch;
+  const AVRational speed =
+      stretch ? av_d2q(options.speed_factor, 1 << 16) : AVRational{1, 1};
+
+  // Входной поток -> выходной (-1 — не копируется). Растянутые таймстемпы
+  // получаются без округления: pts остаются как есть, а time_base источника
+  // умножается на speed.
+  std::vector<int> stream_map(ctx.in->nb_streams, -1);
+  std::vector<AVRational> source_tb(ctx.in->nb_streams);
+  for (unsigned i = 0; i < ctx.in->nb_streams; ++i) {
+    AVStream *in_stream = ctx.in->streams[i];
+    const AVCodecParameters *par = in_stream->codecpar;
+    if (!is_copied_type(par->codec_type) ||
+        !container_accepts(oformat, par->codec_id)) {
+      if (static_cast<int>(i) != audio_stream_index)
+        TE_WARN("remux: dropping stream #{} ({})", i,
+                avcodec_get_name(par->codec_id));
+      in_stream->discard = AVDISCARD_ALL;
+      continue;
+    }
+
+    AVStream *out_stream = avformat_new_stream(ctx.out, nullptr);
+    if (!out_stream ||
+        avcodec_parameters_copy(out_stream->codecpar, par) < 0) {
+      TE_ERROR("remux: could not copy stream #{}", i);
+      return false;
+    }
+    out_stream->codecpar->codec_tag = 0;
+    out_stream->disposition = in_stream->disposition;
+    av_dict_copy(&out_stream->metadata, in_stream->metadata, 0);
+
+    source_tb[i] = av_mul_q(in_stream->time_base, speed);
+    out_stream->time_base = source_tb[i];
+    if (in_stream->avg_frame_rate.num > 0)
+      out_stream->avg_frame_rate = av_div_q(in_stream->avg_frame_rate, speed);
+    stream_map[i] = out_stream->index;
+  }
+
+  const AVCodecID audio_codec = pick_audio_codec(oformat);
+  if (audio_codec == AV_CODEC_ID_NONE) {
+    TE_ERROR("remux: {} has no supported audio codec", oformat->name);
+    return false;
+  }
+
+  // Звук начинается там же, где начинался исходный аудиопоток.
+  const AVStream *in_audio = ctx.in->streams[audio_stream_index];
+  double audio_start = 0.0;
+  if (in_audio->start_time != AV_NOPTS_VALUE)
+    audio_start = in_audio->start_time * av_q2d(in_audio->time_base) *
+                  av_q2d(speed);
+  const int64_t audio_start_pts = std::llround(audio_start * audio.sample_rate);
+
+  // Деструктор энкодера пишет в ctx.out, поэтому объявлен после ctx.
+  AudioEncoder encoder;
+  if (!encoder.attach(ctx.out, audio.sample_rate, audio.channels,
+                      options.audio_bitrate, audio_codec, audio_start_pts)) {
+    return false;
+  }
+  av_dict_copy(&ctx.out->metadata, ctx.in->metadata, 0);
+
+  if (!(oformat->flags & AVFMT_NOFILE) &&
+      avio_open(&ctx.out->pb, out_path, AVIO_FLAG_WRITE) < 0) {
+    TE_ERROR("remux: could not open {}", output.string());
+    return false;
+  }
+  if (avformat_write_header(ctx.out, nullptr) < 0) {
+    TE_ERROR("remux: could not write header to {}", output.string());
+    return false;
+  }
+
+  const size_t total_frames = audio.samples.size() / audio.channels;
+  size_t encoded = 0;
+  std::vector<float> scratch;
+  audio.samples.advise(StorageAccess::Sequential);
+
+  // Дописывает звук до момента seconds на выходной шкале.
+  auto encode_until = [&](double seconds) {
+    const double ahead = (seconds - audio_start) * audio.sample_rate;
+    const size_t target =
+        ahead >= static_cast<double>(total_frames)
+            ? total_frames
+            : static_cast<size_t>(std::max(0.0, ahead));
+    while (encoded < target) {
+      const size_t count = std::min<size_t>(target - encoded, 16384);
+      if (!encoder.encode_interleaved(frames_at(audio, encoded, count, scratch),
+                                      count))
+        return false;
+      encoded += count;
+    }
+    return true;
+  };
+
+  ctx.packet = av_packet_alloc();
+  if (!ctx.packet)
+    return false;
+
+  while (av_read_frame(ctx.in, ctx.packet) >= 0) {
+    const int in_index = ctx.packet->stream_index;
+    if (stream_map[in_index] < 0) {
+      av_packet_unref(ctx.packet);
+      continue;
+    }
+
+    const int64_t ts = ctx.packet->dts != AV_NOPTS_VALUE ? ctx.packet->dts
+                                                         : ctx.packet->pts;
+    if (ts != AV_NOPTS_VALUE &&
+        !encode_until(ts * av_q2d(source_tb[in_index]) + kAudioLeadSeconds)) {
+      av_packet_unref(ctx.packet);
+      return false;
+    }
+
+    AVStream *out_stream = ctx.out->streams[stream_map[in_index]];
+    ctx.packet->stream_index = out_stream->index;
+    av_packet_rescale_ts(ctx.packet, source_tb[in_index],
+                         out_stream->time_base);
+    ctx.packet->pos = -1;
+    if (av_interleaved_write_frame(ctx.out, ctx.packet) < 0) {
+      TE_ERROR("remux: write failed for stream #{}", in_index);
+      return false;
+    }
+  }
+
+  if (!encode_until(std::numeric_limits<double>::infinity()))
+    return false;
+  encoder.close();
+
+  if (av_write_trailer(ctx.out) < 0) {
+    TE_ERROR("remux: could not write trailer to {}", output.string());
+    return false;
+  }
+  TE_INFO("remux: {} copied stream(s) + {} audio -> {}",
+          ctx.out->nb_streams - 1, avcodec_get_name(audio_codec),
+          output.string());
+  return true;
+}
+
+} // namespace
+
+bool remux_with_audio(const std::filesystem::path &input,
+                      int audio_stream_index,
+                      const std::filesystem::path &output,
+                      const AudioBuffer &audio, const RemuxOptions &options) {
+  return remux_impl(input, audio_stream_index, output, audio, options);
+}
+
+bool remux_with_audio(const std::filesystem::path &input,
+                      int audio_stream_index,
+                      const std::filesystem::path &output,
+                      const CompactAudioBuffer &audio,
+                      const RemuxOptions &options) {
+  return remux_impl(input, audio_stream_index, output, audio, options);
+}
+
+} // namespace core
@@ -0,0 +1,38 @@
+#pragma once
+#include <core/audio_buffer.hpp>
+#include <core/compact_buffer.hpp>
+#include <filesystem>
+
+namespace core {
+
+// Что делать с таймстемпами копируемых потоков, раз замедление меняет
+// длительность звука.
+enum class VideoTimestampPolicy {
+  // pts/dts/duration видео и субтитров умножаются на speed_factor: картинка
+  // замедляется вместе со звуком и остаётся в синхроне.
+  Stretch,
+  // Видео как есть; звук длиннее и продолжается после последнего кадра.
+  Keep,
+};
+
+struct RemuxOptions {
+  float speed_factor = 1.0f; // тот же, что у change_speed
+  VideoTimestampPolicy timestamps = VideoTimestampPolicy::Stretch;
+  int audio_bitrate = 128000;
+};
+
+// Пишет output (контейнер — по расширению): видео, субтитры и вложения из
+// input копируются пакетами без перекодирования, аудиопоток audio_stream_index
+// заменяется на audio. Прочие аудиопотоки отбрасываются. Кодек звука —
+// первый из AAC, MP3, Opus, Vorbis, FLAC, который принимает контейнер.
+bool remux_with_audio(const std::filesystem::path &input,
+                      int audio_stream_index,
+                      const std::filesystem::path &output,
+                      const AudioBuffer &audio, const RemuxOptions &options);
+bool remux_with_audio(const std::filesystem::path &input,
+                      int audio_stream_index,
+                      const std::filesystem::path &output,
+                      const CompactAudioBuffer &audio,
+                      const RemuxOptions &options);
+
+} // namespace core
@@ -0,0 +1,360 @@
+#include "core/wav_writer.hpp"
+
+#include "core/sample_convert.hpp"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GRUSTNIFY_HAVE_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+// Поля заголовка пишутся memcpy'ем как есть.
+static_assert(std::endian::native == std::endian::little,
+              "WavWriter assumes a little-endian host");
+
+namespace {
+
+// Выравнивание для O_DIRECT: адрес, смещение и длина кратны блоку.
+constexpr std::size_t kAlign = 4096;
+
+class HeaderCursor {
+public:
+  explicit HeaderCursor(uint8_t *p) : p_(p) {}
+  void tag(const char *t) { bytes(t, 4); }
+  void u16(uint16_t v) { bytes(&v, 2); }
+  void u32(uint32_t v) { bytes(&v, 4); }
+  void u64(uint64_t v) { bytes(&v, 8); }
+  void zeros(std::size_t n) {
+    std::memset(p_ + at_, 0, n);
+    at_ += n;
+  }
+  void bytes(const void *v, std::size_t n) {
+    std::memcpy(p_ + at_, v, n);
+    at_ += n;
+  }
+  std::size_t at() const { return at_; }
+
+private:
+  uint8_t *p_;
+  std::size_t at_ = 0;
+};
+
+} // namespace
+
+void WavWriter::AlignedFree::operator()(uint8_t *p) const { std::free(p); }
+
+WavWriter::WavWriter() = default;
+
+WavWriter::~WavWriter() {
+  if (is_open())
+    close();
+}
+
+void WavWriter::build_header() {
+  HeaderCursor h(blocks_[0].get());
+  const bool is_float = options_.format == WavSampleFormat::F32;
+  const bool extensible = channels_ > 2;
+  const auto bits = static_cast<uint16_t>(sample_bytes_ * 8);
+  const auto block_align = static_cast<uint16_t>(channels_ * sample_bytes_);
+
+  h.tag("RIFF");
+  h.u32(0);
+  h.tag("WAVE");
+
+  // Место под ds64: при переходе на RF64 JUNK переименовывается на месте
+  ds64_at_ = h.at();
+  h.tag("JUNK");
+  h.u32(28);
+  h.zeros(28);
+
+  h.tag("fmt ");
+  h.u32(extensible ? 40 : (is_float ? 18 : 16));
+  h.u16(extensible ? 0xFFFE : (is_float ? 3 : 1));
+  h.u16(static_cast<uint16_t>(channels_));
+  h.u32(static_cast<uint32_t>(sample_rate_));
+  h.u32(static_cast<uint32_t>(sample_rate_) * block_align);
+  h.u16(block_align);
+  h.u16(bits);
+  if (extensible) {
+    h.u16(22);
+    h.u16(bits);
+    h.u32(channels_ < 18 ? (1u << channels_) - 1 : 0); // FL FR FC LFE ...
+    // KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT
+    static constexpr uint8_t kGuidTail[] = {0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                            0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+    h.u32(is_float ? 3 : 1);
+    h.bytes(kGuidTail, sizeof(kGuidTail));
+  } else if (is_float) {
+    h.u16(0);
+  }
+
+  fact_at_ = 0;
+  if (is_float) {
+    h.tag("fact");
+    h.u32(4);
+    fact_at_ = h.at();
+    h.u32(0);
+  }
+
+  // С O_DIRECT данные начинаются с границы блока: весь I/O выровнен.
+  if (direct_) {
+    const std::size_t pad = (kAlign - (h.at() + 16) % kAlign) % kAlign;
+    h.tag("JUNK");
+    h.u32(static_cast<uint32_t>(pad));
+    h.zeros(pad);
+  }
+
+  h.tag("data");
+  data_size_at_ = h.at();
+  h.u32(0);
+
+  header_bytes_ = h.at();
+  fill_ = header_bytes_;
+}
+
+#ifdef GRUSTNIFY_HAVE_POSIX_IO
+
+bool WavWriter::open(const std::filesystem::path &path, int sample_rate,
+                     int channels, const WavOptions &options) {
+  if (is_open())
+    abort();
+  if (sample_rate <= 0 || channels <= 0 || channels > 0xFFFF)
+    return false;
+
+  options_ = options;
+  sample_rate_ = sample_rate;
+  channels_ = channels;
+  sample_bytes_ = options.format == WavSampleFormat::S16 ? 2 : 4;
+
+  for (Block &block : blocks_) {
+    if (!block) {
+      block.reset(
+          static_cast<uint8_t *>(std::aligned_alloc(kAlign, kBlockBytes)));
+      if (!block)
+        return false;
+    }
+  }
+
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  direct_ = false;
+#ifdef O_DIRECT
+  if (options.direct_io) {
+    fd_ = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    direct_ = fd_ >= 0;
+  }
+#endif
+  if (fd_ < 0)
+    fd_ = ::open(path.c_str(), flags, 0644);
+  if (fd_ < 0)
+    return false;
+#ifdef F_NOCACHE
+  if (options.direct_io)
+    fcntl(fd_, F_NOCACHE, 1);
+#endif
+
+  block_ = 0;
+  written_ = 0;
+  dropped_ = 0;
+  data_bytes_ = 0;
+  rf64_ = false;
+  build_header();
+  return true;
+}
+
+bool WavWriter::write(const float *interleaved, std::size_t frames) {
+  if (!is_open())
+    return false;
+
+  const std::size_t n = frames * channels_;
+  for (std::size_t done = 0; done < n;) {
+    const std::size_t take =
+        std::min((kBlockBytes - fill_) / sample_bytes_, n - done);
+    uint8_t *dst = blocks_[block_].get() + fill_;
+    if (options_.format == WavSampleFormat::S16)
+      convert::kernels().f32_to_s16(interleaved + done,
+                                    reinterpret_cast<int16_t *>(dst), take,
+                                    nullptr);
+    else
+      std::memcpy(dst, interleaved + done, take * sizeof(float));
+
+    done += take;
+    fill_ += take * sample_bytes_;
+    data_bytes_ += take * sample_bytes_;
+
+    if (fill_ == kBlockBytes) {
+      fill_ = 0;
+      if (++block_ == kBlocks) {
+        block_ = 0;
+        if (!write_blocks(kBlocks, 0)) {
+          abort();
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool WavWriter::write_blocks(std::size_t count, std::size_t tail_bytes) {
+  iovec iov[kBlocks + 1];
+  int iov_count = 0;
+  for (std::size_t i = 0; i < count; ++i)
+    iov[iov_count++] = {blocks_[i].get(), kBlockBytes};
+  if (tail_bytes > 0)
+    iov[iov_count++] = {blocks_[count].get(), tail_bytes};
+
+  const uint64_t begin = written_;
+  iovec *next = iov;
+  while (iov_count > 0) {
+    const ssize_t n = ::writev(fd_, next, iov_count);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    written_ += static_cast<uint64_t>(n);
+    // Короткая запись: продолжаем с места остановки
+    std::size_t left = static_cast<std::size_t>(n);
+    while (iov_count > 0 && left >= next->iov_len) {
+      left -= next->iov_len;
+      ++next;
+      --iov_count;
+    }
+    if (iov_count > 0) {
+      next->iov_base = static_cast<uint8_t *>(next->iov_base) + left;
+      next->iov_len -= left;
+    }
+  }
+
+  if (options_.drop_cache)
+    drop_written(begin, written_);
+  return true;
+}
+
+void WavWriter::drop_written(uint64_t begin, uint64_t end) {
+#if defined(__linux__)
+  // Новый кусок только отправляем на запись, а предыдущий дожидаемся: к
+  // fadvise его страницы уже чистые, и writeback идёт параллельно с DSP.
+  sync_file_range(fd_, static_cast<off64_t>(begin),
+                  static_cast<off64_t>(end - begin), SYNC_FILE_RANGE_WRITE);
+  if (begin > dropped_) {
+    sync_file_range(fd_, static_cast<off64_t>(dropped_),
+                    static_cast<off64_t>(begin - dropped_),
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                        SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd_, static_cast<off_t>(dropped_),
+                  static_cast<off_t>(begin - dropped_), POSIX_FADV_DONTNEED);
+    dropped_ = begin;
+  }
+#elif defined(POSIX_FADV_DONTNEED)
+  (void)begin;
+  posix_fadvise(fd_, static_cast<off_t>(dropped_),
+                static_cast<off_t>(end - dropped_), POSIX_FADV_DONTNEED);
+  dropped_ = end;
+#else
+  (void)begin;
+  (void)end;
+#endif
+}
+
+bool WavWriter::patch_header() {
+  const uint64_t file_bytes = header_bytes_ + data_bytes_;
+  const uint64_t frames = data_bytes_ / (sample_bytes_ * channels_);
+  rf64_ = file_bytes - 8 > options_.riff_limit;
+
+  auto put = [this](std::size_t at, const void *data, std::size_t n) {
+    return ::pwrite(fd_, data, n, static_cast<off_t>(at)) ==
+           static_cast<ssize_t>(n);
+  };
+  auto put_u32 = [&](std::size_t at, uint32_t v) { return put(at, &v, 4); };
+
+  bool ok = true;
+  if (rf64_) {
+    uint8_t head[8];
+    HeaderCursor riff(head);
+    riff.tag("RF64");
+    riff.u32(0xFFFFFFFFu);
+
+    uint8_t ds64[36];
+    HeaderCursor h(ds64);
+    h.tag("ds64");
+    h.u32(28);
+    h.u64(file_bytes - 8);
+    h.u64(data_bytes_);
+    h.u64(frames);
+    h.u32(0); // таблицы других больших чанков нет
+
+    ok = put(0, head, sizeof(head)) && put(ds64_at_, ds64, sizeof(ds64)) &&
+         put_u32(data_size_at_, 0xFFFFFFFFu);
+    if (fact_at_)
+      ok = ok && put_u32(fact_at_, 0xFFFFFFFFu);
+  } else {
+    ok = put_u32(4, static_cast<uint32_t>(file_bytes - 8)) &&
+         put_u32(data_size_at_, static_cast<uint32_t>(data_bytes_));
+    if (fact_at_)
+      ok = ok && put_u32(fact_at_, static_cast<uint32_t>(frames));
+  }
+  return ok;
+}
+
+bool WavWriter::close() {
+  if (!is_open())
+    return false;
+
+  // Полные блоки и выровненная часть хвоста — одним writev(); остаток
+  // O_DIRECT не примет, поэтому его и патч заголовка пишем без него.
+  const std::size_t tail_aligned = direct_ ? fill_ / kAlign * kAlign : fill_;
+  bool ok = write_blocks(block_, tail_aligned);
+#ifdef O_DIRECT
+  if (direct_)
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_DIRECT);
+#endif
+  if (ok && fill_ > tail_aligned) {
+    const std::size_t rest = fill_ - tail_aligned;
+    ok = ::pwrite(fd_, blocks_[block_].get() + tail_aligned, rest,
+                  static_cast<off_t>(written_)) == static_cast<ssize_t>(rest);
+    written_ += rest;
+  }
+  ok = ok && patch_header();
+
+  if (ok && options_.drop_cache) {
+    fdatasync(fd_);
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+  }
+
+  ok = ::close(fd_) == 0 && ok;
+  fd_ = -1;
+  return ok;
+}
+
+void WavWriter::abort() {
+  ::close(fd_);
+  fd_ = -1;
+}
+
+#else
+
+bool WavWriter::open(const std::filesystem::path &, int, int,
+                     const WavOptions &) {
+  return false;
+}
+bool WavWriter::write(const float *, std::size_t) { return false; }
+bool WavWriter::close() { return false; }
+bool WavWriter::write_blocks(std::size_t, std::size_t) { return false; }
+void WavWriter::drop_written(uint64_t, uint64_t) {}
+bool WavWriter::patch_header() { return false; }
+void WavWriter::abort() {}
+
+#endif
+
+} // namespace core
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+// Прямая запись WAV/RF64 без avformat/avcodec: interleaved float сразу
+// в большие выровненные буферы, которые уходят в файл одним writev().
+namespace core {
+
+enum class WavSampleFormat {
+  F32, // WAVE_FORMAT_IEEE_FLOAT, как есть
+  S16, // PCM, округление SIMD-ядрами core::convert
+};
+
+struct WavOptions {
+  WavSampleFormat format = WavSampleFormat::F32;
+  // O_DIRECT (Linux) / F_NOCACHE (macOS): данные идут мимо page cache.
+  // Если ФС не умеет, файл открывается как обычно.
+  bool direct_io = false;
+  // Записанное по ходу сбрасывается на диск и выкидывается из page cache,
+  // чтобы большой выход не вытеснял чужие данные на общих узлах.
+  bool drop_cache = false;
+  // Размер RIFF, выше которого заголовок становится RF64 (4 ГиБ; меньше —
+  // только для тестов).
+  uint64_t riff_limit = 0xFFFFFFFFull;
+};
+
+class WavWriter {
+public:
+  WavWriter();
+  ~WavWriter();
+  WavWriter(const WavWriter &) = delete;
+  WavWriter &operator=(const WavWriter &) = delete;
+
+  // false — не удалось создать файл или платформа без POSIX I/O (тогда
+  // AudioEncoder пишет WAV через FFmpeg).
+  bool open(const std::filesystem::path &path, int sample_rate, int channels,
+            const WavOptions &options = {});
+  bool write(const float *interleaved, std::size_t frames);
+  // Дописывает хвост и проставляет размеры в заголовке (RIFF или RF64).
+  bool close();
+
+  bool is_open() const { return fd_ >= 0; }
+  uint64_t data_bytes() const { return data_bytes_; }
+  bool is_rf64() const { return rf64_; }
+
+private:
+  struct AlignedFree {
+    void operator()(uint8_t *p) const;
+  };
+  using Block = std::unique_ptr<uint8_t[], AlignedFree>;
+
+  static constexpr std::size_t kBlockBytes = std::size_t{1} << 20;
+  static constexpr std::size_t kBlocks = 4; // 4 МиБ на один writev()
+
+  void build_header();
+  bool write_blocks(std::size_t count, std::size_t tail_bytes);
+  void drop_written(uint64_t begin, uint64_t end);
+  bool patch_header();
+  void abort();
+
+  int fd_ = -1;
+  WavOptions options_;
+  int channels_ = 0;
+  int sample_rate_ = 0;
+  std::size_t sample_bytes_ = 4;
+  bool direct_ = false;
+  bool rf64_ = false;
+
+  Block blocks_[kBlocks];
+  std::size_t block_ = 0; // текущий блок
+  std::size_t fill_ = 0;  // байт в текущем блоке
+
+  uint64_t written_ = 0; // байт уже в файле
+  uint64_t dropped_ = 0; // до этой позиции page cache уже отпущен
+  uint64_t data_bytes_ = 0;
+
+  // Заголовок лежит в начале блока 0; здесь — смещения полей для патча
+  std::size_t header_bytes_ = 0;
+  std::size_t ds64_at_ = 0;
+  std::size_t fact_at_ = 0; // 0 — нет fact (PCM)
+  std::size_t data_size_at_ = 0;
+};
+
+} // namespace core
@@ -0,0 +1,524 @@
+#include "metrics/metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+
+namespace metrics {
+
+namespace detail {
+
+constexpr uint32_t kChunkSlots = 256;
+constexpr uint32_t kMaxChunks = 256; // 64K слотов на реестр
+
+struct Chunk {
+  std::array<std::atomic<uint64_t>, kChunkSlots> cells{};
+};
+
+// Слоты одного потока. Пишет только владелец; куски выделяются лениво и
+// публикуются release-записью, выгрузка читает их acquire.
+struct Shard {
+  std::array<std::atomic<Chunk *>, kMaxChunks> chunks{};
+
+  ~Shard() {
+    for (auto &chunk : chunks)
+      delete chunk.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> &cell(uint32_t slot) {
+    std::atomic<Chunk *> &at = chunks[slot / kChunkSlots];
+    Chunk *chunk = at.load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk = new Chunk;
+      at.store(chunk, std::memory_order_release);
+    }
+    return chunk->cells[slot % kChunkSlots];
+  }
+
+  uint64_t read(uint32_t slot) const {
+    const Chunk *chunk =
+        chunks[slot / kChunkSlots].load(std::memory_order_acquire);
+    return chunk ? chunk->cells[slot % kChunkSlots].load(
+                       std::memory_order_relaxed)
+                 : 0;
+  }
+};
+
+enum class Kind { Counter, Gauge, Histogram };
+
+// Одна серия: имя семейства + набор меток
+struct Series {
+  std::string labels; // уже отформатированные: stage="speed"
+  uint32_t slot = 0;
+  std::vector<double> bounds;
+  std::atomic<int64_t> gauge{0};
+};
+
+struct Family {
+  std::string name;
+  std::string help;
+  Kind kind;
+  std::vector<Series *> series;
+};
+
+struct State : std::enable_shared_from_this<State> {
+  explicit State(uint64_t id) : id(id) {}
+
+  Shard &local_shard();
+  void retire(Shard *shard);
+  // Суммы слотов по всем шардам и итогам завершившихся потоков (под mutex)
+  std::vector<uint64_t> totals() const;
+
+  const uint64_t id;
+  mutable std::mutex mutex;
+  std::deque<Series> series; // адреса стабильны: на них смотрят хэндлы
+  std::vector<Family> families;
+  uint32_t slots = 0;
+  std::vector<uint8_t> is_double; // слот хранит биты double (сумма)
+  std::vector<uint64_t> retired;
+  std::vector<std::unique_ptr<Shard>> shards;
+};
+
+namespace {
+
+uint64_t add_slot(uint64_t a, uint64_t b, bool is_double) {
+  return is_double ? std::bit_cast<uint64_t>(std::bit_cast<double>(a) +
+                                             std::bit_cast<double>(b))
+                   : a + b;
+}
+
+// Шарды потока во всех живых реестрах; на выходе потока вливаются в итоги.
+struct LocalShards {
+  struct Entry {
+    std::weak_ptr<State> state;
+    uint64_t id;
+    Shard *shard;
+  };
+
+  ~LocalShards() {
+    for (const Entry &e : entries) {
+      if (const auto state = e.state.lock())
+        state->retire(e.shard);
+    }
+  }
+
+  std::vector<Entry> entries;
+  uint64_t last_id = 0;
+  Shard *last = nullptr;
+};
+
+thread_local LocalShards t_shards;
+
+} // namespace
+
+Shard &State::local_shard() {
+  LocalShards &local = t_shards;
+  if (local.last_id == id)
+    return *local.last;
+
+  auto it = std::find_if(local.entries.begin(), local.entries.end(),
+                         [&](const auto &e) { return e.id == id; });
+  if (it == local.entries.end()) {
+    std::erase_if(local.entries,
+                  [](const auto &e) { return e.state.expired(); });
+    auto shard = std::make_unique<Shard>();
+    Shard *raw = shard.get();
+    {
+      std::lock_guard lock(mutex);
+      shards.push_back(std::move(shard));
+    }
+    local.entries.push_back({weak_from_this(), id, raw});
+    it = local.entries.end() - 1;
+  }
+  local.last_id = id;
+  local.last = it->shard;
+  return *it->shard;
+}
+
+void State::retire(Shard *shard) {
+  std::lock_guard lock(mutex);
+  for (uint32_t slot = 0; slot < slots; ++slot)
+    retired[slot] = add_slot(retired[slot], shard->read(slot), is_double[slot]);
+  std::erase_if(shards, [&](const auto &s) { return s.get() == shard; });
+}
+
+std::vector<uint64_t> State::totals() const {
+  std::vector<uint64_t> sum = retired;
+  for (const auto &shard : shards) {
+    for (uint32_t slot = 0; slot < slots; ++slot)
+      sum[slot] = add_slot(sum[slot], shard->read(slot), is_double[slot]);
+  }
+  return sum;
+}
+
+} // namespace detail
+
+namespace {
+
+using detail::Family;
+using detail::Kind;
+using detail::Series;
+using detail::State;
+
+void add_local(State *state, uint32_t slot, uint64_t n) {
+  std::atomic<uint64_t> &cell = state->local_shard().cell(slot);
+  cell.store(cell.load(std::memory_order_relaxed) + n,
+             std::memory_order_relaxed);
+}
+
+void add_local(State *state, uint32_t slot, double x) {
+  std::atomic<uint64_t> &cell = state->local_shard().cell(slot);
+  const double sum =
+      std::bit_cast<double>(cell.load(std::memory_order_relaxed)) + x;
+  cell.store(std::bit_cast<uint64_t>(sum), std::memory_order_relaxed);
+}
+
+void append_escaped(std::string &out, std::string_view text, bool quote) {
+  for (const char c : text) {
+    if (c == '\\')
+      out += "\\\\";
+    else if (c == '\n')
+      out += "\\n";
+    else if (quote && c == '"')
+      out += "\\\"";
+    else
+      out += c;
+  }
+}
+
+std::string format_labels(const Labels &labels) {
+  std::string out;
+  for (const auto &[key, value] : labels) {
+    if (!out.empty())
+      out += ',';
+    out += key;
+    out += "=\"";
+    append_escaped(out, value, true);
+    out += '"';
+  }
+  return out;
+}
+
+void append_number(std::string &out, uint64_t value) {
+  char buf[24];
+  const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr);
+}
+
+void append_number(std::string &out, int64_t value) {
+  char buf[24];
+  const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr);
+}
+
+void append_number(std::string &out, double value) {
+  if (std::isnan(value)) {
+    out += "NaN";
+    return;
+  }
+  if (std::isinf(value)) {
+    out += value > 0 ? "+Inf" : "-Inf";
+    return;
+  }
+  char buf[32];
+  const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, res.ptr);
+}
+
+// name_suffix{labels[,extra]} value
+template <typename T>
+void append_sample(std::string &out, const std::string &name,
+                   std::string_view suffix, const std::string &labels,
+                   std::string_view extra, T value) {
+  out += name;
+  out += suffix;
+  if (!labels.empty() || !extra.empty()) {
+    out += '{';
+    out += labels;
+    if (!labels.empty() && !extra.empty())
+      out += ',';
+    out += extra;
+    out += '}';
+  }
+  out += ' ';
+  append_number(out, value);
+  out += '\n';
+}
+
+const char *type_name(Kind kind) {
+  switch (kind) {
+  case Kind::Counter:
+    return "counter";
+  case Kind::Gauge:
+    return "gauge";
+  case Kind::Histogram:
+    return "histogram";
+  }
+  return "unknown";
+}
+
+// Серия под mutex: существующая или новая с slots_needed слотами.
+// nullptr — имя занято метрикой другого типа или слоты кончились.
+Series *find_or_add(State &s, std::string_view name, std::string_view help,
+                    Kind kind, const Labels &labels, uint32_t slots_needed,
+                    uint32_t double_slot = UINT32_MAX) {
+  auto family =
+      std::find_if(s.families.begin(), s.families.end(),
+                   [&](const Family &f) { return f.name == name; });
+  if (family != s.families.end() && family->kind != kind)
+    return nullptr;
+
+  const std::string formatted = format_labels(labels);
+  if (family != s.families.end()) {
+    for (Series *series : family->series) {
+      if (series->labels == formatted)
+        return series;
+    }
+  }
+  if (s.slots + slots_needed > detail::kMaxChunks * detail::kChunkSlots)
+    return nullptr;
+
+  if (family == s.families.end()) {
+    s.families.push_back({std::string(name), std::string(help), kind, {}});
+    family = s.families.end() - 1;
+  }
+  Series &series = s.series.emplace_back();
+  series.labels = formatted;
+  series.slot = s.slots;
+  s.slots += slots_needed;
+  s.is_double.resize(s.slots, 0);
+  s.retired.resize(s.slots, 0);
+  if (double_slot < slots_needed)
+    s.is_double[series.slot + double_slot] = 1;
+  family->series.push_back(&series);
+  return &series;
+}
+
+} // namespace
+
+void Counter::inc(uint64_t n) const {
+  if (state_)
+    add_local(state_, slot_, n);
+}
+
+void Histogram::observe(double value) const {
+  if (!state_ || std::isnan(value))
+    return;
+  // Корзина i — значения <= bounds_[i]; последняя — +Inf
+  const uint32_t bucket = static_cast<uint32_t>(
+      std::lower_bound(bounds_, bounds_ + buckets_, value) - bounds_);
+  add_local(state_, slot_ + bucket, uint64_t{1});
+  add_local(state_, slot_ + buckets_ + 1, value);
+}
+
+Registry::Registry() {
+  static std::atomic<uint64_t> next_id{1};
+  state_ = std::make_shared<State>(next_id.fetch_add(1));
+}
+
+Registry::~Registry() = default;
+
+Registry &Registry::global() {
+  // Не разрушается: потоки, завершающиеся после main(), ещё пишут в него
+  static Registry *instance = new Registry;
+  return *instance;
+}
+
+Counter Registry::counter(std::string_view name, std::string_view help,
+                          const Labels &labels) {
+  std::lock_guard lock(state_->mutex);
+  const Series *series =
+      find_or_add(*state_, name, help, Kind::Counter, labels, 1);
+  return series ? Counter(state_.get(), series->slot) : Counter();
+}
+
+Gauge Registry::gauge(std::string_view name, std::string_view help,
+                      const Labels &labels) {
+  std::lock_guard lock(state_->mutex);
+  Series *series = find_or_add(*state_, name, help, Kind::Gauge, labels, 0);
+  return series ? Gauge(&series->gauge) : Gauge();
+}
+
+Histogram Registry::histogram(std::string_view name, std::string_view help,
+                              std::vector<double> bounds,
+                              const Labels &labels) {
+  std::sort(bounds.begin(), bounds.end());
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  std::erase_if(bounds, [](double b) { return !std::isfinite(b); });
+
+  std::lock_guard lock(state_->mutex);
+  // Корзины, +Inf, сумма
+  const uint32_t buckets = static_cast<uint32_t>(bounds.size());
+  Series *series = find_or_add(*state_, name, help, Kind::Histogram, labels,
+                               buckets + 2, buckets + 1);
+  if (!series)
+    return {};
+  if (series->bounds.empty() && buckets > 0)
+    series->bounds = std::move(bounds);
+  return Histogram(state_.get(), series->slot, series->bounds.data(),
+                   static_cast<uint32_t>(series->bounds.size()));
+}
+
+std::string Registry::openmetrics() const {
+  std::lock_guard lock(state_->mutex);
+  const std::vector<uint64_t> totals = state_->totals();
+
+  std::string out;
+  for (const Family &family : state_->families) {
+    out += "# TYPE ";
+    out += family.name;
+    out += ' ';
+    out += type_name(family.kind);
+    out += '\n';
+    if (!family.help.empty()) {
+      out += "# HELP ";
+      out += family.name;
+      out += ' ';
+      append_escaped(out, family.help, false);
+      out += '\n';
+    }
+
+    for (const Series *series : family.series) {
+      switch (family.kind) {
+      case Kind::Counter:
+        append_sample(out, family.name, "_total", series->labels, {},
+                      totals[series->slot]);
+        break;
+      case Kind::Gauge:
+        append_sample(out, family.name, {}, series->labels, {},
+                      series->gauge.load(std::memory_order_relaxed));
+        break;
+      case Kind::Histogram: {
+        const size_t buckets = series->bounds.size();
+        uint64_t cumulative = 0;
+        std::string le;
+        for (size_t i = 0; i <= buckets; ++i) {
+          cumulative += totals[series->slot + i];
+          le = "le=\"";
+          if (i < buckets)
+            append_number(le, series->bounds[i]);
+          else
+            le += "+Inf";
+          le += '"';
+          append_sample(out, family.name, "_bucket", series->labels, le,
+                        cumulative);
+        }
+        append_sample(out, family.name, "_count", series->labels, {},
+                      cumulative);
+        append_sample(out, family.name, "_sum", series->labels, {},
+                      std::bit_cast<double>(totals[series->slot + buckets + 1]));
+        break;
+      }
+      }
+    }
+  }
+  out += "# EOF\n";
+  return out;
+}
+
+bool Registry::write_openmetrics(const std::filesystem::path &path) const {
+  const std::string text = openmetrics();
+  if (path == "-") {
+    const bool ok = std::fwrite(text.data(), 1, text.size(), stdout) ==
+                    text.size();
+    return std::fflush(stdout) == 0 && ok;
+  }
+
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!out)
+      return false;
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+std::vector<double> exponential_buckets(double start, double factor,
+                                        size_t count) {
+  std::vector<double> bounds(count);
+  for (size_t i = 0; i < count; ++i, start *= factor)
+    bounds[i] = start;
+  return bounds;
+}
+
+namespace {
+
+constexpr const char *kStageNames[] = {"decode", "speed", "reverb",
+                                       "loudness", "encode"};
+constexpr size_t kStages = std::size(kStageNames);
+
+struct StageMetrics {
+  Histogram seconds;
+  Counter frames;
+  Counter skipped;
+};
+
+const std::array<StageMetrics, kStages> &stage_metrics() {
+  static const std::array<StageMetrics, kStages> metrics = [] {
+    std::array<StageMetrics, kStages> m;
+    Registry &r = registry();
+    // 1 мс .. ~17 мин
+    const std::vector<double> bounds = exponential_buckets(0.001, 4.0, 11);
+    for (size_t i = 0; i < kStages; ++i) {
+      const Labels labels{{"stage", kStageNames[i]}};
+      m[i].seconds = r.histogram("grustnify_stage_seconds",
+                                 "Wall time of one pipeline stage call.",
+                                 bounds, labels);
+      m[i].frames = r.counter("grustnify_stage_frames",
+                              "Frames produced by a stage.", labels);
+      m[i].skipped =
+          r.counter("grustnify_stage_skipped_frames",
+                    "Frames a stage filled with silence without processing.",
+                    labels);
+    }
+    return m;
+  }();
+  return metrics;
+}
+
+} // namespace
+
+void record_stage(Stage stage, double seconds, uint64_t frames,
+                  uint64_t skipped_frames) {
+  const StageMetrics &m = stage_metrics()[static_cast<size_t>(stage)];
+  m.seconds.observe(seconds);
+  m.frames.inc(frames);
+  if (skipped_frames)
+    m.skipped.inc(skipped_frames);
+}
+
+void record_job(bool ok, double wall_seconds, double input_seconds) {
+  Registry &r = registry();
+  static const Counter succeeded = r.counter(
+      "grustnify_jobs", "Finished jobs by result.", {{"result", "ok"}});
+  static const Counter failed = r.counter(
+      "grustnify_jobs", "Finished jobs by result.", {{"result", "failed"}});
+  static const Histogram seconds =
+      r.histogram("grustnify_job_seconds", "Wall time of a whole job.",
+                  exponential_buckets(0.01, 4.0, 10));
+  static const Histogram realtime = r.histogram(
+      "grustnify_job_realtime_factor",
+      "Seconds of input processed per second of wall time.",
+      exponential_buckets(1.0, 2.0, 12));
+
+  (ok ? succeeded : failed).inc();
+  seconds.observe(wall_seconds);
+  if (ok && wall_seconds > 0.0 && input_seconds > 0.0)
+    realtime.observe(input_seconds / wall_seconds);
+}
+
+} // namespace metrics
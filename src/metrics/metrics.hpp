@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Сводные метрики процесса для пакетных прогонов: счётчики, гистограммы и
+// gauge'и с выгрузкой в текстовом формате OpenMetrics (его читают Prometheus
+// и textfile-коллектор node_exporter'а).
+//
+// Счётчики и гистограммы шардированы по потокам: поток пишет только в свой
+// шард обычными relaxed-записями, без RMW и блокировок; выгрузка суммирует
+// шарды. Шард завершившегося потока вливается в общие итоги. Gauge — один
+// атомик: его выставляет одно место (глубина очереди и т.п.).
+namespace metrics {
+
+namespace detail {
+struct State;
+}
+
+// Метки в порядке вывода: {{"stage", "speed"}}
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+public:
+  Counter() = default;
+  void inc(uint64_t n = 1) const;
+
+private:
+  friend class Registry;
+  Counter(detail::State *state, uint32_t slot) : state_(state), slot_(slot) {}
+  detail::State *state_ = nullptr; // nullptr — метрика не заведена, no-op
+  uint32_t slot_ = 0;
+};
+
+class Gauge {
+public:
+  Gauge() = default;
+  void set(int64_t value) const {
+    if (value_)
+      value_->store(value, std::memory_order_relaxed);
+  }
+  void add(int64_t delta) const {
+    if (value_)
+      value_->fetch_add(delta, std::memory_order_relaxed);
+  }
+
+private:
+  friend class Registry;
+  explicit Gauge(std::atomic<int64_t> *value) : value_(value) {}
+  std::atomic<int64_t> *value_ = nullptr;
+};
+
+// Границы корзин (le) по возрастанию; +Inf добавляется сама.
+class Histogram {
+public:
+  Histogram() = default;
+  void observe(double value) const;
+
+private:
+  friend class Registry;
+  Histogram(detail::State *state, uint32_t slot, const double *bounds,
+            uint32_t buckets)
+      : state_(state), slot_(slot), bounds_(bounds), buckets_(buckets) {}
+  detail::State *state_ = nullptr;
+  uint32_t slot_ = 0; // корзины, затем сумма
+  const double *bounds_ = nullptr;
+  uint32_t buckets_ = 0; // без +Inf
+};
+
+// Реестр метрик. Регистрация идемпотентна: то же имя с теми же метками
+// возвращает ту же метрику, поэтому хэндлы удобно держать в static.
+// Имя счётчика — без суффикса _total, его дописывает выгрузка.
+class Registry {
+public:
+  Registry();
+  ~Registry();
+
+  Registry(const Registry &) = delete;
+  Registry &operator=(const Registry &) = delete;
+
+  // Реестр процесса: в него пишут декодер, DSP и энкодер
+  static Registry &global();
+
+  Counter counter(std::string_view name, std::string_view help,
+                  const Labels &labels = {});
+  Gauge gauge(std::string_view name, std::string_view help,
+              const Labels &labels = {});
+  Histogram histogram(std::string_view name, std::string_view help,
+                      std::vector<double> bounds, const Labels &labels = {});
+
+  // Снимок всех метрик: семейства в порядке регистрации, "# EOF" в конце
+  std::string openmetrics() const;
+  // path == "-" — stdout; иначе временный файл и rename, чтобы сборщик не
+  // прочитал половину
+  bool write_openmetrics(const std::filesystem::path &path) const;
+
+private:
+  std::shared_ptr<detail::State> state_;
+};
+
+inline Registry &registry() { return Registry::global(); }
+
+// Корзины: start, start * factor, ... (count штук)
+std::vector<double> exponential_buckets(double start, double factor,
+                                        size_t count);
+
+// --- метрики конвейера ---
+
+enum class Stage { Decode, Speed, Reverb, Loudness, Encode };
+
+// Время этапа в grustnify_stage_seconds{stage=...}, кадры — в
+// grustnify_stage_frames_total и grustnify_stage_skipped_frames_total
+// (тишина, см. core/activity.hpp).
+void record_stage(Stage stage, double seconds, uint64_t frames,
+                  uint64_t skipped_frames = 0);
+
+// Замер этапа: done() записывает его, выход без done() (ошибка или
+// делегирование другой функции, которая запишет сама) — нет.
+class StageTimer {
+public:
+  explicit StageTimer(Stage stage)
+      : stage_(stage), started_(std::chrono::steady_clock::now()) {}
+
+  void done(uint64_t frames, uint64_t skipped_frames = 0) const {
+    record_stage(stage_,
+                 std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - started_)
+                     .count(),
+                 frames, skipped_frames);
+  }
+
+private:
+  Stage stage_;
+  std::chrono::steady_clock::time_point started_;
+};
+
+// Задача целиком: grustnify_jobs_total{result=ok|failed}, время в
+// grustnify_job_seconds и во сколько раз быстрее реального времени —
+// grustnify_job_realtime_factor (только для успешных).
+void record_job(bool ok, double wall_seconds, double input_seconds);
+
+} // namespace metrics
@@ -15,7 +15,7 @@
 
 namespace ui {
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
-  setFixedSize(400, 400);
+  setFixedSize(640, 480);
 
   auto *central = new QWidget(this);
   setCentralWidget(central);
@@ -52,6 +52,20 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
   layout->addWidget(field_path_, 0, Qt::AlignCenter);
   layout->addWidget(button_load_, 0, Qt::AlignCenter);
   layout->addWidget(button_grustnify_, 0, Qt::AlignCenter);
+
+  waveform_before_ = new WaveformView(central);
+  waveform_after_ = new WaveformView(central);
+  layout->addWidget(new QLabel("before", central), 0, Qt::AlignLeft);
+  layout->addWidget(waveform_before_);
+  layout->addWidget(new QLabel("after", central), 0, Qt::AlignLeft);
+  layout->addWidget(waveform_after_);
+
+  // Пики считаются в фоне: вид обновляется, когда App их отдаёт
+  auto *app = static_cast<app::App *>(qApp);
+  connect(app, &app::App::input_peaks_changed, this,
+          [this, app] { waveform_before_->set_peaks(&app->input_peaks()); });
+  connect(app, &app::App::output_peaks_changed, this,
+          [this, app] { waveform_after_->set_peaks(&app->output_peaks()); });
 }
 
 MainWindow::~MainWindow() {}
@@ -66,15 +80,13 @@ void MainWindow::on_button_load_clicked() {
     return;
   field_path_->setText(file_path);
 
-  auto *app = static_cast<app::App *>(qApp);
-  app->load_audio_file(file_path);
+  static_cast<app::App *>(qApp)->load_audio_file(file_path);
 }
 
 void MainWindow::on_button_grustnify_clicked() {
   TE_TRACE("grustnify button clicked");
 
-  auto *app = static_cast<app::App *>(qApp);
-  app->process_audio_file();
+  static_cast<app::App *>(qApp)->process_audio_file();
 }
 
 } // namespace ui
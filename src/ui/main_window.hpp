@@ -4,6 +4,8 @@
 #include <QMainWindow>
 #include <QPushButton>
 
+#include "ui/waveform_view.hpp"
+
 namespace ui {
 class MainWindow : public QMainWindow {
   Q_OBJECT
@@ -20,5 +22,7 @@ private:
   QPushButton *button_load_;
   QPushButton *button_grustnify_;
   QLineEdit *field_path_;
+  WaveformView *waveform_before_;
+  WaveformView *waveform_after_;
 };
 } // namespace ui
@@ -0,0 +1,96 @@
+#include "waveform_view.hpp"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace ui {
+
+namespace {
+
+// Ближе этого зум не пускаем: дальше ячейки уровня 0 шире пикселя.
+constexpr double kMinFramesPerPixel = 1.0;
+
+} // namespace
+
+WaveformView::WaveformView(QWidget *parent) : QWidget(parent) {
+  setMinimumHeight(80);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void WaveformView::set_peaks(const core::PeakPyramid *peaks) {
+  peaks_ = peaks && !peaks->empty() ? peaks : nullptr;
+  view_first_ = 0.0;
+  view_frames_ = peaks_ ? static_cast<double>(peaks_->frames()) : 0.0;
+  update();
+}
+
+void WaveformView::clamp_view() {
+  if (!peaks_)
+    return;
+  const double total = static_cast<double>(peaks_->frames());
+  view_frames_ = std::clamp(view_frames_,
+                            std::min(total, kMinFramesPerPixel * width()),
+                            total);
+  view_first_ = std::clamp(view_first_, 0.0, total - view_frames_);
+}
+
+void WaveformView::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+  if (!peaks_ || width() <= 0)
+    return;
+
+  const int w = width();
+  const double mid = height() / 2.0;
+  const double scale = height() / 2.0;
+
+  columns_.resize(static_cast<size_t>(w));
+  peaks_->render(static_cast<uint64_t>(view_first_),
+                 static_cast<uint64_t>(view_frames_), columns_.size(),
+                 columns_.data());
+
+  const QColor peak = palette().highlight().color();
+  const QColor rms = peak.darker(150);
+  for (int x = 0; x < w; ++x) {
+    const core::PeakCell &c = columns_[static_cast<size_t>(x)];
+    painter.setPen(peak);
+    painter.drawLine(QPointF(x, mid - std::clamp(c.max, -1.0f, 1.0f) * scale),
+                     QPointF(x, mid - std::clamp(c.min, -1.0f, 1.0f) * scale));
+    const double r = std::min(c.rms, 1.0f) * scale;
+    painter.setPen(rms);
+    painter.drawLine(QPointF(x, mid - r), QPointF(x, mid + r));
+  }
+}
+
+void WaveformView::wheelEvent(QWheelEvent *event) {
+  if (!peaks_ || width() <= 0)
+    return;
+  // Кадр под курсором остаётся на месте
+  const double at = event->position().x() / width();
+  const double anchor = view_first_ + at * view_frames_;
+  view_frames_ *= std::pow(0.8, event->angleDelta().y() / 120.0);
+  clamp_view();
+  view_first_ = anchor - at * view_frames_;
+  clamp_view();
+  update();
+  event->accept();
+}
+
+void WaveformView::mousePressEvent(QMouseEvent *event) {
+  drag_x_ = event->position().x();
+}
+
+void WaveformView::mouseMoveEvent(QMouseEvent *event) {
+  if (!peaks_ || width() <= 0 || !(event->buttons() & Qt::LeftButton))
+    return;
+  const double x = event->position().x();
+  view_first_ -= (x - drag_x_) * view_frames_ / width();
+  drag_x_ = x;
+  clamp_view();
+  update();
+}
+
+} // namespace ui
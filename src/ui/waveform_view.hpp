@@ -0,0 +1,37 @@
+#pragma once
+
+#include "core/peaks.hpp"
+#include <QWidget>
+#include <vector>
+
+namespace ui {
+
+// Волна по пирамиде пиков: на каждый кадр отрисовки — одна колонка на
+// пиксель, без обращения к сэмплам. Колесо мыши — зум вокруг курсора,
+// перетаскивание — прокрутка.
+class WaveformView : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit WaveformView(QWidget *parent = nullptr);
+
+  // Копия не нужна: пирамида живёт в App; nullptr — пусто
+  void set_peaks(const core::PeakPyramid *peaks);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+  void clamp_view();
+
+  const core::PeakPyramid *peaks_ = nullptr;
+  double view_first_ = 0.0;  // первый видимый кадр
+  double view_frames_ = 0.0; // кадров в окне
+  double drag_x_ = 0.0;
+  std::vector<core::PeakCell> columns_;
+};
+
+} // namespace ui
@@ -0,0 +1,213 @@
+#include "core/activity.hpp"
+#include "core/audio_buffer.hpp"
+#include "core/compact_buffer.hpp"
+#include "core/denormals.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int kRate = 8000;
+constexpr int kChannels = 2;
+
+// Запись с длинными паузами: тон, 12 с цифровой тишины, шум и 30 с тишины
+// (хвост FDN уходит в точный ноль примерно за 20 с)
+core::AudioBuffer gappy() {
+  core::AudioBuffer b{kRate, kChannels, {}};
+  std::vector<float> v;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+  auto append = [&](double seconds, auto &&gen) {
+    const size_t frames = static_cast<size_t>(seconds * kRate);
+    for (size_t n = 0; n < frames; ++n)
+      for (int ch = 0; ch < kChannels; ++ch)
+        v.push_back(gen(n));
+  };
+  append(1.5, [](size_t n) {
+    return 0.4f * std::sin(2.0f * 3.14159265f * 440.0f * n / kRate);
+  });
+  append(12.0, [](size_t) { return 0.0f; });
+  append(0.7, [&](size_t) { return noise(rng); });
+  append(30.0, [](size_t) { return 0.0f; });
+  b.samples.resize_uninitialized(v.size());
+  std::copy(v.begin(), v.end(), b.samples.begin());
+  return b;
+}
+
+std::vector<float> to_vector(const core::AudioBuffer &b) {
+  return {b.samples.data(), b.samples.data() + b.samples.size()};
+}
+
+std::vector<uint16_t> to_vector(const core::CompactAudioBuffer &b) {
+  return {b.samples.data(), b.samples.data() + b.samples.size()};
+}
+
+core::ActivityMap
+activity_of(const core::AudioBuffer &b,
+            float silence_dbfs = core::ActivityMap::kSilenceDbfs) {
+  return core::build_activity(b.samples.data(), b.samples.size() / b.channels,
+                              b.channels, silence_dbfs);
+}
+
+} // namespace
+
+TEST(ActivityTest, BuilderMarksSilentBlocks) {
+  const core::AudioBuffer in = gappy();
+  const size_t frames = in.samples.size() / kChannels;
+  const core::ActivityMap map = activity_of(in);
+  ASSERT_EQ(map.frames, frames);
+  ASSERT_EQ(map.active.size(), (frames + core::ActivityMap::kBlockFrames - 1) /
+                                   core::ActivityMap::kBlockFrames);
+
+  // Подача кусками произвольного размера — та же карта
+  core::ActivityBuilder builder;
+  builder.start(kChannels);
+  for (size_t done = 0, step = 1; done < frames; step = step * 3 % 2011 + 1) {
+    const size_t n = std::min(step, frames - done);
+    builder.add(in.samples.data() + done * kChannels, n);
+    done += n;
+  }
+  EXPECT_EQ(builder.finish().active, map.active);
+
+  EXPECT_TRUE(map.any_active(0, 100));
+  EXPECT_FALSE(map.any_active(3 * kRate, 13 * kRate));
+  EXPECT_TRUE(map.any_active(13 * kRate, 14 * kRate));
+  EXPECT_FALSE(map.any_active(frames - 100, frames + 100));
+
+  // Два участка тишины, границы с точностью до блока
+  const auto ranges = map.silent_ranges(kRate);
+  ASSERT_EQ(ranges.size(), 2u);
+  EXPECT_LE(ranges[0].first, static_cast<size_t>(1.5 * kRate) +
+                                 core::ActivityMap::kBlockFrames);
+  EXPECT_GE(ranges[0].second, static_cast<size_t>(13.5 * kRate) -
+                                  core::ActivityMap::kBlockFrames);
+  EXPECT_EQ(ranges[1].second, frames);
+  EXPECT_GT(map.silent_frames(), static_cast<size_t>(40 * kRate));
+
+  // По умолчанию (без порога) единственный ненулевой отсчёт делает блок
+  // активным, с порогом -90 dBFS — нет
+  std::vector<float> one(4096 * kChannels, 0.0f);
+  one[3000 * kChannels + 1] = 1e-30f;
+  EXPECT_EQ(core::build_activity(one.data(), 4096, kChannels).active,
+            (std::vector<uint8_t>{0, 0, 1, 0}));
+  EXPECT_EQ(core::build_activity(one.data(), 4096, kChannels,
+                                 -std::numeric_limits<float>::infinity())
+                .active,
+            (std::vector<uint8_t>{0, 0, 1, 0}));
+  EXPECT_EQ(core::build_activity(one.data(), 4096, kChannels,
+                                 core::ActivityMap::kNoiseFloorDbfs)
+                .active,
+            (std::vector<uint8_t>(4, 0)));
+}
+
+TEST(ActivityTest, ThresholdCountsNoiseFloorAsSilence) {
+  // Шум -100, -80 и снова -100 dBFS RMS, последний блок неполный
+  const size_t frames = 3 * core::ActivityMap::kBlockFrames + 300;
+  std::vector<float> v(frames * kChannels);
+  std::mt19937 rng(5);
+  std::normal_distribution<float> gauss(0.0f, 1.0f);
+  for (size_t i = 0; i < v.size(); ++i) {
+    const size_t block = i / kChannels / core::ActivityMap::kBlockFrames;
+    const float rms = std::pow(10.0f, (block == 1 ? -80.0f : -100.0f) / 20);
+    v[i] = rms * gauss(rng);
+  }
+  constexpr float kFloor = core::ActivityMap::kNoiseFloorDbfs;
+  const core::ActivityMap map =
+      core::build_activity(v.data(), frames, kChannels, kFloor);
+  EXPECT_EQ(map.active, (std::vector<uint8_t>{0, 1, 0, 0}));
+  // Без порога шум — не тишина
+  EXPECT_EQ(core::build_activity(v.data(), frames, kChannels).active,
+            (std::vector<uint8_t>(4, 1)));
+
+  // Неполный последний блок громче порога — активен
+  for (size_t i = 3 * core::ActivityMap::kBlockFrames * kChannels;
+       i < v.size(); ++i)
+    v[i] = 0.01f;
+  EXPECT_EQ(core::build_activity(v.data(), frames, kChannels, kFloor).active,
+            (std::vector<uint8_t>{0, 1, 0, 1}));
+}
+
+TEST(ActivityTest, SkippingSilenceIsBitExact) {
+  // Состояние ревербератора доходит до точного нуля только без денормалов
+  const core::ScopedFlushDenormals flush_denormals;
+  const core::AudioBuffer in = gappy();
+  const core::ActivityMap map = activity_of(in);
+
+  core::AudioBuffer full, sparse;
+  core::ActivityMap speed_map;
+  EXPECT_EQ(core::change_speed(in, 1.15f, full), 0u);
+  const size_t skipped_speed =
+      core::change_speed(in, 1.15f, sparse, &map, &speed_map);
+  EXPECT_GT(skipped_speed, static_cast<size_t>(45 * kRate));
+  ASSERT_EQ(to_vector(sparse), to_vector(full));
+  EXPECT_EQ(speed_map.frames, full.samples.size() / kChannels);
+
+  for (const auto algorithm :
+       {core::ReverbAlgorithm::Schroeder, core::ReverbAlgorithm::Fdn8,
+        core::ReverbAlgorithm::Fdn16}) {
+    core::ReverbParams p{0.3f, 0.5f, 0.5f};
+    p.algorithm = algorithm;
+    p.render_tail = algorithm == core::ReverbAlgorithm::Fdn8;
+
+    const core::AudioBuffer wet = core::reverb(full, p);
+    core::AudioBuffer wet_sparse;
+    const size_t skipped = core::reverb(sparse, p, wet_sparse, &speed_map);
+    EXPECT_EQ(to_vector(wet_sparse), to_vector(wet));
+#if defined(GRUSTNIFY_DENORMALS_SSE) || defined(GRUSTNIFY_DENORMALS_ARM64)
+    EXPECT_GT(skipped, static_cast<size_t>(5 * kRate));
+#else
+    (void)skipped;
+#endif
+  }
+}
+
+TEST(ActivityTest, NearSilenceDeviatesBelowThreshold) {
+  // Паузы — не цифровой ноль, а шум -100 dBFS: с порогом -90 dBFS они
+  // пропускаются, и выход отличается от полной обработки не больше порога
+  core::AudioBuffer in = gappy();
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<float> floor_noise(-1.7e-5f, 1.7e-5f);
+  for (size_t i = 0; i < in.samples.size(); ++i)
+    if (in.samples[i] == 0.0f)
+      in.samples[i] = floor_noise(rng);
+  const core::ActivityMap map =
+      activity_of(in, core::ActivityMap::kNoiseFloorDbfs);
+
+  core::AudioBuffer full, sparse;
+  core::change_speed(in, 1.15f, full);
+  EXPECT_GT(core::change_speed(in, 1.15f, sparse, &map),
+            static_cast<size_t>(30 * kRate));
+  ASSERT_EQ(sparse.samples.size(), full.samples.size());
+  float deviation = 0.0f;
+  for (size_t i = 0; i < full.samples.size(); ++i)
+    deviation =
+        std::max(deviation, std::fabs(sparse.samples[i] - full.samples[i]));
+  EXPECT_GT(deviation, 0.0f);
+  EXPECT_LT(deviation, std::pow(10.0f, -80.0f / 20));
+}
+
+TEST(ActivityTest, CompactSkippingSilenceIsBitExact) {
+  const core::ScopedFlushDenormals flush_denormals;
+  const core::AudioBuffer in = gappy();
+  const core::ActivityMap map = activity_of(in);
+
+  for (const auto format : {core::CompactFormat::Int16,
+                            core::CompactFormat::Half}) {
+    const core::CompactAudioBuffer c = core::compact(in, format);
+    core::CompactAudioBuffer slow, slow_sparse;
+    core::ActivityMap speed_map;
+    core::change_speed(c, 1.15f, slow);
+    EXPECT_GT(core::change_speed(c, 1.15f, slow_sparse, &map, &speed_map), 0u);
+    ASSERT_EQ(to_vector(slow_sparse), to_vector(slow));
+
+    const core::ReverbParams p{0.3f, 0.5f, 0.5f};
+    core::CompactAudioBuffer wet, wet_sparse;
+    core::reverb(slow, p, wet);
+    core::reverb(slow_sparse, p, wet_sparse, &speed_map);
+    EXPECT_EQ(to_vector(wet_sparse), to_vector(wet));
+  }
+}
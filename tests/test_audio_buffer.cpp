@@ -0,0 +1,78 @@
+#include "core/activity.hpp"
+#include "core/audio_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+core::AudioBuffer noise_buffer(int sample_rate, int channels, size_t frames) {
+  core::AudioBuffer b{sample_rate, channels, {}};
+  b.samples.resize_uninitialized(frames * channels);
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  for (float &x : b.samples)
+    x = dist(rng);
+  // Пауза посередине — для карты активности
+  std::fill(b.samples.begin() + frames / 3 * channels,
+            b.samples.begin() + frames / 2 * channels, 0.0f);
+  return b;
+}
+
+std::vector<float> to_vector(const core::AudioBuffer &b) {
+  return {b.samples.begin(), b.samples.end()};
+}
+
+} // namespace
+
+TEST(AudioBufferTest, InPlaceChangeSpeedMatchesCopy) {
+  const core::AudioBuffer in = noise_buffer(8000, 2, 50000);
+  const core::ActivityMap map =
+      core::build_activity(in.samples.data(), 50000, 2);
+  for (const float speed : {0.5f, 0.87f, 1.0f, 1.0005f, 1.15f, 1.5f, 3.0f}) {
+    core::ActivityMap expected_map, got_map;
+    core::AudioBuffer expected;
+    core::change_speed(in, speed, expected, &map, &expected_map);
+
+    core::AudioBuffer work = in;
+    const float *before = work.samples.data();
+    const core::AudioBuffer got =
+        core::change_speed(std::move(work), speed, &map, &got_map);
+    EXPECT_EQ(to_vector(got), to_vector(expected)) << speed;
+    EXPECT_EQ(got_map.active, expected_map.active) << speed;
+    EXPECT_EQ(got.sample_rate, 8000);
+    // Ускорение не перевыделяет память
+    if (speed <= 1.0f) {
+      EXPECT_EQ(got.samples.data(), before) << speed;
+    }
+
+    // Без карты — то же, что копирующий вариант
+    EXPECT_EQ(to_vector(core::change_speed(core::AudioBuffer(in), speed)),
+              to_vector(core::change_speed(in, speed)))
+        << speed;
+  }
+}
+
+TEST(AudioBufferTest, InPlaceReverbMatchesCopy) {
+  const core::AudioBuffer in = noise_buffer(44100, 2, 20000);
+  core::ReverbParams p;
+  const core::AudioBuffer expected = core::reverb(in, p);
+
+  core::AudioBuffer view_buf = in;
+  core::reverb_inplace(core::view_of(view_buf), p);
+  EXPECT_EQ(to_vector(view_buf), to_vector(expected));
+
+  core::AudioBuffer moved = in;
+  const float *before = moved.samples.data();
+  const core::AudioBuffer got = core::reverb(std::move(moved), p);
+  EXPECT_EQ(got.samples.data(), before);
+  EXPECT_EQ(to_vector(got), to_vector(expected));
+
+  // С хвостом rvalue-вариант дописывает его в тот же буфер
+  p.render_tail = true;
+  EXPECT_EQ(to_vector(core::reverb(core::AudioBuffer(in), p)),
+            to_vector(core::reverb(in, p)));
+}
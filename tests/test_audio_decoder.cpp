@@ -1,17 +1,18 @@
 #include "core/audio_buffer.hpp"
 #include "core/audio_decoder.hpp"
 #include "log/log.hpp"
-#include <QString>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <gtest/gtest.h>
-#include <qcontainerfwd.h>
 
-static QString testDataFile(const char *name) {
-  return QString(TEST_DATA_DIR) + "/" + name;
+static std::filesystem::path testDataFile(const char *name) {
+  return std::filesystem::path(TEST_DATA_DIR) / name;
 }
 
 TEST(AudioDecoderTest, OpenValidFile) {
   grustnify::Log::Init();
-  QString path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
+  std::filesystem::path path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
   core::AudioDecoder decoder(path);
 
   EXPECT_TRUE(decoder.open());
@@ -31,14 +32,14 @@ TEST(AudioDecoderTest, OpenValidFile) {
 }
 
 TEST(AudioDecoderTest, OpenNonExistingFileFails) {
-  QString path = QStringLiteral("does_not_exist_12345.wav");
+  std::filesystem::path path = "does_not_exist_12345.wav";
   core::AudioDecoder decoder(path);
 
   EXPECT_FALSE(decoder.open());
 }
 
 TEST(AudioDecoderTest, DecodeSineFrequency) {
-  QString path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
+  std::filesystem::path path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
   core::AudioDecoder decoder(path);
 
   ASSERT_TRUE(decoder.open());
@@ -59,7 +60,7 @@ TEST(AudioDecoderTest, DecodeSineFrequency) {
   // 1) Проверяем частоту синусоиды через нулевые пересечения.
   //
 
-  const std::vector<float> &s = buffer.samples;
+  const auto &s = buffer.samples;
   int zero_crosses = 0;
 
   for (size_t i = 1; i < s.size(); ++i) {
@@ -87,3 +88,76 @@ TEST(AudioDecoderTest, DecodeSineFrequency) {
   EXPECT_GT(max_amp, 0.7f);
   EXPECT_LT(max_amp, 1.1f);
 }
+
+TEST(AudioDecoderTest, PreviewWindowDownsamples) {
+  std::filesystem::path path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
+  core::DecodeOptions options;
+  options.sample_rate = 22050;
+  options.channels = 2; // источник mono: каналов не прибавляется
+  options.start_seconds = 0.5;
+  options.duration_seconds = 1.0;
+  core::AudioDecoder decoder(path, options);
+
+  ASSERT_TRUE(decoder.open());
+
+  core::AudioBuffer buffer;
+  ASSERT_TRUE(decoder.decode_to_buffer(buffer));
+
+  EXPECT_EQ(buffer.sample_rate, 22050);
+  EXPECT_EQ(buffer.channels, 1);
+  EXPECT_NEAR(static_cast<double>(buffer.samples.size()), 22050.0, 64.0);
+
+  const auto &s = buffer.samples;
+  int zero_crosses = 0;
+  for (size_t i = 1; i < s.size(); ++i) {
+    if ((s[i - 1] <= 0 && s[i] > 0) || (s[i - 1] >= 0 && s[i] < 0)) {
+      zero_crosses++;
+    }
+  }
+  EXPECT_NEAR(zero_crosses / 2.0, 440.0, 5.0);
+}
+
+TEST(AudioDecoderTest, FastOpenMatchesFullProbe) {
+  std::filesystem::path path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
+  core::AudioBuffer buffers[2];
+  for (const bool fast : {true, false}) {
+    core::DecodeOptions options;
+    options.fast_open = fast;
+    core::AudioDecoder decoder(path, options);
+    ASSERT_TRUE(decoder.open());
+    ASSERT_TRUE(decoder.decode_to_buffer(buffers[fast]));
+  }
+
+  EXPECT_EQ(buffers[0].sample_rate, buffers[1].sample_rate);
+  EXPECT_EQ(buffers[0].channels, buffers[1].channels);
+  ASSERT_EQ(buffers[0].samples.size(), buffers[1].samples.size());
+  EXPECT_TRUE(std::equal(buffers[0].samples.begin(), buffers[0].samples.end(),
+                         buffers[1].samples.begin()));
+}
+
+TEST(AudioDecoderTest, WindowMatchesSliceOfFullDecode) {
+  std::filesystem::path path = testDataFile("sine_440hz_44-1kHz_2sec.wav");
+  core::AudioBuffer full;
+  {
+    core::AudioDecoder decoder(path);
+    ASSERT_TRUE(decoder.open());
+    ASSERT_TRUE(decoder.decode_to_buffer(full));
+  }
+
+  // Начало не на границе пакета
+  core::DecodeOptions options;
+  options.start_seconds = 0.7131;
+  options.duration_seconds = 0.25;
+  core::AudioDecoder decoder(path, options);
+  ASSERT_TRUE(decoder.open());
+  core::AudioBuffer window;
+  ASSERT_TRUE(decoder.decode_to_buffer(window));
+
+  const size_t channels = static_cast<size_t>(full.channels);
+  const size_t first = std::llround(0.7131 * full.sample_rate) * channels;
+  const size_t count = std::llround(0.25 * full.sample_rate) * channels;
+  ASSERT_EQ(window.samples.size(), count);
+  ASSERT_LE(first + count, full.samples.size());
+  EXPECT_TRUE(std::equal(window.samples.begin(), window.samples.end(),
+                         full.samples.begin() + first));
+}
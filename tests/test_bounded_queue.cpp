@@ -0,0 +1,55 @@
+#include "app/bounded_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(BoundedQueueTest, PushBlocksWhenFull) {
+  app::BoundedQueue<int> q(2);
+  ASSERT_TRUE(q.push(1));
+  ASSERT_TRUE(q.push(2));
+
+  std::atomic<bool> pushed{false};
+  std::thread producer([&] {
+    q.push(3);
+    pushed = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+  EXPECT_EQ(q.pop(), 1);
+  producer.join();
+  EXPECT_TRUE(pushed);
+  EXPECT_EQ(q.size(), 2u);
+}
+
+TEST(BoundedQueueTest, CloseDrainsThenStops) {
+  app::BoundedQueue<int> q(4);
+  q.push(1);
+  q.push(2);
+  q.close();
+
+  EXPECT_FALSE(q.push(3));
+  EXPECT_EQ(q.pop(), 1);
+  EXPECT_EQ(q.pop(), 2);
+  EXPECT_EQ(q.pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, ManyConsumersSeeEveryItemOnce) {
+  app::BoundedQueue<int> q(3);
+  std::atomic<int> sum{0};
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 4; ++i) {
+    consumers.emplace_back([&] {
+      while (auto v = q.pop())
+        sum += *v;
+    });
+  }
+  for (int i = 1; i <= 100; ++i)
+    q.push(i);
+  q.close();
+  for (auto &t : consumers)
+    t.join();
+  EXPECT_EQ(sum, 5050);
+}
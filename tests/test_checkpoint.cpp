@@ -0,0 +1,83 @@
+#include "core/checkpoint.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+std::filesystem::path temp_dir(const char *name) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   (std::string("grustnify_test_") + name);
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+} // namespace
+
+TEST(CheckpointTest, SaveLoadRoundTrip) {
+  const auto dir = temp_dir("checkpoint_state");
+  core::Checkpoint ck;
+  ck.job_key = 0x1234567890abcdefull;
+  ck.stage = 2;
+  ck.sample_rate = 44100;
+  ck.channels = 2;
+  ck.frames[0] = 1000;
+  ck.frames[1] = 1150;
+  ck.progress = 512;
+  ck.state = {1, 2, 3, 4, 5};
+  ASSERT_TRUE(ck.save(dir / "state"));
+  EXPECT_FALSE(std::filesystem::exists(dir / "state.tmp"));
+
+  core::Checkpoint loaded;
+  ASSERT_TRUE(loaded.load(dir / "state"));
+  EXPECT_EQ(loaded.job_key, ck.job_key);
+  EXPECT_EQ(loaded.stage, 2u);
+  EXPECT_EQ(loaded.sample_rate, 44100);
+  EXPECT_EQ(loaded.channels, 2);
+  EXPECT_EQ(loaded.frames[0], 1000u);
+  EXPECT_EQ(loaded.frames[1], 1150u);
+  EXPECT_EQ(loaded.progress, 512u);
+  EXPECT_EQ(loaded.state, ck.state);
+
+  // Обрезанный файл не принимается
+  std::filesystem::resize_file(dir / "state",
+                               std::filesystem::file_size(dir / "state") - 1);
+  EXPECT_FALSE(loaded.load(dir / "state"));
+  EXPECT_FALSE(loaded.load(dir / "missing"));
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CheckpointTest, StorageSurvivesReopen) {
+#if defined(__unix__) || defined(__APPLE__)
+  const auto dir = temp_dir("checkpoint_storage");
+  const auto path = dir / "a.f32";
+  {
+    core::SampleStorage samples;
+    ASSERT_TRUE(core::open_checkpoint_storage(path, samples, 0));
+    EXPECT_EQ(samples.backend(), core::StorageBackend::MappedFile);
+    samples.resize_uninitialized(100000);
+    for (size_t i = 0; i < samples.size(); ++i)
+      samples[i] = static_cast<float>(i);
+    EXPECT_TRUE(samples.sync());
+  }
+
+  // Как после падения: первые записанные сэмплы на месте, рост их не трогает
+  core::SampleStorage samples;
+  ASSERT_TRUE(core::open_checkpoint_storage(path, samples, 70000));
+  ASSERT_EQ(samples.size(), 70000u);
+  EXPECT_EQ(samples[69999], 69999.0f);
+  samples.resize_uninitialized(300000);
+  EXPECT_EQ(samples[12345], 12345.0f);
+  EXPECT_EQ(samples[69999], 69999.0f);
+
+  // Больше, чем есть в файле, — отказ
+  core::SampleStorage other;
+  EXPECT_FALSE(core::open_checkpoint_storage(dir / "b.f32", other, 10));
+  samples.release();
+  std::filesystem::remove_all(dir);
+#else
+  GTEST_SKIP() << "needs mmap";
+#endif
+}
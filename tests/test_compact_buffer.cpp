@@ -0,0 +1,91 @@
+#include "core/audio_buffer.hpp"
+#include "core/compact_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <numbers>
+#include <vector>
+
+static core::AudioBuffer makeSignal(int sample_rate, int channels,
+                                    double seconds, float amplitude) {
+  core::AudioBuffer b{sample_rate, channels, {}};
+  const size_t frames = static_cast<size_t>(seconds * sample_rate);
+  b.samples.resize(frames * channels);
+  for (size_t n = 0; n < frames; ++n) {
+    for (int ch = 0; ch < channels; ++ch) {
+      const double f = 220.0 * (ch + 1);
+      b.samples[n * channels + ch] =
+          amplitude * static_cast<float>(std::sin(
+                          2.0 * std::numbers::pi * f * n / sample_rate));
+    }
+  }
+  return b;
+}
+
+TEST(CompactBufferTest, Int16ErrorBoundAndClipping) {
+  std::vector<float> values;
+  for (int i = -1000; i <= 1000; ++i)
+    values.push_back(i / 1000.0f * 0.999f);
+  values.push_back(1.5f);
+  core::AudioBuffer b{48000, 1, {}};
+  b.samples.resize(values.size());
+  std::copy(values.begin(), values.end(), b.samples.begin());
+
+  auto c = core::compact(b, core::CompactFormat::Int16);
+  auto back = core::expand(c);
+  ASSERT_EQ(back.samples.size(), b.samples.size());
+  for (size_t i = 0; i + 1 < b.samples.size(); ++i)
+    EXPECT_LE(std::fabs(back.samples[i] - b.samples[i]), 1.0f / 65536.0f);
+  EXPECT_FLOAT_EQ(back.samples[values.size() - 1], 32767.0f / 32768.0f);
+}
+
+TEST(CompactBufferTest, HalfErrorBoundKeepsHeadroom) {
+  const float values[] = {0.001f, -0.3f, 0.7071f, 1.0f, -2.5f, 12.0f, 60000.0f};
+  core::AudioBuffer b{48000, 1, {}};
+  b.samples.resize(std::size(values));
+  std::copy(std::begin(values), std::end(values), b.samples.begin());
+
+  auto back = core::expand(core::compact(b, core::CompactFormat::Half));
+  for (size_t i = 0; i < b.samples.size(); ++i) {
+    EXPECT_LE(std::fabs(back.samples[i] - b.samples[i]),
+              std::fabs(b.samples[i]) * std::ldexp(1.0f, -11));
+  }
+}
+
+TEST(CompactBufferTest, SpeedAndReverbMatchFloatPath) {
+  for (auto format : {core::CompactFormat::Int16, core::CompactFormat::Half}) {
+    auto c = core::compact(makeSignal(44100, 2, 1.3, 0.4f), format);
+    auto f = core::expand(c);
+
+    auto slow_c = core::change_speed(c, 1.15f);
+    auto slow_f = core::compact(core::change_speed(f, 1.15f), format);
+    ASSERT_EQ(slow_c.samples.size(), slow_f.samples.size());
+    for (size_t i = 0; i < slow_c.samples.size(); ++i)
+      ASSERT_EQ(slow_c.samples[i], slow_f.samples[i]) << i;
+
+    core::ReverbParams p{0.1f, 0.5f, 0.3f};
+    auto wet_c = core::reverb(slow_c, p);
+    auto wet_f = core::compact(core::reverb(core::expand(slow_c), p), format);
+    ASSERT_EQ(wet_c.samples.size(), wet_f.samples.size());
+    for (size_t i = 0; i < wet_c.samples.size(); ++i)
+      ASSERT_EQ(wet_c.samples[i], wet_f.samples[i]) << i;
+  }
+}
+
+TEST(CompactBufferTest, NormalizeMatchesFloatPath) {
+  core::LoudnessParams p;
+  p.target_lufs = -9.0f; // с лимитером
+  auto c = core::compact(makeSignal(48000, 2, 5.0, 0.2f),
+                         core::CompactFormat::Half);
+  auto f = core::expand(c);
+
+  auto stats_c = core::normalize_loudness(c, p);
+  auto stats_f = core::normalize_loudness(f, p);
+  EXPECT_NEAR(stats_c.integrated_lufs, stats_f.integrated_lufs, 1e-3);
+
+  auto back = core::expand(c);
+  ASSERT_EQ(back.samples.size(), f.samples.size());
+  for (size_t i = 0; i < f.samples.size(); ++i)
+    ASSERT_NEAR(back.samples[i], f.samples[i], 1e-3f) << i;
+}
@@ -0,0 +1,33 @@
+#include "core/denormals.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+
+namespace {
+
+// volatile — чтобы компилятор не свернул выражение на этапе сборки
+float halve(float x) {
+  volatile float v = x;
+  return v * 0.5f;
+}
+
+} // namespace
+
+TEST(DenormalsTest, ScopedGuardFlushesAndRestores) {
+#if defined(GRUSTNIFY_DENORMALS_SSE) || defined(GRUSTNIFY_DENORMALS_ARM64)
+  const float tiny = std::numeric_limits<float>::min(); // наименьшее нормальное
+  EXPECT_EQ(std::fpclassify(halve(tiny)), FP_SUBNORMAL);
+  {
+    const core::ScopedFlushDenormals guard;
+    EXPECT_EQ(halve(tiny), 0.0f);
+    {
+      const core::ScopedFlushDenormals nested;
+      EXPECT_EQ(halve(tiny), 0.0f);
+    }
+    EXPECT_EQ(halve(tiny), 0.0f); // вложенный guard вернул FTZ, а не сбросил
+  }
+  EXPECT_EQ(std::fpclassify(halve(tiny)), FP_SUBNORMAL);
+#else
+  GTEST_SKIP() << "no FTZ control on this platform";
+#endif
+}
@@ -0,0 +1,215 @@
+#include "app/job_protocol.hpp"
+#include "app/job_server.hpp"
+#include "core/audio_buffer.hpp"
+#include "core/loudness.hpp"
+#include "log/log.hpp"
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <filesystem>
+#include <iterator>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+class JobServerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    if (!grustnify::Log::GetClientLogger())
+      grustnify::Log::Init();
+    socket_path_ = std::filesystem::temp_directory_path() /
+                   ("grustnify-test-" + std::to_string(getpid()) + ".sock");
+    app::JobServerOptions options;
+    options.socket_path = socket_path_;
+    options.workers = 2;
+    options.max_queued_per_client = 4;
+    server_ = std::make_unique<app::JobServer>(options);
+    thread_ = std::thread([this] { server_->run(); });
+  }
+
+  void TearDown() override {
+    server_->request_stop();
+    thread_.join();
+    server_.reset();
+  }
+
+  int connect_client() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path_.c_str(),
+                 sizeof(addr.sun_path) - 1);
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    // Сервер поднимается в соседнем потоке.
+    for (int attempt = 0; attempt < 200; ++attempt) {
+      if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+        return fd;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    close(fd);
+    return -1;
+  }
+
+  std::filesystem::path socket_path_;
+  std::unique_ptr<app::JobServer> server_;
+  std::thread thread_;
+};
+
+core::AudioBuffer makeSine(int sample_rate, int channels, double seconds) {
+  core::AudioBuffer b{sample_rate, channels, {}};
+  const size_t frames = static_cast<size_t>(seconds * sample_rate);
+  b.samples.resize(frames * channels);
+  for (size_t n = 0; n < frames; ++n)
+    for (int ch = 0; ch < channels; ++ch)
+      b.samples[n * channels + ch] = 0.2f * static_cast<float>(std::sin(
+                                                2.0 * std::numbers::pi * 330.0 *
+                                                n / sample_rate));
+  return b;
+}
+
+} // namespace
+
+TEST_F(JobServerTest, ProcessesSharedMemoryPcm) {
+  const core::AudioBuffer input = makeSine(44100, 2, 1.0);
+  const size_t bytes = input.samples.size() * sizeof(float);
+
+  const int pcm = memfd_create("client-pcm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  ASSERT_GE(pcm, 0);
+  ASSERT_EQ(write(pcm, input.samples.data(), bytes),
+            static_cast<ssize_t>(bytes));
+  // Запечатанный — сервер мапит его без копирования
+  ASSERT_EQ(fcntl(pcm, F_ADD_SEALS, F_SEAL_SHRINK), 0);
+
+  const int sock = connect_client();
+  ASSERT_GE(sock, 0);
+
+  app::proto::JobRequest req;
+  req.job_id = 42;
+  req.normalize_loudness = 1;
+  req.sample_rate = input.sample_rate;
+  req.channels = input.channels;
+  req.frames = input.samples.size() / input.channels;
+  ASSERT_TRUE(app::proto::send_message(sock, &req, sizeof(req), pcm));
+  close(pcm);
+
+  app::proto::JobResponse resp;
+  int out_fd = -1;
+  ASSERT_EQ(app::proto::recv_message(sock, &resp, sizeof(resp), &out_fd),
+            static_cast<ssize_t>(sizeof(resp)));
+  ASSERT_EQ(resp.status, app::proto::Status::Ok);
+  ASSERT_GE(out_fd, 0);
+  EXPECT_EQ(resp.job_id, 42u);
+
+  // Эталон — те же этапы локально.
+  core::AudioBuffer expected = core::change_speed(input, req.speed_factor);
+  expected = core::reverb(expected, {req.reverb_mix, req.reverb_room_size,
+                                     req.reverb_damp});
+  core::LoudnessParams loudness;
+  loudness.target_lufs = req.target_lufs;
+  core::normalize_loudness(expected, loudness);
+
+  ASSERT_EQ(resp.frames * resp.channels, expected.samples.size());
+  ASSERT_EQ(resp.bytes, expected.samples.size() * sizeof(float));
+  void *mapped = mmap(nullptr, resp.bytes, PROT_READ, MAP_SHARED, out_fd, 0);
+  ASSERT_NE(mapped, MAP_FAILED);
+  const float *out = static_cast<const float *>(mapped);
+  for (size_t i = 0; i < expected.samples.size(); ++i)
+    ASSERT_EQ(out[i], expected.samples[i]) << i;
+
+  munmap(mapped, resp.bytes);
+  close(out_fd);
+  close(sock);
+}
+
+TEST_F(JobServerTest, RejectsMalformedRequests) {
+  const int sock = connect_client();
+  ASSERT_GE(sock, 0);
+
+  app::proto::JobRequest req;
+  req.job_id = 7;
+  req.sample_rate = 48000;
+  req.channels = 2;
+  req.frames = 100;
+  // Без fd
+  ASSERT_TRUE(app::proto::send_message(sock, &req, sizeof(req), -1));
+
+  app::proto::JobResponse resp;
+  int fd = -1;
+  ASSERT_GT(app::proto::recv_message(sock, &resp, sizeof(resp), &fd), 0);
+  EXPECT_EQ(resp.status, app::proto::Status::BadFd);
+  EXPECT_EQ(resp.job_id, 7u);
+
+  // fd короче заявленного
+  const int pcm = memfd_create("short", MFD_CLOEXEC);
+  ASSERT_TRUE(app::proto::send_message(sock, &req, sizeof(req), pcm));
+  close(pcm);
+  ASSERT_GT(app::proto::recv_message(sock, &resp, sizeof(resp), &fd), 0);
+  EXPECT_EQ(resp.status, app::proto::Status::BadFd);
+
+  // frames * channels * 4 переполняет size_t и не должен пройти проверку
+  // длины fd
+  req.frames = uint64_t{1} << 60;
+  req.channels = 4;
+  const int empty = memfd_create("overflow", MFD_CLOEXEC);
+  ASSERT_TRUE(app::proto::send_message(sock, &req, sizeof(req), empty));
+  close(empty);
+  ASSERT_GT(app::proto::recv_message(sock, &resp, sizeof(resp), &fd), 0);
+  EXPECT_EQ(resp.status, app::proto::Status::BadRequest);
+
+  req.magic = 0;
+  ASSERT_TRUE(app::proto::send_message(sock, &req, sizeof(req), -1));
+  ASSERT_GT(app::proto::recv_message(sock, &resp, sizeof(resp), &fd), 0);
+  EXPECT_EQ(resp.status, app::proto::Status::BadRequest);
+  close(sock);
+}
+
+// Несколько fd в одном сообщении: остаётся первый, остальные закрыты
+TEST(JobProtocolTest, RecvMessageClosesExtraDescriptors) {
+  int pair[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, pair), 0);
+  const auto open_fds = [] {
+    return std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                         std::filesystem::directory_iterator{});
+  };
+
+  const int fds[3] = {memfd_create("a", MFD_CLOEXEC),
+                      memfd_create("b", MFD_CLOEXEC),
+                      memfd_create("c", MFD_CLOEXEC)};
+  const uint32_t payload = 1;
+  iovec iov{const_cast<uint32_t *>(&payload), sizeof(payload)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+  msghdr hdr{};
+  hdr.msg_iov = &iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = control;
+  hdr.msg_controllen = sizeof(control);
+  cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  ASSERT_EQ(sendmsg(pair[0], &hdr, 0), static_cast<ssize_t>(sizeof(payload)));
+  for (const int f : fds)
+    close(f);
+
+  const auto before = open_fds();
+  uint32_t received = 0;
+  int fd = -1;
+  ASSERT_EQ(app::proto::recv_message(pair[1], &received, sizeof(received), &fd),
+            static_cast<ssize_t>(sizeof(received)));
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(open_fds(), before + 1);
+  close(fd);
+  close(pair[0]);
+  close(pair[1]);
+}
+#endif
@@ -0,0 +1,71 @@
+#include "core/audio_buffer.hpp"
+#include "core/loudness.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+
+static core::AudioBuffer makeSine(int sample_rate, int channels, float freq,
+                                  float amplitude, double seconds) {
+  core::AudioBuffer b{sample_rate, channels, {}};
+  const size_t frames = static_cast<size_t>(seconds * sample_rate);
+  b.samples.resize(frames * channels);
+  for (size_t n = 0; n < frames; ++n) {
+    const float v = amplitude * static_cast<float>(std::sin(
+                                    2.0 * std::numbers::pi * freq * n /
+                                    sample_rate));
+    for (int ch = 0; ch < channels; ++ch)
+      b.samples[n * channels + ch] = v;
+  }
+  return b;
+}
+
+TEST(LoudnessTest, MonoSineMatchesReferenceLevel) {
+  // BS.1770: синус ~1 кГц с пиком 0 dBFS в одном канале = -3.01 LKFS.
+  auto b = makeSine(48000, 1, 997.0f, 0.1f, 10.0);
+  auto stats = core::measure_loudness(b);
+
+  EXPECT_NEAR(stats.integrated_lufs, -23.01, 0.2);
+  EXPECT_NEAR(stats.sample_peak, 0.1f, 1e-3f);
+  EXPECT_NEAR(stats.rms_dbfs, -23.01, 0.05);
+}
+
+TEST(LoudnessTest, StereoAddsThreeDecibels) {
+  auto b = makeSine(44100, 2, 997.0f, 0.1f, 10.0);
+  auto stats = core::measure_loudness(b);
+
+  EXPECT_NEAR(stats.integrated_lufs, -20.0, 0.2);
+}
+
+TEST(LoudnessTest, SilenceIsUntouched) {
+  core::AudioBuffer b{48000, 2, {}};
+  b.samples.resize(48000 * 2);
+
+  auto stats = core::normalize_loudness(b, {});
+  EXPECT_TRUE(std::isinf(stats.integrated_lufs));
+  for (float v : b.samples)
+    EXPECT_EQ(v, 0.0f);
+}
+
+TEST(LoudnessTest, NormalizesQuietSignalToTarget) {
+  auto b = makeSine(48000, 2, 440.0f, 0.05f, 8.0);
+  core::LoudnessParams p;
+  p.target_lufs = -16.0f;
+  core::normalize_loudness(b, p);
+
+  auto after = core::measure_loudness(b);
+  EXPECT_NEAR(after.integrated_lufs, -16.0, 0.2);
+}
+
+TEST(LoudnessTest, LimiterKeepsTruePeakUnderCeiling) {
+  // Цель заведомо выше, чем позволяет потолок: работает лимитер.
+  auto b = makeSine(44100, 2, 3000.0f, 0.5f, 5.0);
+  core::LoudnessParams p;
+  p.target_lufs = -3.0f;
+  p.true_peak_ceiling_db = -1.0f;
+  core::normalize_loudness(b, p);
+
+  auto after = core::measure_loudness(b);
+  const double true_peak_db = 20.0 * std::log10(after.true_peak);
+  EXPECT_LE(true_peak_db, -1.0 + 0.1);
+  EXPECT_LE(after.sample_peak, std::pow(10.0f, -1.0f / 20.0f) + 1e-4f);
+}
@@ -0,0 +1,97 @@
+#include "metrics/metrics.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(MetricsTest, CountersSumAcrossThreads) {
+  metrics::Registry r;
+  const metrics::Counter c = r.counter("test_events", "Events.");
+  // Повторная регистрация — та же метрика
+  const metrics::Counter same = r.counter("test_events", "Events.");
+
+  constexpr int kThreads = 8;
+  constexpr int kPerThread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kPerThread; ++i)
+        (i % 2 ? c : same).inc();
+    });
+  }
+  // Шарды живых и завершившихся потоков
+  c.inc(5);
+  for (std::thread &t : threads)
+    t.join();
+
+  EXPECT_EQ(r.openmetrics(), "# TYPE test_events counter\n"
+                             "# HELP test_events Events.\n"
+                             "test_events_total 80005\n"
+                             "# EOF\n");
+}
+
+TEST(MetricsTest, HistogramAndGaugeExposition) {
+  metrics::Registry r;
+  const metrics::Histogram h =
+      r.histogram("test_seconds", "Latency.", {0.5, 0.1}, {{"stage", "a"}});
+  const metrics::Gauge g =
+      r.gauge("test_depth", "Queue \"depth\"\nnow.", {{"queue", "q\"1"}});
+  for (const double x : {0.05, 0.1, 0.3, 2.0})
+    h.observe(x);
+  g.set(7);
+  g.add(-2);
+
+  EXPECT_EQ(r.openmetrics(),
+            "# TYPE test_seconds histogram\n"
+            "# HELP test_seconds Latency.\n"
+            "test_seconds_bucket{stage=\"a\",le=\"0.1\"} 2\n"
+            "test_seconds_bucket{stage=\"a\",le=\"0.5\"} 3\n"
+            "test_seconds_bucket{stage=\"a\",le=\"+Inf\"} 4\n"
+            "test_seconds_count{stage=\"a\"} 4\n"
+            "test_seconds_sum{stage=\"a\"} 2.45\n"
+            "# TYPE test_depth gauge\n"
+            "# HELP test_depth Queue \"depth\"\\nnow.\n"
+            "test_depth{queue=\"q\\\"1\"} 5\n"
+            "# EOF\n");
+
+  // Имя уже занято другим типом — пустой хэндл, без записи
+  r.counter("test_depth", "").inc();
+  EXPECT_EQ(r.openmetrics().find("test_depth_total"), std::string::npos);
+}
+
+TEST(MetricsTest, WritesSnapshotFile) {
+  metrics::Registry r;
+  r.counter("test_jobs", "Jobs.", {{"result", "ok"}}).inc(3);
+
+  const auto path =
+      std::filesystem::temp_directory_path() / "grustnify_test_metrics.prom";
+  ASSERT_TRUE(r.write_openmetrics(path));
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  EXPECT_EQ(text.str(), r.openmetrics());
+  EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+  std::filesystem::remove(path);
+}
+
+TEST(MetricsTest, StageTimerRecordsOnlyWhenDone) {
+  const auto frames_of = [](const std::string &text) {
+    const std::string key =
+        "grustnify_stage_frames_total{stage=\"loudness\"} ";
+    const size_t at = text.find(key);
+    return at == std::string::npos
+               ? 0ull
+               : std::stoull(text.substr(at + key.size()));
+  };
+  const unsigned long long before =
+      frames_of(metrics::registry().openmetrics());
+  {
+    const metrics::StageTimer timer(metrics::Stage::Loudness);
+    timer.done(1000);
+  }
+  { const metrics::StageTimer abandoned(metrics::Stage::Loudness); }
+  EXPECT_EQ(frames_of(metrics::registry().openmetrics()), before + 1000);
+}
@@ -0,0 +1,144 @@
+#include "core/peaks.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+core::AudioBuffer noise(size_t frames, int channels, uint32_t seed) {
+  core::AudioBuffer buf{48000, channels, {}};
+  buf.samples.resize(frames * channels);
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (float &s : buf.samples)
+    s = dist(rng);
+  return buf;
+}
+
+std::filesystem::path temp_file(const char *name) {
+  return std::filesystem::temp_directory_path() /
+         (std::string("grustnify_test_") + name);
+}
+
+} // namespace
+
+TEST(PeaksTest, StreamingBuildMatchesWholeBuffer) {
+  const core::AudioBuffer buf = noise(100000, 2, 1);
+  const core::PeakPyramid whole = core::build_peaks(buf);
+
+  // Блоки произвольного размера, как из декодера
+  core::PeakBuilder builder;
+  builder.start(buf.sample_rate, buf.channels);
+  size_t done = 0;
+  for (size_t step = 1; done < 100000; step = step * 3 % 1021 + 1) {
+    const size_t n = std::min<size_t>(step, 100000 - done);
+    builder.add(buf.samples.data() + done * 2, n);
+    done += n;
+  }
+  const core::PeakPyramid streamed = builder.finish();
+
+  ASSERT_EQ(streamed.frames(), 100000u);
+  ASSERT_EQ(streamed.levels(), whole.levels());
+  const auto &a = whole.level(0);
+  const auto &b = streamed.level(0);
+  ASSERT_EQ(a.size(), (100000 + 255) / 256);
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].min, b[i].min);
+    EXPECT_EQ(a[i].max, b[i].max);
+    EXPECT_NEAR(a[i].rms, b[i].rms, 1e-5f);
+  }
+  EXPECT_EQ(whole.level(whole.levels() - 1).size(), 1u);
+}
+
+TEST(PeaksTest, RenderColumnsMatchSamples) {
+  const core::AudioBuffer buf = noise(1 << 18, 1, 2);
+  const core::PeakPyramid peaks = core::build_peaks(buf);
+
+  // 256 колонок по 1024 кадра: границы совпадают с ячейками уровня 2
+  std::vector<core::PeakCell> cols(256);
+  peaks.render(0, 1 << 18, cols.size(), cols.data());
+  for (size_t x = 0; x < cols.size(); ++x) {
+    const float *s = buf.samples.data() + x * 1024;
+    EXPECT_EQ(cols[x].min, *std::min_element(s, s + 1024));
+    EXPECT_EQ(cols[x].max, *std::max_element(s, s + 1024));
+    EXPECT_NEAR(cols[x].rms, 1.0f / std::sqrt(3.0f), 0.05f);
+  }
+
+  // За концом сигнала — пусто
+  peaks.render(1 << 18, 1 << 18, cols.size(), cols.data());
+  EXPECT_EQ(cols.back().max, 0.0f);
+}
+
+TEST(PeaksTest, SidecarRoundTrip) {
+  const core::PeakPyramid peaks = core::build_peaks(noise(50000, 2, 3));
+  const std::filesystem::path path = temp_file("peaks.peaks");
+  ASSERT_TRUE(peaks.save(path));
+
+  core::PeakPyramid loaded;
+  ASSERT_TRUE(loaded.load(path));
+  EXPECT_EQ(loaded.sample_rate(), 48000);
+  EXPECT_EQ(loaded.channels(), 2);
+  EXPECT_EQ(loaded.frames(), 50000u);
+  ASSERT_EQ(loaded.levels(), peaks.levels());
+  for (size_t i = 0; i < peaks.level(0).size(); ++i) {
+    // half float: относительная ошибка 2^-11
+    EXPECT_NEAR(loaded.level(0)[i].max, peaks.level(0)[i].max, 1e-3f);
+    EXPECT_NEAR(loaded.level(0)[i].min, peaks.level(0)[i].min, 1e-3f);
+  }
+  // 6 байт на ячейку + заголовок
+  EXPECT_LT(std::filesystem::file_size(path), 50000 / 256 * 6 + 64);
+
+  std::filesystem::resize_file(path, 40);
+  EXPECT_FALSE(loaded.load(path));
+
+  // Заголовок обещает больше ячеек, чем есть в файле, — отказ без аллокации
+  ASSERT_TRUE(peaks.save(path));
+  {
+    const uint64_t cells = uint64_t{1} << 40;
+    const uint64_t frames = cells * core::PeakPyramid::kBaseFrames;
+    std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(16); // frames, cells
+    f.write(reinterpret_cast<const char *>(&frames), sizeof(frames));
+    f.write(reinterpret_cast<const char *>(&cells), sizeof(cells));
+  }
+  EXPECT_FALSE(loaded.load(path));
+  std::filesystem::remove(path);
+}
+
+TEST(PeaksTest, ContentHashTracksContent) {
+  const std::filesystem::path path = temp_file("hash.bin");
+  std::vector<char> data(300000, 'x');
+  {
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+  }
+  const uint64_t h1 = core::content_hash(path);
+  EXPECT_NE(h1, 0u);
+  EXPECT_EQ(core::content_hash(path), h1);
+
+  data[data.size() / 2] = 'y'; // попадает в средний участок
+  {
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+  }
+  const uint64_t h2 = core::content_hash(path);
+  EXPECT_NE(h2, h1);
+
+  // Правка вне сэмплируемых участков — ключ меняется по mtime
+  data[100000] = 'z';
+  {
+    std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+  }
+  std::filesystem::last_write_time(
+      path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+  EXPECT_NE(core::content_hash(path), h2);
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(core::content_hash(path), 0u);
+  EXPECT_EQ(core::peak_cache_path("/c", 0xabcull).filename(),
+            "0000000000000abc.peaks");
+}
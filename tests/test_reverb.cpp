@@ -0,0 +1,361 @@
+#include "core/audio_buffer.hpp"
+#include "core/reverb_kernel.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Исходная реализация (вектор на линию задержки, ветвление на wrap) —
+// эталон, с которым сверяются оптимизированные ядра.
+static std::vector<float> referenceReverb(const std::vector<float> &in, int sr,
+                                          int channels,
+                                          const core::ReverbParams &p) {
+  const size_t frames = in.size() / channels;
+  std::vector<float> out(in.size());
+  const float mix = std::clamp(p.mix, 0.0f, 1.0f);
+  const float feedback = 0.75f + std::clamp(p.room_size, 0.0f, 1.0f) * 0.2f;
+  const float damp = std::clamp(p.damp, 0.0f, 1.0f);
+  const float comb_ms[4] = {29.7f, 37.1f, 41.1f, 43.7f};
+  const float ap_ms[2] = {5.0f, 1.7f};
+
+  for (int ch = 0; ch < channels; ++ch) {
+    std::array<std::vector<float>, 4> comb;
+    std::array<std::vector<float>, 2> ap;
+    std::array<size_t, 4> ci{};
+    std::array<size_t, 2> ai{};
+    for (int i = 0; i < 4; ++i)
+      comb[i].assign(std::max(1, int(comb_ms[i] * 0.001f * sr)), 0.0f);
+    for (int i = 0; i < 2; ++i)
+      ap[i].assign(std::max(1, int(ap_ms[i] * 0.001f * sr)), 0.0f);
+
+    for (size_t n = 0; n < frames; ++n) {
+      const float x = in[n * channels + ch];
+      float sum = 0.0f;
+      for (int i = 0; i < 4; ++i) {
+        float y = comb[i][ci[i]];
+        comb[i][ci[i]] = x + y * feedback * (1.0f - damp);
+        if (++ci[i] >= comb[i].size())
+          ci[i] = 0;
+        sum += y;
+      }
+      float a = sum;
+      for (int i = 0; i < 2; ++i) {
+        float by = ap[i][ai[i]];
+        float v = a - by;
+        ap[i][ai[i]] = a + by * 0.5f;
+        if (++ai[i] >= ap[i].size())
+          ai[i] = 0;
+        a = v;
+      }
+      out[n * channels + ch] = (1.0f - mix) * x + mix * a;
+    }
+  }
+  return out;
+}
+
+static std::vector<float> noise(size_t n) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  std::vector<float> v(n);
+  for (float &x : v)
+    x = dist(rng);
+  return v;
+}
+
+TEST(ReverbTest, ConstexprDelaysMatchRuntime) {
+  for (int sr : {44100, 48000, 96000}) {
+    const float ms = 37.1f;
+    const float sr_f = static_cast<float>(sr);
+    EXPECT_EQ(core::reverb_detail::delay_samples(ms, sr),
+              static_cast<int>(ms * 0.001f * sr_f));
+  }
+}
+
+TEST(ReverbTest, DispatchPicksSpecializedKernels) {
+  core::ReverbParams p;
+  for (int channels : {1, 2})
+    for (int sr : {44100, 48000, 96000})
+      EXPECT_STREQ(core::make_reverb_processor(sr, channels, p)->name(),
+                   "schroeder-specialized");
+
+  EXPECT_STREQ(core::make_reverb_processor(22050, 2, p)->name(),
+               "schroeder-generic");
+  EXPECT_STREQ(core::make_reverb_processor(48000, 6, p)->name(),
+               "schroeder-generic");
+}
+
+TEST(ReverbTest, KernelsMatchReferenceImplementation) {
+  core::ReverbParams p{0.4f, 0.9f, 0.2f};
+  for (int channels : {1, 2, 3})
+    for (int sr : {44100, 48000, 96000, 32000}) {
+      SCOPED_TRACE(std::to_string(channels) + "ch@" + std::to_string(sr));
+      const size_t frames = sr / 2;
+      const auto in = noise(frames * channels);
+      const auto ref = referenceReverb(in, sr, channels, p);
+
+      std::vector<float> fast(in.size()), generic(in.size());
+      core::make_reverb_processor(sr, channels, p)
+          ->process(in.data(), fast.data(), frames);
+      core::reverb_detail::make_generic(sr, channels, p)
+          ->process(in.data(), generic.data(), frames);
+
+      EXPECT_EQ(fast, generic);
+      for (size_t i = 0; i < ref.size(); ++i)
+        ASSERT_NEAR(fast[i], ref[i], 1e-4f) << "sample " << i;
+    }
+}
+
+TEST(ReverbTest, BlockwiseProcessingIsSeamless) {
+  core::ReverbParams p;
+  const int sr = 48000, channels = 2;
+  const size_t frames = 20000;
+  const auto in = noise(frames * channels);
+
+  std::vector<float> whole(in.size()), blocks(in.size());
+  core::make_reverb_processor(sr, channels, p)
+      ->process(in.data(), whole.data(), frames);
+
+  auto proc = core::make_reverb_processor(sr, channels, p);
+  for (size_t done = 0; done < frames; done += 777) {
+    const size_t n = std::min<size_t>(777, frames - done);
+    proc->process(in.data() + done * channels, blocks.data() + done * channels,
+                  n);
+  }
+  EXPECT_EQ(whole, blocks);
+}
+
+TEST(ReverbTest, HadamardMixIsOrthonormal) {
+  auto check = [](auto lines_tag) {
+    constexpr int kLines = decltype(lines_tag)::value;
+    std::array<std::array<float, kLines>, kLines> m{};
+    for (int col = 0; col < kLines; ++col) {
+      float basis[kLines] = {};
+      basis[col] = 1.0f;
+      core::reverb_detail::hadamard_mix<kLines>(basis);
+      for (int row = 0; row < kLines; ++row)
+        m[row][col] = basis[row] * core::reverb_detail::hadamard_scale(kLines);
+    }
+    for (int a = 0; a < kLines; ++a)
+      for (int b = 0; b < kLines; ++b) {
+        float dot = 0.0f;
+        for (int i = 0; i < kLines; ++i)
+          dot += m[i][a] * m[i][b];
+        ASSERT_NEAR(dot, a == b ? 1.0f : 0.0f, 1e-6f) << a << "," << b;
+      }
+  };
+  check(std::integral_constant<int, 4>{});
+  check(std::integral_constant<int, 8>{});
+  check(std::integral_constant<int, 16>{});
+}
+
+// Отклик только «мокрой» части на единичный импульс
+static std::vector<float> impulse_response(core::ReverbParams p, int sr,
+                                           size_t frames) {
+  p.mix = 1.0f;
+  std::vector<float> x(frames, 0.0f), y(frames);
+  x[0] = 1.0f;
+  core::make_reverb_processor(sr, 1, p)->process(x.data(), y.data(), frames);
+  return y;
+}
+
+TEST(ReverbTest, FdnSelectionAndBlockwise) {
+  core::ReverbParams p;
+  p.algorithm = core::ReverbAlgorithm::Fdn8;
+  EXPECT_STREQ(core::make_reverb_processor(48000, 2, p)->name(), "fdn8");
+  p.algorithm = core::ReverbAlgorithm::Fdn16;
+  EXPECT_STREQ(core::make_reverb_processor(22050, 6, p)->name(), "fdn16");
+
+  const int sr = 44100, channels = 2;
+  const size_t frames = 20000;
+  const auto in = noise(frames * channels);
+  std::vector<float> whole(in.size()), blocks(in.size());
+  core::make_reverb_processor(sr, channels, p)
+      ->process(in.data(), whole.data(), frames);
+  auto proc = core::make_reverb_processor(sr, channels, p);
+  for (size_t done = 0; done < frames; done += 613) {
+    const size_t n = std::min<size_t>(613, frames - done);
+    proc->process(in.data() + done * channels, blocks.data() + done * channels,
+                  n);
+  }
+  EXPECT_EQ(whole, blocks);
+}
+
+// FDN8 по такту: история линии целиком, без колец и блоков.
+static std::vector<float> referenceFdn8(const std::vector<float> &in, int sr,
+                                        const core::ReverbParams &p) {
+  using namespace core::reverb_detail;
+  constexpr int kLines = 8;
+  const SchroederGains base(p);
+  const float reference =
+      static_cast<float>(delay_samples(kFdnReferenceMs, sr));
+  const float damping = std::clamp(p.damp, 0.0f, 1.0f) * kFdnMaxDamping;
+  const float b = damping / (1.0f + damping);
+
+  std::array<int, kLines> delay{};
+  std::array<float, kLines> now{}, prev{};
+  std::array<std::vector<float>, kLines> hist;
+  for (int i = 0; i < kLines; ++i) {
+    delay[i] = delay_samples(kFdnDelaysMs[2 * i + 1], sr);
+    const float gain =
+        std::pow(base.feedback, static_cast<float>(delay[i]) / reference) *
+        hadamard_scale(kLines);
+    now[i] = gain * (1.0f - b);
+    prev[i] = gain * b;
+    hist[i].assign(in.size(), 0.0f);
+  }
+
+  auto at = [&](int i, long t) { return t < 0 ? 0.0f : hist[i][t]; };
+  std::vector<float> out(in.size());
+  for (long t = 0; t < static_cast<long>(in.size()); ++t) {
+    float v[kLines];
+    float wet = 0.0f;
+    for (int i = 0; i < kLines; ++i) {
+      const float y = at(i, t - delay[i]);
+      wet = (i & 1) ? wet - y : wet + y;
+      v[i] = y * now[i] + at(i, t - delay[i] - 1) * prev[i];
+    }
+    hadamard_mix<kLines>(v);
+    for (int i = 0; i < kLines; ++i)
+      hist[i][t] = v[i] + in[t];
+    out[t] = base.dry * in[t] + base.wet * wet;
+  }
+  return out;
+}
+
+TEST(ReverbTest, FdnMatchesPerTickReference) {
+  // На 8040 Гц линия 63.7 мс — ровно 512 сэмплов: кольцо обязано помнить
+  // сэмпл старше задержки
+  for (int sr : {8040, 44100}) {
+    core::ReverbParams p;
+    p.algorithm = core::ReverbAlgorithm::Fdn8;
+    p.room_size = 0.9f;
+    p.damp = 0.6f;
+    const auto in = noise(sr);
+    std::vector<float> out(in.size());
+    core::make_reverb_processor(sr, 1, p)->process(in.data(), out.data(),
+                                                   in.size());
+    const auto expected = referenceFdn8(in, sr, p);
+    for (size_t i = 0; i < in.size(); ++i)
+      ASSERT_NEAR(out[i], expected[i], 1e-5f) << sr << " Hz, " << i;
+  }
+}
+
+TEST(ReverbTest, FdnTailIsDenseAndDecays) {
+  const int sr = 48000;
+  for (auto algorithm :
+       {core::ReverbAlgorithm::Fdn8, core::ReverbAlgorithm::Fdn16}) {
+    core::ReverbParams p{1.0f, 1.0f, 0.0f, algorithm}; // самый долгий хвост
+    const auto fdn = impulse_response(p, sr, sr * 6);
+    p.algorithm = core::ReverbAlgorithm::Schroeder;
+    const auto schroeder = impulse_response(p, sr, sr * 6);
+
+    // Плотность эха на 0.5..0.6 с: эксцесс отсчётов у плотного хвоста
+    // близок к гауссовым 3, у редких отдельных эхо — на порядок выше
+    auto kurtosis = [&](const std::vector<float> &y) {
+      double s2 = 0.0, s4 = 0.0;
+      const size_t from = sr / 2, to = sr / 2 + sr / 10;
+      for (size_t i = from; i < to; ++i) {
+        const double v2 = static_cast<double>(y[i]) * y[i];
+        s2 += v2;
+        s4 += v2 * v2;
+      }
+      return s4 * static_cast<double>(to - from) / (s2 * s2);
+    };
+    EXPECT_LT(kurtosis(fdn), 6.0);
+    EXPECT_GT(kurtosis(schroeder), 20.0);
+
+    // Затухает и остаётся конечным даже без демпфирования
+    auto energy = [&](size_t from, size_t to) {
+      double e = 0.0;
+      for (size_t i = from; i < to; ++i) {
+        EXPECT_TRUE(std::isfinite(fdn[i]));
+        e += static_cast<double>(fdn[i]) * fdn[i];
+      }
+      return e;
+    };
+    const double head = energy(0, sr / 2);
+    const double tail = energy(sr * 5, sr * 5 + sr / 2);
+    EXPECT_GT(head, 0.0);
+    EXPECT_LT(tail, head * 1e-2);
+  }
+}
+
+TEST(ReverbTest, TailRendersUntilSilence) {
+  const int sr = 44100, channels = 2;
+  core::AudioBuffer in{sr, channels, {}};
+  in.samples.assign(2000 * channels, 0.0f);
+  for (size_t i = 0; i < 200 * channels; ++i)
+    in.samples[i] = 0.5f;
+
+  for (auto algorithm :
+       {core::ReverbAlgorithm::Schroeder, core::ReverbAlgorithm::Fdn8}) {
+    core::ReverbParams p;
+    p.algorithm = algorithm;
+    const core::AudioBuffer cut = core::reverb(in, p);
+    EXPECT_EQ(cut.samples.size(), in.samples.size());
+
+    p.render_tail = true;
+    const core::AudioBuffer tail = core::reverb(in, p);
+    // Начало совпадает, хвост длиннее входа, но обрывается задолго до
+    // лимита и заканчивается тишиной
+    ASSERT_GT(tail.samples.size(), in.samples.size() + sr * channels / 2);
+    EXPECT_LT(tail.samples.size(),
+              static_cast<size_t>(p.tail_max_seconds * sr * channels));
+    EXPECT_TRUE(std::equal(cut.samples.begin(), cut.samples.end(),
+                           tail.samples.begin()));
+    const size_t last_block = 4096 * channels;
+    float last = 0.0f;
+    for (size_t i = tail.samples.size() - last_block; i < tail.samples.size();
+         ++i)
+      last = std::max(last, std::fabs(tail.samples[i]));
+    EXPECT_LT(last, 1e-3f);
+  }
+}
+
+TEST(ReverbTest, TailRespectsLimit) {
+  core::ReverbParams p{0.5f, 1.0f, 0.0f};
+  p.render_tail = true;
+  p.tail_max_seconds = 0.25f;
+  core::AudioBuffer in{8000, 1, {}};
+  in.samples.assign(100, 1.0f);
+  const core::AudioBuffer out = core::reverb(in, p);
+  EXPECT_EQ(out.samples.size(), 100u + 2000u);
+}
+
+TEST(ReverbTest, StateResumesInFreshProcessor) {
+  const int channels = 2;
+  const size_t frames = 30000, split = 12345;
+  const auto in = noise(frames * channels);
+  for (auto algorithm :
+       {core::ReverbAlgorithm::Schroeder, core::ReverbAlgorithm::Fdn8,
+        core::ReverbAlgorithm::Fdn16}) {
+    core::ReverbParams p;
+    p.algorithm = algorithm;
+    // 44100 — специализированное ядро, 32000 — generic
+    for (const int sr : {44100, 32000}) {
+      std::vector<float> whole(in.size()), resumed(in.size());
+      core::make_reverb_processor(sr, channels, p)
+          ->process(in.data(), whole.data(), frames);
+
+      // Как после перезапуска: состояние — байты, процессор — новый
+      std::vector<uint8_t> state;
+      {
+        auto first = core::make_reverb_processor(sr, channels, p);
+        first->process(in.data(), resumed.data(), split);
+        state = first->save_state();
+      }
+      auto second = core::make_reverb_processor(sr, channels, p);
+      ASSERT_TRUE(second->load_state(state.data(), state.size()));
+      second->process(in.data() + split * channels,
+                      resumed.data() + split * channels, frames - split);
+      EXPECT_EQ(whole, resumed) << second->name() << " @ " << sr;
+
+      // Состояние другой конфигурации не подходит
+      EXPECT_FALSE(core::make_reverb_processor(sr, 1, p)->load_state(
+          state.data(), state.size()));
+    }
+  }
+}
@@ -0,0 +1,144 @@
+#include "core/sample_convert.hpp"
+#include <cmath>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using core::convert::Isa;
+using core::convert::Kernels;
+
+static std::vector<float> randomFloats(size_t n, float range) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-range, range);
+  std::vector<float> v(n);
+  for (float &x : v)
+    x = dist(rng);
+  return v;
+}
+
+// Длина не кратна ни одной ширине SIMD, чтобы проверить и хвосты.
+constexpr size_t kCount = 1037;
+
+TEST(SampleConvertTest, AllIsasMatchScalar) {
+  const Kernels &ref = core::convert::kernels_for(Isa::Scalar);
+  // 1.2 — проверяем и насыщение за пределами [-1, 1)
+  const auto f = randomFloats(kCount, 1.2f);
+
+  std::vector<int16_t> s16(kCount);
+  std::vector<int32_t> s32(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    s16[i] = static_cast<int16_t>(i * 977);
+    s32[i] = static_cast<int32_t>(i * 2654435761u);
+  }
+
+  std::vector<int16_t> ref_s16(kCount), got_s16(kCount);
+  std::vector<float> ref_f(kCount), got_f(kCount);
+  ref.f32_to_s16(f.data(), ref_s16.data(), kCount, nullptr);
+
+  for (Isa isa : core::convert::supported_isas()) {
+    SCOPED_TRACE(core::convert::isa_name(isa));
+    const Kernels &k = core::convert::kernels_for(isa);
+    EXPECT_EQ(k.isa, isa);
+
+    k.f32_to_s16(f.data(), got_s16.data(), kCount, nullptr);
+    EXPECT_EQ(got_s16, ref_s16);
+
+    ref.s16_to_f32(s16.data(), ref_f.data(), kCount);
+    k.s16_to_f32(s16.data(), got_f.data(), kCount);
+    EXPECT_EQ(got_f, ref_f);
+
+    ref.s32_to_f32(s32.data(), ref_f.data(), kCount);
+    k.s32_to_f32(s32.data(), got_f.data(), kCount);
+    EXPECT_EQ(got_f, ref_f);
+  }
+}
+
+TEST(SampleConvertTest, PlanarRoundTrip) {
+  for (int channels : {1, 2, 3, 6}) {
+    SCOPED_TRACE(channels);
+    const size_t frames = kCount;
+    const auto in = randomFloats(frames * channels, 1.0f);
+
+    std::vector<std::vector<int16_t>> planes(channels,
+                                             std::vector<int16_t>(frames));
+    std::vector<uint8_t *> plane_ptrs(channels);
+    for (int ch = 0; ch < channels; ++ch)
+      plane_ptrs[ch] = reinterpret_cast<uint8_t *>(planes[ch].data());
+
+    std::vector<float> scratch;
+    core::convert::from_interleaved_f32(in.data(), core::convert::PcmFormat::S16,
+                                        true, plane_ptrs.data(), frames,
+                                        channels, scratch);
+    EXPECT_EQ(planes[channels - 1][frames - 1],
+              static_cast<int16_t>(std::lrintf(
+                  in[frames * channels - 1] * 32768.0f)));
+
+    std::vector<float> back(frames * channels);
+    core::convert::to_interleaved_f32(core::convert::PcmFormat::S16, true,
+                                      plane_ptrs.data(), back.data(), frames,
+                                      channels, scratch);
+    for (size_t i = 0; i < back.size(); ++i)
+      ASSERT_NEAR(back[i], in[i], 1.0f / 32768.0f);
+  }
+}
+
+TEST(SampleConvertTest, TpdfDitherIsUnbiasedAndBounded) {
+  const size_t n = 1 << 16;
+  std::vector<float> in(n, 0.25f / 32768.0f); // четверть LSB
+  std::vector<int16_t> out(n);
+
+  for (Isa isa : core::convert::supported_isas()) {
+    SCOPED_TRACE(core::convert::isa_name(isa));
+    core::convert::DitherState dither;
+    core::convert::kernels_for(isa).f32_to_s16(in.data(), out.data(), n,
+                                               &dither);
+    double mean = 0.0;
+    for (int16_t v : out) {
+      ASSERT_LE(std::abs(v), 1);
+      mean += v;
+    }
+    mean /= n;
+    EXPECT_NEAR(mean, 0.25, 0.02);
+  }
+}
+
+TEST(SampleConvertTest, HalfKernelsMatchScalarConversion) {
+  std::vector<uint16_t> all(65536);
+  for (size_t i = 0; i < all.size(); ++i)
+    all[i] = static_cast<uint16_t>(i);
+
+  auto f = randomFloats(kCount, 70000.0f); // включая переполнение в inf
+  f[0] = 1e-6f;                             // subnormal half
+  f[1] = -0.0f;
+
+  std::vector<float> decoded(all.size());
+  std::vector<uint16_t> encoded(kCount);
+
+  for (Isa isa : core::convert::supported_isas()) {
+    SCOPED_TRACE(core::convert::isa_name(isa));
+    const Kernels &k = core::convert::kernels_for(isa);
+
+    k.f16_to_f32(all.data(), decoded.data(), all.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+      const float ref = core::convert::f16_to_f32(all[i]);
+      if (std::isnan(ref))
+        ASSERT_TRUE(std::isnan(decoded[i])) << i;
+      else
+        ASSERT_EQ(decoded[i], ref) << i;
+    }
+
+    k.f32_to_f16(f.data(), encoded.data(), kCount);
+    for (size_t i = 0; i < kCount; ++i)
+      ASSERT_EQ(encoded[i], core::convert::f32_to_f16(f[i])) << f[i];
+  }
+}
+
+TEST(SampleConvertTest, HalfRoundTripKnownValues) {
+  EXPECT_EQ(core::convert::f32_to_f16(1.0f), 0x3c00);
+  EXPECT_EQ(core::convert::f32_to_f16(-2.0f), 0xc000);
+  EXPECT_EQ(core::convert::f32_to_f16(65504.0f), 0x7bff);
+  EXPECT_EQ(core::convert::f32_to_f16(1e9f), 0x7c00);
+  EXPECT_EQ(core::convert::f16_to_f32(0x0001), std::ldexp(1.0f, -24));
+  EXPECT_EQ(core::convert::f16_to_f32(0x3555), 0.333251953125f);
+}
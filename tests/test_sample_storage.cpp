@@ -0,0 +1,155 @@
+#include "core/audio_buffer.hpp"
+#include "core/sample_storage.hpp"
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Временно меняет порог spill'а и возвращает прежний конфиг в деструкторе.
+struct ScopedStorageConfig {
+  explicit ScopedStorageConfig(std::size_t threshold)
+      : saved(core::storage_config()) {
+    core::StorageConfig config = saved;
+    config.spill_threshold_bytes = threshold;
+    core::set_storage_config(config);
+  }
+  ~ScopedStorageConfig() { core::set_storage_config(saved); }
+
+  core::StorageConfig saved;
+};
+
+} // namespace
+
+TEST(SampleStorageTest, SmallBuffersStayOnHeap) {
+  core::SampleStorage s;
+  s.resize(1024);
+
+  EXPECT_EQ(s.backend(), core::StorageBackend::Heap);
+  EXPECT_EQ(s.size(), 1024u);
+  for (float v : s)
+    EXPECT_EQ(v, 0.0f);
+}
+
+TEST(SampleStorageTest, EraseFrontShiftsInPlace) {
+  core::SampleStorage s;
+  s.resize_uninitialized(10);
+  for (std::size_t i = 0; i < s.size(); ++i)
+    s[i] = static_cast<float>(i);
+  const float *data = s.data();
+
+  s.erase_front(4);
+  ASSERT_EQ(s.size(), 6u);
+  EXPECT_EQ(s.data(), data);
+  for (std::size_t i = 0; i < s.size(); ++i)
+    EXPECT_EQ(s[i], static_cast<float>(i + 4));
+
+  s.erase_front(100);
+  EXPECT_TRUE(s.empty());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(SampleStorageTest, SpillsToMappedFileAboveThreshold) {
+  ScopedStorageConfig scoped(64 * 1024);
+
+  core::SampleStorage s;
+  for (std::size_t i = 0; i < 100000; ++i) {
+    s.resize_uninitialized(i + 1);
+    s[i] = static_cast<float>(i);
+  }
+
+  EXPECT_EQ(s.backend(), core::StorageBackend::MappedFile);
+  ASSERT_EQ(s.size(), 100000u);
+  for (std::size_t i = 0; i < s.size(); ++i)
+    ASSERT_EQ(s[i], static_cast<float>(i));
+}
+
+TEST(SampleStorageTest, AudioBufferCopyAndMoveKeepSamples) {
+  ScopedStorageConfig scoped(0);
+
+  core::AudioBuffer a{48000, 2, {}};
+  a.samples.resize(4096);
+  a.samples[4095] = 0.5f;
+  EXPECT_EQ(a.samples.backend(), core::StorageBackend::MappedFile);
+
+  core::AudioBuffer copy = a;
+  EXPECT_EQ(copy.samples.size(), 4096u);
+  EXPECT_EQ(copy.samples[4095], 0.5f);
+
+  core::AudioBuffer moved = std::move(a);
+  EXPECT_EQ(moved.samples[4095], 0.5f);
+  EXPECT_TRUE(a.samples.empty());
+}
+
+#ifdef __linux__
+TEST(SampleStorageTest, AdoptsSharedMemoryWithoutCopy) {
+  const int fd = memfd_create("storage-test", MFD_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  const float src[4] = {0.25f, -0.5f, 0.75f, 1.0f};
+  ASSERT_EQ(write(fd, src, sizeof(src)), static_cast<ssize_t>(sizeof(src)));
+
+  core::SampleStorage s;
+  ASSERT_TRUE(s.adopt_fd(dup(fd), 4));
+  EXPECT_EQ(s.backend(), core::StorageBackend::MappedFile);
+  EXPECT_EQ(s[2], 0.75f);
+
+  // Запись и рост видны через исходный fd.
+  s[0] = 2.0f;
+  s.resize(2048);
+  s[2047] = 3.0f;
+  float back = 0.0f;
+  ASSERT_EQ(pread(fd, &back, sizeof(back), 0), 4);
+  EXPECT_EQ(back, 2.0f);
+  ASSERT_EQ(pread(fd, &back, sizeof(back), 2047 * sizeof(float)), 4);
+  EXPECT_EQ(back, 3.0f);
+  close(fd);
+}
+
+TEST(SampleStorageTest, AdoptedEmptyFdGrowsInPlace) {
+  const int fd = memfd_create("storage-test", MFD_CLOEXEC);
+  ASSERT_GE(fd, 0);
+
+  core::SampleStorage s;
+  ASSERT_TRUE(s.adopt_fd(fd, 0));
+  s.resize_uninitialized(1000);
+  for (size_t i = 0; i < 1000; ++i)
+    s[i] = static_cast<float>(i);
+  EXPECT_EQ(s.fd(), fd);
+  EXPECT_EQ(s[999], 999.0f);
+}
+
+TEST(SampleStorageTest, AdoptedSealedFdGrowsIntoOwnedStorage) {
+  const int fd = memfd_create("storage-test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  ASSERT_GE(fd, 0);
+  const float src[4] = {0.25f, -0.5f, 0.75f, 1.0f};
+  ASSERT_EQ(write(fd, src, sizeof(src)), static_cast<ssize_t>(sizeof(src)));
+  ASSERT_EQ(fcntl(fd, F_ADD_SEALS,
+                  F_SEAL_WRITE | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL),
+            0);
+
+  core::SampleStorage s;
+  ASSERT_TRUE(s.adopt_fd(dup(fd), 4));
+  s[0] = 2.0f; // копия при записи, в fd не попадает
+
+  // Рост не трогает fd клиента: сэмплы копируются в своё хранилище
+  s.resize(2048);
+  EXPECT_EQ(s.fd(), -1);
+  EXPECT_EQ(s[0], 2.0f);
+  EXPECT_EQ(s[3], 1.0f);
+  EXPECT_EQ(s[2047], 0.0f);
+
+  struct stat st {};
+  ASSERT_EQ(fstat(fd, &st), 0);
+  EXPECT_EQ(st.st_size, static_cast<off_t>(sizeof(src)));
+  float back = 0.0f;
+  ASSERT_EQ(pread(fd, &back, sizeof(back), 0), 4);
+  EXPECT_EQ(back, 0.25f);
+  close(fd);
+}
+#endif
+#endif
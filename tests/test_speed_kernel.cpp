@@ -0,0 +1,115 @@
+#include "core/speed_kernel.hpp"
+#include <cmath>
+#include <gtest/gtest.h>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr core::SpeedQuality kQualities[] = {
+    core::SpeedQuality::Linear, core::SpeedQuality::Fast,
+    core::SpeedQuality::Balanced, core::SpeedQuality::Best};
+
+std::vector<float> render_all(const std::vector<float> &in, int channels,
+                              float speed, core::SpeedQuality quality) {
+  const core::speed::Kernel kernel(speed, quality);
+  const size_t in_frames = in.size() / channels;
+  const size_t out_frames = core::speed::output_frames(in_frames, speed);
+  std::vector<float> out(out_frames * channels);
+  kernel.render(in.data(), 0, in_frames, channels, 0, out_frames, out.data());
+  return out;
+}
+
+double rms(const float *x, size_t n) {
+  double s = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    s += static_cast<double>(x[i]) * x[i];
+  return std::sqrt(s / n);
+}
+
+} // namespace
+
+TEST(SpeedKernelTest, RationalApproximation) {
+  const auto ratio = [](double x) {
+    const core::speed::Ratio r = core::speed::rational_approximation(x, 4096);
+    return std::make_pair(r.num, r.den);
+  };
+  EXPECT_EQ(ratio(1.0 / 1.15f), std::make_pair(20u, 23u));
+  EXPECT_EQ(ratio(1.0 / 0.8f), std::make_pair(5u, 4u));
+  EXPECT_EQ(ratio(1.0 / 1.0005f), std::make_pair(2000u, 2001u));
+  EXPECT_EQ(ratio(2.0), std::make_pair(2u, 1u));
+
+  // Точно не представимое — ближайшая дробь в пределах знаменателя
+  const core::speed::Ratio pi = core::speed::rational_approximation(
+      std::numbers::pi, 4096);
+  EXPECT_LE(pi.den, 4096u);
+  EXPECT_NEAR(static_cast<double>(pi.num) / pi.den, std::numbers::pi, 1e-6);
+}
+
+// Чанки с окнами входа (компактные буферы, checkpoint'ы) — те же сэмплы
+TEST(SpeedKernelTest, BlockwiseRenderMatchesWhole) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  for (const int channels : {1, 2, 3, 6}) {
+    std::vector<float> in(3000 * channels);
+    for (float &x : in)
+      x = dist(rng);
+    const size_t in_frames = 3000;
+    for (const float speed : {0.5f, 0.87f, 1.15f, 1.9f}) {
+      for (const core::SpeedQuality quality : kQualities) {
+        const std::vector<float> whole =
+            render_all(in, channels, speed, quality);
+        const core::speed::Kernel kernel(speed, quality);
+        const size_t out_frames = whole.size() / channels;
+        std::vector<float> blocks(whole.size());
+        for (size_t first = 0; first < out_frames; first += 317) {
+          const size_t count = std::min<size_t>(317, out_frames - first);
+          const size_t begin = kernel.input_begin(first, in_frames);
+          const size_t end = kernel.input_end(first + count - 1, in_frames);
+          const std::vector<float> window(in.begin() + begin * channels,
+                                          in.begin() + end * channels);
+          kernel.render(window.data(), begin, in_frames, channels, first,
+                        count, blocks.data() + first * channels);
+        }
+        EXPECT_EQ(blocks, whole)
+            << channels << " ch, speed " << speed << ", quality "
+            << static_cast<int>(quality);
+      }
+    }
+  }
+}
+
+TEST(SpeedKernelTest, PassesDcAndSilence) {
+  for (const core::SpeedQuality quality : kQualities) {
+    const std::vector<float> dc =
+        render_all(std::vector<float>(4000, 0.5f), 2, 1.15f, quality);
+    // Края — нули за сигналом; середина — единичное усиление
+    for (size_t i = 200; i < dc.size() - 200; ++i)
+      ASSERT_NEAR(dc[i], 0.5f, 1e-5f) << i;
+
+    for (const float x :
+         render_all(std::vector<float>(4000, 0.0f), 2, 0.87f, quality)) {
+      ASSERT_EQ(x, 0.0f);
+    }
+  }
+}
+
+// Ускорение в 1 / 0.8 раза выносит тон на 0.9 Найквиста за новый Найквист:
+// линейная интерполяция отражает его обратно, фильтр — подавляет
+TEST(SpeedKernelTest, SuppressesAliasing) {
+  const size_t frames = 48000;
+  std::vector<float> in(frames);
+  for (size_t i = 0; i < frames; ++i)
+    in[i] = 0.5f * std::sin(std::numbers::pi * 0.9 * i);
+
+  const auto level = [&](core::SpeedQuality quality) {
+    const std::vector<float> out = render_all(in, 1, 0.8f, quality);
+    return 20.0 * std::log10(rms(out.data() + 1000, out.size() - 2000) /
+                             (0.5 / std::sqrt(2.0)));
+  };
+  EXPECT_GT(level(core::SpeedQuality::Linear), -30.0);
+  EXPECT_LT(level(core::SpeedQuality::Fast), -50.0);
+  EXPECT_LT(level(core::SpeedQuality::Balanced), -70.0);
+  EXPECT_LT(level(core::SpeedQuality::Best), -90.0);
+}
@@ -0,0 +1,96 @@
+#include "core/uring_file.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temp_file(const char *name) {
+  return std::filesystem::temp_directory_path() /
+         (std::string("grustnify_test_") + name);
+}
+
+std::vector<uint8_t> pattern(size_t n) {
+  std::vector<uint8_t> v(n);
+  for (size_t i = 0; i < n; ++i)
+    v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+  return v;
+}
+
+// Маленькие чанки, чтобы упреждение несколько раз прокрутилось по кругу
+core::aio::AioOptions small_chunks() {
+  core::aio::AioOptions options;
+  options.chunk_bytes = 64 * 1024;
+  options.depth = 3;
+  return options;
+}
+
+} // namespace
+
+TEST(UringFileTest, PrefetchReadAndSeek) {
+  if (!core::aio::available())
+    GTEST_SKIP() << "io_uring unavailable";
+
+  const std::filesystem::path path = temp_file("prefetch.bin");
+  const std::vector<uint8_t> data = pattern(1000003);
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+
+  auto reader = core::aio::PrefetchReader::open(path, small_chunks());
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(reader->size(), static_cast<int64_t>(data.size()));
+
+  // Нечётные размеры чтения пересекают границы чанков
+  std::vector<uint8_t> got;
+  std::vector<uint8_t> buf(10007);
+  for (int64_t n; (n = reader->read(buf.data(), buf.size())) > 0;)
+    got.insert(got.end(), buf.begin(), buf.begin() + n);
+  EXPECT_EQ(got, data);
+  EXPECT_EQ(reader->read(buf.data(), buf.size()), 0);
+
+  // Назад, как это делает demuxer при поиске заголовков
+  ASSERT_EQ(reader->seek(123456), 123456);
+  ASSERT_EQ(reader->read(buf.data(), 100), 100);
+  EXPECT_EQ(std::memcmp(buf.data(), data.data() + 123456, 100), 0);
+  ASSERT_EQ(reader->seek(999990), 999990);
+  ASSERT_EQ(reader->read(buf.data(), buf.size()), 13);
+  EXPECT_EQ(std::memcmp(buf.data(), data.data() + 999990, 13), 0);
+
+  reader.reset();
+  std::filesystem::remove(path);
+}
+
+TEST(UringFileTest, WriteBehindWithHeaderPatch) {
+  if (!core::aio::available())
+    GTEST_SKIP() << "io_uring unavailable";
+
+  const std::filesystem::path path = temp_file("write_behind.bin");
+  std::vector<uint8_t> data = pattern(777777);
+
+  auto writer = core::aio::WriteBehind::open(path, small_chunks());
+  ASSERT_TRUE(writer);
+  for (size_t done = 0; done < data.size(); done += 5000) {
+    const size_t n = std::min<size_t>(5000, data.size() - done);
+    ASSERT_EQ(writer->write(data.data() + done, n), static_cast<int64_t>(n));
+  }
+  EXPECT_EQ(writer->tell(), static_cast<int64_t>(data.size()));
+
+  // Muxer возвращается в начало и переписывает «заголовок»
+  const uint8_t header[8] = {'G', 'R', 'U', 'S', 'T', 'N', 'F', 'Y'};
+  ASSERT_EQ(writer->seek(4), 4);
+  ASSERT_EQ(writer->write(header, sizeof(header)), 8);
+  EXPECT_EQ(writer->size(), static_cast<int64_t>(data.size()));
+  ASSERT_TRUE(writer->close());
+  std::memcpy(data.data() + 4, header, sizeof(header));
+
+  std::ifstream in(path, std::ios::binary);
+  const std::vector<uint8_t> got{std::istreambuf_iterator<char>(in), {}};
+  EXPECT_EQ(got, data);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,233 @@
+#include "core/audio_buffer.hpp"
+#include "core/video_remux.hpp"
+#include "log/log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+constexpr int kFps = 25;
+constexpr int kFrames = 25; // 1 с видео
+constexpr int kSide = 32;
+constexpr int kRate = 48000;
+constexpr int kChannels = 2;
+constexpr float kSpeed = 1.25f; // 1/speed = 4/5: растянутые pts точны в мс
+
+std::filesystem::path temp_file(const char *name) {
+  return std::filesystem::temp_directory_path() /
+         (std::string("grustnify_test_") + name);
+}
+
+// Видео (mpeg4) и PCM-звук в mkv, одна секунда. false — в сборке FFmpeg
+// нет энкодера mpeg4 или muxer'а matroska.
+bool write_clip(const std::filesystem::path &path) {
+  const std::string name = path.string();
+  const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  if (!codec)
+    return false;
+  AVFormatContext *oc = nullptr;
+  if (avformat_alloc_output_context2(&oc, nullptr, "matroska",
+                                     name.c_str()) < 0 ||
+      !oc)
+    return false;
+
+  AVCodecContext *enc = avcodec_alloc_context3(codec);
+  enc->width = kSide;
+  enc->height = kSide;
+  enc->pix_fmt = AV_PIX_FMT_YUV420P;
+  enc->time_base = AVRational{1, kFps};
+  enc->framerate = AVRational{kFps, 1};
+  enc->gop_size = 5;
+  if (oc->oformat->flags & AVFMT_GLOBALHEADER)
+    enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  AVStream *video = avformat_new_stream(oc, nullptr);
+  AVStream *audio = avformat_new_stream(oc, nullptr);
+  bool ok = video && audio && avcodec_open2(enc, codec, nullptr) >= 0;
+  if (ok) {
+    avcodec_parameters_from_context(video->codecpar, enc);
+    video->time_base = enc->time_base;
+    video->avg_frame_rate = enc->framerate;
+
+    AVCodecParameters *par = audio->codecpar;
+    par->codec_type = AVMEDIA_TYPE_AUDIO;
+    par->codec_id = AV_CODEC_ID_PCM_S16LE;
+    par->format = AV_SAMPLE_FMT_S16;
+    par->sample_rate = kRate;
+    av_channel_layout_default(&par->ch_layout, kChannels);
+    par->bits_per_coded_sample = 16;
+    par->block_align = 2 * kChannels;
+    audio->time_base = AVRational{1, kRate};
+
+    ok = avio_open(&oc->pb, name.c_str(), AVIO_FLAG_WRITE) >= 0 &&
+         avformat_write_header(oc, nullptr) >= 0;
+  }
+
+  AVFrame *frame = av_frame_alloc();
+  AVPacket *packet = av_packet_alloc();
+  if (ok) {
+    frame->format = enc->pix_fmt;
+    frame->width = kSide;
+    frame->height = kSide;
+    ok = av_frame_get_buffer(frame, 0) >= 0;
+  }
+
+  // Пакеты кодера — в файл
+  auto drain = [&] {
+    while (avcodec_receive_packet(enc, packet) >= 0) {
+      packet->stream_index = video->index;
+      av_packet_rescale_ts(packet, enc->time_base, video->time_base);
+      if (av_interleaved_write_frame(oc, packet) < 0)
+        return false;
+    }
+    return true;
+  };
+
+  const int audio_frames = kRate / kFps;
+  for (int i = 0; ok && i < kFrames; ++i) {
+    ok = av_frame_make_writable(frame) >= 0;
+    for (int plane = 0; ok && plane < 3; ++plane) {
+      const int side = plane == 0 ? kSide : kSide / 2;
+      for (int y = 0; y < side; ++y)
+        for (int x = 0; x < side; ++x)
+          frame->data[plane][y * frame->linesize[plane] + x] =
+              static_cast<uint8_t>(plane == 0 ? x * 4 + y + i * 9 : 128);
+    }
+    frame->pts = i;
+    ok = ok && avcodec_send_frame(enc, frame) >= 0 && drain();
+
+    // Тишина того же отрезка
+    ok = ok && av_new_packet(packet, audio_frames * 2 * kChannels) >= 0;
+    if (ok) {
+      std::fill(packet->data, packet->data + packet->size, 0);
+      packet->stream_index = audio->index;
+      packet->pts = packet->dts = static_cast<int64_t>(i) * audio_frames;
+      packet->duration = audio_frames;
+      av_packet_rescale_ts(packet, AVRational{1, kRate}, audio->time_base);
+      ok = av_interleaved_write_frame(oc, packet) >= 0;
+    }
+  }
+  ok = ok && avcodec_send_frame(enc, nullptr) >= 0 && drain() &&
+       av_write_trailer(oc) >= 0;
+
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&enc);
+  if (oc->pb)
+    avio_closep(&oc->pb);
+  avformat_free_context(oc);
+  return ok;
+}
+
+struct VideoPackets {
+  std::vector<std::vector<uint8_t>> data;
+  std::vector<double> pts; // секунды
+  int audio_streams = 0;
+};
+
+VideoPackets read_video(const std::filesystem::path &path) {
+  VideoPackets out;
+  const std::string name = path.string();
+  AVFormatContext *fc = nullptr;
+  if (avformat_open_input(&fc, name.c_str(), nullptr, nullptr) != 0)
+    return out;
+  avformat_find_stream_info(fc, nullptr);
+  for (unsigned i = 0; i < fc->nb_streams; ++i)
+    if (fc->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+      ++out.audio_streams;
+
+  AVPacket *packet = av_packet_alloc();
+  while (av_read_frame(fc, packet) >= 0) {
+    const AVStream *stream = fc->streams[packet->stream_index];
+    if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+      out.data.emplace_back(packet->data, packet->data + packet->size);
+      out.pts.push_back(packet->pts * av_q2d(stream->time_base));
+    }
+    av_packet_unref(packet);
+  }
+  av_packet_free(&packet);
+  avformat_close_input(&fc);
+  return out;
+}
+
+// Замедленный звук: тон на всю длину исходника, умноженную на kSpeed
+core::AudioBuffer slowed_audio() {
+  core::AudioBuffer b{kRate, kChannels, {}};
+  const size_t frames =
+      static_cast<size_t>(std::lround(kFrames * kSpeed * kRate / kFps));
+  b.samples.resize(frames * kChannels);
+  for (size_t n = 0; n < frames; ++n)
+    for (int ch = 0; ch < kChannels; ++ch)
+      b.samples[n * kChannels + ch] =
+          0.3f * std::sin(2.0f * 3.14159265f * 440.0f * n / kRate);
+  return b;
+}
+
+class VideoRemuxTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    if (!grustnify::Log::GetClientLogger())
+      grustnify::Log::Init();
+    input_ = temp_file("remux_in.mkv");
+    output_ = temp_file("remux_out.mkv");
+    if (!write_clip(input_))
+      GTEST_SKIP() << "FFmpeg build lacks the mpeg4 encoder or mkv muxer";
+    source_ = read_video(input_);
+    ASSERT_EQ(source_.data.size(), static_cast<size_t>(kFrames));
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(input_);
+    std::filesystem::remove(output_);
+  }
+
+  VideoPackets remux(core::VideoTimestampPolicy policy) {
+    core::RemuxOptions options;
+    options.speed_factor = kSpeed;
+    options.timestamps = policy;
+    EXPECT_TRUE(core::remux_with_audio(input_, 1, output_, audio_, options));
+    return read_video(output_);
+  }
+
+  std::filesystem::path input_, output_;
+  VideoPackets source_;
+  const core::AudioBuffer audio_ = slowed_audio();
+};
+
+} // namespace
+
+TEST_F(VideoRemuxTest, StretchKeepsVideoInSyncWithSlowedAudio) {
+  const VideoPackets out = remux(core::VideoTimestampPolicy::Stretch);
+  ASSERT_EQ(out.data.size(), source_.data.size());
+  EXPECT_EQ(out.audio_streams, 1);
+  for (size_t i = 0; i < out.data.size(); ++i) {
+    EXPECT_EQ(out.data[i], source_.data[i]) << "packet " << i;
+    EXPECT_NEAR(out.pts[i], source_.pts[i] * kSpeed, 1e-3) << "packet " << i;
+  }
+
+  // Последний кадр — не дальше одного (растянутого) кадра от конца звука
+  const double frame = kSpeed / kFps;
+  const double audio_seconds =
+      static_cast<double>(audio_.samples.size() / kChannels) / kRate;
+  EXPECT_LE(std::fabs(audio_seconds - out.pts.back()), frame + 1e-3);
+}
+
+TEST_F(VideoRemuxTest, KeepLeavesVideoTimestampsUnchanged) {
+  const VideoPackets out = remux(core::VideoTimestampPolicy::Keep);
+  ASSERT_EQ(out.data.size(), source_.data.size());
+  EXPECT_EQ(out.audio_streams, 1);
+  for (size_t i = 0; i < out.data.size(); ++i) {
+    EXPECT_EQ(out.data[i], source_.data[i]) << "packet " << i;
+    EXPECT_NEAR(out.pts[i], source_.pts[i], 1e-6) << "packet " << i;
+  }
+}
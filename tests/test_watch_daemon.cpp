@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include "app/watch_daemon.hpp"
+#include <filesystem>
+
+TEST(WatchDaemonTest, InputsSharingStemPublishToDifferentFiles) {
+  const std::filesystem::path wav = "/srv/inbox/x.wav";
+  const std::filesystem::path flac = "/srv/inbox/x.flac";
+
+  const auto wav_out = app::watch_output_name(wav, false);
+  const auto flac_out = app::watch_output_name(flac, false);
+  EXPECT_EQ(wav_out, "x.wav_grustnified.mp3");
+  EXPECT_EQ(flac_out, "x.flac_grustnified.mp3");
+  EXPECT_NE(wav_out, flac_out);
+
+  // keep_video: контейнер входа сохраняется
+  EXPECT_EQ(app::watch_output_name("/srv/inbox/clip.mkv", true),
+            "clip.mkv_grustnified.mkv");
+  EXPECT_NE(app::watch_output_name("/srv/inbox/clip.mkv", true),
+            app::watch_output_name("/srv/inbox/clip.mp4", true));
+}
+#endif
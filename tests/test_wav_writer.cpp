@@ -0,0 +1,174 @@
+#include "core/wav_writer.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::filesystem::path temp_file(const char *name) {
+  return std::filesystem::temp_directory_path() /
+         (std::string("grustnify_test_") + name);
+}
+
+std::vector<uint8_t> read_all(const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), {}};
+}
+
+uint32_t u32_at(const std::vector<uint8_t> &b, size_t at) {
+  uint32_t v;
+  std::memcpy(&v, b.data() + at, 4);
+  return v;
+}
+
+uint64_t u64_at(const std::vector<uint8_t> &b, size_t at) {
+  uint64_t v;
+  std::memcpy(&v, b.data() + at, 8);
+  return v;
+}
+
+// Смещение полезной нагрузки чанка id (после 8-байтового заголовка)
+size_t find_chunk(const std::vector<uint8_t> &b, const char *id) {
+  for (size_t at = 12; at + 8 <= b.size();) {
+    const uint32_t size = u32_at(b, at + 4);
+    if (std::memcmp(b.data() + at, id, 4) == 0)
+      return at + 8;
+    if (std::memcmp(b.data() + at, "data", 4) == 0)
+      break;
+    at += 8 + size + (size & 1);
+  }
+  return 0;
+}
+
+std::vector<float> ramp(size_t n) {
+  std::vector<float> v(n);
+  for (size_t i = 0; i < n; ++i)
+    v[i] = static_cast<float>(i % 2000) / 1000.0f - 1.0f;
+  return v;
+}
+
+} // namespace
+
+TEST(WavWriterTest, FloatRoundTripAcrossBlocks) {
+  const std::filesystem::path path = temp_file("float.wav");
+  // 5.1 и больше 4 МиБ: несколько writev() и WAVE_FORMAT_EXTENSIBLE
+  const size_t frames = 300000;
+  const std::vector<float> samples = ramp(frames * 6);
+
+  core::WavWriter writer;
+  ASSERT_TRUE(writer.open(path, 48000, 6));
+  for (size_t done = 0; done < frames; done += 7777) {
+    const size_t n = std::min<size_t>(7777, frames - done);
+    ASSERT_TRUE(writer.write(samples.data() + done * 6, n));
+  }
+  ASSERT_TRUE(writer.close());
+  EXPECT_FALSE(writer.is_rf64());
+
+  const std::vector<uint8_t> b = read_all(path);
+  ASSERT_EQ(std::memcmp(b.data(), "RIFF", 4), 0);
+  EXPECT_EQ(u32_at(b, 4), b.size() - 8);
+
+  const size_t fmt = find_chunk(b, "fmt ");
+  ASSERT_NE(fmt, 0u);
+  uint16_t tag, channels;
+  std::memcpy(&tag, b.data() + fmt, 2);
+  std::memcpy(&channels, b.data() + fmt + 2, 2);
+  EXPECT_EQ(tag, 0xFFFE);
+  EXPECT_EQ(channels, 6);
+  EXPECT_EQ(u32_at(b, fmt + 4), 48000u);
+
+  const size_t fact = find_chunk(b, "fact");
+  ASSERT_NE(fact, 0u);
+  EXPECT_EQ(u32_at(b, fact), frames);
+
+  const size_t data = find_chunk(b, "data");
+  ASSERT_NE(data, 0u);
+  ASSERT_EQ(u32_at(b, data - 4), samples.size() * sizeof(float));
+  ASSERT_EQ(b.size(), data + samples.size() * sizeof(float));
+  EXPECT_EQ(std::memcmp(b.data() + data, samples.data(),
+                        samples.size() * sizeof(float)),
+            0);
+  std::filesystem::remove(path);
+}
+
+TEST(WavWriterTest, Int16Pcm) {
+  const std::filesystem::path path = temp_file("s16.wav");
+  const std::vector<float> samples = {0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f};
+
+  core::WavOptions options;
+  options.format = core::WavSampleFormat::S16;
+  core::WavWriter writer;
+  ASSERT_TRUE(writer.open(path, 44100, 2, options));
+  ASSERT_TRUE(writer.write(samples.data(), 3));
+  ASSERT_TRUE(writer.close());
+
+  const std::vector<uint8_t> b = read_all(path);
+  const size_t fmt = find_chunk(b, "fmt ");
+  uint16_t tag;
+  std::memcpy(&tag, b.data() + fmt, 2);
+  EXPECT_EQ(tag, 1);
+  EXPECT_EQ(find_chunk(b, "fact"), 0u);
+
+  const size_t data = find_chunk(b, "data");
+  ASSERT_EQ(u32_at(b, data - 4), 12u);
+  int16_t pcm[6];
+  std::memcpy(pcm, b.data() + data, sizeof(pcm));
+  EXPECT_EQ(pcm[0], 0);
+  EXPECT_EQ(pcm[1], 16384);
+  EXPECT_EQ(pcm[2], -16384);
+  EXPECT_EQ(pcm[3], 32767);
+  EXPECT_EQ(pcm[4], -32768);
+  EXPECT_EQ(pcm[5], 32767); // клип
+  std::filesystem::remove(path);
+}
+
+TEST(WavWriterTest, SwitchesToRf64AboveLimit) {
+  const std::filesystem::path path = temp_file("rf64.wav");
+  const std::vector<float> samples = ramp(20000);
+
+  core::WavOptions options;
+  options.riff_limit = 4096; // вместо 4 ГиБ
+  core::WavWriter writer;
+  ASSERT_TRUE(writer.open(path, 48000, 2, options));
+  ASSERT_TRUE(writer.write(samples.data(), 10000));
+  ASSERT_TRUE(writer.close());
+  EXPECT_TRUE(writer.is_rf64());
+
+  const std::vector<uint8_t> b = read_all(path);
+  ASSERT_EQ(std::memcmp(b.data(), "RF64", 4), 0);
+  EXPECT_EQ(u32_at(b, 4), 0xFFFFFFFFu);
+  const size_t ds64 = find_chunk(b, "ds64");
+  ASSERT_EQ(ds64, 20u); // сразу после WAVE
+  EXPECT_EQ(u64_at(b, ds64), b.size() - 8);
+  EXPECT_EQ(u64_at(b, ds64 + 8), samples.size() * sizeof(float));
+  EXPECT_EQ(u64_at(b, ds64 + 16), 10000u);
+  const size_t data = find_chunk(b, "data");
+  EXPECT_EQ(u32_at(b, data - 4), 0xFFFFFFFFu);
+  std::filesystem::remove(path);
+}
+
+TEST(WavWriterTest, DirectIoFallsBackAndDropsCache) {
+  const std::filesystem::path path = temp_file("direct.wav");
+  const std::vector<float> samples = ramp(2 * 700001);
+
+  core::WavOptions options;
+  options.direct_io = true;
+  options.drop_cache = true;
+  core::WavWriter writer;
+  ASSERT_TRUE(writer.open(path, 48000, 2, options));
+  ASSERT_TRUE(writer.write(samples.data(), 700001));
+  ASSERT_TRUE(writer.close());
+
+  const std::vector<uint8_t> b = read_all(path);
+  const size_t data = find_chunk(b, "data");
+  ASSERT_NE(data, 0u);
+  ASSERT_EQ(b.size(), data + samples.size() * sizeof(float));
+  EXPECT_EQ(std::memcmp(b.data() + data, samples.data(),
+                        samples.size() * sizeof(float)),
+            0);
+  std::filesystem::remove(path);
+}